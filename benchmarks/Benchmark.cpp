@@ -0,0 +1,191 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file Benchmark.cpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include <omp.h>
+
+#include <steam/common/Timer.hpp>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// Allocation counting. With glibc, the malloc family is interposed (this also counts the
+/// allocations of Eigen, which bypass operator new); otherwise only operator new is counted.
+//////////////////////////////////////////////////////////////////////////////////////////////
+static std::atomic<unsigned long long> numAllocations(0);
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr == NULL && size != 0 ? ENOMEM : 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_memalign(alignment, size);
+}
+
+} // extern "C"
+
+#else
+
+void* operator new(std::size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size ? size : 1);
+  if (ptr == NULL) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+#endif
+
+namespace steam {
+namespace bench {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Registry of benchmarks (constructed on first use, registrations are static)
+//////////////////////////////////////////////////////////////////////////////////////////////
+static std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Directory of the datasets
+//////////////////////////////////////////////////////////////////////////////////////////////
+static std::string& dataDirectory() {
+#ifdef STEAM_BENCHMARK_DATA_DIR
+  static std::string directory(STEAM_BENCHMARK_DATA_DIR);
+#else
+  static std::string directory("../../include/steam/data");
+#endif
+  return directory;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Registers a benchmark
+//////////////////////////////////////////////////////////////////////////////////////////////
+Registration::Registration(const std::string& name, bool threaded, const SetupFunction& setup) {
+  Benchmark benchmark;
+  benchmark.name = name;
+  benchmark.threaded = threaded;
+  benchmark.setup = setup;
+  registry().push_back(benchmark);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the registered benchmarks, sorted by name
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<Benchmark> getBenchmarks() {
+  std::vector<Benchmark> benchmarks = registry();
+  std::sort(benchmarks.begin(), benchmarks.end(),
+            [](const Benchmark& a, const Benchmark& b) { return a.name < b.name; });
+  return benchmarks;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Number of heap allocations made by the process so far (all threads)
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long long allocationCount() {
+  return numAllocations.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Run a benchmark for one thread count
+//////////////////////////////////////////////////////////////////////////////////////////////
+Result run(const Benchmark& benchmark, unsigned int numThreads, const Options& options) {
+
+  // Build the fixture, and warm up (caches, memory pools, lazy initialization)
+  omp_set_num_threads(numThreads);
+  Operation op = benchmark.setup(numThreads);
+  op();
+
+  // Increase the iterations until the measured time exceeds the minimum
+  Result result;
+  result.name = benchmark.name;
+  result.numThreads = numThreads;
+  unsigned long long iterations = 1;
+  while (true) {
+    const unsigned long long allocsBefore = allocationCount();
+    steam::Timer timer;
+    for (unsigned long long i = 0; i < iterations; i++) {
+      op();
+    }
+    const double seconds = timer.seconds();
+    const unsigned long long allocs = allocationCount() - allocsBefore;
+
+    if (seconds >= options.minSeconds || iterations >= options.maxIterations) {
+      result.iterations = iterations;
+      result.nsPerOp = 1e9*seconds/iterations;
+      result.allocsPerOp = double(allocs)/iterations;
+      return result;
+    }
+
+    // Aim 20% past the minimum, growing by at most 10x per round
+    const double scale = seconds > 0.0 ? 1.2*options.minSeconds/seconds : 10.0;
+    const unsigned long long next = (unsigned long long)(iterations*std::min(10.0, scale));
+    iterations = std::min(options.maxIterations, std::max(iterations + 1, next));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Set the directory of the datasets
+//////////////////////////////////////////////////////////////////////////////////////////////
+void setDataDirectory(const std::string& directory) {
+  dataDirectory() = directory;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the path of a dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::string dataFile(const std::string& name) {
+  return dataDirectory() + "/" + name;
+}
+
+} // bench
+} // steam
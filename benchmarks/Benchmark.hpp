@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file Benchmark.hpp
+/// \brief A minimal microbenchmark harness: benchmarks register a setup function that builds
+///        their fixture and returns the operation to time. The runner reports the wall time
+///        and the number of heap allocations per operation, and the thread scaling of the
+///        benchmarks that run in parallel.
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_BENCHMARK_HPP
+#define STEAM_BENCHMARK_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace steam {
+namespace bench {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief The operation that is timed, it is called repeatedly on the same fixture
+//////////////////////////////////////////////////////////////////////////////////////////////
+typedef std::function<void()> Operation;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Builds the fixture of a benchmark for a number of threads, and returns the
+///        operation. May throw (e.g. if a dataset is missing), the benchmark is then skipped.
+//////////////////////////////////////////////////////////////////////////////////////////////
+typedef std::function<Operation(unsigned int numThreads)> SetupFunction;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief A registered benchmark
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Benchmark {
+  std::string name;     // group/subject/operation
+  bool threaded;        // whether to run it for every thread count
+  SetupFunction setup;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Result of a benchmark for one thread count
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Result {
+  std::string name;
+  unsigned int numThreads;
+  unsigned long long iterations;
+  double nsPerOp;
+  double allocsPerOp;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Options of the runner
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Options {
+  Options() : minSeconds(0.2), maxIterations(1000000000ull) {}
+
+  /// \brief Benchmarks whose name contains one of the filters are run (all, if empty)
+  std::vector<std::string> filters;
+
+  /// \brief Thread counts of the threaded benchmarks (1 up to the number of cores, doubling,
+  ///        if empty)
+  std::vector<unsigned int> threadCounts;
+
+  /// \brief Minimum measured time, and maximum number of iterations, per result
+  double minSeconds;
+  unsigned long long maxIterations;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Registers a benchmark at static initialization, e.g.
+///
+///        static steam::bench::Registration reg("group/subject/op", false, &setupFunction);
+//////////////////////////////////////////////////////////////////////////////////////////////
+class Registration
+{
+ public:
+  Registration(const std::string& name, bool threaded, const SetupFunction& setup);
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the registered benchmarks, sorted by name
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<Benchmark> getBenchmarks();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Number of heap allocations made by the process so far (all threads)
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long long allocationCount();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Run a benchmark for one thread count: the iterations are increased until the
+///        measured time exceeds the minimum
+//////////////////////////////////////////////////////////////////////////////////////////////
+Result run(const Benchmark& benchmark, unsigned int numThreads, const Options& options);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Set and get the directory of the datasets used by the end-to-end benchmarks
+//////////////////////////////////////////////////////////////////////////////////////////////
+void setDataDirectory(const std::string& directory);
+std::string dataFile(const std::string& name);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Keep the compiler from optimizing away a computed value
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // bench
+} // steam
+
+#endif // STEAM_BENCHMARK_HPP
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file blockmat_bench.cpp
+/// \brief Benchmarks of the block-sparse matrix and Jacobian utilities used during assembly
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.hpp"
+
+#include <steam.hpp>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Block pattern of a pose-graph Hessian (upper triangle): 6x6 blocks on the diagonal,
+///        odometry blocks next to it, and a loop closure every 10 poses to 100 poses back
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct PoseGraphPattern {
+  static const unsigned int numPoses = 2000;
+
+  PoseGraphPattern() : blockSizes(numPoses, 6), block(Eigen::MatrixXd::Identity(6,6)) {
+    for (unsigned int i = 0; i < numPoses; i++) {
+      rows.push_back(i); cols.push_back(i);
+      if (i + 1 < numPoses) {
+        rows.push_back(i); cols.push_back(i + 1);
+      }
+      if (i >= 100 && i % 10 == 0) {
+        rows.push_back(i - 100); cols.push_back(i);
+      }
+    }
+  }
+
+  std::vector<unsigned int> blockSizes;
+  std::vector<unsigned int> rows;
+  std::vector<unsigned int> cols;
+  Eigen::MatrixXd block;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Zero and re-accumulate every block of a pose-graph Hessian (in parallel, as done by
+///        the cost-term collections)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation blockSparseAdd(unsigned int numThreads) {
+  boost::shared_ptr<PoseGraphPattern> pattern(new PoseGraphPattern());
+  boost::shared_ptr<steam::BlockSparseMatrix> matrix(
+      new steam::BlockSparseMatrix(pattern->blockSizes, true));
+  return [pattern, matrix, numThreads]() {
+    matrix->zero();
+    const int numBlocks = pattern->rows.size();
+    #pragma omp parallel for num_threads(numThreads)
+    for (int i = 0; i < numBlocks; i++) {
+      matrix->add(pattern->rows[i], pattern->cols[i], pattern->block);
+    }
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Convert an assembled pose-graph Hessian to an Eigen sparse matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation blockSparseToEigen(unsigned int) {
+  PoseGraphPattern pattern;
+  boost::shared_ptr<steam::BlockSparseMatrix> matrix(
+      new steam::BlockSparseMatrix(pattern.blockSizes, true));
+  for (unsigned int i = 0; i < pattern.rows.size(); i++) {
+    matrix->add(pattern.rows[i], pattern.cols[i], pattern.block);
+  }
+  return [matrix]() {
+    steam::bench::doNotOptimize(matrix->toEigen());
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Merge the Jacobians of two branches of an evaluation tree that share two states
+///        (the copy of the unmerged Jacobians is included)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation jacobianMerge(unsigned int) {
+  std::vector<steam::StateKey> keys(6);
+  std::vector<steam::Jacobian<6,6> > jacs;
+  for (unsigned int i = 0; i < 4; i++) {
+    jacs.push_back(steam::Jacobian<6,6>(keys[i], Eigen::Matrix<double,6,6>::Identity()));
+  }
+  jacs.push_back(steam::Jacobian<6,6>(keys[4], Eigen::Matrix<double,6,6>::Identity()));
+  jacs.push_back(steam::Jacobian<6,6>(keys[1], Eigen::Matrix<double,6,6>::Identity()));
+  jacs.push_back(steam::Jacobian<6,6>(keys[5], Eigen::Matrix<double,6,6>::Identity()));
+  jacs.push_back(steam::Jacobian<6,6>(keys[3], Eigen::Matrix<double,6,6>::Identity()));
+  std::vector<steam::Jacobian<6,6> > merged;
+  merged.reserve(jacs.size());
+  return [jacs, merged]() mutable {
+    merged.assign(jacs.begin(), jacs.end());
+    steam::Jacobian<6,6>::merge(&merged, 4);
+    steam::bench::doNotOptimize(merged);
+  };
+}
+
+steam::bench::Registration reg1("blockmat/BlockSparseMatrix/add", true, &blockSparseAdd);
+steam::bench::Registration reg2("blockmat/BlockSparseMatrix/toEigen", false, &blockSparseToEigen);
+steam::bench::Registration reg3("blockmat/Jacobian/merge", false, &jacobianMerge);
+
+} // namespace
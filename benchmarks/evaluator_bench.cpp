@@ -0,0 +1,182 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file evaluator_bench.cpp
+/// \brief Benchmarks of the block-automatic evaluators (evaluation, and evaluation with the
+///        fixed-size Jacobians used by the cost terms)
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.hpp"
+
+#include <lgmath.hpp>
+#include <steam.hpp>
+#include <steam/trajectory/SteamTrajPoseInterpEval.hpp>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief A transform state evaluator with a fixed, non-trivial value
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::se3::TransformEvaluator::Ptr makeTransformEval(double scale) {
+  Eigen::Matrix<double,6,1> xi;
+  xi << 0.1, -0.2, 0.3, 0.05, -0.1, 0.2;
+  xi *= scale;
+  steam::se3::TransformStateVar::Ptr state(
+      new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi)));
+  return steam::se3::TransformStateEvaluator::MakeShared(state);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Stereo camera intrinsics of the synthetic problems
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::stereo::CameraIntrinsics::Ptr makeIntrinsics() {
+  steam::stereo::CameraIntrinsics::Ptr intrinsics(new steam::stereo::CameraIntrinsics());
+  intrinsics->b = 0.24;
+  intrinsics->fu = intrinsics->fv = 480.0;
+  intrinsics->cu = 320.0;
+  intrinsics->cv = 240.0;
+  return intrinsics;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate a composition of two transforms
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation composeTransformEvaluate(unsigned int) {
+  steam::se3::TransformEvaluator::Ptr eval = steam::se3::ComposeTransformEvaluator::MakeShared(
+      makeTransformEval(1.0), makeTransformEval(-2.0));
+  return [eval]() {
+    steam::bench::doNotOptimize(eval->evaluate());
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate a composition of two transforms, and its 6x6 Jacobians
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation composeTransformJacobians(unsigned int) {
+  steam::se3::TransformEvaluator::Ptr eval = steam::se3::ComposeTransformEvaluator::MakeShared(
+      makeTransformEval(1.0), makeTransformEval(-2.0));
+  return [eval]() {
+    steam::EvalTreeHandle<lgmath::se3::Transformation> tree = eval->getBlockAutomaticEvaluation();
+    std::vector<steam::Jacobian<6,6> > jacs;
+    eval->appendBlockAutomaticJacobians(Eigen::Matrix<double,6,6>::Identity(),
+                                        tree.getRoot(), &jacs);
+    steam::bench::doNotOptimize(jacs);
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate a landmark transformed into a camera frame
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation composeLandmarkEvaluate(unsigned int) {
+  steam::se3::LandmarkStateVar::Ptr landmark(
+      new steam::se3::LandmarkStateVar(Eigen::Vector3d(1.0, -0.5, 10.0)));
+  steam::se3::ComposeLandmarkEvaluator::Ptr eval =
+      steam::se3::ComposeLandmarkEvaluator::MakeShared(makeTransformEval(1.0), landmark);
+  return [eval]() {
+    steam::bench::doNotOptimize(eval->evaluate());
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate a landmark transformed into a camera frame, and its 4x6 Jacobians
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation composeLandmarkJacobians(unsigned int) {
+  steam::se3::LandmarkStateVar::Ptr landmark(
+      new steam::se3::LandmarkStateVar(Eigen::Vector3d(1.0, -0.5, 10.0)));
+  steam::se3::ComposeLandmarkEvaluator::Ptr eval =
+      steam::se3::ComposeLandmarkEvaluator::MakeShared(makeTransformEval(1.0), landmark);
+  return [eval]() {
+    steam::EvalTreeHandle<Eigen::Vector4d> tree = eval->getBlockAutomaticEvaluation();
+    std::vector<steam::Jacobian<4,6> > jacs;
+    eval->appendBlockAutomaticJacobians(Eigen::Matrix4d::Identity(), tree.getRoot(), &jacs);
+    steam::bench::doNotOptimize(jacs);
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate a stereo reprojection error
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation stereoErrorEvaluate(unsigned int) {
+  steam::se3::LandmarkStateVar::Ptr landmark(
+      new steam::se3::LandmarkStateVar(Eigen::Vector3d(1.0, -0.5, 10.0)));
+  steam::StereoCameraErrorEval::Ptr eval(new steam::StereoCameraErrorEval(
+      Eigen::Vector4d(350.0, 220.0, 340.0, 220.0), makeIntrinsics(), makeTransformEval(0.1),
+      landmark));
+  return [eval]() {
+    steam::bench::doNotOptimize(eval->evaluate());
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate a stereo reprojection error and its Jacobians
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation stereoErrorJacobians(unsigned int) {
+  steam::se3::LandmarkStateVar::Ptr landmark(
+      new steam::se3::LandmarkStateVar(Eigen::Vector3d(1.0, -0.5, 10.0)));
+  steam::StereoCameraErrorEval::Ptr eval(new steam::StereoCameraErrorEval(
+      Eigen::Vector4d(350.0, 220.0, 340.0, 220.0), makeIntrinsics(), makeTransformEval(0.1),
+      landmark));
+  return [eval]() {
+    std::vector<steam::Jacobian<4,6> > jacs;
+    steam::bench::doNotOptimize(eval->evaluate(Eigen::Matrix4d::Identity(), &jacs));
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Make a pose interpolation evaluator halfway between two trajectory knots
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::se3::SteamTrajPoseInterpEval::Ptr makeInterpEval() {
+  Eigen::Matrix<double,6,1> velocity;
+  velocity << 5.0, 0.1, 0.0, 0.0, 0.0, 0.2;
+  steam::se3::SteamTrajVar::Ptr knot1(new steam::se3::SteamTrajVar(steam::Time(0.0),
+      makeTransformEval(1.0), steam::VectorSpaceStateVar::Ptr(
+          new steam::VectorSpaceStateVar(velocity))));
+  steam::se3::SteamTrajVar::Ptr knot2(new steam::se3::SteamTrajVar(steam::Time(0.1),
+      makeTransformEval(1.1), steam::VectorSpaceStateVar::Ptr(
+          new steam::VectorSpaceStateVar(velocity))));
+  return steam::se3::SteamTrajPoseInterpEval::MakeShared(steam::Time(0.04), knot1, knot2);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate an interpolated trajectory pose
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation trajInterpEvaluate(unsigned int) {
+  steam::se3::SteamTrajPoseInterpEval::Ptr eval = makeInterpEval();
+  return [eval]() {
+    steam::bench::doNotOptimize(eval->evaluate());
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate an interpolated trajectory pose and its Jacobians (two poses and two
+///        velocities)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation trajInterpJacobians(unsigned int) {
+  steam::se3::SteamTrajPoseInterpEval::Ptr eval = makeInterpEval();
+  return [eval]() {
+    steam::EvalTreeHandle<lgmath::se3::Transformation> tree = eval->getBlockAutomaticEvaluation();
+    std::vector<steam::Jacobian<6,6> > jacs;
+    eval->appendBlockAutomaticJacobians(Eigen::Matrix<double,6,6>::Identity(),
+                                        tree.getRoot(), &jacs);
+    steam::bench::doNotOptimize(jacs);
+  };
+}
+
+steam::bench::Registration reg1("evaluator/ComposeTransform/evaluate", false,
+                                &composeTransformEvaluate);
+steam::bench::Registration reg2("evaluator/ComposeTransform/jacobians", false,
+                                &composeTransformJacobians);
+steam::bench::Registration reg3("evaluator/ComposeLandmark/evaluate", false,
+                                &composeLandmarkEvaluate);
+steam::bench::Registration reg4("evaluator/ComposeLandmark/jacobians", false,
+                                &composeLandmarkJacobians);
+steam::bench::Registration reg5("evaluator/StereoCameraError/evaluate", false,
+                                &stereoErrorEvaluate);
+steam::bench::Registration reg6("evaluator/StereoCameraError/jacobians", false,
+                                &stereoErrorJacobians);
+steam::bench::Registration reg7("evaluator/SteamTrajPoseInterp/evaluate", false,
+                                &trajInterpEvaluate);
+steam::bench::Registration reg8("evaluator/SteamTrajPoseInterp/jacobians", false,
+                                &trajInterpJacobians);
+
+} // namespace
@@ -0,0 +1,156 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file main.cpp
+/// \brief Runs the steam microbenchmarks and prints ns/op, allocations/op and thread scaling
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <omp.h>
+
+#include <steam/common/MemoryUsage.hpp>
+
+#include "Benchmark.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Print the usage
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void printUsage() {
+  std::cout << "Usage: steam_benchmarks [options] [filter ...]" << std::endl << std::endl
+            << "  filter            run the benchmarks whose name contains a filter" << std::endl
+            << "  --list            list the benchmarks and exit" << std::endl
+            << "  --threads=1,2,4   thread counts of the threaded benchmarks" << std::endl
+            << "  --min-time=0.2    minimum measured seconds per result" << std::endl
+            << "  --data=DIR        directory of the datasets" << std::endl
+            << "  --csv             print comma-separated values" << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a comma-separated list of thread counts
+//////////////////////////////////////////////////////////////////////////////////////////////
+static std::vector<unsigned int> parseThreadCounts(const std::string& list) {
+  std::vector<unsigned int> counts;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    const int count = atoi(item.c_str());
+    if (count < 1) {
+      throw std::invalid_argument("invalid thread count: " + item);
+    }
+    counts.push_back(count);
+  }
+  return counts;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Runs the benchmarks
+//////////////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+
+  // Parse the options
+  steam::bench::Options options;
+  bool list = false;
+  bool csv = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg == "--list") {
+        list = true;
+      } else if (arg == "--csv") {
+        csv = true;
+      } else if (arg.compare(0, 10, "--threads=") == 0) {
+        options.threadCounts = parseThreadCounts(arg.substr(10));
+      } else if (arg.compare(0, 11, "--min-time=") == 0) {
+        options.minSeconds = atof(arg.c_str() + 11);
+      } else if (arg.compare(0, 7, "--data=") == 0) {
+        steam::bench::setDataDirectory(arg.substr(7));
+      } else if (arg.compare(0, 1, "-") == 0) {
+        printUsage();
+        return arg == "--help" || arg == "-h" ? 0 : 1;
+      } else {
+        options.filters.push_back(arg);
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  // Let the solvers report the allocations of each iteration
+  steam::setAllocationCounter(&steam::bench::allocationCount);
+
+  // Default thread counts: 1, 2, 4, ... up to the number of cores
+  if (options.threadCounts.empty()) {
+    const unsigned int numProcs = omp_get_num_procs();
+    for (unsigned int count = 1; count < numProcs; count *= 2) {
+      options.threadCounts.push_back(count);
+    }
+    options.threadCounts.push_back(numProcs);
+  }
+
+  // Select the benchmarks
+  std::vector<steam::bench::Benchmark> benchmarks;
+  std::vector<steam::bench::Benchmark> all = steam::bench::getBenchmarks();
+  for (unsigned int i = 0; i < all.size(); i++) {
+    bool selected = options.filters.empty();
+    for (unsigned int f = 0; f < options.filters.size(); f++) {
+      selected = selected || all[i].name.find(options.filters[f]) != std::string::npos;
+    }
+    if (selected) {
+      benchmarks.push_back(all[i]);
+    }
+  }
+  if (list) {
+    for (unsigned int i = 0; i < benchmarks.size(); i++) {
+      std::cout << benchmarks[i].name << (benchmarks[i].threaded ? " (threaded)" : "")
+                << std::endl;
+    }
+    return 0;
+  }
+
+  // Run them, the speedup is relative to the first thread count
+  if (csv) {
+    printf("benchmark,threads,iterations,ns_per_op,allocs_per_op,speedup\n");
+  } else {
+    printf("%-48s %7s %11s %15s %11s %8s\n", "benchmark", "threads", "iterations", "ns/op",
+           "allocs/op", "speedup");
+  }
+  int status = 0;
+  for (unsigned int i = 0; i < benchmarks.size(); i++) {
+    std::vector<unsigned int> counts(1, 1);
+    if (benchmarks[i].threaded) {
+      counts = options.threadCounts;
+    }
+    double baseNsPerOp = 0.0;
+    for (unsigned int t = 0; t < counts.size(); t++) {
+      steam::bench::Result result;
+      try {
+        result = steam::bench::run(benchmarks[i], counts[t], options);
+      } catch (const std::exception& e) {
+        std::cerr << benchmarks[i].name << ": skipped (" << e.what() << ")" << std::endl;
+        status = 1;
+        break;
+      }
+      if (t == 0) {
+        baseNsPerOp = result.nsPerOp;
+      }
+      const double speedup = baseNsPerOp/result.nsPerOp;
+      if (csv) {
+        printf("%s,%u,%llu,%.1f,%.2f,%.3f\n", result.name.c_str(), result.numThreads,
+               result.iterations, result.nsPerOp, result.allocsPerOp, speedup);
+      } else {
+        printf("%-48s %7u %11llu %15.1f %11.2f %7.2fx\n", result.name.c_str(),
+               result.numThreads, result.iterations, result.nsPerOp, result.allocsPerOp,
+               speedup);
+      }
+      fflush(stdout);
+    }
+  }
+  return status;
+}
@@ -0,0 +1,374 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file perf_test.cpp
+/// \brief Performance regression tests, run by ctest (label 'perf'). Fixed-seed synthetic
+///        problems are solved on one thread; the iteration counts and final costs must match
+///        the stored baselines (determinism). The wall time and heap allocations of the solves
+///        are compared to tolerances of the baselines as well, but since they depend on the
+///        machine and build, exceeding them is only reported, unless the comparison is made
+///        strict with --strict or the environment variable STEAM_PERF_STRICT=1.
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include <omp.h>
+
+#include <lgmath.hpp>
+#include <steam.hpp>
+#include <steam/data/SyntheticProblems.hpp>
+
+#include "Benchmark.hpp"
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Outcome of a solve (or the baseline of a case)
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Measurement {
+  Measurement() : iterations(0), cost(0.0), ms(0.0), allocations(0) {}
+
+  unsigned int iterations;
+  double cost;
+  double ms;
+  unsigned long long allocations;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief A regression case: builds its problem and solves it (only the solve is measured)
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Case {
+  std::string name;
+  std::function<Measurement()> solve;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Options of the runner
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct Options {
+  Options() : update(false), strict(false), repetitions(5), timeTolerance(3.0),
+               allocTolerance(0.1), costTolerance(1e-6) {
+    const char* env = getenv("STEAM_PERF_STRICT");
+    strict = env && atoi(env) != 0;
+#ifdef STEAM_PERF_BASELINES
+    baselines = STEAM_PERF_BASELINES;
+#else
+    baselines = "perf_baselines.txt";
+#endif
+  }
+
+  /// \brief Baselines file, and whether to overwrite it with the measurements
+  std::string baselines;
+  bool update;
+
+  /// \brief Whether exceeding the time and allocation tolerances fails the test
+  bool strict;
+
+  /// \brief Solves per case (the fastest and least allocating are compared)
+  unsigned int repetitions;
+
+  /// \brief Maximum ratio of the time to its baseline, maximum relative increase of the
+  ///        allocations, and maximum relative difference of the final cost
+  double timeTolerance;
+  double allocTolerance;
+  double costTolerance;
+
+  /// \brief Cases whose name contains one of the filters are run (all, if empty)
+  std::vector<std::string> filters;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Solve a problem to convergence, and measure the solve
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename SolverType>
+Measurement solve(steam::OptimizationProblem* problem) {
+  typename SolverType::Params params;
+  params.maxIterations = 100;
+
+  const unsigned long long allocsBefore = steam::bench::allocationCount();
+  steam::Timer timer;
+  SolverType solver(problem, params);
+  solver.optimize();
+
+  Measurement result;
+  result.ms = timer.milliseconds();
+  result.allocations = steam::bench::allocationCount() - allocsBefore;
+  result.iterations = solver.getCurrIteration();
+  result.cost = solver.getLastIterationReport().cost;
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Pose graph of 400 poses (8 laps) with loop closures, solved with dogleg
+//////////////////////////////////////////////////////////////////////////////////////////////
+Measurement poseGraphDogleg() {
+  static steam::data::G2oSe3Dataset dataset;
+  if (dataset.vertices.empty()) {
+    steam::data::PoseGraphParams params;
+    params.numPoses = 400;
+    params.posesPerLap = 50;
+    params.seed = 1;
+    dataset = steam::data::generatePoseGraph(params);
+  }
+  steam::OptimizationProblem problem;
+  steam::data::buildG2oSe3Problem(dataset, steam::L2LossFunc::Ptr(new steam::L2LossFunc()),
+                                  1).addToProblem(&problem);
+  return solve<steam::DoglegGaussNewtonSolver>(&problem);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Stereo bundle adjustment of 30 frames and 300 landmarks with outliers, solved with
+///        Levenberg-Marquardt and a Cauchy loss
+//////////////////////////////////////////////////////////////////////////////////////////////
+Measurement stereoBaLevMarq() {
+  static steam::data::SimpleBaDataset dataset;
+  if (dataset.meas.empty()) {
+    steam::data::StereoBaParams params;
+    params.numFrames = 30;
+    params.numLandmarks = 300;
+    params.trackLength = 8;
+    params.outlierRatio = 0.02;
+    params.seed = 2;
+    dataset = steam::data::generateStereoBa(params);
+  }
+  steam::OptimizationProblem problem;
+  steam::data::buildSimpleBaProblem(dataset, steam::CauchyLossFunc::Ptr(
+      new steam::CauchyLossFunc(2.0)), 1).addToProblem(&problem);
+  return solve<steam::LevMarqGaussNewtonSolver>(&problem);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Continuous-time stereo problem of 20 knots and 150 landmarks, measured between the
+///        knots, solved with line search
+//////////////////////////////////////////////////////////////////////////////////////////////
+Measurement trajectoryLineSearch() {
+  static steam::data::SimpleBaDataset dataset;
+  if (dataset.meas.empty()) {
+    steam::data::StereoBaParams params;
+    params.numFrames = 20;
+    params.numLandmarks = 150;
+    params.trackLength = 6;
+    params.measTimesPerFrame = 2;
+    params.seed = 3;
+    dataset = steam::data::generateStereoBa(params);
+  }
+  Eigen::Matrix<double,6,1> Qc_diag;
+  Qc_diag << 1.0, 0.01, 0.01, 0.01, 0.01, 1.0;
+  Eigen::Matrix<double,6,6> Qc_inv = Qc_diag.cwiseInverse().asDiagonal();
+  steam::OptimizationProblem problem;
+  steam::data::buildSimpleBaTrajectoryProblem(dataset, Qc_inv,
+      steam::L2LossFunc::Ptr(new steam::L2LossFunc()), 1).addToProblem(&problem);
+  return solve<steam::LineSearchGaussNewtonSolver>(&problem);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Read the baselines file (a missing file has no baselines)
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::map<std::string, Measurement> readBaselines(const std::string& file) {
+  std::map<std::string, Measurement> baselines;
+  std::ifstream in(file.c_str());
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::stringstream ss(line);
+    std::string name;
+    Measurement baseline;
+    if (!(ss >> name >> baseline.iterations >> baseline.cost >> baseline.ms
+             >> baseline.allocations)) {
+      throw std::runtime_error("invalid baseline in " + file + ": " + line);
+    }
+    baselines[name] = baseline;
+  }
+  return baselines;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write the baselines file
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeBaselines(const std::string& file,
+                    const std::map<std::string, Measurement>& baselines) {
+  FILE* out = fopen(file.c_str(), "w");
+  if (out == NULL) {
+    throw std::runtime_error("cannot write " + file);
+  }
+  fprintf(out, "# Baselines of steam_perf_tests (regenerate with --update on the reference\n"
+               "# build). Iterations and final costs must match; times and allocations are\n"
+               "# machine dependent and only fail the test with --strict (STEAM_PERF_STRICT=1).\n"
+               "# name iterations final_cost ms allocations\n");
+  for (std::map<std::string, Measurement>::const_iterator it = baselines.begin();
+       it != baselines.end(); ++it) {
+    fprintf(out, "%s %u %.12e %.3f %llu\n", it->first.c_str(), it->second.iterations,
+            it->second.cost, it->second.ms, it->second.allocations);
+  }
+  fclose(out);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Print the usage
+//////////////////////////////////////////////////////////////////////////////////////////////
+void printUsage() {
+  std::cout << "Usage: steam_perf_tests [options] [filter ...]" << std::endl << std::endl
+            << "  filter                run the cases whose name contains a filter" << std::endl
+            << "  --baselines=FILE      baselines file" << std::endl
+            << "  --update              overwrite the baselines with the measurements"
+            << std::endl
+            << "  --strict              fail when a time or allocation tolerance is exceeded"
+            << std::endl
+            << "                        (also set by STEAM_PERF_STRICT=1)" << std::endl
+            << "  --repetitions=5       solves per case" << std::endl
+            << "  --time-tolerance=3    maximum ratio of the time to its baseline" << std::endl
+            << "  --alloc-tolerance=0.1 maximum relative increase of the allocations"
+            << std::endl
+            << "  --cost-tolerance=1e-6 maximum relative difference of the final cost"
+            << std::endl;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Runs the performance regression tests, returns non-zero if any fails
+//////////////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+
+  // Parse the options
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--update") {
+      options.update = true;
+    } else if (arg == "--strict") {
+      options.strict = true;
+    } else if (arg.compare(0, 12, "--baselines=") == 0) {
+      options.baselines = arg.substr(12);
+    } else if (arg.compare(0, 14, "--repetitions=") == 0) {
+      options.repetitions = std::max(1, atoi(arg.c_str() + 14));
+    } else if (arg.compare(0, 17, "--time-tolerance=") == 0) {
+      options.timeTolerance = atof(arg.c_str() + 17);
+    } else if (arg.compare(0, 18, "--alloc-tolerance=") == 0) {
+      options.allocTolerance = atof(arg.c_str() + 18);
+    } else if (arg.compare(0, 17, "--cost-tolerance=") == 0) {
+      options.costTolerance = atof(arg.c_str() + 17);
+    } else if (arg.compare(0, 1, "-") == 0) {
+      printUsage();
+      return arg == "--help" || arg == "-h" ? 0 : 1;
+    } else {
+      options.filters.push_back(arg);
+    }
+  }
+
+  // One thread, so that the allocations (and the order of the reductions) are deterministic
+  omp_set_num_threads(1);
+
+  std::vector<Case> cases;
+  Case poseGraph = {"posegraph/dogleg", &poseGraphDogleg};
+  Case stereoBa = {"stereo_ba/levmarq", &stereoBaLevMarq};
+  Case trajectory = {"trajectory/linesearch", &trajectoryLineSearch};
+  cases.push_back(poseGraph);
+  cases.push_back(stereoBa);
+  cases.push_back(trajectory);
+
+  std::map<std::string, Measurement> baselines;
+  try {
+    baselines = readBaselines(options.baselines);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  printf("%-24s %5s %20s %12s %12s %14s %14s  %s\n", "case", "iters", "final cost", "ms",
+         "baseline ms", "allocations", "baseline", "status");
+  int status = 0;
+  for (unsigned int i = 0; i < cases.size(); i++) {
+    bool selected = options.filters.empty();
+    for (unsigned int f = 0; f < options.filters.size(); f++) {
+      selected = selected || cases[i].name.find(options.filters[f]) != std::string::npos;
+    }
+    if (!selected) {
+      continue;
+    }
+
+    // Solve repeatedly, the iterations and cost must not change between repetitions
+    std::vector<std::string> failures;
+    std::vector<std::string> warnings;
+    Measurement best;
+    try {
+      for (unsigned int r = 0; r < options.repetitions; r++) {
+        const Measurement result = cases[i].solve();
+        if (r == 0) {
+          best = result;
+        } else if (result.iterations != best.iterations || result.cost != best.cost) {
+          failures.push_back("not deterministic between repetitions");
+        }
+        best.ms = std::min(best.ms, result.ms);
+        best.allocations = std::min(best.allocations, result.allocations);
+      }
+    } catch (const std::exception& e) {
+      failures.push_back(std::string("solve failed (") + e.what() + ")");
+    }
+
+    // Compare to the baseline
+    std::map<std::string, Measurement>::const_iterator it = baselines.find(cases[i].name);
+    Measurement baseline;
+    if (options.update) {
+      baselines[cases[i].name] = best;
+    } else if (it == baselines.end()) {
+      failures.push_back("no baseline (run with --update)");
+    } else {
+      baseline = it->second;
+      std::stringstream ss;
+      if (best.iterations != baseline.iterations) {
+        ss << "iterations " << best.iterations << " != " << baseline.iterations;
+        failures.push_back(ss.str());
+      }
+      if (std::fabs(best.cost - baseline.cost) >
+          options.costTolerance*std::max(std::fabs(baseline.cost), 1.0)) {
+        failures.push_back("final cost differs from the baseline");
+      }
+
+      // Machine dependent, only reported unless strict
+      std::vector<std::string>& exceeded = options.strict ? failures : warnings;
+      if (best.ms > options.timeTolerance*baseline.ms) {
+        exceeded.push_back("slower than the baseline");
+      }
+      if (best.allocations > (1.0 + options.allocTolerance)*baseline.allocations) {
+        exceeded.push_back("more allocations than the baseline");
+      }
+    }
+
+    const bool failed = !failures.empty();
+    std::string result = failed ? "FAILED" : !warnings.empty() ? "warning" :
+                         options.update ? "updated" : "ok";
+    failures.insert(failures.end(), warnings.begin(), warnings.end());
+    for (unsigned int f = 0; f < failures.size(); f++) {
+      result += (f == 0 ? ": " : ", ") + failures[f];
+    }
+    printf("%-24s %5u %20.12e %12.3f %12.3f %14llu %14llu  %s\n", cases[i].name.c_str(),
+           best.iterations, best.cost, best.ms, baseline.ms, best.allocations,
+           baseline.allocations, result.c_str());
+    fflush(stdout);
+    if (failed) {
+      status = 1;
+    }
+  }
+
+  if (options.update) {
+    try {
+      writeBaselines(options.baselines, baselines);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return status;
+}
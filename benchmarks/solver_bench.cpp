@@ -0,0 +1,209 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file solver_bench.cpp
+/// \brief Benchmarks of the Gauss-Newton system assembly and factorization, and end-to-end
+///        solves of the sphere2500 pose graph and the stereo_dataset3 bundle adjustment
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.hpp"
+
+#include <stdexcept>
+
+#include <Eigen/SparseCholesky>
+
+#include <lgmath.hpp>
+#include <steam.hpp>
+#include <steam/data/ParseBA.hpp>
+#include <steam/data/ParseSphere.hpp>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief An optimization problem, with a backup of its initial condition
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct ProblemFixture {
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Build the state vector of the problem, and save its initial condition
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void initialize() {
+    const std::vector<steam::StateVariableBase::Ptr>& states = problem.getStateVariables();
+    for (unsigned int i = 0; i < states.size(); i++) {
+      stateVector.addStateVariable(states[i]);
+    }
+    stateVector.saveValues(&initialValues);
+  }
+
+  steam::OptimizationProblem problem;
+  steam::StateVector stateVector;
+  steam::StateVector::Snapshot initialValues;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief The sphere2500 pose graph (initialized from odometry, as SpherePoseGraphRelax)
+//////////////////////////////////////////////////////////////////////////////////////////////
+boost::shared_ptr<ProblemFixture> makeSphereProblem(unsigned int numThreads) {
+
+  // Parse once
+  static std::vector<steam::data::SphereEdge> edges;
+  if (edges.empty()) {
+    edges = steam::data::parseSphereDataset(steam::bench::dataFile("sphere2500.txt"));
+  }
+
+  // Poses from odometry, the first is locked
+  std::vector<steam::se3::TransformStateVar::Ptr> poses(1,
+      steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar()));
+  poses[0]->setLock(true);
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    if (edges[i].idA == poses.size() - 1 && edges[i].idB == poses.size()) {
+      poses.push_back(steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar(
+          edges[i].T_BA * poses.back()->getValue())));
+    }
+  }
+
+  // Relative pose cost terms
+  steam::ParallelizedCostTermCollection::Ptr costTerms(
+      new steam::ParallelizedCostTermCollection(numThreads));
+  steam::BaseNoiseModel<6>::Ptr sharedNoiseModel(
+      new steam::StaticNoiseModel<6>(edges[0].sqrtInformation, steam::SQRT_INFORMATION));
+  steam::L2LossFunc::Ptr sharedLossFunc(new steam::L2LossFunc());
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    steam::TransformErrorEval::Ptr errorfunc(new steam::TransformErrorEval(
+        edges[i].T_BA, poses[edges[i].idB], poses[edges[i].idA]));
+    costTerms->add(steam::WeightedLeastSqCostTerm<6,6>::Ptr(
+        new steam::WeightedLeastSqCostTerm<6,6>(errorfunc, sharedNoiseModel, sharedLossFunc)));
+  }
+
+  boost::shared_ptr<ProblemFixture> fixture(new ProblemFixture());
+  for (unsigned int i = 1; i < poses.size(); i++) {
+    fixture->problem.addStateVariable(poses[i]);
+  }
+  fixture->problem.addCostTerm(costTerms);
+  fixture->initialize();
+  return fixture;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief The stereo_dataset3 bundle adjustment with a trajectory prior, as
+///        SimpleBAandTrajPrior (some frames have no measurements, so the knots are needed)
+//////////////////////////////////////////////////////////////////////////////////////////////
+boost::shared_ptr<ProblemFixture> makeStereoProblem(unsigned int numThreads) {
+
+  // Parse once
+  static steam::data::SimpleBaDataset dataset;
+  if (dataset.meas.empty()) {
+    dataset = steam::data::parseSimpleBaDataset(steam::bench::dataFile("stereo_dataset3.txt"));
+  }
+
+  // Penalize accelerations, except forward and yaw
+  Eigen::Matrix<double,6,1> Qc_diag;
+  Qc_diag << 1.0, 0.01, 0.01, 0.01, 0.01, 1.0;
+  Eigen::Matrix<double,6,6> Qc_inv = Qc_diag.cwiseInverse().asDiagonal();
+
+  boost::shared_ptr<ProblemFixture> fixture(new ProblemFixture());
+  steam::data::buildSimpleBaTrajectoryProblem(dataset, Qc_inv,
+      steam::L2LossFunc::Ptr(new steam::L2LossFunc()), numThreads).addToProblem(
+          &fixture->problem);
+  fixture->initialize();
+  return fixture;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Assemble the Gauss-Newton system of sphere2500
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation sphereAssembly(unsigned int numThreads) {
+  boost::shared_ptr<ProblemFixture> fixture = makeSphereProblem(numThreads);
+  return [fixture]() {
+    Eigen::SparseMatrix<double> approximateHessian;
+    Eigen::VectorXd gradientVector;
+    fixture->problem.buildGaussNewtonTerms(fixture->stateVector, &approximateHessian,
+                                           &gradientVector);
+    steam::bench::doNotOptimize(gradientVector);
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Assemble the Gauss-Newton system of stereo_dataset3
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation stereoAssembly(unsigned int numThreads) {
+  boost::shared_ptr<ProblemFixture> fixture = makeStereoProblem(numThreads);
+  return [fixture]() {
+    Eigen::SparseMatrix<double> approximateHessian;
+    Eigen::VectorXd gradientVector;
+    fixture->problem.buildGaussNewtonTerms(fixture->stateVector, &approximateHessian,
+                                           &gradientVector);
+    steam::bench::doNotOptimize(gradientVector);
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Numerical factorization of an approximate Hessian (the symbolic analysis is done
+///        once, as in the solvers)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation factorize(const boost::shared_ptr<ProblemFixture>& fixture) {
+  boost::shared_ptr<Eigen::SparseMatrix<double> > approximateHessian(
+      new Eigen::SparseMatrix<double>());
+  Eigen::VectorXd gradientVector;
+  fixture->problem.buildGaussNewtonTerms(fixture->stateVector, approximateHessian.get(),
+                                         &gradientVector);
+  typedef Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Upper> SolverType;
+  boost::shared_ptr<SolverType> solver(new SolverType());
+  solver->analyzePattern(*approximateHessian);
+  return [approximateHessian, solver]() {
+    solver->factorize(*approximateHessian);
+    if (solver->info() != Eigen::Success) {
+      throw std::runtime_error("factorization failed");
+    }
+  };
+}
+
+steam::bench::Operation sphereFactorize(unsigned int) {
+  return factorize(makeSphereProblem(1));
+}
+
+steam::bench::Operation stereoFactorize(unsigned int) {
+  return factorize(makeStereoProblem(1));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Solve sphere2500 from odometry (a fixed number of dogleg iterations)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation sphereSolve(unsigned int numThreads) {
+  boost::shared_ptr<ProblemFixture> fixture = makeSphereProblem(numThreads);
+  return [fixture]() {
+    fixture->stateVector.restoreValues(fixture->initialValues);
+    steam::DoglegGaussNewtonSolver::Params params;
+    params.maxIterations = 5;
+    params.absoluteCostChangeThreshold = 0.0;
+    params.relativeCostChangeThreshold = 0.0;
+    steam::DoglegGaussNewtonSolver solver(&fixture->problem, params);
+    solver.optimize();
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Solve stereo_dataset3 from its initial condition (a fixed number of
+///        Levenberg-Marquardt iterations)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation stereoSolve(unsigned int numThreads) {
+  boost::shared_ptr<ProblemFixture> fixture = makeStereoProblem(numThreads);
+  return [fixture]() {
+    fixture->stateVector.restoreValues(fixture->initialValues);
+    steam::LevMarqGaussNewtonSolver::Params params;
+    params.maxIterations = 5;
+    params.absoluteCostChangeThreshold = 0.0;
+    params.relativeCostChangeThreshold = 0.0;
+    steam::LevMarqGaussNewtonSolver solver(&fixture->problem, params);
+    solver.optimize();
+  };
+}
+
+steam::bench::Registration reg1("solver/assembly/sphere2500", true, &sphereAssembly);
+steam::bench::Registration reg2("solver/assembly/stereo_dataset3", true, &stereoAssembly);
+steam::bench::Registration reg3("solver/factorize/sphere2500", false, &sphereFactorize);
+steam::bench::Registration reg4("solver/factorize/stereo_dataset3", false, &stereoFactorize);
+steam::bench::Registration reg5("solver/solve/sphere2500", true, &sphereSolve);
+steam::bench::Registration reg6("solver/solve/stereo_dataset3", true, &stereoSolve);
+
+} // namespace
@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file state_bench.cpp
+/// \brief Benchmarks of the state vector operations made at every solver iteration
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.hpp"
+
+#include <lgmath.hpp>
+#include <steam.hpp>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief A state vector of poses and landmarks, in the proportions of a bundle adjustment
+//////////////////////////////////////////////////////////////////////////////////////////////
+boost::shared_ptr<steam::StateVector> makeStateVector() {
+  boost::shared_ptr<steam::StateVector> stateVector(new steam::StateVector());
+  for (unsigned int i = 0; i < 1000; i++) {
+    Eigen::Matrix<double,6,1> xi;
+    xi << 0.5*i, 0.1, 0.0, 0.0, 0.0, 0.01*i;
+    stateVector->addStateVariable(steam::se3::TransformStateVar::Ptr(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi))));
+  }
+  for (unsigned int i = 0; i < 5000; i++) {
+    stateVector->addStateVariable(steam::se3::LandmarkStateVar::Ptr(
+        new steam::se3::LandmarkStateVar(Eigen::Vector3d(0.1*i, 1.0, 10.0))));
+  }
+  return stateVector;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Apply a perturbation to every state (alternating in sign, so that the states stay
+///        bounded)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation stateVectorUpdate(unsigned int) {
+  boost::shared_ptr<steam::StateVector> stateVector = makeStateVector();
+  unsigned int size = 0;
+  for (unsigned int i = 0; i < stateVector->getStateBlockSizes().size(); i++) {
+    size += stateVector->getStateBlockSizes()[i];
+  }
+  Eigen::VectorXd perturbation = Eigen::VectorXd::Constant(size, 1e-3);
+  return [stateVector, perturbation]() mutable {
+    stateVector->update(perturbation);
+    perturbation = -perturbation;
+  };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Copy the values of a deep copy back into a state vector (the solver backup path)
+//////////////////////////////////////////////////////////////////////////////////////////////
+steam::bench::Operation stateVectorCopyValues(unsigned int) {
+  boost::shared_ptr<steam::StateVector> stateVector = makeStateVector();
+  boost::shared_ptr<steam::StateVector> backup(new steam::StateVector(*stateVector));
+  return [stateVector, backup]() {
+    stateVector->copyValues(*backup);
+  };
+}
+
+steam::bench::Registration reg1("state/StateVector/update", true, &stateVectorUpdate);
+steam::bench::Registration reg2("state/StateVector/copyValues", false, &stateVectorCopyValues);
+
+} // namespace
@@ -16,6 +16,7 @@
 // common
 #include <steam/common/Time.hpp>
 #include <steam/common/Timer.hpp>
+#include <steam/common/MemoryUsage.hpp>
 
 // evaluator
 #include <steam/evaluator/ErrorEvaluator.hpp>
@@ -31,6 +32,7 @@
 // evaluator - samples (sample functions)
 #include <steam/evaluator/samples/StereoCameraErrorEval.hpp>
 #include <steam/evaluator/samples/StereoCameraErrorEvalX.hpp>
+#include <steam/evaluator/samples/MonoCameraErrorEval.hpp>
 #include <steam/evaluator/samples/TransformErrorEval.hpp>
 #include <steam/evaluator/samples/PositionErrorEval.hpp>
 #include <steam/evaluator/samples/VectorSpaceErrorEval.hpp>
@@ -41,9 +43,11 @@
 // problem
 #include <steam/problem/WeightedLeastSqCostTerm.hpp>
 #include <steam/problem/ParallelizedCostTermCollection.hpp>
+#include <steam/problem/CostTermProfiler.hpp>
 #include <steam/problem/NoiseModel.hpp>
 #include <steam/problem/LossFunctions.hpp>
 #include <steam/problem/OptimizationProblem.hpp>
+#include <steam/problem/CostTermIngestor.hpp>
 
 // solver
 #include <steam/solver/VanillaGaussNewtonSolver.hpp>
@@ -114,6 +114,12 @@ class BlockSparseMatrix : public BlockMatrixBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   Eigen::SparseMatrix<double> toEigen(bool getSubBlockSparsity = false) const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the approximate number of bytes held by the matrix (block data, map nodes and
+  ///        the OpenMP locks of the columns and entries)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::size_t getMemoryUsage() const;
+
  private:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
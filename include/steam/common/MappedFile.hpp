@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file MappedFile.hpp
+/// \brief Read-only memory-mapped view of a file
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_MAPPED_FILE_HPP
+#define STEAM_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace steam {
+namespace parse {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Read-only, memory-mapped view of an entire file. The contents can be tokenized
+///        in place (see ParseUtils.hpp), without copying lines or fields into strings.
+///        Note that the contents are NOT null-terminated.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+ public:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor, maps the file (throws std::invalid_argument if it cannot be opened)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  explicit MappedFile(const std::string& fileName);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Destructor, unmaps the file
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  ~MappedFile();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the start of the file contents (NULL for an empty file)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const char* data() const { return data_; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the size of the file in bytes
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::size_t size() const { return size_; }
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Not copyable
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Mapped contents and size
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const char* data_;
+  std::size_t size_;
+};
+
+} // parse
+} // steam
+
+#endif // STEAM_MAPPED_FILE_HPP
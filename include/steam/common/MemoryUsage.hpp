@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file MemoryUsage.hpp
+/// \brief Memory accounting of the solver pipeline (bytes per subsystem, allocation counts
+///        and the peak resident memory of the process)
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_MEMORY_USAGE_HPP
+#define STEAM_MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <iostream>
+
+#include <Eigen/Sparse>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes held by each subsystem of the solver pipeline. The sizes are computed from the
+///        container sizes (with typical node overheads), they do not include the allocator's
+///        own bookkeeping.
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct MemoryUsage
+{
+  MemoryUsage() : blockHessian(0), sparseHessian(0), choleskyFactor(0), stateVector(0),
+                  stateBackup(0), evaluatorPools(0) {}
+
+  /// Block-sparse approximate Hessian used during assembly (blocks, map nodes and the OpenMP
+  /// locks of every block)
+  std::size_t blockHessian;
+
+  /// Compressed Eigen copy of the approximate Hessian
+  std::size_t sparseHessian;
+
+  /// Cholesky factor, fill-reducing permutation and elimination tree (known from the symbolic
+  /// analysis, before the numerical factorization)
+  std::size_t choleskyFactor;
+
+  /// Index of the state vector (the states themselves belong to the problem)
+  std::size_t stateVector;
+
+  /// Backup of the state values made before proposed updates
+  std::size_t stateBackup;
+
+  /// Evaluation-tree node pools of all threads (process wide)
+  std::size_t evaluatorPools;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Total bytes
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::size_t total() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Keep the larger of each subsystem's bytes
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void updateMax(const MemoryUsage& other);
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Print the bytes of each subsystem
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::ostream& operator<<(std::ostream& out, const MemoryUsage& usage);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes of a compressed sparse matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t getMemoryUsage(const Eigen::SparseMatrix<double>& matrix);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Record the allocation (positive) or release (negative) of evaluator pool memory
+//////////////////////////////////////////////////////////////////////////////////////////////
+void recordPoolMemory(std::ptrdiff_t bytes);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes currently held by the evaluator pools
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t getPoolMemoryUsage();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Function that returns the number of heap allocations made by the process so far.
+///        The library does not replace the allocator; an application (or benchmark) that counts
+///        its allocations can install a counter so that the solvers report them per iteration.
+//////////////////////////////////////////////////////////////////////////////////////////////
+typedef unsigned long long (*AllocationCounter)();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Install the allocation counter (NULL to remove it)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void setAllocationCounter(AllocationCounter counter);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Number of heap allocations made so far, according to the installed counter (always
+///        zero if there is none)
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long long getAllocationCount();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Peak resident memory of the process in bytes (zero if it is not available)
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t getPeakResidentMemory();
+
+} // steam
+
+#endif // STEAM_MEMORY_USAGE_HPP
@@ -9,10 +9,15 @@
 #define STEAM_PARSE_UTILS_HPP
 
 #include <stdlib.h>
+#include <string.h>
 #include <vector>
+#include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <exception>
+#include <algorithm>
 
 namespace steam {
 namespace parse {
@@ -92,6 +97,345 @@ static void writeData(const std::string& fileName,
   outFileStream.close();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a floating-point field in place (the field is not null-terminated). Numbers
+///        with at most 19 significant digits and a decimal exponent of magnitude at most 22
+///        are converted exactly with a single multiplication or division (Clinger's fast
+///        path), which gives the same result as strtod; anything else falls back to strtod.
+///        Throws std::invalid_argument if the field is not entirely a number.
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline double parseDouble(const char* begin, const char* end) {
+
+  // Exactly representable powers of ten
+  static const double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                 1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  // Parse sign, decimal digits and exponent
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-'); ++p;
+  }
+  unsigned long long mantissa = 0;
+  int numDigits = 0;      // significant digits in mantissa
+  int numParsed = 0;      // all parsed digits
+  int exponent = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p, ++numParsed) {
+    mantissa = 10*mantissa + (*p - '0');
+    numDigits += (mantissa != 0);
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++numParsed) {
+      mantissa = 10*mantissa + (*p - '0');
+      numDigits += (mantissa != 0);
+      --exponent;
+    }
+  }
+  if (numParsed > 0 && p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negativeExp = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negativeExp = (*p == '-'); ++p;
+    }
+    int exp = 0;
+    const char* expBegin = p;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+      exp = exp < 10000 ? 10*exp + (*p - '0') : exp;
+    }
+    exponent += (p == expBegin) ? 100000 : (negativeExp ? -exp : exp); // missing digits, use slow path
+  }
+
+  // Fast path
+  if (p == end && numParsed > 0 && numDigits <= 19 && mantissa <= (1ull << 53) &&
+      exponent >= -22 && exponent <= 22) {
+    double value = double(mantissa);
+    value = exponent < 0 ? value/pow10[-exponent] : value*pow10[exponent];
+    return negative ? -value : value;
+  }
+
+  // Slow path (long mantissa, large exponent, inf/nan, or malformed field)
+  const std::string field(begin, end);
+  char* fieldEnd = NULL;
+  double value = strtod(field.c_str(), &fieldEnd);
+  if (field.empty() || fieldEnd != field.c_str() + field.size()) {
+    throw std::invalid_argument("could not parse '" + field + "' as a floating-point number");
+  }
+  return value;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse an integer field in place (the field is not null-terminated). Throws
+///        std::invalid_argument if the field is not entirely an integer.
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline long parseInt(const char* begin, const char* end) {
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-'); ++p;
+  }
+  long value = 0;
+  const char* digits = p;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    value = 10*value + (*p - '0');
+  }
+  if (p == digits || p != end) {
+    throw std::invalid_argument("could not parse '" + std::string(begin, end) + "' as an integer");
+  }
+  return negative ? -value : value;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Check whether a field (not null-terminated) is equal to a string literal
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline bool fieldEquals(const char* begin, const char* end, const char* literal) {
+  const size_t length = strlen(literal);
+  return size_t(end - begin) == length && memcmp(begin, literal, length) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the next line from a buffer, without the line ending ('\n' or "\r\n").
+///        Advances 'pos' past the line, returns false once 'pos' reaches 'end'.
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline bool nextLine(const char** pos, const char* end,
+                     const char** lineBegin, const char** lineEnd) {
+  if (*pos >= end) {
+    return false;
+  }
+  *lineBegin = *pos;
+  const char* newline = static_cast<const char*>(memchr(*pos, '\n', end - *pos));
+  *lineEnd = newline ? newline : end;
+  *pos = newline ? newline + 1 : end;
+  if (*lineEnd > *lineBegin && *(*lineEnd - 1) == '\r') {
+    --(*lineEnd);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Count the delimited fields of a line (a trailing delimiter does not start a new
+///        field, matching loadData)
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline unsigned int countFields(const char* begin, const char* end, char delim) {
+  if (begin == end) {
+    return 0;
+  }
+  unsigned int count = 1;
+  for (const char* p = begin; p < end - 1; ++p) {
+    count += (*p == delim);
+  }
+  return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Narrow a field (not null-terminated) to exclude leading and trailing spaces and tabs
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline void trimBlanks(const char** begin, const char** end) {
+  while (*begin < *end && (**begin == ' ' || **begin == '\t')) {
+    ++(*begin);
+  }
+  while (*end > *begin && (*(*end - 1) == ' ' || *(*end - 1) == '\t')) {
+    --(*end);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Zero-copy cursor over the delimited fields of a single line
+//////////////////////////////////////////////////////////////////////////////////////////////
+class FieldCursor
+{
+ public:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  FieldCursor(const char* lineBegin, const char* lineEnd, char delim)
+    : pos_(lineBegin), end_(lineEnd), delim_(delim), done_(lineBegin == lineEnd) {}
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether there are fields remaining
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool hasNext() const { return !done_; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the next field (throws std::out_of_range if there are no fields remaining)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void next(const char** fieldBegin, const char** fieldEnd) {
+    if (done_) {
+      throw std::out_of_range("line has fewer fields than expected");
+    }
+    const char* delim = static_cast<const char*>(memchr(pos_, delim_, end_ - pos_));
+    *fieldBegin = pos_;
+    *fieldEnd = delim ? delim : end_;
+    pos_ = delim ? delim + 1 : end_;
+    done_ = (pos_ == end_);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Parse the next field as a floating-point number (surrounding spaces and tabs are
+  ///        ignored)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  double nextDouble() {
+    const char* begin; const char* end;
+    this->next(&begin, &end);
+    trimBlanks(&begin, &end);
+    return parseDouble(begin, end);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Parse the next field as an integer (surrounding spaces and tabs are ignored)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  long nextInt() {
+    const char* begin; const char* end;
+    this->next(&begin, &end);
+    trimBlanks(&begin, &end);
+    return parseInt(begin, end);
+  }
+
+ private:
+  const char* pos_;
+  const char* end_;
+  char delim_;
+  bool done_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Zero-copy cursor over whitespace separated tokens (runs of spaces, tabs and line
+///        endings separate tokens, as in the g2o and BAL formats)
+//////////////////////////////////////////////////////////////////////////////////////////////
+class TokenCursor
+{
+ public:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  TokenCursor(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether there are tokens remaining
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool hasNext() {
+    this->skipSpace();
+    return pos_ < end_;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the next token (throws std::out_of_range if there are no tokens remaining)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void next(const char** tokenBegin, const char** tokenEnd) {
+    if (!this->hasNext()) {
+      throw std::out_of_range("fewer tokens than expected");
+    }
+    *tokenBegin = pos_;
+    while (pos_ < end_ && !isSpace(*pos_)) {
+      ++pos_;
+    }
+    *tokenEnd = pos_;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Parse the next token as a floating-point number
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  double nextDouble() {
+    const char* begin; const char* end;
+    this->next(&begin, &end);
+    return parseDouble(begin, end);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Parse the next token as an integer
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  long nextInt() {
+    const char* begin; const char* end;
+    this->next(&begin, &end);
+    return parseInt(begin, end);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Position of the cursor (after the last token)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const char* position() const { return pos_; }
+
+ private:
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+  }
+  void skipSpace() {
+    while (pos_ < end_ && isSpace(*pos_)) {
+      ++pos_;
+    }
+  }
+  const char* pos_;
+  const char* end_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the position after the first numLines lines of a buffer (or the end of the
+///        buffer, if it has fewer lines)
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline const char* skipLines(const char* begin, const char* end, size_t numLines) {
+  const char* pos = begin;
+  for (size_t i = 0; i < numLines && pos < end; i++) {
+    const char* newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    pos = newline ? newline + 1 : end;
+  }
+  return pos;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Split a buffer into (at most) numChunks contiguous chunks that each start at the
+///        beginning of a line. Returns the numChunks+1 chunk boundaries (chunks may be empty).
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline std::vector<const char*> splitIntoLineChunks(const char* begin, const char* end,
+                                                    unsigned int numChunks) {
+  numChunks = numChunks > 0 ? numChunks : 1;
+  std::vector<const char*> bounds(numChunks + 1, end);
+  bounds[0] = begin;
+  for (unsigned int c = 1; c < numChunks; c++) {
+    const char* p = begin + (end - begin)*size_t(c)/numChunks;
+    p = p > bounds[c-1] ? p : bounds[c-1];
+    const char* newline = (p < end) ? static_cast<const char*>(memchr(p, '\n', end - p)) : NULL;
+    bounds[c] = newline ? newline + 1 : end;
+  }
+  return bounds;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a buffer of lines in parallel chunks. The buffer is split into line-aligned
+///        chunks of at least minChunkBytes (at most one per thread), and each chunk is
+///        parsed into its own partial result, in order. Exceptions thrown by the chunk parser
+///        are rethrown (for the first failing chunk) after all chunks are done.
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Result, typename Allocator>
+void parseLineChunks(const char* begin, const char* end, unsigned int numThreads,
+                     void (*parseChunk)(const char*, const char*, Result*),
+                     std::vector<Result, Allocator>* partials,
+                     size_t minChunkBytes = 1u << 20) {
+
+  size_t numChunks = size_t(end - begin)/(minChunkBytes > 0 ? minChunkBytes : 1);
+  numChunks = std::max<size_t>(1, std::min<size_t>(numChunks, std::max(1u, numThreads)));
+  std::vector<const char*> bounds = splitIntoLineChunks(begin, end, numChunks);
+
+  partials->clear();
+  partials->resize(numChunks);
+  std::vector<std::exception_ptr> errors(numChunks);
+  #pragma omp parallel for num_threads(numChunks) schedule(static,1)
+  for (int c = 0; c < int(numChunks); c++) {
+    try {
+      parseChunk(bounds[c], bounds[c+1], &partials->at(c));
+    } catch (...) {
+      errors[c] = std::current_exception();
+    }
+  }
+
+  for (size_t c = 0; c < numChunks; c++) {
+    if (errors[c]) {
+      std::rethrow_exception(errors[c]);
+    }
+  }
+}
+
 } // parse
 } // steam
 
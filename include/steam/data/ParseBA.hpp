@@ -14,6 +14,8 @@
 #include <Eigen/Core>
 #include <lgmath.hpp>
 #include <steam/evaluator/samples/StereoCameraErrorEval.hpp>
+#include <steam/problem/StereoCostTermCollection.hpp>
+#include <steam/common/MappedFile.hpp>
 
 namespace steam {
 namespace data {
@@ -73,9 +75,120 @@ struct SimpleBaDataset {
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Function that parses a simple BA dataset
+/// \brief Function that parses a simple BA dataset. The file is memory-mapped and tokenized
+///        in place; large files are split into line-aligned chunks that are parsed by up to
+///        numThreads threads.
 //////////////////////////////////////////////////////////////////////////////////////////////
-SimpleBaDataset parseSimpleBaDataset(const std::string& file);
+SimpleBaDataset parseSimpleBaDataset(const std::string& file, unsigned int numThreads = 1);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Incremental reader of a simple BA dataset, for streaming ingestion. The lines
+///        before the first measurement (frames, landmarks and calibration) are parsed on
+///        construction, and the stereo measurements are then parsed one at a time, straight
+///        from the memory-mapped file (they are never stored). All other lines must precede
+///        the measurements.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class SimpleBaStream
+{
+ public:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor, parses the lines before the first measurement
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  explicit SimpleBaStream(const std::string& file);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the dataset parsed from the lines before the first measurement (without
+  ///        measurements)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const SimpleBaDataset& getDataset() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Parse the next stereo measurement, returns false at the end of the file
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool next(SimpleBaDataset::StereoMeas* meas);
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Mapped file, and the position of the next line
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  steam::parse::MappedFile mapped_;
+  const char* pos_;
+  const char* end_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Frames, landmarks and calibration
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  SimpleBaDataset dataset_;
+
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a simple BA dataset, in the format read by parseSimpleBaDataset. The
+///        measurements are written last, so that the file can also be read by SimpleBaStream.
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeSimpleBaDataset(const std::string& file, const SimpleBaDataset& dataset);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bundle adjustment problem built from a simple BA dataset: one TransformStateVar per
+///        frame (T_k0, in the order of frames_ic), one LandmarkStateVar per landmark (in the
+///        order of land_ic), and a StereoCostTermCollection with the measurements
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct SimpleBaProblem {
+
+  std::vector<se3::TransformStateVar::Ptr> poses;
+  std::vector<se3::LandmarkStateVar::Ptr> landmarks;
+  StereoCostTermCollection::Ptr costTerms;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the unlocked poses and landmarks, and the cost terms, to an optimization
+  ///        problem
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addToProblem(OptimizationProblem* problem) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the bundle adjustment problem of a simple BA dataset, from its initial
+///        conditions. The first pose is locked. Throws std::invalid_argument if a measurement
+///        refers to an unknown frame or landmark.
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaProblem buildSimpleBaProblem(const SimpleBaDataset& dataset,
+                                     const LossFunctionBase::ConstPtr& lossFunc,
+                                     unsigned int numThreads = STEAM_DEFAULT_NUM_OPENMP_THREADS);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Continuous-time problem built from a simple BA dataset: the frames are the knots of
+///        a SteamTrajInterface (with a pose and velocity state each), and each measurement is
+///        taken at the interpolated pose at its own time
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct SimpleBaTrajectoryProblem {
+
+  std::vector<se3::TransformStateVar::Ptr> poses;
+  std::vector<VectorSpaceStateVar::Ptr> velocities;
+  std::vector<se3::LandmarkStateVar::Ptr> landmarks;
+  boost::shared_ptr<se3::SteamTrajInterface> trajectory;
+  ParallelizedCostTermCollection::Ptr costTerms;      // stereo measurements
+  ParallelizedCostTermCollection::Ptr priorCostTerms; // trajectory smoothing prior
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the unlocked states, and the cost terms, to an optimization problem
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addToProblem(OptimizationProblem* problem) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the continuous-time problem of a simple BA dataset, from its initial
+///        conditions (the velocities are initialized by finite differences of the poses). The
+///        first pose is locked. Throws std::invalid_argument if a measurement refers to an
+///        unknown landmark.
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaTrajectoryProblem buildSimpleBaTrajectoryProblem(
+    const SimpleBaDataset& dataset, const Eigen::Matrix<double,6,6>& Qc_inv,
+    const LossFunctionBase::ConstPtr& lossFunc,
+    unsigned int numThreads = STEAM_DEFAULT_NUM_OPENMP_THREADS);
 
 } // data
 } // steam
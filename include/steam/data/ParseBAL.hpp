@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file ParseBAL.hpp
+/// \brief Parses a Bundle-Adjustment-in-the-Large (BAL) dataset
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_PARSE_BAL_HPP
+#define STEAM_PARSE_BAL_HPP
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <lgmath.hpp>
+#include <steam.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Structure used to store a BAL dataset, converted to the steam conventions
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct BalDataset {
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure used to store a camera estimate. BAL cameras look down their negative
+  ///        z-axis (the projection is -f*(x/z, y/z)); T_c0 includes a rotation of pi about z,
+  ///        so that the steam camera model (mono::cameraModel) gives the same projection.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Camera {
+    lgmath::se3::Transformation T_c0;
+    double f;
+    double k1;
+    double k2;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure used to store a camera measurement (with assoc. camera and point IDs)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Observation {
+    unsigned int cameraID;
+    unsigned int pointID;
+    Eigen::Matrix<double,2,1> data; // u v
+  };
+
+  std::vector<Camera> cameras;                     // initial condition of cameras
+  std::vector<Eigen::Matrix<double,3,1> > points;  // initial condition of points
+  std::vector<Observation> observations;           // image measurements
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Function that parses a BAL dataset. The file is memory-mapped and tokenized in
+///        place; the observations and the camera/point parameters are split into line-aligned
+///        chunks that are parsed by up to numThreads threads.
+//////////////////////////////////////////////////////////////////////////////////////////////
+BalDataset parseBalDataset(const std::string& file, unsigned int numThreads = 1);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bundle adjustment problem built from a BAL dataset: one TransformStateVar per
+///        camera, one LandmarkStateVar per point, and one MonoCameraErrorEval cost term per
+///        observation (the camera intrinsics are fixed)
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct BalProblem {
+
+  std::vector<se3::TransformStateVar::Ptr> poses;
+  std::vector<se3::LandmarkStateVar::Ptr> landmarks;
+  ParallelizedCostTermCollection::Ptr costTerms;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the unlocked poses and landmarks, and the cost terms, to an optimization
+  ///        problem
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addToProblem(OptimizationProblem* problem) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the bundle adjustment problem of a BAL dataset, with unit (pixel) noise. The
+///        first camera is locked. Throws std::invalid_argument if an observation refers to an
+///        unknown camera or point.
+//////////////////////////////////////////////////////////////////////////////////////////////
+BalProblem buildBalProblem(const BalDataset& dataset, const LossFunctionBase::ConstPtr& lossFunc,
+                           unsigned int numThreads = STEAM_DEFAULT_NUM_OPENMP_THREADS);
+
+} // data
+} // steam
+
+#endif // STEAM_PARSE_BAL_HPP
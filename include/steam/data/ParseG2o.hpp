@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file ParseG2o.hpp
+/// \brief Parses a 3D pose-graph dataset in the g2o format (VERTEX_SE3:QUAT/EDGE_SE3:QUAT)
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_PARSE_G2O_HPP
+#define STEAM_PARSE_G2O_HPP
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <lgmath.hpp>
+#include <steam.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Structure used to store a g2o pose-graph dataset, converted to the steam
+///        conventions
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct G2oSe3Dataset {
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure used to store a pose estimate (VERTEX_SE3:QUAT)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Vertex {
+    unsigned int id;
+    lgmath::se3::Transformation T_k0;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure used to store a relative pose measurement (EDGE_SE3:QUAT). The g2o
+  ///        information matrix (on translation and quaternion vector) is converted to the
+  ///        square-root information of the se(3) error of TransformErrorEval(T_BA, B, A).
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Edge {
+    unsigned int idA;
+    unsigned int idB;
+    lgmath::se3::Transformation T_BA;
+    Eigen::Matrix<double,6,6> sqrtInformation;
+  };
+
+  std::vector<Vertex> vertices;   // initial condition of poses
+  std::vector<Edge> edges;        // relative pose measurements
+  std::vector<unsigned int> fixed; // IDs of the fixed vertices (FIX)
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Function that parses a g2o 3D pose-graph dataset. The file is memory-mapped and
+///        tokenized in place; large files are split into line-aligned chunks that are parsed
+///        by up to numThreads threads.
+//////////////////////////////////////////////////////////////////////////////////////////////
+G2oSe3Dataset parseG2oSe3Dataset(const std::string& file, unsigned int numThreads = 1);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a g2o 3D pose-graph dataset (the inverse of the conversions made by
+///        parseG2oSe3Dataset)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeG2oSe3Dataset(const std::string& file, const G2oSe3Dataset& dataset);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Pose-graph problem built from a g2o dataset: one TransformStateVar per vertex (in
+///        the order of the dataset) and one TransformErrorEval cost term per edge
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct G2oSe3Problem {
+
+  std::vector<se3::TransformStateVar::Ptr> poses;
+  ParallelizedCostTermCollection::Ptr costTerms;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the unlocked poses and the cost terms to an optimization problem
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addToProblem(OptimizationProblem* problem) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the pose-graph problem of a g2o dataset. The fixed vertices are locked (the
+///        first vertex, if there are none). Edges with the same information share a noise
+///        model. Throws std::invalid_argument if an edge refers to an unknown vertex.
+//////////////////////////////////////////////////////////////////////////////////////////////
+G2oSe3Problem buildG2oSe3Problem(const G2oSe3Dataset& dataset,
+                                 const LossFunctionBase::ConstPtr& lossFunc,
+                                 unsigned int numThreads = STEAM_DEFAULT_NUM_OPENMP_THREADS);
+
+} // data
+} // steam
+
+#endif // STEAM_PARSE_G2O_HPP
@@ -29,9 +29,11 @@ struct SphereEdge {
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Function that parses an iSAM1 sphere dataset
+/// \brief Function that parses an iSAM1 sphere dataset. The file is memory-mapped and
+///        tokenized in place; large files are split into line-aligned chunks that are parsed
+///        by up to numThreads threads.
 //////////////////////////////////////////////////////////////////////////////////////////////
-std::vector<SphereEdge> parseSphereDataset(const std::string& file);
+std::vector<SphereEdge> parseSphereDataset(const std::string& file, unsigned int numThreads = 1);
 
 } // data
 } // steam
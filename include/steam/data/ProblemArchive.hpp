@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file ProblemArchive.hpp
+/// \brief Versioned binary format for saving and restoring optimization problems
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_PROBLEM_ARCHIVE_HPP
+#define STEAM_PROBLEM_ARCHIVE_HPP
+
+#include <string>
+#include <vector>
+
+#include <steam/state/StateVariableBase.hpp>
+#include <steam/trajectory/SteamTrajVar.hpp>
+#include <steam/problem/OptimizationProblem.hpp>
+#include <steam/problem/StereoCostTermCollection.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Current version of the binary problem archive format. Readers reject archives with
+///        a newer version, and skip sections of unknown type.
+//////////////////////////////////////////////////////////////////////////////////////////////
+static const unsigned int PROBLEM_ARCHIVE_VERSION = 2;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Contents of a binary problem archive, used to checkpoint a problem and to restore
+///        it quickly (e.g. to replay recorded problems).
+///
+///        The format is a sequence of 8-byte aligned sections (states, trajectory knots,
+///        noise models, loss functions and stereo cost-term collections). Bulk data is stored
+///        as flat arrays, so that a memory-mapped archive is restored with block copies rather
+///        than by constructing each cost term. States are referenced by their position in the
+///        archive (state keys are regenerated when an archive is read), and shared states,
+///        noise models and loss functions are stored once.
+///
+///        Supported types:
+///          - states: se3::TransformStateVar, se3::LandmarkStateVar, VectorSpaceStateVar
+///          - trajectory knots: se3::SteamTrajVar, with a TransformStateEvaluator pose
+///          - cost terms: StereoCostTermCollection
+///          - noise models (4D): static, diagonal, isotropic and block-diagonal (with 1x1, 2x2
+///            or 4x4 blocks); dynamic models are rejected, since their covariance depends on
+///            an evaluator that cannot be archived
+///          - loss functions: L2, Huber, Cauchy, Geman-McClure and DCS
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct ProblemArchive {
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief State variables. When writing, states that are referenced by the knots or cost
+  ///        terms but not listed here are appended automatically.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<StateVariableBase::Ptr> states;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Trajectory knots (add them to a SteamTrajInterface to rebuild the trajectory)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<se3::SteamTrajVar::Ptr> knots;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Stereo cost-term collections
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<StereoCostTermCollection::Ptr> stereoCostTerms;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the unlocked states and the cost terms to an optimization problem
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addToProblem(OptimizationProblem* problem) const;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a problem archive (throws std::invalid_argument for unsupported types)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeProblemArchive(const std::string& file, const ProblemArchive& archive);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Read a problem archive (throws std::runtime_error for malformed archives)
+//////////////////////////////////////////////////////////////////////////////////////////////
+ProblemArchive readProblemArchive(const std::string& file);
+
+} // data
+} // steam
+
+#endif // STEAM_PROBLEM_ARCHIVE_HPP
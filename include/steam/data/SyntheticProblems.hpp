@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file SyntheticProblems.hpp
+/// \brief Deterministic generators of synthetic problems of arbitrary size (pose graphs,
+///        stereo bundle adjustment and continuous-time trajectories), for scaling studies
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_SYNTHETIC_PROBLEMS_HPP
+#define STEAM_SYNTHETIC_PROBLEMS_HPP
+
+#include <steam/data/ParseBA.hpp>
+#include <steam/data/ParseG2o.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parameters of a synthetic 3D pose graph. The poses follow a helix (laps of a
+///        circle, rising by lapRise per lap), with odometry edges between consecutive poses
+///        and loop closures to poses of previous laps. The initial condition is the dead
+///        reckoning of the odometry.
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct PoseGraphParams {
+  PoseGraphParams() : numPoses(1000), posesPerLap(100), lapRise(0.5), stepLength(1.0),
+                      loopClosureDensity(0.2), sigmaTranslation(0.05), sigmaRotation(0.01),
+                      seed(0) {}
+
+  /// \brief Number of poses, and number of poses per lap
+  unsigned int numPoses;
+  unsigned int posesPerLap;
+
+  /// \brief Height gained per lap, and distance between consecutive poses (m)
+  double lapRise;
+  double stepLength;
+
+  /// \brief Expected number of loop closures per pose (after the first lap), may exceed one
+  double loopClosureDensity;
+
+  /// \brief Standard deviation of the measurement noise, on translation (m) and rotation (rad)
+  double sigmaTranslation;
+  double sigmaRotation;
+
+  /// \brief Random seed
+  unsigned int seed;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Generate a synthetic 3D pose graph (the first vertex is fixed)
+//////////////////////////////////////////////////////////////////////////////////////////////
+G2oSe3Dataset generatePoseGraph(const PoseGraphParams& params);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parameters of a synthetic stereo bundle adjustment problem. The vehicle drives
+///        along a gentle sinusoid at constant speed, with a forward-looking stereo camera.
+///        Each landmark is tracked over trackLength consecutive frames, and the tracks are
+///        spread evenly over the frames.
+///
+///        If measTimesPerFrame is zero, the measurements are taken at the frame times. Else,
+///        the dataset is a continuous-time trajectory problem: each landmark is measured at
+///        measTimesPerFrame random times in each interval between the frames of its track
+///        (the frames are the trajectory knots, see buildSimpleBaTrajectoryProblem).
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct StereoBaParams {
+  StereoBaParams() : numFrames(100), numLandmarks(1000), trackLength(10), outlierRatio(0.0),
+                     framePeriod(0.1), speed(5.0), pixelNoise(0.5), sigmaTranslation(0.1),
+                     sigmaRotation(0.01), sigmaLandmark(0.2), measTimesPerFrame(0), seed(0) {}
+
+  /// \brief Number of frames, landmarks and frames per landmark track
+  unsigned int numFrames;
+  unsigned int numLandmarks;
+  unsigned int trackLength;
+
+  /// \brief Fraction of the measurements replaced by random pixels
+  double outlierRatio;
+
+  /// \brief Time between frames (s), and vehicle speed (m/s)
+  double framePeriod;
+  double speed;
+
+  /// \brief Standard deviation of the measurement noise (pixels, unit covariance if zero)
+  double pixelNoise;
+
+  /// \brief Standard deviation of the initial-condition errors of the poses, on translation
+  ///        (m) and rotation (rad), and of the landmarks (m). The first pose is exact.
+  double sigmaTranslation;
+  double sigmaRotation;
+  double sigmaLandmark;
+
+  /// \brief Number of measurement times per frame interval (zero for frame times)
+  unsigned int measTimesPerFrame;
+
+  /// \brief Random seed
+  unsigned int seed;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Generate a synthetic stereo bundle adjustment (or continuous-time trajectory)
+///        problem, with ground truth, initial conditions and time-ordered measurements
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaDataset generateStereoBa(const StereoBaParams& params);
+
+} // data
+} // steam
+
+#endif // STEAM_SYNTHETIC_PROBLEMS_HPP
@@ -6,6 +6,8 @@
 
 #include <steam/evaluator/blockauto/BlockAutomaticEvaluator.hpp>
 
+#include <algorithm>
+
 namespace steam {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -52,4 +54,29 @@ EvalTreeHandle<TYPE> BlockAutomaticEvaluator<TYPE,INNER_DIM,MAX_STATE_SIZE>::get
   return EvalTreeHandle<TYPE>(this->evaluateTree());
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluation of the block automatic Jacobian tree, for any (fixed or dynamic) LHS.
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename TYPE, int INNER_DIM, int MAX_STATE_SIZE>
+template<typename LHS_TYPE, int LHS_DIM, int JAC_MAX_STATE_DIM>
+void BlockAutomaticEvaluator<TYPE,INNER_DIM,MAX_STATE_SIZE>::appendBlockAutomaticJacobians(
+    const Eigen::MatrixBase<LHS_TYPE>& lhs,
+    EvalTreeNode<TYPE>* evaluationTree,
+    std::vector<Jacobian<LHS_DIM,JAC_MAX_STATE_DIM> >* outJacobians) const {
+
+  // Evaluate LHS expressions once (a plain matrix is referenced, not copied)
+  const typename LHS_TYPE::PlainObject& lhsEval = lhs.derived();
+  const int rows = lhsEval.rows();
+
+  // Pass the LHS through the tree in blocks of rows. Note that the tree outputs the same
+  // Jacobians for every block, so the sink appends them once and fills in the later rows.
+  const int maxRows = JacobianSink<MAX_STATE_SIZE>::MAX_LHS_ROWS;
+  JacobianVectorSink<LHS_DIM,JAC_MAX_STATE_DIM,MAX_STATE_SIZE> sink(outJacobians, rows);
+  for (int row = 0; row < rows; row += maxRows) {
+    sink.setRow(row);
+    this->appendJacobianRows(lhsEval.middleRows(row, std::min(maxRows, rows - row)),
+                             evaluationTree, &sink);
+  }
+}
+
 } // steam
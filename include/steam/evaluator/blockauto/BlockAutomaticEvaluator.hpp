@@ -10,6 +10,7 @@
 #include <steam/evaluator/EvaluatorBase.hpp>
 #include <steam/evaluator/blockauto/EvalTreeNode.hpp>
 #include <steam/evaluator/blockauto/EvalTreeHandle.hpp>
+#include <steam/evaluator/blockauto/JacobianSink.hpp>
 
 namespace steam {
 
@@ -25,6 +26,10 @@ class BlockAutomaticEvaluator : public EvaluatorBase<TYPE>
   typedef boost::shared_ptr<BlockAutomaticEvaluator<TYPE,INNER_DIM,MAX_STATE_SIZE> > Ptr;
   typedef boost::shared_ptr<const BlockAutomaticEvaluator<TYPE,INNER_DIM,MAX_STATE_SIZE> > ConstPtr;
 
+  /// Block of LHS rows passed through the evaluation tree (stack allocated)
+  typedef Eigen::Matrix<double, Eigen::Dynamic, INNER_DIM, Eigen::ColMajor,
+                        JacobianSink<MAX_STATE_SIZE>::MAX_LHS_ROWS, INNER_DIM> LhsBlock;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Default constructor
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -69,34 +74,27 @@ class BlockAutomaticEvaluator : public EvaluatorBase<TYPE>
   virtual EvalTreeNode<TYPE>* evaluateTree() const = 0;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Interface for the evaluation of the block automatic Jacobian tree
+  /// \brief Evaluation of the block automatic Jacobian tree, for any (fixed or dynamic) LHS.
   ///
-  /// Note the various fixed-sizes are hardcoded since virtual functions CANNOT be templated.
+  /// The LHS is evaluated once and passed to appendJacobianRows in blocks of at most
+  /// JacobianSink::MAX_LHS_ROWS rows, so fixed-size LHS dimensions never allocate on the heap.
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual void appendBlockAutomaticJacobians(
-      const Eigen::MatrixXd& lhs,
-      EvalTreeNode<TYPE>* evaluationTree,
-      std::vector<Jacobian<> >* outJacobians) const = 0;
-  virtual void appendBlockAutomaticJacobians(
-      const Eigen::Matrix<double,1,INNER_DIM>& lhs,
-      EvalTreeNode<TYPE>* evaluationTree,
-      std::vector<Jacobian<1,MAX_STATE_SIZE> >* outJacobians) const = 0;
-  virtual void appendBlockAutomaticJacobians(
-      const Eigen::Matrix<double,2,INNER_DIM>& lhs,
-      EvalTreeNode<TYPE>* evaluationTree,
-      std::vector<Jacobian<2,MAX_STATE_SIZE> >* outJacobians) const = 0;
-  virtual void appendBlockAutomaticJacobians(
-      const Eigen::Matrix<double,3,INNER_DIM>& lhs,
+  template<typename LHS_TYPE, int LHS_DIM, int JAC_MAX_STATE_DIM>
+  void appendBlockAutomaticJacobians(
+      const Eigen::MatrixBase<LHS_TYPE>& lhs,
       EvalTreeNode<TYPE>* evaluationTree,
-      std::vector<Jacobian<3,MAX_STATE_SIZE> >* outJacobians) const = 0;
-  virtual void appendBlockAutomaticJacobians(
-      const Eigen::Matrix<double,4,INNER_DIM>& lhs,
-      EvalTreeNode<TYPE>* evaluationTree,
-      std::vector<Jacobian<4,MAX_STATE_SIZE> >* outJacobians) const = 0;
-  virtual void appendBlockAutomaticJacobians(
-      const Eigen::Matrix<double,6,INNER_DIM>& lhs,
+      std::vector<Jacobian<LHS_DIM,JAC_MAX_STATE_DIM> >* outJacobians) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Interface for the evaluation of the block automatic Jacobian tree, for a block of
+  ///        at most JacobianSink::MAX_LHS_ROWS rows of the LHS. Derived evaluators pass the
+  ///        (bounded-size) product of the LHS and their local Jacobian to their children, and
+  ///        add the Jacobians of their own state variables to the sink.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void appendJacobianRows(
+      const Eigen::Ref<const LhsBlock>& lhs,
       EvalTreeNode<TYPE>* evaluationTree,
-      std::vector<Jacobian<6,MAX_STATE_SIZE> >* outJacobians) const = 0;
+      JacobianSink<MAX_STATE_SIZE>* outJacobians) const = 0;
 };
 
 } // steam
@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file JacobianSink.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_JACOBIAN_SINK_HPP
+#define STEAM_JACOBIAN_SINK_HPP
+
+#include <Eigen/Core>
+#include <stdexcept>
+#include <vector>
+
+#include <steam/problem/Jacobian.hpp>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Output of the block-automatic Jacobian evaluation. The LHS is passed through the
+///        evaluation tree in blocks of at most MAX_LHS_ROWS rows, so that the intermediate
+///        products have a bounded size and live on the stack, whatever the LHS dimension.
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MAX_STATE_SIZE>
+class JacobianSink
+{
+ public:
+
+  /// Largest number of LHS rows that is passed through an evaluation tree at once
+  enum { MAX_LHS_ROWS = 12 };
+
+  /// Rows of a Jacobian with respect to a single state variable
+  typedef Eigen::Matrix<double, Eigen::Dynamic, MAX_STATE_SIZE, Eigen::ColMajor,
+                        MAX_LHS_ROWS, MAX_STATE_SIZE> Block;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Destructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual ~JacobianSink() {}
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of Jacobians output so far (the hint index of merge)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int size() const = 0;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the Jacobian (rows of the current LHS block) w.r.t. a state variable
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void add(const StateKey& key, const Eigen::Ref<const Block>& jac) = 0;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Merge the Jacobians from hintIndex onwards with earlier Jacobians w.r.t. the same
+  ///        state variable (see Jacobian::merge)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void merge(unsigned int hintIndex) = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Sink that appends to a vector of Jacobians with the full LHS dimension. The first
+///        block of LHS rows appends the Jacobians; since the evaluation tree outputs the same
+///        Jacobians for every block, later blocks are added to the rows of the existing ones.
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int LHS_DIM, int JAC_MAX_STATE_DIM, int MAX_STATE_SIZE>
+class JacobianVectorSink : public JacobianSink<MAX_STATE_SIZE>
+{
+ public:
+
+  /// Convenience typedefs
+  typedef typename JacobianSink<MAX_STATE_SIZE>::Block Block;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  JacobianVectorSink(std::vector<Jacobian<LHS_DIM,JAC_MAX_STATE_DIM> >* outJacobians,
+                     unsigned int lhsRows)
+    : outJacobians_(outJacobians), lhsRows_(lhsRows), row_(0), begin_(outJacobians->size()) {
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the first LHS row of the block that is being evaluated
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void setRow(unsigned int row) {
+    row_ = row;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of Jacobians output so far
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int size() const {
+    return outJacobians_->size();
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the Jacobian (rows of the current LHS block) w.r.t. a state variable
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void add(const StateKey& key, const Eigen::Ref<const Block>& jac) {
+
+    // First block, append the Jacobian
+    if (row_ == 0) {
+      outJacobians_->push_back(Jacobian<LHS_DIM,JAC_MAX_STATE_DIM>());
+      Jacobian<LHS_DIM,JAC_MAX_STATE_DIM>& jacref = outJacobians_->back();
+      jacref.key = key;
+      if ((unsigned int)jac.rows() == lhsRows_) {
+        jacref.jac = jac;
+      } else {
+        jacref.jac.setZero(lhsRows_, jac.cols());
+        jacref.jac.topRows(jac.rows()) = jac;
+      }
+      return;
+    }
+
+    // Later blocks, add to the Jacobian of the state (prefer those output by this evaluation)
+    for (unsigned int i = begin_; i < outJacobians_->size(); i++) {
+      if (outJacobians_->at(i).key.equals(key)) {
+        outJacobians_->at(i).jac.middleRows(row_, jac.rows()) += jac;
+        return;
+      }
+    }
+    for (unsigned int i = 0; i < begin_; i++) {
+      if (outJacobians_->at(i).key.equals(key)) {
+        outJacobians_->at(i).jac.middleRows(row_, jac.rows()) += jac;
+        return;
+      }
+    }
+    throw std::runtime_error("Block-automatic evaluation output a Jacobian for a state that "
+                             "was not in the first block of LHS rows.");
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Merge Jacobians w.r.t. the same state variable (later blocks are added in place)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void merge(unsigned int hintIndex) {
+    if (row_ == 0) {
+      Jacobian<LHS_DIM,JAC_MAX_STATE_DIM>::merge(outJacobians_, hintIndex);
+    }
+  }
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Output Jacobians
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<Jacobian<LHS_DIM,JAC_MAX_STATE_DIM> >* outJacobians_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Total number of LHS rows
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int lhsRows_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief First LHS row of the current block
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int row_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Number of Jacobians in the output before this evaluation
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int begin_;
+};
+
+} // steam
+
+#endif // STEAM_JACOBIAN_SINK_HPP
@@ -6,6 +6,8 @@
 
 #include <steam/evaluator/blockauto/Pool.hpp>
 
+#include <steam/common/MemoryUsage.hpp>
+
 namespace steam {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -15,6 +17,7 @@ template<typename TYPE, int MAX_SIZE>
 Pool<TYPE,MAX_SIZE>::Pool() {
   index_ = 0;
   resources_ = new TYPE[MAX_SIZE];
+  recordPoolMemory(MAX_SIZE*sizeof(TYPE));
   for (unsigned int i = 0; i < MAX_SIZE; i++) {
     available_[i] = true;
   }
@@ -27,6 +30,7 @@ template<typename TYPE, int MAX_SIZE>
 Pool<TYPE,MAX_SIZE>::~Pool() {
   if (resources_) {
     delete [] resources_;
+    recordPoolMemory(-std::ptrdiff_t(MAX_SIZE*sizeof(TYPE)));
   }
 }
 
@@ -69,43 +69,12 @@ public:
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Evaluate the Jacobian tree
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual void appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                               EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                               std::vector<Jacobian<> >* outJacobians) const;
-
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Fixed-size evaluations of the Jacobian tree
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,4>& lhs,
-                                EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                                std::vector<Jacobian<1,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,4>& lhs,
-                                EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                                std::vector<Jacobian<2,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,4>& lhs,
-                                EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                                std::vector<Jacobian<3,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,4>& lhs,
-                                EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                                std::vector<Jacobian<4,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,4>& lhs,
-                                EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                                std::vector<Jacobian<6,6> >* outJacobians) const;
+  virtual void appendJacobianRows(const Eigen::Ref<const LhsBlock>& lhs,
+                                  EvalTreeNode<Eigen::Vector4d>* evaluationTree,
+                                  JacobianSink<6>* outJacobians) const;
 
 private:
 
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Implementation for Block Automatic Differentiation
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-  void appendJacobiansImpl(const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
-                           EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                           std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const;
-
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Transform evaluator
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -119,6 +88,7 @@ private:
 };
 
 } // se3
+
 } // steam
 
 #endif // STEAM_COMPOSE_LANDMARK_EVALUATOR_HPP
@@ -60,40 +60,12 @@ class FixedTransformEvaluator : public TransformEvaluator
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Evaluate the Jacobian tree
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual void appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                               EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                               std::vector<Jacobian<> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,6>& lhs,
-                               EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                               std::vector<Jacobian<1,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,6>& lhs,
-                               EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                               std::vector<Jacobian<2,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,6>& lhs,
-                               EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                               std::vector<Jacobian<3,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,6>& lhs,
-                               EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                               std::vector<Jacobian<4,6> >* outJacobians) const;
-
-  virtual void appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,6>& lhs,
-                               EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                               std::vector<Jacobian<6,6> >* outJacobians) const;
+  virtual void appendJacobianRows(const Eigen::Ref<const LhsBlock>& lhs,
+                                  EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
+                                  JacobianSink<6>* outJacobians) const;
 
  private:
 
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Implementation for Block Automatic Differentiation
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-  void appendJacobiansImpl(const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
-                           EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                           std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const;
-
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Fixed transformation matrix
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -101,6 +73,7 @@ class FixedTransformEvaluator : public TransformEvaluator
 };
 
 } // se3
+
 } // steam
 
 #endif // STEAM_FIXED_TRANSFORM_EVALUATOR_HPP
@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file MonoCameraErrorEval.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_MONO_CAMERA_ERROR_EVALUATOR_HPP
+#define STEAM_MONO_CAMERA_ERROR_EVALUATOR_HPP
+
+#include <steam.hpp>
+
+namespace steam {
+
+namespace mono {
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Simple structure to hold the intrinsics of a monocular pinhole camera with radial
+///        distortion (as used by the Bundle-Adjustment-in-the-Large datasets)
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct CameraIntrinsics {
+  /// Convenience typedefs
+  typedef boost::shared_ptr<CameraIntrinsics> Ptr;
+  typedef boost::shared_ptr<const CameraIntrinsics> ConstPtr;
+
+  /// \brief Focal length in the u-coordinate (horizontal)
+  double fu;
+
+  /// \brief Focal length in the v-coordinate (vertical)
+  double fv;
+
+  /// \brief Focal center offset in the u-coordinate (horizontal)
+  double cu;
+
+  /// \brief Focal center offset in the v-coordinate (vertical)
+  double cv;
+
+  /// \brief Second and fourth order radial distortion coefficients
+  double k1;
+  double k2;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Monocular camera model, projects a homogeneous point (in the camera frame) into
+///        (u v). With a = x/z, b = y/z and r2 = a*a + b*b, the projection is
+///          u = fu * (1 + k1*r2 + k2*r2*r2) * a + cu
+///          v = fv * (1 + k1*r2 + k2*r2*r2) * b + cv
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Vector2d cameraModel(const CameraIntrinsics& intrinsics, const Eigen::Vector4d& point);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Calculates the monocular camera model Jacobian
+/// \param The camera intrinsic properties.
+/// \param The homogeneous point the jacobian is being evaluated at.
+/// \return the jacobian of the camera model, evaluated at the given point.
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Matrix<double,2,4> cameraModelJacobian(const CameraIntrinsics& intrinsics,
+                                              const Eigen::Vector4d& point);
+
+} // end namespace mono
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Monocular camera (reprojection) error function evaluator
+///
+/// *Note that we fix MAX_STATE_DIM to 6. Typically the performance benefits of fixed size
+///  matrices begin to die if larger than 6x6. Size 6 allows for transformation matrices
+///  and 6D velocities. If you have a state-type larger than this, consider writing an
+///  error evaluator that extends from the dynamically sized ErrorEvaluatorX.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class MonoCameraErrorEval : public ErrorEvaluator<2,6>::type
+{
+public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<MonoCameraErrorEval> Ptr;
+  typedef boost::shared_ptr<const MonoCameraErrorEval> ConstPtr;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  MonoCameraErrorEval(const Eigen::Vector2d& meas,
+                      const mono::CameraIntrinsics::ConstPtr& intrinsics,
+                      const se3::TransformEvaluator::ConstPtr& T_cam_landmark,
+                      const se3::LandmarkStateVar::Ptr& landmark);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns whether or not an evaluator contains unlocked state variables
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool isActive() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Evaluate the 2-d measurement error (u v)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Vector2d evaluate() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Evaluate the 2-d measurement error (u v) and Jacobians
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Vector2d evaluate(const Eigen::Matrix2d& lhs,
+                                   std::vector<Jacobian<2,6> >* jacs) const;
+
+private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Measurement coordinates extracted from the image (u v)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  Eigen::Vector2d meas_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Camera instrinsics
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  mono::CameraIntrinsics::ConstPtr intrinsics_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Point evaluator (evaluates the point transformed into the camera frame)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  se3::ComposeLandmarkEvaluator::ConstPtr eval_;
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+} // steam
+
+#endif // STEAM_MONO_CAMERA_ERROR_EVALUATOR_HPP
@@ -10,6 +10,9 @@
 #include <steam.hpp>
 #include <steam/problem/NoiseModel.hpp>
 
+#include <atomic>
+#include <mutex>
+
 namespace steam {
 
 namespace stereo {
@@ -45,6 +48,42 @@ struct CameraIntrinsics {
 //////////////////////////////////////////////////////////////////////////////////////////////
 Eigen::Matrix4d cameraModelJacobian(const CameraIntrinsics::ConstPtr &intrinsics, const Eigen::Vector4d& point);
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Calculates the stereo Camera model Jacobian (intrinsics by reference)
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Matrix4d cameraModelJacobian(const CameraIntrinsics &intrinsics, const Eigen::Vector4d& point);
+
+/// \brief Batch of homogeneous points (x y z w) or projections (ul vl ur vr), stored as
+///        structure-of-arrays (one row per coordinate, one column per point)
+typedef Eigen::Matrix<double,4,Eigen::Dynamic,Eigen::RowMajor> PointBatch;
+
+/// \brief Batch of stereo camera model Jacobians, stored as structure-of-arrays (row r holds
+///        entry r of the column-major 4x4 Jacobian, one column per point)
+typedef Eigen::Matrix<double,16,Eigen::Dynamic,Eigen::RowMajor> JacobianBatch;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched stereo camera model, projects N homogeneous points (in the camera frame)
+///        into (ul vl ur vr). The intrinsics are loaded once, and the loop runs across points
+///        so that it vectorizes over SIMD lanes (e.g. AVX2/AVX-512 with -march=native). This
+///        is intended for batched cost terms and for front-end reprojection checks (e.g.
+///        outlier rejection).
+/// \param The stereo camera intrinsic properties.
+/// \param The points, as structure-of-arrays.
+/// \param The output projections (same number of columns as the points).
+//////////////////////////////////////////////////////////////////////////////////////////////
+void cameraModelBatch(const CameraIntrinsics& intrinsics,
+                      const Eigen::Ref<const PointBatch>& points,
+                      Eigen::Ref<PointBatch> projections);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched stereo camera model and Jacobians (see cameraModelJacobian), evaluated at
+///        each of the N points.
+//////////////////////////////////////////////////////////////////////////////////////////////
+void cameraModelBatch(const CameraIntrinsics& intrinsics,
+                      const Eigen::Ref<const PointBatch>& points,
+                      Eigen::Ref<PointBatch> projections,
+                      Eigen::Ref<JacobianBatch> jacobians);
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Evaluates the noise of an uncertain map landmark, which has been reprojected into the
@@ -53,6 +92,28 @@ Eigen::Matrix4d cameraModelJacobian(const CameraIntrinsics::ConstPtr &intrinsics
 class LandmarkNoiseEvaluator : public NoiseEvaluator<4> {
  public:
 
+  /// \brief Failures of the diagnostic positive-definiteness checks (bit flags)
+  enum DiagnosticFailure {
+    /// The landmark covariance (constructor)
+    LANDMARK_COV_NOT_PD = 1,
+    /// The measurement noise (constructor)
+    MEAS_NOISE_NOT_PD = 2,
+    /// The landmark covariance transformed into the query frame, it is not projected
+    QUERY_LANDMARK_COV_NOT_PD = 4,
+    /// The landmark covariance projected into the camera, it is not added
+    PROJECTED_LANDMARK_NOISE_NOT_PD = 8,
+    /// The total covariance
+    TOTAL_COV_NOT_PD = 16
+  };
+
+  /// \brief Set whether evaluators constructed from now on run the diagnostic
+  ///        positive-definiteness checks (enabled unless set otherwise). Each check is an
+  ///        eigen-decomposition, production code can disable them.
+  static void setDefaultDiagnosticChecks(bool enabled);
+
+  /// \brief Get whether new evaluators run the diagnostic checks
+  static bool getDefaultDiagnosticChecks();
+
   /// \brief Constructor
   /// \param The landmark mean, in the query frame.
   /// \param The landmark covariance, in the query frame.
@@ -74,22 +135,36 @@ class LandmarkNoiseEvaluator : public NoiseEvaluator<4> {
   ///         camera frame.
   virtual Eigen::Matrix<double,4,4> evaluate();
 
+  /// \brief Stamp of the inputs, so that DynamicNoiseModel only re-evaluates the covariance
+  ///        when the transform T_query_map has actually changed. Between state changes
+  ///        this is a lock-free check; after a state change, T_query_map is re-evaluated
+  ///        and compared against the transform of the last stamp.
+  virtual StateStamp getInputStamp() const;
+
+  /// \brief Enable or disable the diagnostic positive-definiteness checks of this evaluator
+  ///        (see setDefaultDiagnosticChecks). When disabled, the reprojected landmark noise is
+  ///        always added to the measurement noise.
+  void setDiagnosticChecks(bool enabled);
+
+  /// \brief Get the failed diagnostic checks (DiagnosticFailure flags) of the constructor
+  ///        and of the last covariance computation, 0 if all checks passed or were disabled.
+  unsigned int getDiagnosticFailures() const;
+
  private:
   template <int N>
   bool positiveDefinite(const Eigen::Matrix<double,N,N> &matrix) {
-  
+
+    // Diagnostics disabled, assume the matrix is fine
+    if (!diagnostic_checks_) {
+      return true;
+    }
+
     // Initialize an eigen value solver
     Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double,N,N>> 
        eigsolver(matrix, Eigen::EigenvaluesOnly);
 
     // Check the minimum eigen value
-    auto positive_definite = eigsolver.eigenvalues().minCoeff() > 0;
-    if (!positive_definite) {
-      std::cout << "Covariance \n" << matrix << "\n must be positive definite. "
-                << "Min. eigenvalue : " << eigsolver.eigenvalues().minCoeff();
-    }
-    
-    return positive_definite;
+    return eigsolver.eigenvalues().minCoeff() > 0;
   }
 
   /// \brief The stereo camera intrinsics.
@@ -114,6 +189,32 @@ class LandmarkNoiseEvaluator : public NoiseEvaluator<4> {
 
   // \brief the last computed covariance
   Eigen::Matrix<double,4,4> last_computed_cov_;
+
+  /// \brief The transform (matrix) at which last_computed_cov_ was computed.
+  Eigen::Matrix4d last_computed_T_;
+
+  /// \brief Whether last_computed_cov_ has been computed.
+  bool computed_;
+
+  /// \brief Whether to run the diagnostic positive-definiteness checks.
+  bool diagnostic_checks_;
+
+  /// \brief Failed checks of the constructor, and of the last covariance computation.
+  unsigned int construction_failures_;
+  unsigned int evaluation_failures_;
+
+  /// \brief Input stamp, and the transform (matrix) it was issued for.
+  mutable std::atomic<StateStamp> input_stamp_;
+  mutable Eigen::Matrix4d stamped_T_;
+
+  /// \brief Latest global state stamp at which the input stamp was checked.
+  mutable std::atomic<StateStamp> checked_stamp_;
+
+  /// \brief Serializes updates of the input stamp.
+  mutable std::mutex stamp_mutex_;
+
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
 } // end namespace stereo
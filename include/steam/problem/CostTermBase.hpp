@@ -7,8 +7,12 @@
 #ifndef STEAM_COST_TERM_BASE_HPP
 #define STEAM_COST_TERM_BASE_HPP
 
+#include <stdexcept>
+#include <typeinfo>
+
 #include <boost/shared_ptr.hpp>
 
+#include <steam/problem/lossfunc/LossFunctionBase.hpp>
 #include <steam/state/StateVector.hpp>
 #include <steam/blockmat/BlockSparseMatrix.hpp>
 #include <steam/blockmat/BlockVector.hpp>
@@ -55,6 +59,46 @@ class CostTermBase
   virtual void buildGaussNewtonTerms(const StateVector& stateVector,
                                      BlockSparseMatrix* approximateHessian,
                                      BlockVector* gradientVector) const = 0;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns the loss function if the cost of this term is loss(whitenedErrorNorm()),
+  ///        otherwise NULL. Collections use this to evaluate the costs and weights of many
+  ///        terms that share a loss function in a single batched call.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual const LossFunctionBase* getLossFunction() const { return NULL; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the norm of the whitened error (required if getLossFunction() is not NULL)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual double whitenedErrorNorm() const {
+    throw std::runtime_error("[CostTermBase] cost term does not expose a whitened error norm.");
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns whether whitenedErrorNorm() only changes when a state variable changes
+  ///        (see StampGenerator), so that a norm computed by a collection's cost() may be
+  ///        reused for the weight of a linearization at the same latest stamp. False by
+  ///        default, the weight is then always recomputed.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool hasStampedInputs() const { return false; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the contribution of this cost term to the Gauss-Newton system of equations,
+  ///        using a loss-function weight that was already computed from whitenedErrorNorm()
+  ///        at the current state (required if getLossFunction() is not NULL)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void buildReweightedGaussNewtonTerms(const StateVector& stateVector,
+                                               BlockSparseMatrix* approximateHessian,
+                                               BlockVector* gradientVector,
+                                               double weight) const {
+    throw std::runtime_error("[CostTermBase] cost term does not support precomputed weights.");
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns the type that the time spent in this cost term is attributed to by a
+  ///        CostTermProfiler (the dynamic type of the cost term by default)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual const std::type_info& getProfileType() const { return typeid(*this); }
 };
 
 } // steam
@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file CostTermIngestor-inl.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/problem/CostTermIngestor.hpp>
+
+#include <stdexcept>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+CostTermIngestor<MEAS>::CostTermIngestor(const CostTermFactory& factory, unsigned int batchSize,
+                                         unsigned int maxQueuedBatches)
+  : factory_(factory), batchSize_(batchSize > 0 ? batchSize : 1),
+    maxQueuedBatches_(maxQueuedBatches > 0 ? maxQueuedBatches : 1),
+    closed_(false), cancelled_(false), numAppended_(0) {
+  if (!factory_) {
+    throw std::invalid_argument("[CostTermIngestor] null cost term factory.");
+  }
+  batch_.reserve(batchSize_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Destructor, cancels and joins the producer thread (if any)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+CostTermIngestor<MEAS>::~CostTermIngestor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+  }
+  queueChanged_.notify_all();
+  if (producerThread_.joinable()) {
+    producerThread_.join();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Run a producer on a background thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+void CostTermIngestor<MEAS>::startProducer(const Producer& producer) {
+  if (producerThread_.joinable()) {
+    throw std::logic_error("[CostTermIngestor] a producer was already started.");
+  }
+  producerThread_ = std::thread([this, producer]() {
+    try {
+      producer(this);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      producerError_ = std::current_exception();
+    }
+    this->close();
+  });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Create the cost term of a measurement (producer side)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+bool CostTermIngestor<MEAS>::push(const MEAS& meas) {
+  batch_.push_back(factory_(meas));
+  if (batch_.size() >= batchSize_) {
+    this->flush();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !cancelled_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Queue the current partial batch (producer side)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+void CostTermIngestor<MEAS>::flush() {
+  if (batch_.empty()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (queue_.size() >= maxQueuedBatches_ && !cancelled_) {
+    queueChanged_.wait(lock);
+  }
+  if (!cancelled_) {
+    queue_.push_back(std::vector<CostTermBase::ConstPtr>());
+    queue_.back().swap(batch_);
+    batch_.reserve(batchSize_);
+  } else {
+    batch_.clear();
+  }
+  lock.unlock();
+  queueChanged_.notify_all();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Flush and mark the end of the stream (producer side)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+void CostTermIngestor<MEAS>::close() {
+  this->flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  queueChanged_.notify_all();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add all ready batches of cost terms to the problem (consumer side)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+unsigned int CostTermIngestor<MEAS>::appendReady(OptimizationProblem* problem) {
+
+  // Take the ready batches (the producer can continue while they are added)
+  std::deque<std::vector<CostTermBase::ConstPtr> > ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (producerError_) {
+      std::exception_ptr error = producerError_;
+      producerError_ = std::exception_ptr();
+      std::rethrow_exception(error);
+    }
+    ready.swap(queue_);
+  }
+  queueChanged_.notify_all();
+
+  unsigned int numAdded = 0;
+  for (unsigned int b = 0; b < ready.size(); b++) {
+    for (unsigned int i = 0; i < ready[b].size(); i++) {
+      problem->addCostTerm(ready[b][i]);
+    }
+    numAdded += ready[b].size();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  numAppended_ += numAdded;
+  return numAdded;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Block until a batch is ready or the stream is finished (consumer side)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+bool CostTermIngestor<MEAS>::waitForBatch() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (queue_.empty() && !closed_ && !producerError_) {
+    queueChanged_.wait(lock);
+  }
+  return !queue_.empty();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Whether the stream is closed and all cost terms have been appended
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+bool CostTermIngestor<MEAS>::isFinished() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_ && queue_.empty() && !producerError_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of cost terms appended to the problem so far
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+unsigned int CostTermIngestor<MEAS>::getNumAppended() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return numAppended_;
+}
+
+} // steam
@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file CostTermIngestor.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_COST_TERM_INGESTOR_HPP
+#define STEAM_COST_TERM_INGESTOR_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <steam/problem/CostTermBase.hpp>
+#include <steam/problem/OptimizationProblem.hpp>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Streaming ingestion of measurements into a live optimization problem.
+///
+///        A producer (a thread started with startProducer(), or any other thread calling
+///        push()) hands over measurements one at a time. They are turned into cost terms by
+///        the factory, on the producer thread, and queued in batches. The thread that owns the
+///        problem calls appendReady() between solver iterations to add the ready batches. This
+///        way the problem is never modified while the solver is using it, and neither the
+///        measurements nor the cost terms of the whole dataset need to exist at once.
+///
+///        The queue holds at most maxQueuedBatches batches; push() blocks while it is full, so
+///        the producer cannot run arbitrarily far ahead of the consumer. Note that the states
+///        used by the cost terms must be added to the problem by the consumer.
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename MEAS>
+class CostTermIngestor
+{
+ public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<CostTermIngestor<MEAS> > Ptr;
+  typedef boost::shared_ptr<const CostTermIngestor<MEAS> > ConstPtr;
+
+  /// Creates the cost term for a measurement (called on the producer thread)
+  typedef std::function<CostTermBase::ConstPtr(const MEAS&)> CostTermFactory;
+
+  /// Pushes measurements into the ingestor (run on the producer thread)
+  typedef std::function<void(CostTermIngestor<MEAS>*)> Producer;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  CostTermIngestor(const CostTermFactory& factory, unsigned int batchSize = 1024,
+                   unsigned int maxQueuedBatches = 16);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Destructor, cancels and joins the producer thread (if any)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  ~CostTermIngestor();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Run a producer on a background thread. The stream is closed when it returns, and
+  ///        an exception thrown by the producer is rethrown by appendReady().
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void startProducer(const Producer& producer);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Create the cost term of a measurement (producer side). Blocks while the queue is
+  ///        full. Returns false if the ingestor was cancelled, in which case the producer
+  ///        should stop.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool push(const MEAS& meas);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Queue the current partial batch (producer side)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void flush();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Flush and mark the end of the stream (producer side)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void close();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add all ready batches of cost terms to the problem (consumer side, does not
+  ///        block). Returns the number of cost terms added.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int appendReady(OptimizationProblem* problem);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Block until a batch is ready or the stream is finished (consumer side). Returns
+  ///        whether a batch is ready.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool waitForBatch() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether the stream is closed and all cost terms have been appended
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool isFinished() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of cost terms appended to the problem so far
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getNumAppended() const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Not copyable
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  CostTermIngestor(const CostTermIngestor&);
+  CostTermIngestor& operator=(const CostTermIngestor&);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Cost term factory and batching parameters
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  CostTermFactory factory_;
+  const unsigned int batchSize_;
+  const unsigned int maxQueuedBatches_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batch being filled by the producer (only accessed by the producer)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<CostTermBase::ConstPtr> batch_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Queue of full batches, and stream status (guarded by mutex_)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::deque<std::vector<CostTermBase::ConstPtr> > queue_;
+  bool closed_;
+  bool cancelled_;
+  std::exception_ptr producerError_;
+  unsigned int numAppended_;
+  mutable std::mutex mutex_;
+  mutable std::condition_variable queueChanged_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Background producer thread
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::thread producerThread_;
+};
+
+} // steam
+
+#include <steam/problem/CostTermIngestor-inl.hpp>
+
+#endif // STEAM_COST_TERM_INGESTOR_HPP
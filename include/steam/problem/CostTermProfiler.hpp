@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file CostTermProfiler.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_COST_TERM_PROFILER_HPP
+#define STEAM_COST_TERM_PROFILER_HPP
+
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Attributes the time spent in cost terms to their types (see
+///        CostTermBase::getProfileType, e.g. the error evaluator of a WeightedLeastSqCostTerm).
+///
+///        A profiler is attached to a ParallelizedCostTermCollection, which then times one in
+///        every 'sampleInterval' cost terms (the sampled subset rotates between calls) in cost()
+///        and buildGaussNewtonTerms(). Each OpenMP thread accumulates into its own counters,
+///        which are only merged when the statistics are requested, so that a profiler with a
+///        coarse sample interval is cheap enough to leave attached.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class CostTermProfiler
+{
+ public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<CostTermProfiler> Ptr;
+  typedef boost::shared_ptr<const CostTermProfiler> ConstPtr;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Counters filled in by a cost term while it is sampled (see activeSample)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Sample
+  {
+    Sample() : jacobians(0), hessianBlocks(0) {}
+
+    /// Number of Jacobians evaluated
+    unsigned int jacobians;
+
+    /// Number of (upper-triangular) Hessian blocks accumulated into
+    unsigned int hessianBlocks;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Statistics of a cost-term type. Counts and times are estimates: the sampled
+  ///        values scaled by the sample interval (they are exact for an interval of 1).
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct TypeStats
+  {
+    TypeStats() : evaluations(0), linearizations(0), evaluateTime(0.0), linearizeTime(0.0),
+                  jacobians(0), hessianBlocks(0) {}
+
+    /// Name of the type
+    std::string name;
+
+    /// Number of cost evaluations, and of linearizations (Gauss-Newton contributions)
+    unsigned long long evaluations;
+    unsigned long long linearizations;
+
+    /// Cumulative time (ms) of the cost evaluations, and of the linearizations
+    double evaluateTime;
+    double linearizeTime;
+
+    /// Number of Jacobians evaluated, and of Hessian blocks touched, by the linearizations
+    unsigned long long jacobians;
+    unsigned long long hessianBlocks;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor, times one in every 'sampleInterval' cost terms
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  CostTermProfiler(unsigned int sampleInterval = 1);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the sample interval
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getSampleInterval() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the statistics of each cost-term type, by decreasing total time
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<TypeStats> getStats() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Print a summary table of the statistics, with the share of the total time
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void printSummary(std::ostream& out = std::cout) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Clear the statistics
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void reset();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Prepare the counters of 'numThreads' threads for a pass over a collection, and
+  ///        return the index of the first sampled cost term (must be called outside of the
+  ///        parallel region)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int beginPass(unsigned int numThreads);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Record a sampled cost evaluation on the calling thread
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void recordEvaluate(const std::type_info& type, double seconds);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Record a sampled linearization on the calling thread
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void recordLinearize(const std::type_info& type, double seconds, const Sample& sample);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the sample of the cost term being linearized on the calling thread, or NULL if
+  ///        it is not sampled. Cost terms add their Jacobian and Hessian-block counts to it.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  static Sample* activeSample();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the sample of the cost term being linearized on the calling thread
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  static void setActiveSample(Sample* sample);
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Sampled counters of a type
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Counters
+  {
+    Counters() : type(NULL), evaluations(0), linearizations(0), evaluateTime(0.0),
+                 linearizeTime(0.0), jacobians(0), hessianBlocks(0) {}
+
+    const std::type_info* type;
+    unsigned long long evaluations;
+    unsigned long long linearizations;
+    double evaluateTime;
+    double linearizeTime;
+    unsigned long long jacobians;
+    unsigned long long hessianBlocks;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Counters of a thread (few types, so they are searched linearly from the last one
+  ///        used; consecutive cost terms are usually of the same type)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct ThreadCounters
+  {
+    ThreadCounters() : last(0) {}
+
+    std::vector<Counters> types;
+    unsigned int last;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the counters of a type on the calling thread
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  Counters& getCounters(const std::type_info& type);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Sample interval
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const unsigned int sampleInterval_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Index of the first sampled cost term in the next pass
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int nextOffset_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Counters of each thread (allocated separately, to avoid false sharing)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<boost::shared_ptr<ThreadCounters> > threads_;
+};
+
+} // steam
+
+#endif // STEAM_COST_TERM_PROFILER_HPP
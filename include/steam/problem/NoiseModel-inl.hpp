@@ -6,7 +6,9 @@
 
 #include <steam/problem/NoiseModel.hpp>
 
+#include <cmath>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 #include <Eigen/Cholesky>
@@ -16,18 +18,48 @@ namespace steam {
 
 template<int MEAS_DIM>
 DynamicNoiseModel<MEAS_DIM>::DynamicNoiseModel(boost::shared_ptr<NoiseEvaluator<MEAS_DIM>> eval) :
-eval_(eval) {
-  this->setByCovariance(eval_->evaluateCovariance());
+eval_(eval), cachedStamp_(0) {
+  const StateStamp stamp = eval_->getInputStamp();
+  sqrtInformation_ = this->computeSqrtInformation(eval_->evaluateCovariance().inverse());
+  cachedStamp_.store(stamp);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the sqrt information for the current inputs of the evaluator
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>&
+DynamicNoiseModel<MEAS_DIM>::currentSqrtInformation() const {
+
+  // Unknown inputs, evaluate into thread-local storage rather than the shared cache
+  const StateStamp stamp = eval_->getInputStamp();
+  if (stamp == 0) {
+    static thread_local Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> sqrtInformation;
+    sqrtInformation = this->computeSqrtInformation(eval_->evaluateCovariance().inverse());
+    return sqrtInformation;
+  }
+
+  // Fast path, the cache is up to date (the stamp is read before the inputs are evaluated)
+  if (cachedStamp_.load(std::memory_order_acquire) == stamp) {
+    return sqrtInformation_;
+  }
+
+  // Re-evaluate, unless another thread did so while we waited for the lock
+  std::lock_guard<std::mutex> lock(cacheMutex_);
+  if (cachedStamp_.load(std::memory_order_relaxed) != stamp) {
+    sqrtInformation_ = this->computeSqrtInformation(eval_->evaluateCovariance().inverse());
+    cachedStamp_.store(stamp, std::memory_order_release);
+  }
+  return sqrtInformation_;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Get a reference to the square root information matrix
+/// \brief Get the square root information matrix
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& DynamicNoiseModel<MEAS_DIM>::getSqrtInformation() const {
-  this->setByCovariance(eval_->evaluateCovariance());
-  return this->sqrtInformation_;
+Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> DynamicNoiseModel<MEAS_DIM>::getSqrtInformation() const {
+  return this->currentSqrtInformation();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -36,8 +68,7 @@ const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& DynamicNoiseModel<MEAS_DIM>::getS
 template<int MEAS_DIM>
 double DynamicNoiseModel<MEAS_DIM>::getWhitenedErrorNorm(
     const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
-  this->setByCovariance(eval_->evaluateCovariance());
-  return (this->sqrtInformation_*rawError).norm();
+  return (this->currentSqrtInformation()*rawError).norm();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -46,8 +77,15 @@ double DynamicNoiseModel<MEAS_DIM>::getWhitenedErrorNorm(
 template<int MEAS_DIM>
 Eigen::Matrix<double,MEAS_DIM,1> DynamicNoiseModel<MEAS_DIM>::whitenError(
     const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
-  this->setByCovariance(eval_->evaluateCovariance());
-  return this->sqrtInformation_*rawError;
+  return this->currentSqrtInformation()*rawError;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns whether the evaluator reports an input stamp (not 0)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+bool DynamicNoiseModel<MEAS_DIM>::hasStampedInputs() const {
+  return eval_->getInputStamp() != 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -61,8 +99,8 @@ StaticNoiseModel<MEAS_DIM>::StaticNoiseModel() {
 /// \brief General constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-BaseNoiseModel<MEAS_DIM>::BaseNoiseModel(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix,
-                                 MatrixType type) {
+StaticNoiseModel<MEAS_DIM>::StaticNoiseModel(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix,
+                                             MatrixType type) {
 
   // Depending on the type of 'matrix', we set the internal storage
   switch(type) {
@@ -82,8 +120,8 @@ BaseNoiseModel<MEAS_DIM>::BaseNoiseModel(const Eigen::Matrix<double,MEAS_DIM,MEA
 /// \brief Set by covariance matrix
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-void BaseNoiseModel<MEAS_DIM>::setByCovariance(
-    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) const {
+void StaticNoiseModel<MEAS_DIM>::setByCovariance(
+    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) {
 
   // Information is the inverse of covariance
   this->setByInformation(matrix.inverse());
@@ -93,25 +131,47 @@ void BaseNoiseModel<MEAS_DIM>::setByCovariance(
 /// \brief Set by information matrix
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-void BaseNoiseModel<MEAS_DIM>::setByInformation(
-    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) const {
+void StaticNoiseModel<MEAS_DIM>::setByInformation(
+    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) {
 
-  // Check that the matrix is positive definite
-  this->assertPositiveDefiniteMatrix(matrix);
+  // Store upper triangular matrix (the square root information matrix)
+  this->setBySqrtInformation(this->computeSqrtInformation(matrix));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Whiten the rows of a raw Jacobian in place (one column at a time, so that the
+///        temporaries of fixed-size models live on the stack)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+void BaseNoiseModel<MEAS_DIM>::whitenJacobian(
+    Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const {
+  const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> sqrtInformation = this->getSqrtInformation();
+  for (int c = 0; c < jac.cols(); c++) {
+    jac.col(c) = sqrtInformation*jac.col(c);
+  }
+}
 
-  // Perform an LLT decomposition
-  Eigen::LLT<Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> > lltOfInformation(matrix);
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute the square root information of an information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> BaseNoiseModel<MEAS_DIM>::computeSqrtInformation(
+    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& information) const {
 
-  // Store upper triangular matrix (the square root information matrix)
-  this->setBySqrtInformation(lltOfInformation.matrixL().transpose());
+  // Check that the matrix is positive definite
+  this->assertPositiveDefiniteMatrix(information);
+
+  // Perform an LLT decomposition, the sqrt information is the upper triangular factor
+  Eigen::LLT<Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> > lltOfInformation(information);
+  return lltOfInformation.matrixL().transpose();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Set by square root of information matrix
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-void BaseNoiseModel<MEAS_DIM>::setBySqrtInformation(
-    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix)  const {
+void StaticNoiseModel<MEAS_DIM>::setBySqrtInformation(
+    const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) {
 
   // Set internal storage matrix
   sqrtInformation_ = matrix; // todo: check this is upper triangular
@@ -137,40 +197,293 @@ void BaseNoiseModel<MEAS_DIM>::assertPositiveDefiniteMatrix(
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief General constructor
+/// \brief Get the square root information matrix
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-StaticNoiseModel<MEAS_DIM>::StaticNoiseModel(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix,
-                                             MatrixType type) 
-: BaseNoiseModel<MEAS_DIM>::BaseNoiseModel(matrix,type) {
+Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> StaticNoiseModel<MEAS_DIM>::getSqrtInformation() const {
+  return sqrtInformation_;
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+double StaticNoiseModel<MEAS_DIM>::getWhitenedErrorNorm(
+    const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
+  return (sqrtInformation_*rawError).norm();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Get a reference to the square root information matrix
+/// \brief Get the whitened error vector, sqrtInformation*rawError
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& StaticNoiseModel<MEAS_DIM>::getSqrtInformation() const {
-  return this->sqrtInformation_;
+Eigen::Matrix<double,MEAS_DIM,1> StaticNoiseModel<MEAS_DIM>::whitenError(
+    const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
+  return sqrtInformation_*rawError;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor from the diagonal of a covariance, information or sqrt information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+DiagonalNoiseModel<MEAS_DIM>::DiagonalNoiseModel(const Eigen::Matrix<double,MEAS_DIM,1>& diagonal,
+                                                 MatrixType type) {
+
+  // Check that the matrix is positive definite
+  if (diagonal.size() == 0 || diagonal.minCoeff() <= 0) {
+    std::stringstream ss; ss << "Diagonal \n" << diagonal.transpose()
+                             << "\n must be strictly positive.";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Depending on the type of 'diagonal', we set the internal storage
+  switch(type) {
+    case COVARIANCE :
+      sqrtInfoDiagonal_ = diagonal.cwiseSqrt().cwiseInverse();
+      break;
+    case INFORMATION :
+      sqrtInfoDiagonal_ = diagonal.cwiseSqrt();
+      break;
+    case SQRT_INFORMATION :
+      sqrtInfoDiagonal_ = diagonal;
+      break;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the diagonal of the square root information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+const Eigen::Matrix<double,MEAS_DIM,1>&
+DiagonalNoiseModel<MEAS_DIM>::getSqrtInformationDiagonal() const {
+  return sqrtInfoDiagonal_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the square root information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> DiagonalNoiseModel<MEAS_DIM>::getSqrtInformation() const {
+  return sqrtInfoDiagonal_.asDiagonal();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-double StaticNoiseModel<MEAS_DIM>::getWhitenedErrorNorm(
+double DiagonalNoiseModel<MEAS_DIM>::getWhitenedErrorNorm(
     const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
-  return (this->sqrtInformation_*rawError).norm();
+  return sqrtInfoDiagonal_.cwiseProduct(rawError).norm();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Get the whitened error vector, sqrtInformation*rawError
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<int MEAS_DIM>
-Eigen::Matrix<double,MEAS_DIM,1> StaticNoiseModel<MEAS_DIM>::whitenError(
+Eigen::Matrix<double,MEAS_DIM,1> DiagonalNoiseModel<MEAS_DIM>::whitenError(
+    const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
+  return sqrtInfoDiagonal_.cwiseProduct(rawError);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Whiten the rows of a raw Jacobian in place (row scaling)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+void DiagonalNoiseModel<MEAS_DIM>::whitenJacobian(
+    Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const {
+  jac = sqrtInfoDiagonal_.asDiagonal()*jac;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor from the scalar covariance, information or sqrt information
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+IsotropicNoiseModel<MEAS_DIM>::IsotropicNoiseModel(double value, MatrixType type, int dim)
+  : dim_(dim) {
+
+  // Check the dimension and that the matrix is positive definite
+  if (dim <= 0 || (MEAS_DIM != Eigen::Dynamic && dim != MEAS_DIM)) {
+    throw std::invalid_argument("[IsotropicNoiseModel] invalid dimension.");
+  }
+  if (value <= 0) {
+    std::stringstream ss; ss << "Isotropic value " << value << " must be strictly positive.";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Depending on the type of 'value', we set the internal storage
+  switch(type) {
+    case COVARIANCE :
+      sqrtInfo_ = 1.0/std::sqrt(value);
+      break;
+    case INFORMATION :
+      sqrtInfo_ = std::sqrt(value);
+      break;
+    case SQRT_INFORMATION :
+      sqrtInfo_ = value;
+      break;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the scalar square root information
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+double IsotropicNoiseModel<MEAS_DIM>::getSqrtInformationScalar() const {
+  return sqrtInfo_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the square root information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> IsotropicNoiseModel<MEAS_DIM>::getSqrtInformation() const {
+  return sqrtInfo_*Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>::Identity(dim_, dim_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+double IsotropicNoiseModel<MEAS_DIM>::getWhitenedErrorNorm(
+    const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
+  return sqrtInfo_*rawError.norm();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the whitened error vector, sqrtInformation*rawError
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+Eigen::Matrix<double,MEAS_DIM,1> IsotropicNoiseModel<MEAS_DIM>::whitenError(
     const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
-  return this->sqrtInformation_*rawError;
+  return sqrtInfo_*rawError;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Whiten a raw Jacobian in place (scaling)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM>
+void IsotropicNoiseModel<MEAS_DIM>::whitenJacobian(
+    Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const {
+  jac *= sqrtInfo_;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor from the diagonal blocks of a covariance, information or sqrt
+///        information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::BlockDiagonalNoiseModel(const BlockVectorType& blocks,
+                                                                     MatrixType type) {
+
+  static_assert(BLOCK_DIM > 0, "BLOCK_DIM must be fixed and positive.");
+  static_assert(MEAS_DIM == Eigen::Dynamic || MEAS_DIM % BLOCK_DIM == 0,
+                "MEAS_DIM must be a multiple of BLOCK_DIM.");
+
+  const int dim = blocks.size()*BLOCK_DIM;
+  if (dim == 0 || (MEAS_DIM != Eigen::Dynamic && dim != MEAS_DIM)) {
+    throw std::invalid_argument("[BlockDiagonalNoiseModel] the blocks do not match the "
+                                "measurement dimension.");
+  }
+
+  // The sqrt information (upper-triangular factor) of a block-diagonal matrix is block-diagonal
+  sqrtInfoBlocks_.resize(blocks.size());
+  for (unsigned int i = 0; i < blocks.size(); i++) {
+    sqrtInfoBlocks_[i] = computeBlockSqrtInformation(blocks[i], type);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute the (upper-triangular) square root information of a block
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+typename BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::BlockType
+BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::computeBlockSqrtInformation(const BlockType& block,
+                                                                         MatrixType type) {
+
+  // The sqrt information is stored as given
+  if (type == SQRT_INFORMATION) {
+    return block;
+  }
+
+  // Check that the information matrix is positive definite
+  const BlockType information = type == COVARIANCE ? BlockType(block.inverse()) : block;
+  Eigen::SelfAdjointEigenSolver<BlockType> eigsolver(information, Eigen::EigenvaluesOnly);
+  if (eigsolver.eigenvalues().minCoeff() <= 0) {
+    std::stringstream ss; ss << "Block \n" << block << "\n must be positive definite. "
+                             << "Min. eigenvalue : " << eigsolver.eigenvalues().minCoeff();
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Perform an LLT decomposition, the sqrt information is the upper triangular factor
+  Eigen::LLT<BlockType> lltOfInformation(information);
+  return lltOfInformation.matrixL().transpose();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the (upper-triangular) diagonal blocks of the square root information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+const typename BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::BlockVectorType&
+BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::getSqrtInformationBlocks() const {
+  return sqrtInfoBlocks_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the square root information matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>
+BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::getSqrtInformation() const {
+  const int dim = sqrtInfoBlocks_.size()*BLOCK_DIM;
+  Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> matrix = Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>::Zero(dim, dim);
+  for (unsigned int i = 0; i < sqrtInfoBlocks_.size(); i++) {
+    matrix.template block<BLOCK_DIM,BLOCK_DIM>(i*BLOCK_DIM, i*BLOCK_DIM) = sqrtInfoBlocks_[i];
+  }
+  return matrix;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+double BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::getWhitenedErrorNorm(
+    const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
+  double squaredNorm = 0.0;
+  for (unsigned int i = 0; i < sqrtInfoBlocks_.size(); i++) {
+    squaredNorm += (sqrtInfoBlocks_[i].template triangularView<Eigen::Upper>()*
+                    rawError.template segment<BLOCK_DIM>(i*BLOCK_DIM)).squaredNorm();
+  }
+  return std::sqrt(squaredNorm);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the whitened error vector, sqrtInformation*rawError
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+Eigen::Matrix<double,MEAS_DIM,1> BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::whitenError(
+    const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const {
+  Eigen::Matrix<double,MEAS_DIM,1> whitened(rawError.size());
+  for (unsigned int i = 0; i < sqrtInfoBlocks_.size(); i++) {
+    whitened.template segment<BLOCK_DIM>(i*BLOCK_DIM) =
+        sqrtInfoBlocks_[i].template triangularView<Eigen::Upper>()*
+        rawError.template segment<BLOCK_DIM>(i*BLOCK_DIM);
+  }
+  return whitened;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Whiten the rows of a raw Jacobian in place (one block of rows at a time)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<int MEAS_DIM, int BLOCK_DIM>
+void BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM>::whitenJacobian(
+    Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const {
+  for (int c = 0; c < jac.cols(); c++) {
+    for (unsigned int i = 0; i < sqrtInfoBlocks_.size(); i++) {
+      jac.col(c).template segment<BLOCK_DIM>(i*BLOCK_DIM) =
+          sqrtInfoBlocks_[i].template triangularView<Eigen::Upper>()*
+          jac.col(c).template segment<BLOCK_DIM>(i*BLOCK_DIM);
+    }
+  }
+}
 
 } // steam
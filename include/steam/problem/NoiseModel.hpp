@@ -9,7 +9,13 @@
 
 #include <Eigen/Dense>
 #include <boost/shared_ptr.hpp>
+#include <atomic>
 #include <mutex>
+#include <vector>
+
+#include <Eigen/StdVector>
+
+#include <steam/state/StateVariableBase.hpp>
 
 namespace steam {
 
@@ -33,6 +39,16 @@ public:
     return evaluate();
   }
 
+  /// \brief Stamp of the inputs of the model (see StampGenerator). DynamicNoiseModel only
+  ///        re-evaluates the covariance when the stamp changes. The default, 0, means that
+  ///        the inputs are unknown and the covariance is re-evaluated on every request (into
+  ///        thread-local storage, so that concurrent requests do not share a cache).
+  ///        Models that only depend on state variables can return the latest stamp of those
+  ///        states, or conservatively StampGenerator::getLatestStamp().
+  virtual StateStamp getInputStamp() const {
+    return 0;
+  }
+
 protected:
   /// \brief Evaluates the uncertainty based on a derived model.
   /// \return the uncertainty, in the form of a covariance matrix.
@@ -54,12 +70,6 @@ class BaseNoiseModel
   /// \brief Default constructor.
   BaseNoiseModel()=default;
 
-  /// \brief Constructor
-  /// \brief A noise matrix, determined by the type parameter.
-  /// \brief The type of noise matrix set in the previous paramter.
-  BaseNoiseModel(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix,
-             MatrixType type = COVARIANCE);
-
   /// \brief Deault destructor
   virtual ~BaseNoiseModel() = default;
 
@@ -68,36 +78,32 @@ class BaseNoiseModel
   typedef boost::shared_ptr<const BaseNoiseModel<MEAS_DIM> > ConstPtr;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Set by covariance matrix
+  /// \brief Get the square root information matrix (structured models assemble it on
+  ///        request, whitening should use whitenError and whitenJacobian)
   //////////////////////////////////////////////////////////////////////////////////////////////
-  void setByCovariance(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) const;
+  virtual Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> getSqrtInformation() const = 0;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Set by information matrix
+  /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
   //////////////////////////////////////////////////////////////////////////////////////////////
-  void setByInformation(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) const ;
+  virtual double getWhitenedErrorNorm(const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const = 0;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Set by square root of information matrix
+  /// \brief Get the whitened error vector, sqrtInformation*rawError
   //////////////////////////////////////////////////////////////////////////////////////////////
-  void setBySqrtInformation(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) const ;
+  virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
+      const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const = 0;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Get a reference to the square root information matrix
+  /// \brief Whiten the rows of a raw Jacobian in place, sqrtInformation*jacobian
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& getSqrtInformation() const = 0;
-
+  virtual void whitenJacobian(Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+  /// \brief Returns whether the noise only changes when a state variable changes (see
+  ///        StampGenerator), true for static noise models
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual double getWhitenedErrorNorm(const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const = 0;
-
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Get the whitened error vector, sqrtInformation*rawError
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
-      const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const = 0;
+  virtual bool hasStampedInputs() const { return true; }
 
  protected:
 
@@ -107,14 +113,10 @@ class BaseNoiseModel
   void assertPositiveDefiniteMatrix(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix) const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief The square root information (found by performing an LLT decomposition on the
-  ///        information matrix (inverse covariance matrix). This triangular matrix is
-  ///        stored directly for faster error whitening.
+  /// \brief Compute the square root information of an information matrix (without storing it)
   //////////////////////////////////////////////////////////////////////////////////////////////
-  mutable Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> sqrtInformation_;
-
- private:
-
+  Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> computeSqrtInformation(
+      const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& information) const;
 };
 
 /// @class StaticNoiseModel Noise model for uncertainties that do not change during the 
@@ -139,11 +141,25 @@ class StaticNoiseModel : public BaseNoiseModel<MEAS_DIM>
   StaticNoiseModel(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix,
              MatrixType type = COVARIANCE);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set by covariance matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void setByCovariance(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set by information matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void setByInformation(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix);
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Get a reference to the square root information matrix
+  /// \brief Set by square root of information matrix
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& getSqrtInformation() const;
+  void setBySqrtInformation(const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& matrix);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the square root information matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> getSqrtInformation() const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
@@ -156,8 +172,183 @@ class StaticNoiseModel : public BaseNoiseModel<MEAS_DIM>
   virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
       const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
 
-private:
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief The square root information (found by performing an LLT decomposition on the
+  ///        information matrix (inverse covariance matrix). This triangular matrix is
+  ///        stored directly for faster error whitening.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> sqrtInformation_;
+};
+
+/// @class DiagonalNoiseModel Static noise model with a diagonal covariance. Whitening is an
+///        element-wise product, so a single instance can be shared by many cost terms cheaply.
+template <int MEAS_DIM>
+class DiagonalNoiseModel : public BaseNoiseModel<MEAS_DIM>
+{
+ public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<DiagonalNoiseModel<MEAS_DIM> > Ptr;
+  typedef boost::shared_ptr<const DiagonalNoiseModel<MEAS_DIM> > ConstPtr;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor from the diagonal of a covariance, information or sqrt information
+  ///        matrix (determined by the type parameter)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  DiagonalNoiseModel(const Eigen::Matrix<double,MEAS_DIM,1>& diagonal,
+                     MatrixType type = COVARIANCE);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the diagonal of the square root information matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const Eigen::Matrix<double,MEAS_DIM,1>& getSqrtInformationDiagonal() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the square root information matrix (assembled, it is not stored)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> getSqrtInformation() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual double getWhitenedErrorNorm(const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the whitened error vector, sqrtInformation*rawError
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
+      const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whiten the rows of a raw Jacobian in place (row scaling)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void whitenJacobian(Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Diagonal of the square root information matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  Eigen::Matrix<double,MEAS_DIM,1> sqrtInfoDiagonal_;
+};
+
+/// @class IsotropicNoiseModel Static noise model with an isotropic covariance (a scalar multiple
+///        of identity). Whitening is a single scaling.
+template <int MEAS_DIM>
+class IsotropicNoiseModel : public BaseNoiseModel<MEAS_DIM>
+{
+ public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<IsotropicNoiseModel<MEAS_DIM> > Ptr;
+  typedef boost::shared_ptr<const IsotropicNoiseModel<MEAS_DIM> > ConstPtr;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor from the scalar covariance, information or sqrt information (determined
+  ///        by the type parameter). The dimension only needs to be set if MEAS_DIM is dynamic.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  IsotropicNoiseModel(double value, MatrixType type = COVARIANCE, int dim = MEAS_DIM);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the scalar square root information
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  double getSqrtInformationScalar() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the square root information matrix (assembled, it is not stored)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> getSqrtInformation() const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual double getWhitenedErrorNorm(const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the whitened error vector, sqrtInformation*rawError
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
+      const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whiten a raw Jacobian in place (scaling)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void whitenJacobian(Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Scalar square root information
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  double sqrtInfo_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Measurement dimension
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  int dim_;
+};
+
+/// @class BlockDiagonalNoiseModel Static noise model with a block-diagonal covariance made of
+///        BLOCK_DIM x BLOCK_DIM blocks (e.g. independent 3D points). Whitening is one small
+///        triangular product per block, rather than a full MEAS_DIM x MEAS_DIM product.
+template <int MEAS_DIM, int BLOCK_DIM>
+class BlockDiagonalNoiseModel : public BaseNoiseModel<MEAS_DIM>
+{
+ public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM> > Ptr;
+  typedef boost::shared_ptr<const BlockDiagonalNoiseModel<MEAS_DIM,BLOCK_DIM> > ConstPtr;
+
+  /// Block types
+  typedef Eigen::Matrix<double,BLOCK_DIM,BLOCK_DIM> BlockType;
+  typedef std::vector<BlockType, Eigen::aligned_allocator<BlockType> > BlockVectorType;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor from the diagonal blocks of a covariance, information or sqrt
+  ///        information matrix (determined by the type parameter)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  BlockDiagonalNoiseModel(const BlockVectorType& blocks, MatrixType type = COVARIANCE);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the (upper-triangular) diagonal blocks of the square root information matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const BlockVectorType& getSqrtInformationBlocks() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the square root information matrix (assembled, it is not stored)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> getSqrtInformation() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual double getWhitenedErrorNorm(const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the whitened error vector, sqrtInformation*rawError
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
+      const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whiten the rows of a raw Jacobian in place (one block of rows at a time)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void whitenJacobian(Eigen::Ref<Eigen::Matrix<double,MEAS_DIM,Eigen::Dynamic> > jac) const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the (upper-triangular) square root information of a block
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  static BlockType computeBlockSqrtInformation(const BlockType& block, MatrixType type);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Upper-triangular diagonal blocks of the square root information matrix
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  BlockVectorType sqrtInfoBlocks_;
 };
 
 /// \brief DynamicNoiseModel Noise model for uncertainties that change during the steam optimization
@@ -173,10 +364,14 @@ class DynamicNoiseModel : public BaseNoiseModel<MEAS_DIM>
   /// \brief Deault destructor.
   ~DynamicNoiseModel()=default;
 
+  /// Convenience typedefs
+  typedef boost::shared_ptr<DynamicNoiseModel<MEAS_DIM> > Ptr;
+  typedef boost::shared_ptr<const DynamicNoiseModel<MEAS_DIM> > ConstPtr;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Get a reference to the square root information matrix
+  /// \brief Get the square root information matrix
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& getSqrtInformation() const;
+  virtual Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> getSqrtInformation() const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Get the norm of the whitened error vector, sqrt(rawError^T * info * rawError)
@@ -189,9 +384,30 @@ class DynamicNoiseModel : public BaseNoiseModel<MEAS_DIM>
   virtual Eigen::Matrix<double,MEAS_DIM,1> whitenError(
       const Eigen::Matrix<double,MEAS_DIM,1>& rawError) const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns whether the evaluator reports an input stamp (not 0)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool hasStampedInputs() const;
+
  private:
+  /// \brief Get the sqrt information for the current inputs of the evaluator. If the input
+  ///        stamp is known, this is the cache (re-evaluated when the stamp changes, then a
+  ///        lock-free check), so that cost terms evaluated in parallel share it read-only. If
+  ///        the stamp is 0, the sqrt information is evaluated into thread-local storage, valid
+  ///        until the next call on the same thread, and the cache is left untouched.
+  const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>& currentSqrtInformation() const;
+
   /// \brief A pointer to a noise evaluator.
   boost::shared_ptr<NoiseEvaluator<MEAS_DIM>> eval_;
+
+  /// \brief Cached sqrt information, for the input stamp cachedStamp_
+  mutable Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> sqrtInformation_;
+
+  /// \brief Input stamp of the cached sqrt information (0 if it must be re-evaluated)
+  mutable std::atomic<StateStamp> cachedStamp_;
+
+  /// \brief Serializes re-evaluation of the cache
+  mutable std::mutex cacheMutex_;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////
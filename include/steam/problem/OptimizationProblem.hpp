@@ -9,7 +9,9 @@
 
 #include <Eigen/Core>
 #include <Eigen/Sparse>
+#include <boost/unordered_map.hpp>
 
+#include <steam/common/MemoryUsage.hpp>
 #include <steam/state/StateVector.hpp>
 #include <steam/problem/ParallelizedCostTermCollection.hpp>
 
@@ -18,11 +20,27 @@ namespace steam {
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Container for active state variables and cost terms associated with the
 ///        optimization problem to be solved.
+///
+///        States and cost terms can be added and removed incrementally (e.g. for sliding-window
+///        estimation). Changes to the set of states are logged, so that solvers constructed on
+///        the problem can patch their state vector rather than rebuild it.
 //////////////////////////////////////////////////////////////////////////////////////////////
 class OptimizationProblem
 {
  public:
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Logged change to the set of state variables
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct StateChange
+  {
+    /// State that was added or removed
+    StateVariableBase::Ptr state;
+
+    /// Whether the state was added (true) or removed (false)
+    bool added;
+  };
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Default constructor
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,11 +51,34 @@ class OptimizationProblem
   //////////////////////////////////////////////////////////////////////////////////////////////
   void addStateVariable(const StateVariableBase::Ptr& statevar);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Remove a state variable. Cost terms that depend on the state should be removed
+  ///        (or the state locked) before solving again.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void removeStateVariable(const StateKey& key);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Check if a state variable has been added to the problem
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool hasStateVariable(const StateKey& key) const;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Add a cost term (should depend on active states that were added to the problem)
   //////////////////////////////////////////////////////////////////////////////////////////////
   void addCostTerm(const CostTermBase::ConstPtr& costTerm);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Remove a cost term
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void removeCostTerm(const CostTermBase::ConstPtr& costTerm);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Attach a profiler to the single-threaded cost terms (NULL to detach). Collections
+  ///        added with addCostTerm are evaluated one at a time, so a ParallelizedCostTermCollection
+  ///        among them can be given the same profiler (see its setProfiler).
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void setCostTermProfiler(const CostTermProfiler::Ptr& profiler);
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Compute the cost from the collection of cost terms
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -54,11 +95,31 @@ class OptimizationProblem
   unsigned int getNumberOfCostTerms() const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Fill in the supplied block matrices
+  /// \brief Get the structure revision, which is incremented whenever a state or cost term
+  ///        is added or removed
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getStructureRevision() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the total number of state changes (additions and removals) made so far
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getNumberOfStateChanges() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the state changes made after the first 'numChanges' changes, in order.
+  ///        The log is periodically trimmed; returns false if it no longer covers the
+  ///        requested changes (in which case the caller should rebuild from scratch).
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool getStateChangesSince(unsigned int numChanges, std::vector<StateChange>* changes) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Fill in the supplied block matrices. If 'memoryUsage' is given, the bytes of the
+  ///        block-sparse and compressed approximate Hessians are recorded in it.
   //////////////////////////////////////////////////////////////////////////////////////////////
   void buildGaussNewtonTerms(const StateVector& stateVector,
                              Eigen::SparseMatrix<double>* approximateHessian,
-                             Eigen::VectorXd* gradientVector) const;
+                             Eigen::VectorXd* gradientVector,
+                             MemoryUsage* memoryUsage = NULL) const;
 
  private:
 
@@ -76,6 +137,27 @@ class OptimizationProblem
   /// \brief Collection of state variables
   //////////////////////////////////////////////////////////////////////////////////////////////
   std::vector<StateVariableBase::Ptr> stateVariables_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Position of each state variable in stateVariables_ (for removal)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  boost::unordered_map<StateID, unsigned int> stateIndices_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Log of the most recent state changes, and the number of changes trimmed from it
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<StateChange> stateChanges_;
+  unsigned int numTrimmedStateChanges_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure revision
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int structureRevision_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Append to the state change log (trims it once it is large relative to the problem)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void logStateChange(const StateVariableBase::Ptr& state, bool added);
 };
 
 } // namespace steam
@@ -8,8 +8,10 @@
 #define STEAM_PARALLELIZED_COST_TERM_COLLECTION_HPP
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <steam/problem/CostTermBase.hpp>
+#include <steam/problem/CostTermProfiler.hpp>
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// The define STEAM_DEFAULT_NUM_OPENMP_THREADS can be used to set the default template
@@ -44,12 +46,25 @@ class ParallelizedCostTermCollection : public CostTermBase
   ParallelizedCostTermCollection(unsigned int numThreads = STEAM_DEFAULT_NUM_OPENMP_THREADS);
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Add a cost term
+  /// \brief Add a cost term (a cost term may be added more than once, it then contributes
+  ///        once per addition)
   //////////////////////////////////////////////////////////////////////////////////////////////
   void add(const CostTermBase::ConstPtr& costTerm);
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Compute the cost from the collection of cost terms
+  /// \brief Remove a cost term (one addition of it, if it was added more than once). O(1),
+  ///        the last cost term is moved into the freed position; the pointer-to-index map is
+  ///        built on the first removal. Returns false if the cost term is not in the collection.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool remove(const CostTermBase::ConstPtr& costTerm);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the cost from the collection of cost terms. Cost terms are processed in
+  ///        blocks; the whitened error norms of robust terms (see
+  ///        CostTermBase::getLossFunction) are gathered and each run of terms that share a loss
+  ///        function is evaluated with a single batched call. The norms of terms with stamped
+  ///        inputs (see CostTermBase::hasStampedInputs) are kept so that a following
+  ///        buildGaussNewtonTerms at the same state can reuse them for the weights.
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual double cost() const;
 
@@ -65,15 +80,43 @@ class ParallelizedCostTermCollection : public CostTermBase
 
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Build the left-hand and right-hand sides of the Gauss-Newton system of equations
-  ///        using the cost terms in this collection.
+  ///        using the cost terms in this collection. If no state variable has changed since
+  ///        the last call to cost(), the loss weights are computed in batches from the stored
+  ///        whitened error norms; otherwise, and for terms whose norm was not stored (inputs
+  ///        that are not stamped, or a failed evaluation), each cost term computes its own
+  ///        weight.
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual void buildGaussNewtonTerms(const StateVector& stateVector,
                                      BlockSparseMatrix* approximateHessian,
                                      BlockVector* gradientVector) const;
 
   virtual std::vector<double> costs() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Attach a profiler that attributes the time spent in cost() and
+  ///        buildGaussNewtonTerms() to the cost-term types (NULL to detach). A profiler must
+  ///        not be shared by collections that are evaluated concurrently.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void setProfiler(const CostTermProfiler::Ptr& profiler);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the attached profiler (NULL if none)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const CostTermProfiler::Ptr& getProfiler() const;
+
  private:
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Number of cost terms per block in the batched cost and weight evaluation
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  static const unsigned int BATCH_SIZE = 256;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the loss functions of a block of cost terms, returns whether any are robust
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool getLossFunctions(unsigned int begin, unsigned int end,
+                        const LossFunctionBase** losses) const;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Number of threads
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -83,6 +126,35 @@ class ParallelizedCostTermCollection : public CostTermBase
   /// \brief Collection of nonlinear cost-term factors
   //////////////////////////////////////////////////////////////////////////////////////////////
   std::vector<CostTermBase::ConstPtr> costTerms_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Positions of each cost term in costTerms_ (for removal), and whether they are
+  ///        maintained (from the first removal on)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  typedef boost::unordered_multimap<const CostTermBase*, unsigned int> IndexMap;
+  IndexMap indices_;
+  bool indexed_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whitened error norms of the robust cost terms (NaN where a norm may not be
+  ///        reused), and the (latest) state stamp at which they were computed
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct NormCache {
+    std::vector<double> norms;
+    StateStamp stamp;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Norms from the last call to cost() (NULL if none, or if the collection changed
+  ///        since). cost() fills a new cache and publishes it with boost::atomic_store, so
+  ///        concurrent calls to cost() and buildGaussNewtonTerms() do not race.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  mutable boost::shared_ptr<const NormCache> norms_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Optional profiler
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  CostTermProfiler::Ptr profiler_;
 };
 
 } // steam
@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file StereoCostTermCollection.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_STEREO_COST_TERM_COLLECTION_HPP
+#define STEAM_STEREO_COST_TERM_COLLECTION_HPP
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <steam/problem/CostTermBase.hpp>
+#include <steam/problem/NoiseModel.hpp>
+#include <steam/problem/ParallelizedCostTermCollection.hpp>
+#include <steam/problem/lossfunc/LossFunctionBase.hpp>
+#include <steam/state/LieGroupStateVar.hpp>
+#include <steam/state/LandmarkStateVar.hpp>
+#include <steam/evaluator/samples/StereoCameraErrorEval.hpp>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Homogeneous collection of stereo camera cost terms, for large bundle adjustment
+///        problems. Each term is equivalent to a WeightedLeastSqCostTerm<4,6> over a
+///        StereoCameraErrorEval with the pose chain T_cam_vehicle * T_vehicle_map, where the
+///        camera intrinsics, extrinsic calibration (T_cam_vehicle), noise model and loss
+///        function are shared by all terms.
+///
+///        Rather than one heap-allocated cost term and evaluator chain per measurement, the
+///        measurements and pose/landmark indices are stored as structure-of-arrays, and the
+///        cost and Gauss-Newton terms are computed in tight loops over blocks of terms (with
+///        no per-term virtual calls or shared-pointer copies). The collection is added to an
+///        OptimizationProblem as a single (parallelized) cost term.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class StereoCostTermCollection : public CostTermBase
+{
+ public:
+
+  /// Convenience typedefs
+  typedef boost::shared_ptr<StereoCostTermCollection> Ptr;
+  typedef boost::shared_ptr<const StereoCostTermCollection> ConstPtr;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor. Note that the noise model is queried once per cost or linearization
+  ///        pass, so a dynamic noise model must not depend on the individual measurement.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  StereoCostTermCollection(const stereo::CameraIntrinsics& intrinsics,
+                           const lgmath::se3::Transformation& T_cam_vehicle,
+                           const BaseNoiseModel<4>::ConstPtr& noiseModel,
+                           const LossFunctionBase::ConstPtr& lossFunc,
+                           unsigned int numThreads = STEAM_DEFAULT_NUM_OPENMP_THREADS);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Register a vehicle pose, T_vehicle_map, returns its index for add()
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int addPose(const se3::TransformStateVar::Ptr& T_vehicle_map);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Register a landmark (in the map frame), returns its index for add()
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int addLandmark(const se3::LandmarkStateVar::Ptr& landmark);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Reserve storage for a number of measurements
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void reserve(unsigned int numMeasurements);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add a stereo measurement (ul vl ur vr) of a registered landmark from a registered
+  ///        pose
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void add(const Eigen::Vector4d& meas, unsigned int poseIndex, unsigned int landmarkIndex);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add a batch of n stereo measurements, given as structure-of-arrays (measurements[k]
+  ///        holds coordinate k of each measurement), with their pose and landmark indices
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void add(unsigned int n, const double* const measurements[4], const unsigned int* poseIndices,
+           const unsigned int* landmarkIndices);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the shared camera intrinsics and extrinsic calibration (T_cam_vehicle)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const stereo::CameraIntrinsics& getIntrinsics() const;
+  const lgmath::se3::Transformation& getCamVehicleTransform() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the shared noise model and loss function
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const BaseNoiseModel<4>::ConstPtr& getNoiseModel() const;
+  const LossFunctionBase::ConstPtr& getLossFunc() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of threads
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getNumThreads() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the registered poses and landmarks (in registration order)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const std::vector<se3::TransformStateVar::Ptr>& getPoses() const;
+  const std::vector<se3::LandmarkStateVar::Ptr>& getLandmarks() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get coordinate k (ul vl ur vr) of every measurement, and the pose and landmark
+  ///        index of every measurement
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const std::vector<double>& getMeasurements(unsigned int k) const;
+  const std::vector<unsigned int>& getPoseIndices() const;
+  const std::vector<unsigned int>& getLandmarkIndices() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the cost from the collection of cost terms
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual double cost() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns the number of cost terms contained by this object
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int numCostTerms() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns whether or not the implementation already uses multi-threading
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool isImplParallelized() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Build the left-hand and right-hand sides of the Gauss-Newton system of equations
+  ///        using the cost terms in this collection.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void buildGaussNewtonTerms(const StateVector& stateVector,
+                                     BlockSparseMatrix* approximateHessian,
+                                     BlockVector* gradientVector) const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Number of cost terms per block
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  static const unsigned int BATCH_SIZE = 256;
+
+  /// Aligned vector of 4x4 matrices
+  typedef std::vector<Eigen::Matrix4d, Eigen::aligned_allocator<Eigen::Matrix4d> > Matrix4dVector;
+
+  /// Per-block structure-of-arrays buffers (see stereo::cameraModelBatch)
+  typedef Eigen::Matrix<double,4,BATCH_SIZE,Eigen::RowMajor> PointBlock;
+  typedef Eigen::Matrix<double,16,BATCH_SIZE,Eigen::RowMajor> JacobianBlock;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute T_cam_map = T_cam_vehicle * T_vehicle_map for every pose
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void computeCameraPoses(Matrix4dVector* T_cam_map) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the landmarks in the camera frame, the whitened errors and their norms,
+  ///        and optionally the camera model Jacobians, for the terms [begin, end)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void evaluateBlock(unsigned int begin, unsigned int end,
+                     const Matrix4dVector& T_cam_map,
+                     const Eigen::Matrix4d& sqrtInformation,
+                     PointBlock* points,
+                     PointBlock* whitenedErrors,
+                     double* norms,
+                     JacobianBlock* cameraJacobians = NULL) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Shared camera intrinsics and extrinsic calibration
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  stereo::CameraIntrinsics intrinsics_;
+  lgmath::se3::Transformation T_cam_vehicle_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Shared noise model and loss function
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  BaseNoiseModel<4>::ConstPtr noiseModel_;
+  LossFunctionBase::ConstPtr lossFunc_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether the noise model is diagonal (DiagonalNoiseModel or IsotropicNoiseModel),
+  ///        and the diagonal of its sqrt information, used to whiten by row scaling
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool diagonalNoise_;
+  Eigen::Vector4d sqrtInfoDiagonal_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Number of threads
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const unsigned int numThreads_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Registered poses and landmarks
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<se3::TransformStateVar::Ptr> poses_;
+  std::vector<se3::LandmarkStateVar::Ptr> landmarks_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Measurements as structure-of-arrays, measurements_[k][i] is coordinate k
+  ///        (ul vl ur vr) of term i
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<double> measurements_[4];
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Pose and landmark index of each term
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<unsigned int> poseIndices_;
+  std::vector<unsigned int> landmarkIndices_;
+};
+
+} // steam
+
+#endif // STEAM_STEREO_COST_TERM_COLLECTION_HPP
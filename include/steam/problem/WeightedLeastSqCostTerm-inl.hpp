@@ -29,7 +29,7 @@ WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::WeightedLeastSqCostTerm(
 template <int MEAS_DIM, int MAX_STATE_SIZE>
 double WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::cost() const
 {
-  return lossFunc_->cost(noiseModel_->getWhitenedErrorNorm(errorFunction_->evaluate()));
+  return lossFunc_->cost(this->whitenedErrorNorm());
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -58,6 +58,115 @@ void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::buildGaussNewtonTerms(
     BlockSparseMatrix* approximateHessian,
     BlockVector* gradientVector) const {
 
+  // Compute the whitened errors and jacobians
+  // err = sqrt(R^-1)*rawError
+  // jac = sqrt(R^-1)*rawJacobian
+  std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> > jacobians;
+  Eigen::Matrix<double,MEAS_DIM,1> error = this->evalWhitened(&jacobians);
+
+  // Get weight from loss function and add the contributions
+  this->addGaussNewtonTerms(stateVector, approximateHessian, gradientVector, error, jacobians,
+                            lossFunc_->weight(error.norm()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns the loss function (the cost is loss(whitenedErrorNorm()))
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+const LossFunctionBase* WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::getLossFunction() const {
+  return lossFunc_.get();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute the norm of the whitened error, sqrt(e^T * cov^{-1} * e)
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+double WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::whitenedErrorNorm() const {
+  return noiseModel_->getWhitenedErrorNorm(errorFunction_->evaluate());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns whether the noise model has stamped inputs
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+bool WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::hasStampedInputs() const {
+  return noiseModel_->hasStampedInputs();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the contribution of this cost term to the Gauss-Newton system of equations,
+///        using a precomputed loss-function weight
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::buildReweightedGaussNewtonTerms(
+    const StateVector& stateVector,
+    BlockSparseMatrix* approximateHessian,
+    BlockVector* gradientVector,
+    double weight) const {
+
+  std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> > jacobians;
+  Eigen::Matrix<double,MEAS_DIM,1> error = this->evalWhitened(&jacobians);
+  this->addGaussNewtonTerms(stateVector, approximateHessian, gradientVector, error, jacobians,
+                            weight);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns the type of the error evaluator, which the time spent in this cost term is
+///        attributed to by a CostTermProfiler
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+const std::type_info& WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::getProfileType() const {
+  return typeid(*errorFunction_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate the whitened error vector and Jacobians, as in:
+///              error = sqrt(cov^-1)*rawError
+///           jacobian = sqrt(cov^-1)*rawJacobian
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+Eigen::Matrix<double,MEAS_DIM,1> WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::evalWhitened(
+    std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+
+  // Check and initialize jacobian array
+  if (outJacobians == NULL) {
+    throw std::invalid_argument("Null pointer provided to return-input 'jacs' in evaluate");
+  }
+  outJacobians->clear();
+
+  // Get raw error and Jacobians, and whiten the Jacobians (the noise model exploits its
+  // structure, e.g. diagonal models scale the rows)
+  Eigen::Matrix<double,MEAS_DIM,1> rawError;
+  if (MEAS_DIM != Eigen::Dynamic) {
+    static const Eigen::Matrix<double,MEAS_DIM,MEAS_DIM> identity =
+        Eigen::Matrix<double,MEAS_DIM,MEAS_DIM>::Identity(MEAS_DIM, MEAS_DIM);
+    rawError = errorFunction_->evaluate(identity, outJacobians);
+    for (unsigned int i = 0; i < outJacobians->size(); i++) {
+      noiseModel_->whitenJacobian((*outJacobians)[i].jac);
+    }
+  } else {
+    // The dimension is only known at run time, the sqrt information is the left-hand side
+    rawError = errorFunction_->evaluate(noiseModel_->getSqrtInformation(), outJacobians);
+  }
+
+  // Get whitened error vector
+  return noiseModel_->whitenError(rawError);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the iteratively reweighted contribution of the whitened error and Jacobians,
+///        weight*J^T*J and -weight*J^T*e, to the Gauss-Newton system of equations. Applying
+///        the weight to the (small) outputs avoids a sqrt and scaling every Jacobian.
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int MEAS_DIM, int MAX_STATE_SIZE>
+void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::addGaussNewtonTerms(
+    const StateVector& stateVector,
+    BlockSparseMatrix* approximateHessian,
+    BlockVector* gradientVector,
+    const Eigen::Matrix<double,MEAS_DIM,1>& error,
+    const std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> >& jacobians,
+    double weight) const {
+
   // Get square block indices (we know the hessian is block-symmetric)
   const std::vector<unsigned int>& blkSizes =
       approximateHessian->getIndexing().rowIndexing().blkSizes();
@@ -66,12 +175,6 @@ void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::buildGaussNewtonTerms(
   Eigen::Matrix<double,Eigen::Dynamic,Eigen::Dynamic,0,MAX_STATE_SIZE,MAX_STATE_SIZE> newHessianTerm;
   Eigen::Matrix<double,Eigen::Dynamic,Eigen::Dynamic,0,MAX_STATE_SIZE,1> newGradTerm;
 
-  // Compute the weighted and whitened errors and jacobians
-  // err = sqrt(w)*sqrt(R^-1)*rawError
-  // jac = sqrt(w)*sqrt(R^-1)*rawJacobian
-  std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> > jacobians;
-  Eigen::Matrix<double,MEAS_DIM,1> error = this->evalWeightedAndWhitened(&jacobians);
-
   // For each jacobian
   for (unsigned int i = 0; i < jacobians.size(); i++) {
 
@@ -80,7 +183,7 @@ void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::buildGaussNewtonTerms(
 
     // Calculate terms needed to update the right-hand-side
     unsigned int size1 = blkSizes.at(blkIdx1);
-    newGradTerm = (-1)*jacobians[i].jac.leftCols(size1).transpose()*error;
+    newGradTerm = (-weight)*(jacobians[i].jac.leftCols(size1).transpose()*error);
 
     // Update the right-hand side (thread critical)
     #pragma omp critical(b_update)
@@ -101,11 +204,11 @@ void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::buildGaussNewtonTerms(
       if (blkIdx1 <= blkIdx2) {
         row = blkIdx1;
         col = blkIdx2;
-        newHessianTerm = jacobians[i].jac.leftCols(size1).transpose()*jacobians[j].jac.leftCols(size2);
+        newHessianTerm = weight*(jacobians[i].jac.leftCols(size1).transpose()*jacobians[j].jac.leftCols(size2));
       } else {
         row = blkIdx2;
         col = blkIdx1;
-        newHessianTerm = jacobians[j].jac.leftCols(size2).transpose()*jacobians[i].jac.leftCols(size1);
+        newHessianTerm = weight*(jacobians[j].jac.leftCols(size2).transpose()*jacobians[i].jac.leftCols(size1));
       }
 
       // Update the left-hand side (thread critical)
@@ -116,42 +219,13 @@ void WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::buildGaussNewtonTerms(
 
     } // end row loop
   } // end column loop
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the iteratively reweighted error vector and Jacobians. The error and
-///        Jacobians are first whitened by the noise model and then weighted by the loss
-///        function, as in:
-///              error = sqrt(weight)*sqrt(cov^-1)*rawError
-///           jacobian = sqrt(weight)*sqrt(cov^-1)*rawJacobian
-//////////////////////////////////////////////////////////////////////////////////////////////
-template <int MEAS_DIM, int MAX_STATE_SIZE>
-Eigen::Matrix<double,MEAS_DIM,1> WeightedLeastSqCostTerm<MEAS_DIM,MAX_STATE_SIZE>::evalWeightedAndWhitened(
-    std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
-
-  // Check and initialize jacobian array
-  if (outJacobians == NULL) {
-    throw std::invalid_argument("Null pointer provided to return-input 'jacs' in evaluate");
-  }
-  outJacobians->clear();
-
-  // Get raw error and Jacobians
-  Eigen::Matrix<double,MEAS_DIM,1> rawError =
-      errorFunction_->evaluate(noiseModel_->getSqrtInformation(), outJacobians);
 
-  // Get whitened error vector
-  Eigen::Matrix<double,MEAS_DIM,1> whiteError = noiseModel_->whitenError(rawError);
-
-  // Get weight from loss function
-  double sqrt_w = sqrt(lossFunc_->weight(whiteError.norm()));
-
-  // Weight the white jacobians
-  for (unsigned int i = 0; i < outJacobians->size(); i++) {
-    outJacobians->at(i).jac *= sqrt_w;
+  // Count the Jacobians and Hessian blocks if this cost term is being profiled
+  CostTermProfiler::Sample* sample = CostTermProfiler::activeSample();
+  if (sample) {
+    sample->jacobians += jacobians.size();
+    sample->hessianBlocks += jacobians.size()*(jacobians.size() + 1)/2;
   }
-
-  // Weight the error and return
-  return sqrt_w * whiteError;
 }
 
 } // steam
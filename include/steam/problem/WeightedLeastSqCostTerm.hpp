@@ -10,6 +10,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include <steam/problem/CostTermBase.hpp>
+#include <steam/problem/CostTermProfiler.hpp>
 
 #include <steam/evaluator/ErrorEvaluator.hpp>
 #include <steam/problem/NoiseModel.hpp>
@@ -62,18 +63,58 @@ public:
                                      BlockSparseMatrix* approximateHessian,
                                      BlockVector* gradientVector) const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns the loss function (the cost is loss(whitenedErrorNorm()))
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual const LossFunctionBase* getLossFunction() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the norm of the whitened error, sqrt(e^T * cov^{-1} * e)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual double whitenedErrorNorm() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns whether the noise model has stamped inputs (the error evaluator is
+  ///        assumed to depend only on state variables and constants)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool hasStampedInputs() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the contribution of this cost term to the Gauss-Newton system of equations,
+  ///        using a precomputed loss-function weight
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void buildReweightedGaussNewtonTerms(const StateVector& stateVector,
+                                               BlockSparseMatrix* approximateHessian,
+                                               BlockVector* gradientVector,
+                                               double weight) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Returns the type of the error evaluator (e.g. StereoCameraErrorEval), which the
+  ///        time spent in this cost term is attributed to by a CostTermProfiler
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual const std::type_info& getProfileType() const;
+
 private:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Evaluate the iteratively reweighted error vector and Jacobians. The error and
-  ///        Jacobians are first whitened by the noise model and then weighted by the loss
-  ///        function, as in:
-  ///              error = sqrt(weight)*sqrt(cov^-1)*rawError
-  ///           jacobian = sqrt(weight)*sqrt(cov^-1)*rawJacobian
+  /// \brief Evaluate the whitened error vector and Jacobians, as in:
+  ///              error = sqrt(cov^-1)*rawError
+  ///           jacobian = sqrt(cov^-1)*rawJacobian
   //////////////////////////////////////////////////////////////////////////////////////////////
-  Eigen::Matrix<double,MEAS_DIM,1> evalWeightedAndWhitened(
+  Eigen::Matrix<double,MEAS_DIM,1> evalWhitened(
       std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> >* outJacobians) const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add the iteratively reweighted contribution of the whitened error and Jacobians,
+  ///        weight*J^T*J and -weight*J^T*e, to the Gauss-Newton system of equations
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addGaussNewtonTerms(const StateVector& stateVector,
+                           BlockSparseMatrix* approximateHessian,
+                           BlockVector* gradientVector,
+                           const Eigen::Matrix<double,MEAS_DIM,1>& error,
+                           const std::vector<Jacobian<MEAS_DIM,MAX_STATE_SIZE> >& jacobians,
+                           double weight) const;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Error evaluator
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,6 +40,21 @@ class DcsLossFunc : public LossFunctionBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual double weight(double whitened_error_norm) const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void costBatch(const double* whitened_error_norms, unsigned int n, double* out) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the constructor threshold, k
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  double getK() const;
+
  private:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -39,6 +39,16 @@ public:
   /// \brief Weight for iteratively reweighted least-squares (influence function div. by error)
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual double weight(double whitened_error_norm) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void costBatch(const double* whitened_error_norms, unsigned int n, double* out) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const;
 };
 
 } // steam
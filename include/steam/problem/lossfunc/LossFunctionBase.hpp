@@ -40,6 +40,26 @@ public:
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual double weight(double whitened_error_norm) const = 0;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batched cost function, out[i] = cost(whitened_error_norms[i]). This allows a
+  ///        collection of cost terms that share a loss function to make one virtual call for
+  ///        many terms; derived classes should override it with a loop that vectorizes.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void costBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+    for (unsigned int i = 0; i < n; i++) {
+      out[i] = this->cost(whitened_error_norms[i]);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+    for (unsigned int i = 0; i < n; i++) {
+      out[i] = this->weight(whitened_error_norms[i]);
+    }
+  }
+
 };
 
 } // steam
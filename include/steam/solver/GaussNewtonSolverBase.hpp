@@ -63,6 +63,15 @@ class GaussNewtonSolverBase : public SolverBase
   BlockMatrix queryCovarianceBlock(const std::vector<steam::StateKey>& rowKeys,
                                    const std::vector<steam::StateKey>& colKeys);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Predict the memory of an iteration before running it. The system is assembled at
+  ///        the current state and its sparsity pattern is analyzed, which gives the size of the
+  ///        Cholesky factor (including its fill-in) without the numerical factorization. The
+  ///        analysis is kept for the next factorization. This can be used to reject problems
+  ///        that would not fit in memory.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  MemoryUsage predictMemoryUsage();
+
  protected:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -72,13 +81,15 @@ class GaussNewtonSolverBase : public SolverBase
                              Eigen::VectorXd* gradientVector);
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Perform the LLT decomposition on the approx. Hessian matrix
+  /// \brief Perform the LLT decomposition on the approx. Hessian matrix. Returns whether the
+  ///        sparsity pattern had to be (re)analyzed.
   //////////////////////////////////////////////////////////////////////////////////////////////
-  void factorizeHessian(const Eigen::SparseMatrix<double>& approximateHessian,
+  bool factorizeHessian(const Eigen::SparseMatrix<double>& approximateHessian,
                         bool augmentedHessian = false);
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Solve the Gauss-Newton system of equations: A*x = b
+  /// \brief Solve the Gauss-Newton system of equations: A*x = b (the factorization is
+  ///        recorded in the iteration report)
   //////////////////////////////////////////////////////////////////////////////////////////////
   Eigen::VectorXd solveGaussNewton(const Eigen::SparseMatrix<double>& approximateHessian,
                                    const Eigen::VectorXd& gradientVector,
@@ -105,16 +116,72 @@ class GaussNewtonSolverBase : public SolverBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual bool linearizeSolveAndUpdate(double* newCost, double* gradNorm) = 0;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Analyze the sparsity pattern of the approx. Hessian, if the structure of the
+  ///        problem changed since the last analysis. Returns whether it was analyzed.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool analyzePattern(const Eigen::SparseMatrix<double>& approximateHessian);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Sparse LLT solver that exposes the size of its symbolic analysis
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  class HessianSolver : public Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Upper>
+  {
+   public:
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the bytes of the factor, permutations and elimination tree, which are
+    ///        allocated by the pattern analysis (before the numerical factorization)
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    std::size_t getMemoryUsage() const;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the number of non-zeros of the factor allocated by the pattern analysis
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    int getFactorNonZeros() const;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    /// \brief Analyze the pattern of a matrix that extends the last analyzed matrix (with rows
+    ///        and columns appended, and possibly more non-zeros), keeping the fill-reducing
+    ///        ordering of the analyzed rows and ordering the appended rows last. This skips
+    ///        the AMD ordering; the elimination tree and column counts are recomputed.
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    void analyzeExtendedPattern(const Eigen::SparseMatrix<double>& a);
+  };
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief The solver object (stored over iterations to reuse the same pattern)
   //////////////////////////////////////////////////////////////////////////////////////////////
-  Eigen::SimplicialLLT<Eigen::SparseMatrix<double>, Eigen::Upper> hessianSolver_;
+  HessianSolver hessianSolver_;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Whether or not the pattern of the approx. Hessian has been analyzed by the solver
   //////////////////////////////////////////////////////////////////////////////////////////////
   bool patternInitialized_;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure revision of the problem, order revision of the state vector, size and
+  ///        non-zeros of the approx. Hessian at the last analysis. The pattern only changes
+  ///        with the structure of the problem, so it is not compared entry by entry.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int analyzedRevision_;
+  unsigned int analyzedStateOrder_;
+  int analyzedSize_;
+  int analyzedNonZeros_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Size of the approx. Hessian and non-zeros of the factor at the last full analysis
+  ///        (with a new AMD ordering). Extended analyses reuse that ordering until the system
+  ///        doubles in size or the factor in non-zeros.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  int orderedSize_;
+  int orderedFactorNonZeros_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure revision of the problem at the last factorization
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int factorizedRevision_;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Whether or not the last factorization was for the information matrix and if
   ///        if it was successful. *Note that solving LM does not solve the information matrix
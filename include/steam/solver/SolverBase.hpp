@@ -11,6 +11,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <stdexcept>
+#include <vector>
 
 #include <steam/problem/OptimizationProblem.hpp>
 
@@ -81,6 +82,87 @@ class SolverBase
     TERMINATE_CONVERGED_ZERO_GRADIENT
   };
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Telemetry of a single solver iteration, passed to the observers. Wall times are in
+  ///        milliseconds and do not overlap (e.g. the solve time excludes the factorization).
+  ///        Step-control values that do not apply to a solver are left at zero.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct IterationReport {
+    IterationReport() : iteration(0), cost(0.0), prevCost(0.0), gradientNorm(0.0),
+      stepSuccess(false), buildTime(0.0), factorizeTime(0.0), solveTime(0.0),
+      updateTime(0.0), costEvalTime(0.0), iterationTime(0.0), trustRegionSize(0.0),
+      dampingCoeff(0.0), stepScale(0.0), actualToPredictedRatio(0.0), numBacktracks(0),
+      numFactorizations(0), patternAnalyzed(false), hessianNonZeros(0), factorNonZeros(0),
+      numAllocations(0), peakResidentMemory(0), converged(false),
+      termination(TERMINATE_NOT_YET_TERMINATED) {}
+
+    /// Iteration number (starting at 1), and cost before and after the iteration
+    unsigned int iteration;
+    double cost;
+    double prevCost;
+
+    /// Norm of the gradient at the start of the iteration, and whether a step was accepted
+    double gradientNorm;
+    bool stepSuccess;
+
+    /// Wall times: linearization and assembly of the system, numerical factorization,
+    /// computation of the step (back substitution, Cauchy point), state updates (including
+    /// backups and reverts), cost evaluations of the proposed states, and the whole iteration
+    double buildTime;
+    double factorizeTime;
+    double solveTime;
+    double updateTime;
+    double costEvalTime;
+    double iterationTime;
+
+    /// Step control: trust-region size (dogleg), damping coefficient (Levenberg-Marquardt),
+    /// scale of the accepted step (line search), ratio of the actual to predicted cost
+    /// reduction of the last proposed step, and number of rejected steps
+    double trustRegionSize;
+    double dampingCoeff;
+    double stepScale;
+    double actualToPredictedRatio;
+    unsigned int numBacktracks;
+
+    /// Factorizations made, whether the sparsity pattern was (re)analyzed, and the number of
+    /// non-zeros of the approximate Hessian (upper triangle) and of its Cholesky factor
+    unsigned int numFactorizations;
+    bool patternAnalyzed;
+    unsigned int hessianNonZeros;
+    unsigned int factorNonZeros;
+
+    /// Bytes held by each subsystem (the largest assembled and factorized systems of the
+    /// iteration), heap allocations made during the iteration (zero unless an
+    /// AllocationCounter is installed, see MemoryUsage.hpp), and the peak resident memory of
+    /// the process
+    MemoryUsage memory;
+    unsigned long long numAllocations;
+    std::size_t peakResidentMemory;
+
+    /// Convergence status after the iteration
+    bool converged;
+    Termination termination;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Interface of the observers of the solver iterations (e.g. to stream telemetry to a
+  ///        metrics system, or tune the solver parameters)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  class Observer
+  {
+   public:
+    /// Convenience typedefs
+    typedef boost::shared_ptr<Observer> Ptr;
+    typedef boost::shared_ptr<const Observer> ConstPtr;
+
+    virtual ~Observer() {}
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    /// \brief Called at the end of every iteration (also before an unsuccessful step throws)
+    ////////////////////////////////////////////////////////////////////////////////////////////
+    virtual void onIteration(const IterationReport& report) = 0;
+  };
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Constructor
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -92,14 +174,17 @@ class SolverBase
   bool converged() const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Perform an iteration of the solver
+  /// \brief Perform an iteration of the solver. If states or cost terms were added to (or
+  ///        removed from) the problem since the last iteration, the state vector is patched
+  ///        and the convergence tracking is restarted.
   //////////////////////////////////////////////////////////////////////////////////////////////
   void iterate();
 
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Perform iterations until convergence
   ///        This function is made to be simple and require no private methods so that users
-  ///        can choose to control the loop themselves.
+  ///        can choose to control the loop themselves. A converged solver is restarted if
+  ///        the problem structure has changed since the last iteration.
   //////////////////////////////////////////////////////////////////////////////////////////////
   void optimize();
 
@@ -113,6 +198,26 @@ class SolverBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   unsigned int getCurrIteration() const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add an observer of the iterations (observers are called in the order added)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void addObserver(const Observer::Ptr& observer);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Remove an observer of the iterations
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void removeObserver(const Observer::Ptr& observer);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Return the report of the last iteration
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const IterationReport& getLastIterationReport() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Return the largest bytes held by each subsystem over the iterations so far
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const MemoryUsage& getPeakMemoryUsage() const;
+
  protected:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -150,6 +255,29 @@ class SolverBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   void rejectProposedState();
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the report of the current iteration, for the derived solvers to fill in
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  IterationReport& getCurrIterationReport();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Record the bytes of the state vector, its backup (predicted from the current
+  ///        values if no backup was made yet) and the evaluator pools
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void getStateMemoryUsage(MemoryUsage* usage) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Apply structural changes made to the problem since the last synchronization
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void syncWithProblem();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the revision of the order of the state vector. It changes when states are
+  ///        removed or the state vector is rebuilt (which moves states), but not when states
+  ///        are only appended, since the existing states then keep their block indices.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getStateOrderRevision() const;
+
  private:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -162,6 +290,11 @@ class SolverBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual const SolverBase::Params& getSolverBaseParams() const = 0;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Add all unlocked states of the problem to an empty state vector
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void buildStateVector();
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Reference to optimization problem
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -172,15 +305,27 @@ class SolverBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   StateVector stateVec_;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Structure revision and number of state changes of the problem at the last
+  ///        synchronization
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int structureRevision_;
+  unsigned int numStateChanges_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Revision of the order of the state vector (see getStateOrderRevision)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int stateOrderRevision_;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Since many solvers need to test the state vector after a proposed update (before
   ///        deciding if the update is appropriate), we implement a way to 'temporarily' modify
   ///        the state, and then either confirm the change, or reject it and revert to the
   ///        original values. These variables are used to backup the state vector while
-  ///        performing a temporary update.
+  ///        performing a temporary update (the snapshot packs the raw state values, so that
+  ///        backing up and reverting does not clone or virtually copy each state).
   //////////////////////////////////////////////////////////////////////////////////////////////
-  StateVector stateVectorBackup_;
-  bool firstBackup_;
+  StateVector::Snapshot stateSnapshot_;
   bool pendingProposedState_;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -208,6 +353,17 @@ class SolverBase
   //////////////////////////////////////////////////////////////////////////////////////////////
   Termination term_;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Report of the current (or last) iteration, and the observers
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  IterationReport report_;
+  std::vector<Observer::Ptr> observers_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Largest bytes held by each subsystem over the iterations
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  MemoryUsage peakMemory_;
+
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////
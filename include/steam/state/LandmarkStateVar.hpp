@@ -39,11 +39,31 @@ class LandmarkStateVar : public StateVariable<Eigen::Vector4d>
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual bool update(const Eigen::VectorXd& perturbation);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Update the state from a raw perturbation (without allocation)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool updateRaw(const double* perturbation);
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Clone method
   //////////////////////////////////////////////////////////////////////////////////////////////
   virtual StateVariableBase::Ptr clone() const;
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of doubles used to store the raw (homogeneous) value
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int getRawValueSize() const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Write the raw value of the state into a buffer
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void writeRawValue(double* out) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the value of the state from a raw buffer (no rescaling is performed)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void readRawValue(const double* in);
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Set value -- mostly for landmark initialization
   //////////////////////////////////////////////////////////////////////////////////////////////
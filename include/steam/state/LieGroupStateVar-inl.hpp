@@ -43,6 +43,20 @@ bool LieGroupStateVar<TYPE,DIM>::update(const Eigen::VectorXd& perturbation) {
 
   // Update the Lie matrix using a left-multiplicative perturbation
   this->value_ = TYPE(perturbation)*this->value_;
+  this->markChanged();
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Update the state from a raw perturbation (without allocation)
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename TYPE, int DIM>
+bool LieGroupStateVar<TYPE,DIM>::updateRaw(const double* perturbation) {
+
+  // Fixed-size copy of the perturbation (on the stack)
+  Eigen::Matrix<double,DIM,1> xi = Eigen::Map<const Eigen::Matrix<double,DIM,1> >(perturbation);
+  this->value_ = TYPE(xi)*this->value_;
+  this->markChanged();
   return true;
 }
 
@@ -54,4 +68,31 @@ StateVariableBase::Ptr LieGroupStateVar<TYPE,DIM>::clone() const {
   return LieGroupStateVar<TYPE,DIM>::Ptr(new LieGroupStateVar<TYPE,DIM>(*this));
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of doubles used to store the raw value (the matrix entries)
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename TYPE, int DIM>
+unsigned int LieGroupStateVar<TYPE,DIM>::getRawValueSize() const {
+  return MatrixType::SizeAtCompileTime;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write the raw value of the state into a buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename TYPE, int DIM>
+void LieGroupStateVar<TYPE,DIM>::writeRawValue(double* out) const {
+  Eigen::Map<MatrixType> raw(out);
+  raw = this->value_.matrix();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Set the value of the state from a raw buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename TYPE, int DIM>
+void LieGroupStateVar<TYPE,DIM>::readRawValue(const double* in) {
+  Eigen::Map<const MatrixType> raw(in);
+  this->value_ = TYPE(MatrixType(raw));
+  this->markChanged();
+}
+
 } // steam
@@ -7,6 +7,9 @@
 #ifndef STEAM_LIE_GROUP_STATE_VARIABLE_HPP
 #define STEAM_LIE_GROUP_STATE_VARIABLE_HPP
 
+#include <type_traits>
+#include <utility>
+
 #include <steam/state/StateVariable.hpp>
 #include <lgmath.hpp>
 
@@ -15,6 +18,8 @@ namespace steam {
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Lie group state variable. Note that TYPE must implement a constructor from a
 ///        vector of the perturbation dimension (DIM); usually this is the exponential map.
+///        TYPE must also provide its fixed-size matrix representation, matrix(), and a
+///        constructor from it; these are used for raw value storage.
 /////////////////////////////////////////////////////////////////////////////////////////////
 template<typename TYPE, int DIM>
 class LieGroupStateVar : public StateVariable<TYPE>
@@ -51,11 +56,38 @@ class LieGroupStateVar : public StateVariable<TYPE>
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual bool update(const Eigen::VectorXd& perturbation);
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Update the state from a raw perturbation (without allocation)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool updateRaw(const double* perturbation);
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Clone method
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual StateVariableBase::Ptr clone() const;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of doubles used to store the raw value (the matrix entries)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int getRawValueSize() const;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Write the raw value of the state into a buffer
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void writeRawValue(double* out) const;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the value of the state from a raw buffer
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void readRawValue(const double* in);
+
+ private:
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Matrix representation of TYPE
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  typedef typename std::decay<decltype(std::declval<const TYPE&>().matrix())>::type MatrixType;
+
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
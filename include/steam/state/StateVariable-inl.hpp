@@ -36,6 +36,7 @@ const TYPE& StateVariable<TYPE>::getValue() const {
 template<typename TYPE>
 void StateVariable<TYPE>::setValue(const TYPE& value) {
   value_ = value;
+  this->markChanged();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -48,6 +49,7 @@ void StateVariable<TYPE>::setFromCopy(const StateVariableBase::ConstPtr& other)
   }
   StateVariable<TYPE>::ConstPtr p = boost::static_pointer_cast<const StateVariable<TYPE> >(other);
   value_ = p->value_;
+  this->markChanged();
 }
 
 } // steam
@@ -10,6 +10,7 @@
 #include <Eigen/Core>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
+#include <atomic>
 
 namespace steam {
 
@@ -34,6 +35,42 @@ class IdGenerator
   }
 };
 
+/// Defines type we will use for change stamps (0 is never a valid stamp)
+typedef unsigned long long StateStamp;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief A generator class for change stamps. Stamps increase monotonically over all state
+///        variables, so the latest stamp of a set of states changes whenever any of them does.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class StampGenerator
+{
+ public:
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Static method to generate the next stamp (thread safe)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  static StateStamp getNextStamp() {
+    return ++counter();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Static method to get the latest stamp given to any state variable (thread safe)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  static StateStamp getLatestStamp() {
+    return counter().load();
+  }
+
+ private:
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Global stamp counter
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  static std::atomic<StateStamp>& counter() {
+    static std::atomic<StateStamp> latestStamp(0);
+    return latestStamp;
+  }
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Class for managing IDs (allows future extension to 'key' attributes)
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -44,7 +81,7 @@ public:
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Default constructor (gets next free ID)
   /////////////////////////////////////////////////////////////////////////////////////////////
-  StateKey() : id_(IdGenerator::getNextId()) {}
+  StateKey() : id_(IdGenerator::getNextId()), slot_(-1) {}
 
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Get ID of the key
@@ -56,13 +93,27 @@ public:
   /////////////////////////////////////////////////////////////////////////////////////////////
   bool equals(const StateKey& other) const {return id_ == other.getID();}
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the slot (block index) assigned to the state by the last StateVector it was
+  ///        added to, or -1. This is only a hint, used to avoid a hashed lookup.
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  int getSlot() const {return slot_;}
+
 private:
 
+  /// StateVariableBase sets the slot on behalf of StateVector
+  friend class StateVariableBase;
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Identification number
   /////////////////////////////////////////////////////////////////////////////////////////////
   StateID id_;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Slot hint (see getSlot), does not take part in the identity of the key
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  mutable int slot_;
+
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -80,7 +131,7 @@ public:
   /// \brief Constructor
   /////////////////////////////////////////////////////////////////////////////////////////////
   StateVariableBase(unsigned int perturbDim, bool isLocked = false)
-    : perturbDim_(perturbDim), isLocked_(isLocked) {
+    : perturbDim_(perturbDim), isLocked_(isLocked), stamp_(StampGenerator::getNextStamp()) {
 
     // Throw logic error
     if (perturbDim_ <= 0) {
@@ -94,11 +145,42 @@ public:
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual bool update(const Eigen::VectorXd& perturbation) = 0;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Update a state from a raw perturbation of size getPerturbDim(). State types should
+  ///        override this with a fixed-size view of the buffer to avoid allocation; the
+  ///        default copies the perturbation into a dynamic vector.
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool updateRaw(const double* perturbation) {
+    return this->update(Eigen::Map<const Eigen::VectorXd>(perturbation, perturbDim_));
+  }
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Interface to set the state value from another instance of the state
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual void setFromCopy(const ConstPtr& other) = 0;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of doubles used to store the raw value of the state, or 0 if the
+  ///        state type does not support raw value storage (see StateVector::Snapshot)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int getRawValueSize() const {
+    return 0;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Write the raw value of the state into a buffer of size getRawValueSize()
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void writeRawValue(double* out) const {
+    throw std::runtime_error("State variable type does not support raw value storage.");
+  }
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the value of the state from a buffer written by writeRawValue()
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void readRawValue(const double* in) {
+    throw std::runtime_error("State variable type does not support raw value storage.");
+  }
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Get the states unique key
   /////////////////////////////////////////////////////////////////////////////////////////////
@@ -129,13 +211,41 @@ public:
     return isLocked_;
   }
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the change stamp of the state, which is renewed every time the value of the
+  ///        state is modified (clones keep the stamp of the original)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  StateStamp getStamp() const {
+    return stamp_;
+  }
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Interface for clone method
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual Ptr clone() const = 0;
 
+protected:
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Renew the change stamp, must be called by derived classes whenever the value of
+  ///        the state is modified
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  void markChanged() {
+    stamp_ = StampGenerator::getNextStamp();
+  }
+
 private:
 
+  /// StateVector assigns the slot hint of the key
+  friend class StateVector;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the slot hint of the key (the ID is never changed)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  void setSlot(int slot) const {
+    key_.slot_ = slot;
+  }
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Unique identifier key, set on construction
   /////////////////////////////////////////////////////////////////////////////////////////////
@@ -151,6 +261,11 @@ private:
   /////////////////////////////////////////////////////////////////////////////////////////////
   bool isLocked_;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Change stamp of the current value
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  StateStamp stamp_;
+
 };
 
 } // steam
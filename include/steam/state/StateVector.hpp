@@ -16,11 +16,33 @@ namespace steam {
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Class to contain a list of the active state variables.
 ///        Also keeps track of the 'block' ordering (affects visual sparsity)
+///
+///        States are stored densely, in block order; the block index of a state is its slot
+///        in the dense storage. The slot is also stored in the key of the state variable, so
+///        that block-index lookups from Jacobian keys are typically a single array read.
 //////////////////////////////////////////////////////////////////////////////////////////////
 class StateVector
 {
  public:
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Saved state values. States with a raw value representation are packed into a
+  ///        single contiguous buffer; other states fall back to a cloned copy. A snapshot is
+  ///        reused across saves, so that repeated saves do not allocate.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct Snapshot
+  {
+    /// Packed raw values, in block order
+    std::vector<double> values;
+
+    /// Cloned copies of states without a raw value representation (NULL otherwise)
+    std::vector<StateVariableBase::Ptr> copies;
+
+    /// Approximate number of bytes held by the snapshot (the cloned states count as their
+    /// handles only)
+    std::size_t getMemoryUsage() const;
+  };
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Default constructor
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -42,11 +64,30 @@ class StateVector
   //////////////////////////////////////////////////////////////////////////////////////////////
   void copyValues(const StateVector& other);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Save the values of all states into a snapshot
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void saveValues(Snapshot* snapshot) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Restore the values of all states from a snapshot (the structure of the state
+  ///        vector must not have changed since the snapshot was saved)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void restoreValues(const Snapshot& snapshot);
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Add state variable
   //////////////////////////////////////////////////////////////////////////////////////////////
   void addStateVariable(const StateVariableBase::Ptr& statevar);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Remove a state variable. The last state is moved into the freed slot (this
+  ///        changes the block index of the moved state). Removal is O(1) if the moved state
+  ///        has the same perturbation size as the removed one, otherwise the offsets of the
+  ///        states after the slot are updated, which is O(n).
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void removeStateVariable(const StateKey& key);
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Check if a state variable exists in the vector
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -70,13 +111,20 @@ class StateVector
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Get an ordered list of the sizes of the 'block' state variables
   //////////////////////////////////////////////////////////////////////////////////////////////
-  std::vector<unsigned int> getStateBlockSizes() const;
+  const std::vector<unsigned int>& getStateBlockSizes() const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Update the state vector
+  /// \brief Update the state vector. Each state is handed a view of its segment of the
+  ///        perturbation (no copies), and large state vectors are updated in parallel.
   //////////////////////////////////////////////////////////////////////////////////////////////
   void update(const Eigen::VectorXd& perturbation);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the approximate number of bytes held by the state vector's index (the states
+  ///        are shared with the problem and not counted)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::size_t getMemoryUsage() const;
+
  private:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -87,19 +135,32 @@ class StateVector
     /// State
     StateVariableBase::Ptr state;
 
-    /// Block index in active state (set to -1 if not an active variable)
-    int localBlockIndex;
+    /// ID of the state (cached to avoid dereferencing the state)
+    StateID id;
+
+    /// Offset of the state in the full perturbation vector
+    unsigned int offset;
   };
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Main container for state variables
+  /// \brief Main container for state variables, ordered by block index
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<StateContainer> states_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Map from state ID to block index, for keys without a valid slot hint
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  boost::unordered_map<StateID, unsigned int> indices_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Sizes of the 'block' state variables, ordered by block index
   //////////////////////////////////////////////////////////////////////////////////////////////
-  boost::unordered_map<StateID, StateContainer> states_;
+  std::vector<unsigned int> blockSizes_;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Block size of the related linear system
+  /// \brief Total perturbation dimension of all states
   //////////////////////////////////////////////////////////////////////////////////////////////
-  unsigned int numBlockEntries_;
+  unsigned int perturbDim_;
 
 };
 
@@ -38,11 +38,31 @@ class VectorSpaceStateVar : public StateVariable<Eigen::VectorXd>
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual bool update(const Eigen::VectorXd& perturbation);
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Update the state from a raw perturbation (without allocation)
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual bool updateRaw(const double* perturbation);
+
   /////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Clone method
   /////////////////////////////////////////////////////////////////////////////////////////////
   virtual StateVariableBase::Ptr clone() const;
 
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of doubles used to store the raw value
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual unsigned int getRawValueSize() const;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Write the raw value of the state into a buffer
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void writeRawValue(double* out) const;
+
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Set the value of the state from a raw buffer
+  /////////////////////////////////////////////////////////////////////////////////////////////
+  virtual void readRawValue(const double* in);
+
 };
 
 } // steam
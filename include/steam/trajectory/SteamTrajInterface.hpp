@@ -12,6 +12,7 @@
 #include <steam/common/Time.hpp>
 
 #include <steam/trajectory/SteamTrajVar.hpp>
+#include <steam/trajectory/SteamTrajKnotArray.hpp>
 
 #include <steam/problem/WeightedLeastSqCostTerm.hpp>
 #include <steam/problem/ParallelizedCostTermCollection.hpp>
@@ -50,6 +51,17 @@ class SteamTrajInterface
   void add(const steam::Time& time, const se3::TransformEvaluator::Ptr& T_k0,
            const VectorSpaceStateVar::Ptr& velocity);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Remove all knots strictly before a time (e.g. to slide an estimation window).
+  ///        Note that this does not remove pose or velocity priors added at those knots.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void removeKnotsBefore(const steam::Time& time);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the number of knots
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int getNumKnots() const;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Get transform evaluator
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -60,6 +72,37 @@ class SteamTrajInterface
   //////////////////////////////////////////////////////////////////////////////////////////////
   Eigen::VectorXd getVelocity(const steam::Time& time);
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get transform evaluators for a batch of times. The times must be sorted in
+  ///        ascending order, so that all knot lookups can be done in a single sweep.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<TransformEvaluator::ConstPtr> getInterpPoseEvals(
+      const std::vector<steam::Time>& times) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get interpolated pose values for a batch of sorted times. Quantities that only
+  ///        depend on the knot interval are computed once per interval, rather than per time.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<lgmath::se3::Transformation> getInterpPoses(
+      const std::vector<steam::Time>& times) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get interpolated velocities for a batch of sorted times (one column per time)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  Eigen::Matrix<double,6,Eigen::Dynamic> getVelocities(
+      const std::vector<steam::Time>& times) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief De-skew a point cloud into the vehicle frame at a reference time. Points are
+  ///        stored as structure-of-arrays (one column per coordinate), each with its own
+  ///        timestamp (the times need not be sorted). Each point, p_t, is mapped to
+  ///        T_ref_0 * T_t_0^{-1} * p_t, where T_t_0 is the interpolated pose at its time.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  Eigen::Matrix<double,Eigen::Dynamic,3> deskewPointCloud(
+      const std::vector<steam::Time>& times,
+      const Eigen::Matrix<double,Eigen::Dynamic,3>& points,
+      const steam::Time& refTime) const;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Add a unary pose prior factor at a knot time. Note that only a single pose prior
   ///        should exist on a trajectory, adding a second will overwrite the first.
@@ -90,6 +133,34 @@ class SteamTrajInterface
 
  private:
 
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Interval quantities shared by all batched queries between the same two knots
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  struct IntervalCache {
+    lgmath::se3::Transformation T_10;     // pose of the first knot
+    Eigen::Matrix<double,6,1> xi_21;      // se3 algebra of the relative knot pose
+    Eigen::Matrix<double,6,1> w1;         // velocity of the first knot
+    Eigen::Matrix<double,6,1> J21inv_w2;  // J_21_inv * velocity of the second knot
+    double T;                             // duration of the interval (seconds)
+  };
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Sweep a sorted vector of times against the knots. Outputs, for each time, the
+  ///        index of the last knot at or before it (-1 if the time is before the first knot).
+  ///        Optionally outputs the (unique) indices of the intervals that contain a time
+  ///        strictly between two knots. Throws if a time requires disallowed extrapolation.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void sweepKnots(const std::vector<steam::Time>& times,
+                  std::vector<int>* knotIndices,
+                  std::vector<int>* intervals = NULL) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Compute the interval caches for the provided interval indices
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void buildIntervalCaches(const std::vector<int>& intervals,
+                           std::vector<IntervalCache,
+                                       Eigen::aligned_allocator<IntervalCache> >* caches) const;
+
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Ordered map of knots
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -111,9 +182,9 @@ class SteamTrajInterface
   steam::WeightedLeastSqCostTerm<6,6>::Ptr velocityPriorFactor_;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
-  /// \brief Ordered map of knots
+  /// \brief Ordered array of knots
   //////////////////////////////////////////////////////////////////////////////////////////////
-  std::map<boost::int64_t, SteamTrajVar::Ptr> knotMap_;
+  SteamTrajKnotArray knots_;
 
 };
 
@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file SteamTrajKnotArray.hpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef STEAM_TRAJECTORY_KNOT_ARRAY_HPP
+#define STEAM_TRAJECTORY_KNOT_ARRAY_HPP
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <steam/common/Time.hpp>
+#include <steam/trajectory/SteamTrajVar.hpp>
+
+namespace steam {
+namespace se3 {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Time-ordered, contiguous container of trajectory knots. Knot times are stored in
+///        a separate contiguous array for fast searching; when the knots are uniformly
+///        spaced, lookups are a direct O(1) index computation rather than a binary search.
+///
+///        The container is intended for sliding-window use: appending a knot after the
+///        latest time is amortized O(1), and dropping knots from the front (earliest times)
+///        is amortized O(1) per knot.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class SteamTrajKnotArray
+{
+ public:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Constructor
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  SteamTrajKnotArray();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Insert a knot. Appending a knot after the latest time is amortized O(1), otherwise
+  ///        the knot is inserted in order (O(n)). Throws if a knot already exists at the time.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void insert(const SteamTrajVar::Ptr& knot);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Drop the earliest 'num' knots
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void dropFront(unsigned int num = 1);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Drop all knots strictly before a time
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void dropBefore(const steam::Time& time);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Remove all knots
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void clear();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Number of knots
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int size() const { return knots_.size() - begin_; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether or not the container is empty
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool empty() const { return knots_.size() == begin_; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the knot at index i (ordered by time)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const SteamTrajVar::Ptr& at(unsigned int i) const { return knots_[begin_ + i]; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the time (nanoseconds) of the knot at index i
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  boost::int64_t timeAt(unsigned int i) const { return times_[begin_ + i]; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the earliest knot
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const SteamTrajVar::Ptr& front() const { return knots_[begin_]; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the latest knot
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  const SteamTrajVar::Ptr& back() const { return knots_.back(); }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether or not the knots are uniformly spaced (true for less than three knots)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool isUniform() const { return uniform_; }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the index of the first knot with time equal to or greater than 'time'
+  ///        (returns size() if there is no such knot)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int lowerBound(const steam::Time& time) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the index of the first knot with time greater than 'time'
+  ///        (returns size() if there is no such knot)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int upperBound(const steam::Time& time) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the index of the knot at exactly 'time' (returns size() if there is none)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int find(const steam::Time& time) const;
+
+ private:
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Recompute the uniform spacing flag from scratch
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  void updateUniformity();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Knots (ordered by time), the active range starts at begin_
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<SteamTrajVar::Ptr> knots_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Knot times in nanoseconds (parallel to knots_)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  std::vector<boost::int64_t> times_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Index of the first active knot. Dropped knots are only erased from the front of
+  ///        the vectors once they make up half the storage, which amortizes the cost.
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  unsigned int begin_;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  /// \brief Whether or not the knots are uniformly spaced, and the spacing (nanoseconds)
+  //////////////////////////////////////////////////////////////////////////////////////////////
+  bool uniform_;
+  boost::int64_t spacing_;
+};
+
+} // se3
+} // steam
+
+#endif // STEAM_TRAJECTORY_KNOT_ARRAY_HPP
@@ -16,9 +16,10 @@ namespace steam {
 namespace se3 {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Gaussian-process prior evaluator
+/// \brief Gaussian-process prior evaluator. The error is always 12-dimensional and the state
+///        perturbations at most 6-dimensional, so the fixed-size error evaluator is used.
 //////////////////////////////////////////////////////////////////////////////////////////////
-class SteamTrajPriorFactor : public ErrorEvaluatorX
+class SteamTrajPriorFactor : public ErrorEvaluator<12,6>::type
 {
  public:
 
@@ -40,12 +41,13 @@ class SteamTrajPriorFactor : public ErrorEvaluatorX
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Evaluate the GP prior factor
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual Eigen::VectorXd evaluate() const;
+  virtual Eigen::Matrix<double,12,1> evaluate() const;
 
   //////////////////////////////////////////////////////////////////////////////////////////////
   /// \brief Evaluate the GP prior factor and Jacobians
   //////////////////////////////////////////////////////////////////////////////////////////////
-  virtual Eigen::VectorXd evaluate(const Eigen::MatrixXd& lhs, std::vector<Jacobian<> >* jacs) const;
+  virtual Eigen::Matrix<double,12,1> evaluate(const Eigen::Matrix<double,12,12>& lhs,
+                                              std::vector<Jacobian<12,6> >* jacs) const;
 
  private:
 
@@ -0,0 +1,125 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file GenerateSyntheticProblem.cpp
+/// \brief Command-line generator of seeded synthetic problems of arbitrary size, for scaling
+///        studies. Pose graphs are written in the g2o format, and stereo bundle adjustment
+///        and continuous-time trajectory problems in the simple BA format.
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <steam/data/SyntheticProblems.hpp>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Print the usage and the parameters of each problem type
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void printUsage() {
+  std::cout << "Usage: GenerateSyntheticProblem <posegraph|stereo|trajectory> <output file> "
+            << "[name=value ...]" << std::endl << std::endl
+            << "posegraph:  poses posesPerLap lapRise stepLength loopClosures sigmaTranslation "
+            << "sigmaRotation seed" << std::endl
+            << "stereo:     frames landmarks trackLength outlierRatio framePeriod speed "
+            << "pixelNoise sigmaTranslation sigmaRotation sigmaLandmark seed" << std::endl
+            << "trajectory: as stereo, and measTimesPerFrame (default 4)" << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get a parameter by name (removing it from the map), or a default value
+//////////////////////////////////////////////////////////////////////////////////////////////
+static double take(std::map<std::string, double>* args, const std::string& name,
+                   double defaultValue) {
+  std::map<std::string, double>::iterator it = args->find(name);
+  if (it == args->end()) {
+    return defaultValue;
+  }
+  const double value = it->second;
+  args->erase(it);
+  return value;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Generates a synthetic problem and writes it to a file
+//////////////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+
+  if (argc < 3) {
+    printUsage();
+    return 1;
+  }
+  const std::string type = argv[1];
+  const std::string filename = argv[2];
+
+  // Parse name=value parameters
+  std::map<std::string, double> args;
+  for (int i = 3; i < argc; i++) {
+    const std::string arg = argv[i];
+    const size_t equals = arg.find('=');
+    char* end = NULL;
+    const double value = equals == std::string::npos ? 0.0 :
+        strtod(arg.c_str() + equals + 1, &end);
+    if (equals == std::string::npos || end == arg.c_str() + equals + 1 || *end != '\0') {
+      std::cerr << "Malformed parameter: " << arg << std::endl;
+      return 1;
+    }
+    args[arg.substr(0, equals)] = value;
+  }
+
+  if (type == "posegraph") {
+
+    steam::data::PoseGraphParams params;
+    params.numPoses = take(&args, "poses", params.numPoses);
+    params.posesPerLap = take(&args, "posesPerLap", params.posesPerLap);
+    params.lapRise = take(&args, "lapRise", params.lapRise);
+    params.stepLength = take(&args, "stepLength", params.stepLength);
+    params.loopClosureDensity = take(&args, "loopClosures", params.loopClosureDensity);
+    params.sigmaTranslation = take(&args, "sigmaTranslation", params.sigmaTranslation);
+    params.sigmaRotation = take(&args, "sigmaRotation", params.sigmaRotation);
+    params.seed = take(&args, "seed", params.seed);
+    if (!args.empty()) {
+      std::cerr << "Unknown parameter: " << args.begin()->first << std::endl;
+      return 1;
+    }
+
+    steam::data::G2oSe3Dataset dataset = steam::data::generatePoseGraph(params);
+    steam::data::writeG2oSe3Dataset(filename, dataset);
+    std::cout << "Wrote " << dataset.vertices.size() << " poses and " << dataset.edges.size()
+              << " edges to " << filename << std::endl;
+
+  } else if (type == "stereo" || type == "trajectory") {
+
+    steam::data::StereoBaParams params;
+    params.numFrames = take(&args, "frames", params.numFrames);
+    params.numLandmarks = take(&args, "landmarks", params.numLandmarks);
+    params.trackLength = take(&args, "trackLength", params.trackLength);
+    params.outlierRatio = take(&args, "outlierRatio", params.outlierRatio);
+    params.framePeriod = take(&args, "framePeriod", params.framePeriod);
+    params.speed = take(&args, "speed", params.speed);
+    params.pixelNoise = take(&args, "pixelNoise", params.pixelNoise);
+    params.sigmaTranslation = take(&args, "sigmaTranslation", params.sigmaTranslation);
+    params.sigmaRotation = take(&args, "sigmaRotation", params.sigmaRotation);
+    params.sigmaLandmark = take(&args, "sigmaLandmark", params.sigmaLandmark);
+    params.seed = take(&args, "seed", params.seed);
+    if (type == "trajectory") {
+      params.measTimesPerFrame = take(&args, "measTimesPerFrame", 4);
+    }
+    if (!args.empty()) {
+      std::cerr << "Unknown parameter: " << args.begin()->first << std::endl;
+      return 1;
+    }
+
+    steam::data::SimpleBaDataset dataset = steam::data::generateStereoBa(params);
+    steam::data::writeSimpleBaDataset(filename, dataset);
+    std::cout << "Wrote " << dataset.frames_ic.size() << " frames, " << dataset.land_ic.size()
+              << " landmarks and " << dataset.meas.size() << " measurements to " << filename
+              << std::endl;
+
+  } else {
+    printUsage();
+    return 1;
+  }
+  return 0;
+}
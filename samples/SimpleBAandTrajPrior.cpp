@@ -172,7 +172,7 @@ int main(int argc, char** argv) {
   steam::ParallelizedCostTermCollection::Ptr stereoCostTerms(new steam::ParallelizedCostTermCollection());
 
   // Setup shared noise and loss function
-  steam::BaseNoiseModel<4>::Ptr sharedCameraNoiseModel(new steam::StaticNoiseModel<4>(dataset.noise));
+  steam::BaseNoiseModel<4>::Ptr sharedCameraNoiseModel(new steam::DiagonalNoiseModel<4>(dataset.noise.diagonal()));
   steam::L2LossFunc::Ptr sharedLossFunc(new steam::L2LossFunc());
 
   // Setup camera intrinsics
@@ -286,6 +286,30 @@ Eigen::SparseMatrix<double> BlockSparseMatrix::toEigen(bool getSubBlockSparsity)
   return mat;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the approximate number of bytes held by the matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t BlockSparseMatrix::getMemoryUsage() const {
+
+  // Matrix, columns, and the block sizes and offsets of the indexing
+  const BlockMatrixIndexing& indexing = this->getIndexing();
+  std::size_t bytes = sizeof(*this) + cols_.capacity()*sizeof(BlockSparseColumn) +
+      2*sizeof(unsigned int)*(indexing.rowIndexing().numEntries() +
+                              indexing.colIndexing().numEntries());
+
+  // Entries: a tree node (value and about four words of links and color) and the block data
+  const std::size_t nodeBytes = sizeof(std::pair<const unsigned int, BlockRowEntry>) +
+                                4*sizeof(void*);
+  for (unsigned int c = 0; c < cols_.size(); c++) {
+    bytes += cols_[c].rows.size()*nodeBytes;
+    for (std::map<unsigned int, BlockRowEntry>::const_iterator it = cols_[c].rows.begin();
+         it != cols_[c].rows.end(); ++it) {
+      bytes += it->second.data.size()*sizeof(double);
+    }
+  }
+  return bytes;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Gets the number of non-zero entries per scalar-column
 //////////////////////////////////////////////////////////////////////////////////////////////
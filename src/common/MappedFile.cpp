@@ -0,0 +1,63 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file MappedFile.cpp
+/// \brief Read-only memory-mapped view of a file
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/common/MappedFile.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace steam {
+namespace parse {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor, maps the file (throws std::invalid_argument if it cannot be opened)
+//////////////////////////////////////////////////////////////////////////////////////////////
+MappedFile::MappedFile(const std::string& fileName) : data_(NULL), size_(0) {
+
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  struct stat info;
+  if (fd < 0 || ::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    std::stringstream ss; ss << "error opening input file " << fileName;
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Empty files cannot be mapped
+  size_ = info.st_size;
+  if (size_ > 0) {
+    void* mapped = ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      std::stringstream ss; ss << "error mapping input file " << fileName;
+      throw std::invalid_argument(ss.str());
+    }
+    ::madvise(mapped, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(mapped);
+  }
+
+  // The mapping remains valid after the descriptor is closed
+  ::close(fd);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Destructor, unmaps the file
+//////////////////////////////////////////////////////////////////////////////////////////////
+MappedFile::~MappedFile() {
+  if (data_) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+} // parse
+} // steam
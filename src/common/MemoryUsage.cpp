@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file MemoryUsage.cpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/common/MemoryUsage.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+#include <sys/resource.h>
+
+namespace steam {
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes held by the evaluator pools, and the installed allocation counter
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::atomic<std::ptrdiff_t> poolBytes(0);
+std::atomic<AllocationCounter> allocationCounter(NULL);
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Total bytes
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t MemoryUsage::total() const {
+  return blockHessian + sparseHessian + choleskyFactor + stateVector + stateBackup +
+         evaluatorPools;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Keep the larger of each subsystem's bytes
+//////////////////////////////////////////////////////////////////////////////////////////////
+void MemoryUsage::updateMax(const MemoryUsage& other) {
+  blockHessian = std::max(blockHessian, other.blockHessian);
+  sparseHessian = std::max(sparseHessian, other.sparseHessian);
+  choleskyFactor = std::max(choleskyFactor, other.choleskyFactor);
+  stateVector = std::max(stateVector, other.stateVector);
+  stateBackup = std::max(stateBackup, other.stateBackup);
+  evaluatorPools = std::max(evaluatorPools, other.evaluatorPools);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Print the bytes of each subsystem
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::ostream& operator<<(std::ostream& out, const MemoryUsage& usage) {
+  out << "block Hessian: " << usage.blockHessian << " B, "
+      << "sparse Hessian: " << usage.sparseHessian << " B, "
+      << "Cholesky factor: " << usage.choleskyFactor << " B, "
+      << "state vector: " << usage.stateVector << " B, "
+      << "state backup: " << usage.stateBackup << " B, "
+      << "evaluator pools: " << usage.evaluatorPools << " B, "
+      << "total: " << usage.total() << " B";
+  return out;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes of a compressed sparse matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t getMemoryUsage(const Eigen::SparseMatrix<double>& matrix) {
+  return sizeof(matrix) + (matrix.outerSize() + 1)*sizeof(int) +
+         matrix.data().allocatedSize()*(sizeof(double) + sizeof(int));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Record the allocation (positive) or release (negative) of evaluator pool memory
+//////////////////////////////////////////////////////////////////////////////////////////////
+void recordPoolMemory(std::ptrdiff_t bytes) {
+  poolBytes += bytes;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes currently held by the evaluator pools
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t getPoolMemoryUsage() {
+  return poolBytes.load();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Install the allocation counter (NULL to remove it)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void setAllocationCounter(AllocationCounter counter) {
+  allocationCounter = counter;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Number of heap allocations made so far, according to the installed counter
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long long getAllocationCount() {
+  AllocationCounter counter = allocationCounter.load();
+  return counter ? counter() : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Peak resident memory of the process in bytes
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t getPeakResidentMemory() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss;         // bytes
+#else
+  return usage.ru_maxrss*1024ul;  // kilobytes
+#endif
+}
+
+} // steam
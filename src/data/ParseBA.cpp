@@ -7,104 +7,484 @@
 
 #include <steam/data/ParseBA.hpp>
 
+#include <cstdio>
 #include <iostream>
+#include <unordered_map>
 
+#include <steam/common/MappedFile.hpp>
 #include <steam/common/ParseUtils.hpp>
 
 namespace steam {
 namespace data {
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Partial dataset parsed from a chunk of lines (with flags for the single-line fields)
+//////////////////////////////////////////////////////////////////////////////////////////////
+struct SimpleBaChunk {
+  SimpleBaChunk() : hasExtrinsic(false), hasCamParams(false), hasNoise(false) {}
+  SimpleBaDataset data;
+  bool hasExtrinsic;
+  bool hasCamParams;
+  bool hasNoise;
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse the remaining fields of a FRAME_GT/FRAME_IC line
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseFrame(steam::parse::FieldCursor* fields, SimpleBaDataset::Frame* frame) {
+  frame->frameID = fields->nextInt();
+  frame->time = fields->nextDouble();
+  for (unsigned int j = 0; j < 6; j++) {
+    frame->pose_vec_k0[j] = fields->nextDouble();
+  }
+  frame->T_k0 = lgmath::se3::Transformation(frame->pose_vec_k0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse the remaining fields of a LAND_GT/LAND_IC line
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseLandmark(steam::parse::FieldCursor* fields, SimpleBaDataset::Landmark* landmark) {
+  landmark->landID = fields->nextInt();
+  for (unsigned int j = 0; j < 3; j++) {
+    landmark->point[j] = fields->nextDouble();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse the remaining fields of a STEREO line
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseStereoMeas(steam::parse::FieldCursor* fields, SimpleBaDataset::StereoMeas* meas) {
+  meas->frameID = fields->nextInt();
+  meas->landID = fields->nextInt();
+  meas->time = fields->nextDouble();
+  for (unsigned int j = 0; j < 4; j++) {
+    meas->data[j] = fields->nextDouble();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse the remaining fields of a line of the given type
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseSimpleBaLine(const char* type, const char* typeEnd,
+                              steam::parse::FieldCursor* fields, SimpleBaChunk* chunk) {
+
+  SimpleBaDataset& result = chunk->data;
+  if (steam::parse::fieldEquals(type, typeEnd, "STEREO")) { // check if line is a stereo camera measurement
+    SimpleBaDataset::StereoMeas temp;
+    parseStereoMeas(fields, &temp);
+    result.meas.push_back(temp);
+  } else if (steam::parse::fieldEquals(type, typeEnd, "FRAME_GT")) { // check if line is a ground-truth pose
+    SimpleBaDataset::Frame temp;
+    parseFrame(fields, &temp);
+    result.frames_gt.push_back(temp);
+  } else if (steam::parse::fieldEquals(type, typeEnd, "LAND_GT")) { // check if line is a ground-truth landmark
+    SimpleBaDataset::Landmark temp;
+    parseLandmark(fields, &temp);
+    result.land_gt.push_back(temp);
+  } else if (steam::parse::fieldEquals(type, typeEnd, "FRAME_IC")) { // check if line is a pose initial condition
+    SimpleBaDataset::Frame temp;
+    parseFrame(fields, &temp);
+    result.frames_ic.push_back(temp);
+  } else if (steam::parse::fieldEquals(type, typeEnd, "LAND_IC")) { // check if line is a landmark initial condition
+    SimpleBaDataset::Landmark temp;
+    parseLandmark(fields, &temp);
+    result.land_ic.push_back(temp);
+  } else if (steam::parse::fieldEquals(type, typeEnd, "EXTRINSIC")) { // check if line is the extrinsic calibration
+    Eigen::Matrix<double,6,1> vector_cam_veh;
+    for (unsigned int j = 0; j < 6; j++) {
+      vector_cam_veh[j] = fields->nextDouble();
+    }
+    result.T_cv = lgmath::se3::Transformation(vector_cam_veh);
+    chunk->hasExtrinsic = true;
+  } else if (steam::parse::fieldEquals(type, typeEnd, "CAMPARAMS")) { // check if line is the intrinsic calibration
+    result.camParams.b  = fields->nextDouble();
+    result.camParams.fu = fields->nextDouble();
+    result.camParams.fv = fields->nextDouble();
+    result.camParams.cu = fields->nextDouble();
+    result.camParams.cv = fields->nextDouble();
+    chunk->hasCamParams = true;
+  } else if (steam::parse::fieldEquals(type, typeEnd, "DIAGNOISE")) { // check if line is the diagonal sensor noise
+    result.noise = Eigen::Matrix4d::Zero();
+    for (unsigned int j = 0; j < 4; j++) {
+      result.noise(j,j) = fields->nextDouble();
+    }
+    chunk->hasNoise = true;
+  } else { // unrecognized line
+    throw std::logic_error("file contained unrecognized field");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a chunk of lines of a simple BA dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseSimpleBaChunk(const char* begin, const char* end, SimpleBaChunk* chunk) {
+
+  const char* pos = begin;
+  const char* lineBegin; const char* lineEnd;
+  while (steam::parse::nextLine(&pos, end, &lineBegin, &lineEnd)) {
+
+    // Skip blank lines
+    if (lineBegin == lineEnd) {
+      continue;
+    }
+
+    // Get line type and parse accordingly
+    steam::parse::FieldCursor fields(lineBegin, lineEnd, ',');
+    const char* type; const char* typeEnd;
+    fields.next(&type, &typeEnd);
+    parseSimpleBaLine(type, typeEnd, &fields, chunk);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Append the elements of one vector to another
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+static void append(const std::vector<T>& from, std::vector<T>* to) {
+  to->insert(to->end(), from.begin(), from.end());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Function that parses a simple BA dataset
 //////////////////////////////////////////////////////////////////////////////////////////////
-SimpleBaDataset parseSimpleBaDataset(const std::string& file) {
+SimpleBaDataset parseSimpleBaDataset(const std::string& file, unsigned int numThreads) {
 
-  // Parse comma delimited file into a matrix of strings
-  std::vector<std::vector<std::string> > temp = steam::parse::loadData(file, ',');
-  if (temp.size() < 1u) {
+  // Map the comma delimited file
+  steam::parse::MappedFile mapped(file);
+  if (mapped.size() < 1u) {
     std::stringstream ss; ss << "The file: " << file << ", was empty.";
     throw std::invalid_argument(ss.str());
   }
 
-  // Loop over each line and parse accordingly
+  // Parse chunks of lines (in parallel for large files)
+  std::vector<SimpleBaChunk, Eigen::aligned_allocator<SimpleBaChunk> > chunks;
+  steam::parse::parseLineChunks(mapped.data(), mapped.data() + mapped.size(), numThreads,
+                                &parseSimpleBaChunk, &chunks);
+  if (chunks.size() == 1u) {
+    return chunks[0].data;
+  }
+
+  // Concatenate chunks in file order (later single-line fields overwrite earlier ones)
   SimpleBaDataset result;
-  for (std::vector<std::vector<std::string> >::iterator it = temp.begin(); it != temp.end(); ++it) {
-
-    if (it->at(0) == "FRAME_GT") { // check if line is a ground-truth pose
-      SimpleBaDataset::Frame temp;
-      unsigned int i = 0;
-      temp.frameID = atoi(it->at(++i).c_str());
-      temp.time = atof(it->at(++i).c_str());
-      for (unsigned int j = 0; j < 6; j++) {
-        temp.pose_vec_k0[j] = atof(it->at(++i).c_str());
-      }
-      temp.T_k0 = lgmath::se3::Transformation(temp.pose_vec_k0);
-      result.frames_gt.push_back(temp);
-    } else if (it->at(0) == "LAND_GT") { // check if line is a ground-truth landmark
-      SimpleBaDataset::Landmark temp;
-      unsigned int i = 0;
-      temp.landID = atoi(it->at(++i).c_str());
-      for (unsigned int j = 0; j < 3; j++) {
-        temp.point[j] = atof(it->at(++i).c_str());
-      }
-      result.land_gt.push_back(temp);
-    } else if (it->at(0) == "FRAME_IC") { // check if line is a pose initial condition
-      SimpleBaDataset::Frame temp;
-      unsigned int i = 0;
-      temp.frameID = atoi(it->at(++i).c_str());
-      temp.time = atof(it->at(++i).c_str());
-      for (unsigned int j = 0; j < 6; j++) {
-        temp.pose_vec_k0[j] = atof(it->at(++i).c_str());
-      }
-      temp.T_k0 = lgmath::se3::Transformation(temp.pose_vec_k0);
-      result.frames_ic.push_back(temp);
-    } else if (it->at(0) == "LAND_IC") { // check if line is a landmark initial condition
-      SimpleBaDataset::Landmark temp;
-      unsigned int i = 0;
-      temp.landID = atoi(it->at(++i).c_str());
-      for (unsigned int j = 0; j < 3; j++) {
-        temp.point[j] = atof(it->at(++i).c_str());
-      }
-      result.land_ic.push_back(temp);
-    } else if (it->at(0) == "EXTRINSIC") { // check if line is the extrinsic calibration
-      Eigen::Matrix<double,6,1> vector_cam_veh;
-      unsigned int i = 0;
-      for (unsigned int j = 0; j < 6; j++) {
-        vector_cam_veh[j] = atof(it->at(++i).c_str());
-      }
-      result.T_cv = lgmath::se3::Transformation(vector_cam_veh);
-    } else if (it->at(0) == "CAMPARAMS") { // check if line is the intrinsic calibration
-      unsigned int i = 0;
-      result.camParams.b  = atof(it->at(++i).c_str());
-      result.camParams.fu = atof(it->at(++i).c_str());
-      result.camParams.fv = atof(it->at(++i).c_str());
-      result.camParams.cu = atof(it->at(++i).c_str());
-      result.camParams.cv = atof(it->at(++i).c_str());
-    } else if (it->at(0) == "DIAGNOISE") { // check if line is the diagonal sensor noise
-      result.noise = Eigen::Matrix4d::Zero();
-      unsigned int i = 1;
-      result.noise(i-1,i-1) = atof(it->at(i).c_str()); i++;
-      result.noise(i-1,i-1) = atof(it->at(i).c_str()); i++;
-      result.noise(i-1,i-1) = atof(it->at(i).c_str()); i++;
-      result.noise(i-1,i-1) = atof(it->at(i).c_str()); i++;
-    } else if (it->at(0) == "STEREO") { // check if line is a stereo camera measurement
-      SimpleBaDataset::StereoMeas temp;
-      unsigned int i = 0;
-      temp.frameID = atoi(it->at(++i).c_str());
-      temp.landID = atoi(it->at(++i).c_str());
-      temp.time = atof(it->at(++i).c_str());
-      for (unsigned int j = 0; j < 4; j++) {
-        temp.data[j] = atof(it->at(++i).c_str());
-      }
-      result.meas.push_back(temp);
-    } else { // unrecognized line
-      throw std::logic_error("file contained unrecognized field");
+  size_t numMeas = 0;
+  for (unsigned int c = 0; c < chunks.size(); c++) {
+    numMeas += chunks[c].data.meas.size();
+  }
+  result.meas.reserve(numMeas);
+  for (unsigned int c = 0; c < chunks.size(); c++) {
+    const SimpleBaDataset& data = chunks[c].data;
+    append(data.frames_gt, &result.frames_gt);
+    append(data.land_gt, &result.land_gt);
+    append(data.frames_ic, &result.frames_ic);
+    append(data.land_ic, &result.land_ic);
+    append(data.meas, &result.meas);
+    if (chunks[c].hasExtrinsic) {
+      result.T_cv = data.T_cv;
+    }
+    if (chunks[c].hasCamParams) {
+      result.camParams = data.camParams;
+    }
+    if (chunks[c].hasNoise) {
+      result.noise = data.noise;
     }
   }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor, parses the lines before the first measurement
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaStream::SimpleBaStream(const std::string& file)
+  : mapped_(file), pos_(mapped_.data()), end_(mapped_.data() + mapped_.size()) {
+
+  if (mapped_.size() < 1u) {
+    std::stringstream ss; ss << "The file: " << file << ", was empty.";
+    throw std::invalid_argument(ss.str());
+  }
 
+  SimpleBaChunk header;
+  const char* pos = pos_;
+  const char* lineBegin; const char* lineEnd;
+  while (steam::parse::nextLine(&pos, end_, &lineBegin, &lineEnd)) {
+    if (lineBegin == lineEnd) {
+      continue;
+    }
+    steam::parse::FieldCursor fields(lineBegin, lineEnd, ',');
+    const char* type; const char* typeEnd;
+    fields.next(&type, &typeEnd);
+    if (steam::parse::fieldEquals(type, typeEnd, "STEREO")) {
+      break;
+    }
+    parseSimpleBaLine(type, typeEnd, &fields, &header);
+    pos_ = pos;
+  }
+  dataset_ = header.data;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the dataset parsed from the lines before the first measurement
+//////////////////////////////////////////////////////////////////////////////////////////////
+const SimpleBaDataset& SimpleBaStream::getDataset() const {
+  return dataset_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse the next stereo measurement, returns false at the end of the file
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool SimpleBaStream::next(SimpleBaDataset::StereoMeas* meas) {
+  const char* lineBegin; const char* lineEnd;
+  while (steam::parse::nextLine(&pos_, end_, &lineBegin, &lineEnd)) {
+    if (lineBegin == lineEnd) {
+      continue;
+    }
+    steam::parse::FieldCursor fields(lineBegin, lineEnd, ',');
+    const char* type; const char* typeEnd;
+    fields.next(&type, &typeEnd);
+    if (!steam::parse::fieldEquals(type, typeEnd, "STEREO")) {
+      throw std::logic_error("only stereo measurements may follow the first measurement");
+    }
+    parseStereoMeas(&fields, meas);
+    return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write FRAME_GT/FRAME_IC lines
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void writeFrames(FILE* out, const char* type,
+                        const std::vector<SimpleBaDataset::Frame>& frames) {
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    const Eigen::Matrix<double,6,1>& vec = frames[i].pose_vec_k0;
+    fprintf(out, "%s,%u,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n", type, frames[i].frameID,
+            frames[i].time, vec[0], vec[1], vec[2], vec[3], vec[4], vec[5]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write LAND_GT/LAND_IC lines
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void writeLandmarks(FILE* out, const char* type,
+                           const std::vector<SimpleBaDataset::Landmark>& landmarks) {
+  for (unsigned int i = 0; i < landmarks.size(); i++) {
+    const Eigen::Matrix<double,3,1>& point = landmarks[i].point;
+    fprintf(out, "%s,%u,%.17g,%.17g,%.17g\n", type, landmarks[i].landID,
+            point[0], point[1], point[2]);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a simple BA dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeSimpleBaDataset(const std::string& file, const SimpleBaDataset& dataset) {
+
+  FILE* out = fopen(file.c_str(), "w");
+  if (out == NULL) {
+    throw std::invalid_argument("error opening output file " + file);
+  }
+
+  // Frames, landmarks and calibration
+  writeFrames(out, "FRAME_GT", dataset.frames_gt);
+  writeLandmarks(out, "LAND_GT", dataset.land_gt);
+  writeFrames(out, "FRAME_IC", dataset.frames_ic);
+  writeLandmarks(out, "LAND_IC", dataset.land_ic);
+  const Eigen::Matrix<double,6,1> vector_cam_veh = dataset.T_cv.vec();
+  fprintf(out, "EXTRINSIC,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n", vector_cam_veh[0],
+          vector_cam_veh[1], vector_cam_veh[2], vector_cam_veh[3], vector_cam_veh[4],
+          vector_cam_veh[5]);
+  fprintf(out, "CAMPARAMS,%.17g,%.17g,%.17g,%.17g,%.17g\n", dataset.camParams.b,
+          dataset.camParams.fu, dataset.camParams.fv, dataset.camParams.cu, dataset.camParams.cv);
+  fprintf(out, "DIAGNOISE,%.17g,%.17g,%.17g,%.17g\n", dataset.noise(0,0), dataset.noise(1,1),
+          dataset.noise(2,2), dataset.noise(3,3));
+
+  // Measurements
+  for (unsigned int i = 0; i < dataset.meas.size(); i++) {
+    const SimpleBaDataset::StereoMeas& meas = dataset.meas[i];
+    fprintf(out, "STEREO,%u,%u,%.17g,%.17g,%.17g,%.17g,%.17g\n", meas.frameID, meas.landID,
+            meas.time, meas.data[0], meas.data[1], meas.data[2], meas.data[3]);
+  }
+
+  const bool failed = ferror(out) != 0;
+  if (fclose(out) != 0 || failed) {
+    throw std::runtime_error("error writing output file " + file);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the unlocked poses and landmarks, and the cost terms, to an optimization
+///        problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SimpleBaProblem::addToProblem(OptimizationProblem* problem) const {
+  for (unsigned int i = 0; i < poses.size(); i++) {
+    if (!poses[i]->isLocked()) {
+      problem->addStateVariable(poses[i]);
+    }
+  }
+  for (unsigned int i = 0; i < landmarks.size(); i++) {
+    problem->addStateVariable(landmarks[i]);
+  }
+  problem->addCostTerm(costTerms);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Map the IDs of frames or landmarks to their index
+//////////////////////////////////////////////////////////////////////////////////////////////
+static std::unordered_map<unsigned int, unsigned int> indexFrames(
+    const std::vector<SimpleBaDataset::Frame>& frames) {
+  std::unordered_map<unsigned int, unsigned int> index;
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    index[frames[i].frameID] = i;
+  }
+  return index;
+}
+
+static std::unordered_map<unsigned int, unsigned int> indexLandmarks(
+    const std::vector<SimpleBaDataset::Landmark>& landmarks) {
+  std::unordered_map<unsigned int, unsigned int> index;
+  for (unsigned int i = 0; i < landmarks.size(); i++) {
+    index[landmarks[i].landID] = i;
+  }
+  return index;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the bundle adjustment problem of a simple BA dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaProblem buildSimpleBaProblem(const SimpleBaDataset& dataset,
+                                     const LossFunctionBase::ConstPtr& lossFunc,
+                                     unsigned int numThreads) {
+
+  // Shared calibration and noise
+  stereo::CameraIntrinsics intrinsics;
+  intrinsics.b  = dataset.camParams.b;
+  intrinsics.fu = dataset.camParams.fu;
+  intrinsics.fv = dataset.camParams.fv;
+  intrinsics.cu = dataset.camParams.cu;
+  intrinsics.cv = dataset.camParams.cv;
+  BaseNoiseModel<4>::ConstPtr noiseModel(new DiagonalNoiseModel<4>(dataset.noise.diagonal()));
+  SimpleBaProblem result;
+  result.costTerms.reset(new StereoCostTermCollection(intrinsics, dataset.T_cv, noiseModel,
+                                                      lossFunc, numThreads));
+
+  // Pose and landmark states (registered in the same order)
+  for (unsigned int i = 0; i < dataset.frames_ic.size(); i++) {
+    result.poses.push_back(se3::TransformStateVar::Ptr(
+        new se3::TransformStateVar(dataset.frames_ic[i].T_k0)));
+    result.costTerms->addPose(result.poses[i]);
+  }
+  if (!result.poses.empty()) {
+    result.poses[0]->setLock(true);
+  }
+  for (unsigned int i = 0; i < dataset.land_ic.size(); i++) {
+    result.landmarks.push_back(se3::LandmarkStateVar::Ptr(
+        new se3::LandmarkStateVar(dataset.land_ic[i].point)));
+    result.costTerms->addLandmark(result.landmarks[i]);
+  }
+
+  // Measurements
+  const std::unordered_map<unsigned int, unsigned int> frameIndex = indexFrames(dataset.frames_ic);
+  const std::unordered_map<unsigned int, unsigned int> landIndex = indexLandmarks(dataset.land_ic);
+  result.costTerms->reserve(dataset.meas.size());
+  for (unsigned int i = 0; i < dataset.meas.size(); i++) {
+    const SimpleBaDataset::StereoMeas& meas = dataset.meas[i];
+    std::unordered_map<unsigned int, unsigned int>::const_iterator frame =
+        frameIndex.find(meas.frameID);
+    std::unordered_map<unsigned int, unsigned int>::const_iterator land =
+        landIndex.find(meas.landID);
+    if (frame == frameIndex.end() || land == landIndex.end()) {
+      std::stringstream ss; ss << "measurement " << i << " refers to an unknown frame or landmark.";
+      throw std::invalid_argument(ss.str());
+    }
+    result.costTerms->add(meas.data, frame->second, land->second);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the unlocked states, and the cost terms, to an optimization problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SimpleBaTrajectoryProblem::addToProblem(OptimizationProblem* problem) const {
+  for (unsigned int i = 0; i < poses.size(); i++) {
+    if (!poses[i]->isLocked()) {
+      problem->addStateVariable(poses[i]);
+    }
+    problem->addStateVariable(velocities[i]);
+  }
+  for (unsigned int i = 0; i < landmarks.size(); i++) {
+    problem->addStateVariable(landmarks[i]);
+  }
+  problem->addCostTerm(costTerms);
+  problem->addCostTerm(priorCostTerms);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the continuous-time problem of a simple BA dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaTrajectoryProblem buildSimpleBaTrajectoryProblem(
+    const SimpleBaDataset& dataset, const Eigen::Matrix<double,6,6>& Qc_inv,
+    const LossFunctionBase::ConstPtr& lossFunc, unsigned int numThreads) {
+
+  // Knots, with velocities from finite differences of the poses
+  SimpleBaTrajectoryProblem result;
+  result.trajectory.reset(new se3::SteamTrajInterface(Qc_inv));
+  const std::vector<SimpleBaDataset::Frame>& frames = dataset.frames_ic;
+  Eigen::Matrix<double,6,1> velocity = Eigen::Matrix<double,6,1>::Zero();
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    if (i + 1 < frames.size()) {
+      velocity = (frames[i+1].T_k0/frames[i].T_k0).vec()/(frames[i+1].time - frames[i].time);
+    }
+    result.poses.push_back(se3::TransformStateVar::Ptr(
+        new se3::TransformStateVar(frames[i].T_k0)));
+    result.velocities.push_back(VectorSpaceStateVar::Ptr(new VectorSpaceStateVar(velocity)));
+    result.trajectory->add(steam::Time(frames[i].time),
+                           se3::TransformStateEvaluator::MakeShared(result.poses[i]),
+                           result.velocities[i]);
+  }
+  if (!result.poses.empty()) {
+    result.poses[0]->setLock(true);
+  }
+
+  // Landmarks
+  for (unsigned int i = 0; i < dataset.land_ic.size(); i++) {
+    result.landmarks.push_back(se3::LandmarkStateVar::Ptr(
+        new se3::LandmarkStateVar(dataset.land_ic[i].point)));
+  }
+
+  // Shared calibration, noise and loss
+  stereo::CameraIntrinsics::Ptr intrinsics(new stereo::CameraIntrinsics());
+  intrinsics->b  = dataset.camParams.b;
+  intrinsics->fu = dataset.camParams.fu;
+  intrinsics->fv = dataset.camParams.fv;
+  intrinsics->cu = dataset.camParams.cu;
+  intrinsics->cv = dataset.camParams.cv;
+  BaseNoiseModel<4>::ConstPtr noiseModel(new DiagonalNoiseModel<4>(dataset.noise.diagonal()));
+  se3::TransformEvaluator::Ptr T_cv = se3::FixedTransformEvaluator::MakeShared(dataset.T_cv);
+
+  // Measurements, at the interpolated pose of their time
+  const std::unordered_map<unsigned int, unsigned int> landIndex = indexLandmarks(dataset.land_ic);
+  result.costTerms.reset(new ParallelizedCostTermCollection(numThreads));
+  for (unsigned int i = 0; i < dataset.meas.size(); i++) {
+    const SimpleBaDataset::StereoMeas& meas = dataset.meas[i];
+    std::unordered_map<unsigned int, unsigned int>::const_iterator land =
+        landIndex.find(meas.landID);
+    if (land == landIndex.end()) {
+      std::stringstream ss; ss << "measurement " << i << " refers to an unknown landmark.";
+      throw std::invalid_argument(ss.str());
+    }
+    se3::TransformEvaluator::Ptr T_c0 = se3::compose(T_cv,
+        result.trajectory->getInterpPoseEval(steam::Time(meas.time)));
+    StereoCameraErrorEval::Ptr errorfunc(new StereoCameraErrorEval(meas.data, intrinsics, T_c0,
+        result.landmarks[land->second]));
+    result.costTerms->add(WeightedLeastSqCostTerm<4,6>::Ptr(
+        new WeightedLeastSqCostTerm<4,6>(errorfunc, noiseModel, lossFunc)));
+  }
+
+  // Smoothing prior
+  result.priorCostTerms.reset(new ParallelizedCostTermCollection(numThreads));
+  result.trajectory->appendPriorCostTerms(result.priorCostTerms);
   return result;
 }
 
 } // data
 } // steam
-
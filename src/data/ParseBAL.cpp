@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file ParseBAL.cpp
+/// \brief Parses a Bundle-Adjustment-in-the-Large (BAL) dataset
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/data/ParseBAL.hpp>
+
+#include <Eigen/Geometry>
+
+#include <steam/common/MappedFile.hpp>
+#include <steam/common/ParseUtils.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a chunk of observation lines (camera point u v)
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseBalObservationChunk(const char* begin, const char* end,
+                                     std::vector<BalDataset::Observation>* result) {
+  const char* pos = begin;
+  const char* lineBegin; const char* lineEnd;
+  while (steam::parse::nextLine(&pos, end, &lineBegin, &lineEnd)) {
+    steam::parse::TokenCursor tokens(lineBegin, lineEnd);
+    if (!tokens.hasNext()) {
+      continue;
+    }
+    BalDataset::Observation obs;
+    obs.cameraID = tokens.nextInt();
+    obs.pointID = tokens.nextInt();
+    obs.data[0] = tokens.nextDouble();
+    obs.data[1] = tokens.nextDouble();
+    result->push_back(obs);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a chunk of camera and point parameters (any number per line)
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseBalParameterChunk(const char* begin, const char* end,
+                                   std::vector<double>* result) {
+  steam::parse::TokenCursor tokens(begin, end);
+  while (tokens.hasNext()) {
+    result->push_back(tokens.nextDouble());
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Function that parses a BAL dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+BalDataset parseBalDataset(const std::string& file, unsigned int numThreads) {
+
+  // Map the space delimited file
+  steam::parse::MappedFile mapped(file);
+  if (mapped.size() < 1u) {
+    std::stringstream ss; ss << "The file: " << file << ", was empty.";
+    throw std::invalid_argument(ss.str());
+  }
+  const char* begin = mapped.data();
+  const char* end = mapped.data() + mapped.size();
+
+  // Header (number of cameras, points and observations)
+  const char* obsBegin = steam::parse::skipLines(begin, end, 1);
+  steam::parse::TokenCursor header(begin, obsBegin);
+  const long numCameras = header.nextInt();
+  const long numPoints = header.nextInt();
+  const long numObservations = header.nextInt();
+  if (numCameras < 0 || numPoints < 0 || numObservations < 0) {
+    throw std::logic_error("BAL header contains a negative count.");
+  }
+
+  // Observations, one per line (in parallel chunks for large files)
+  const char* obsEnd = steam::parse::skipLines(obsBegin, end, numObservations);
+  BalDataset result;
+  std::vector<std::vector<BalDataset::Observation> > obsChunks;
+  steam::parse::parseLineChunks(obsBegin, obsEnd, numThreads, &parseBalObservationChunk,
+                                &obsChunks);
+  result.observations.reserve(numObservations);
+  for (unsigned int c = 0; c < obsChunks.size(); c++) {
+    result.observations.insert(result.observations.end(), obsChunks[c].begin(),
+                               obsChunks[c].end());
+  }
+  if (result.observations.size() != size_t(numObservations)) {
+    throw std::logic_error("BAL file has fewer observations than its header.");
+  }
+
+  // Camera parameters (9 per camera), then point parameters (3 per point)
+  std::vector<std::vector<double> > paramChunks;
+  steam::parse::parseLineChunks(obsEnd, end, numThreads, &parseBalParameterChunk, &paramChunks);
+  std::vector<double> params;
+  params.reserve(9*numCameras + 3*numPoints);
+  for (unsigned int c = 0; c < paramChunks.size(); c++) {
+    params.insert(params.end(), paramChunks[c].begin(), paramChunks[c].end());
+  }
+  if (params.size() != size_t(9*numCameras + 3*numPoints)) {
+    throw std::logic_error("BAL file has the wrong number of camera and point parameters.");
+  }
+
+  // Cameras: Rodrigues rotation, translation, focal length and radial distortion, for the
+  // camera model P = R*X + t, p = -P/P.z, uv = f*(1 + k1*|p|^2 + k2*|p|^4)*p
+  result.cameras.resize(numCameras);
+  for (long i = 0; i < numCameras; i++) {
+    const double* p = &params[9*i];
+    const Eigen::Vector3d aaxis(p[0], p[1], p[2]);
+    const double angle = aaxis.norm();
+    Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+    if (angle > 0.0) {
+      T.topLeftCorner<3,3>() = Eigen::AngleAxisd(angle, aaxis/angle).toRotationMatrix();
+    }
+    T.topRightCorner<3,1>() << p[3], p[4], p[5];
+
+    // Rotate by pi about z, so that the camera looks down its positive z-axis
+    T.topRows<2>() *= -1.0;
+    result.cameras[i].T_c0 = lgmath::se3::Transformation(T);
+    result.cameras[i].f = p[6];
+    result.cameras[i].k1 = p[7];
+    result.cameras[i].k2 = p[8];
+  }
+
+  // Points
+  result.points.resize(numPoints);
+  for (long i = 0; i < numPoints; i++) {
+    const double* p = &params[9*numCameras + 3*i];
+    result.points[i] << p[0], p[1], p[2];
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the unlocked poses and landmarks, and the cost terms, to an optimization
+///        problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+void BalProblem::addToProblem(OptimizationProblem* problem) const {
+  for (unsigned int i = 0; i < poses.size(); i++) {
+    if (!poses[i]->isLocked()) {
+      problem->addStateVariable(poses[i]);
+    }
+  }
+  for (unsigned int i = 0; i < landmarks.size(); i++) {
+    problem->addStateVariable(landmarks[i]);
+  }
+  problem->addCostTerm(costTerms);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the bundle adjustment problem of a BAL dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+BalProblem buildBalProblem(const BalDataset& dataset, const LossFunctionBase::ConstPtr& lossFunc,
+                           unsigned int numThreads) {
+
+  // Create a pose state, pose evaluator and intrinsics for each camera
+  BalProblem result;
+  std::vector<se3::TransformEvaluator::ConstPtr> poseEvals(dataset.cameras.size());
+  std::vector<mono::CameraIntrinsics::ConstPtr> intrinsics(dataset.cameras.size());
+  result.poses.reserve(dataset.cameras.size());
+  for (unsigned int i = 0; i < dataset.cameras.size(); i++) {
+    const BalDataset::Camera& camera = dataset.cameras[i];
+    result.poses.push_back(se3::TransformStateVar::Ptr(new se3::TransformStateVar(camera.T_c0)));
+    poseEvals[i] = se3::TransformStateEvaluator::MakeShared(result.poses[i]);
+    mono::CameraIntrinsics::Ptr intrinsic(new mono::CameraIntrinsics());
+    intrinsic->fu = camera.f; intrinsic->fv = camera.f;
+    intrinsic->cu = 0.0; intrinsic->cv = 0.0;
+    intrinsic->k1 = camera.k1; intrinsic->k2 = camera.k2;
+    intrinsics[i] = intrinsic;
+  }
+  if (!result.poses.empty()) {
+    result.poses[0]->setLock(true);
+  }
+
+  // Create a landmark state for each point
+  result.landmarks.reserve(dataset.points.size());
+  for (unsigned int i = 0; i < dataset.points.size(); i++) {
+    result.landmarks.push_back(se3::LandmarkStateVar::Ptr(
+        new se3::LandmarkStateVar(dataset.points[i])));
+  }
+
+  // Create a reprojection cost term for each observation
+  result.costTerms.reset(new ParallelizedCostTermCollection(numThreads));
+  BaseNoiseModel<2>::ConstPtr sharedNoiseModel(new DiagonalNoiseModel<2>(Eigen::Vector2d::Ones()));
+  for (unsigned int i = 0; i < dataset.observations.size(); i++) {
+    const BalDataset::Observation& obs = dataset.observations[i];
+    if (obs.cameraID >= result.poses.size() || obs.pointID >= result.landmarks.size()) {
+      std::stringstream ss; ss << "observation " << i << " refers to an unknown camera or point.";
+      throw std::invalid_argument(ss.str());
+    }
+    MonoCameraErrorEval::Ptr errorfunc(new MonoCameraErrorEval(obs.data,
+        intrinsics[obs.cameraID], poseEvals[obs.cameraID], result.landmarks[obs.pointID]));
+    result.costTerms->add(WeightedLeastSqCostTerm<2,6>::Ptr(
+        new WeightedLeastSqCostTerm<2,6>(errorfunc, sharedNoiseModel, lossFunc)));
+  }
+  return result;
+}
+
+} // data
+} // steam
@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file ParseG2o.cpp
+/// \brief Parses a 3D pose-graph dataset in the g2o format (VERTEX_SE3:QUAT/EDGE_SE3:QUAT)
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/data/ParseG2o.hpp>
+
+#include <cstdio>
+#include <unordered_map>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Geometry>
+
+#include <steam/common/MappedFile.hpp>
+#include <steam/common/ParseUtils.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a g2o pose (x y z qx qy qz qw) into a transformation matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+static Eigen::Matrix4d parseG2oPose(steam::parse::TokenCursor* tokens) {
+  Eigen::Vector3d r;
+  r[0] = tokens->nextDouble();
+  r[1] = tokens->nextDouble();
+  r[2] = tokens->nextDouble();
+  const double qx = tokens->nextDouble();
+  const double qy = tokens->nextDouble();
+  const double qz = tokens->nextDouble();
+  const double qw = tokens->nextDouble();
+  Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+  T.topLeftCorner<3,3>() = Eigen::Quaterniond(qw, qx, qy, qz).normalized().toRotationMatrix();
+  T.topRightCorner<3,1>() = r;
+  return T;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Scaling from the g2o error (translation, quaternion vector) to the se(3) error
+//////////////////////////////////////////////////////////////////////////////////////////////
+static Eigen::Matrix<double,6,1> g2oErrorScale() {
+  Eigen::Matrix<double,6,1> scale;
+  scale << 1.0, 1.0, 1.0, 0.5, 0.5, 0.5;
+  return scale;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a transformation matrix as a g2o pose (x y z qx qy qz qw)
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void writeG2oPose(FILE* out, const Eigen::Matrix4d& T) {
+  const Eigen::Quaterniond q(Eigen::Matrix3d(T.topLeftCorner<3,3>()));
+  fprintf(out, " %.17g %.17g %.17g %.17g %.17g %.17g %.17g", T(0,3), T(1,3), T(2,3),
+          q.x(), q.y(), q.z(), q.w());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a chunk of lines of a g2o dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void parseG2oSe3Chunk(const char* begin, const char* end, G2oSe3Dataset* result) {
+
+  // Loop over each line
+  const char* pos = begin;
+  const char* lineBegin; const char* lineEnd;
+  while (steam::parse::nextLine(&pos, end, &lineBegin, &lineEnd)) {
+
+    // Skip blank lines
+    steam::parse::TokenCursor tokens(lineBegin, lineEnd);
+    if (!tokens.hasNext()) {
+      continue;
+    }
+    const char* type; const char* typeEnd;
+    tokens.next(&type, &typeEnd);
+
+    if (steam::parse::fieldEquals(type, typeEnd, "VERTEX_SE3:QUAT")) {
+
+      // The pose is T_0k (vertex in the world frame)
+      G2oSe3Dataset::Vertex vertex;
+      vertex.id = tokens.nextInt();
+      vertex.T_k0 = lgmath::se3::Transformation(parseG2oPose(&tokens)).inverse();
+      result->vertices.push_back(vertex);
+
+    } else if (steam::parse::fieldEquals(type, typeEnd, "EDGE_SE3:QUAT")) {
+
+      // The measurement is T_ij, the pose of vertex j in the frame of vertex i
+      G2oSe3Dataset::Edge edge;
+      edge.idA = tokens.nextInt();
+      edge.idB = tokens.nextInt();
+      edge.T_BA = lgmath::se3::Transformation(parseG2oPose(&tokens)).inverse();
+
+      // Information on (translation, quaternion vector), upper-triangular entries row by row
+      Eigen::Matrix<double,6,6> information;
+      for (unsigned int r = 0; r < 6; r++) {
+        for (unsigned int c = r; c < 6; c++) {
+          information(r,c) = information(c,r) = tokens.nextDouble();
+        }
+      }
+
+      // The quaternion vector is half of the rotation vector (to first order); both errors
+      // are expressed in the frame of vertex j
+      const Eigen::Matrix<double,6,1> scale = g2oErrorScale();
+      information = scale.asDiagonal() * information * scale.asDiagonal();
+      Eigen::LLT<Eigen::Matrix<double,6,6> > llt(information);
+      if (llt.info() != Eigen::Success) {
+        throw std::logic_error("EDGE_SE3:QUAT information matrix is not positive definite.");
+      }
+      edge.sqrtInformation = llt.matrixU();
+      result->edges.push_back(edge);
+
+    } else if (steam::parse::fieldEquals(type, typeEnd, "FIX")) {
+      while (tokens.hasNext()) {
+        result->fixed.push_back(tokens.nextInt());
+      }
+    } else {
+      throw std::logic_error("file contained unrecognized field");
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Function that parses a g2o 3D pose-graph dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+G2oSe3Dataset parseG2oSe3Dataset(const std::string& file, unsigned int numThreads) {
+
+  // Map the space delimited file
+  steam::parse::MappedFile mapped(file);
+  if (mapped.size() < 1u) {
+    std::stringstream ss; ss << "The file: " << file << ", was empty.";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Parse chunks of lines (in parallel for large files)
+  std::vector<G2oSe3Dataset> chunks;
+  steam::parse::parseLineChunks(mapped.data(), mapped.data() + mapped.size(), numThreads,
+                                &parseG2oSe3Chunk, &chunks);
+  if (chunks.size() == 1u) {
+    return chunks[0];
+  }
+
+  // Concatenate chunks in file order
+  G2oSe3Dataset result;
+  for (unsigned int c = 0; c < chunks.size(); c++) {
+    result.vertices.insert(result.vertices.end(), chunks[c].vertices.begin(),
+                           chunks[c].vertices.end());
+    result.edges.insert(result.edges.end(), chunks[c].edges.begin(), chunks[c].edges.end());
+    result.fixed.insert(result.fixed.end(), chunks[c].fixed.begin(), chunks[c].fixed.end());
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a g2o 3D pose-graph dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeG2oSe3Dataset(const std::string& file, const G2oSe3Dataset& dataset) {
+
+  FILE* out = fopen(file.c_str(), "w");
+  if (out == NULL) {
+    throw std::invalid_argument("error opening output file " + file);
+  }
+
+  // Vertices, as T_0k
+  for (unsigned int i = 0; i < dataset.vertices.size(); i++) {
+    fprintf(out, "VERTEX_SE3:QUAT %u", dataset.vertices[i].id);
+    writeG2oPose(out, dataset.vertices[i].T_k0.inverse().matrix());
+    fprintf(out, "\n");
+  }
+
+  // Edges, as T_ij and the information on (translation, quaternion vector)
+  const Eigen::Matrix<double,6,1> inverseScale = g2oErrorScale().cwiseInverse();
+  for (unsigned int i = 0; i < dataset.edges.size(); i++) {
+    const G2oSe3Dataset::Edge& edge = dataset.edges[i];
+    fprintf(out, "EDGE_SE3:QUAT %u %u", edge.idA, edge.idB);
+    writeG2oPose(out, edge.T_BA.inverse().matrix());
+    const Eigen::Matrix<double,6,6> information = inverseScale.asDiagonal() *
+        (edge.sqrtInformation.transpose() * edge.sqrtInformation) * inverseScale.asDiagonal();
+    for (unsigned int r = 0; r < 6; r++) {
+      for (unsigned int c = r; c < 6; c++) {
+        fprintf(out, " %.17g", information(r,c));
+      }
+    }
+    fprintf(out, "\n");
+  }
+
+  // Fixed vertices
+  for (unsigned int i = 0; i < dataset.fixed.size(); i++) {
+    fprintf(out, "FIX %u\n", dataset.fixed[i]);
+  }
+
+  const bool failed = ferror(out) != 0;
+  if (fclose(out) != 0 || failed) {
+    throw std::runtime_error("error writing output file " + file);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the unlocked poses and the cost terms to an optimization problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+void G2oSe3Problem::addToProblem(OptimizationProblem* problem) const {
+  for (unsigned int i = 0; i < poses.size(); i++) {
+    if (!poses[i]->isLocked()) {
+      problem->addStateVariable(poses[i]);
+    }
+  }
+  problem->addCostTerm(costTerms);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the pose-graph problem of a g2o dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+G2oSe3Problem buildG2oSe3Problem(const G2oSe3Dataset& dataset,
+                                 const LossFunctionBase::ConstPtr& lossFunc,
+                                 unsigned int numThreads) {
+
+  // Create a pose state for each vertex
+  G2oSe3Problem result;
+  std::unordered_map<unsigned int, unsigned int> index;
+  result.poses.reserve(dataset.vertices.size());
+  for (unsigned int i = 0; i < dataset.vertices.size(); i++) {
+    index[dataset.vertices[i].id] = i;
+    result.poses.push_back(se3::TransformStateVar::Ptr(
+        new se3::TransformStateVar(dataset.vertices[i].T_k0)));
+  }
+
+  // Lock the fixed poses (or the first pose)
+  for (unsigned int i = 0; i < dataset.fixed.size(); i++) {
+    std::unordered_map<unsigned int, unsigned int>::const_iterator it =
+        index.find(dataset.fixed[i]);
+    if (it != index.end()) {
+      result.poses[it->second]->setLock(true);
+    }
+  }
+  if (dataset.fixed.empty() && !result.poses.empty()) {
+    result.poses[0]->setLock(true);
+  }
+
+  // Create a relative pose cost term for each edge
+  result.costTerms.reset(new ParallelizedCostTermCollection(numThreads));
+  BaseNoiseModel<6>::ConstPtr sharedNoiseModel;
+  Eigen::Matrix<double,6,6> sharedSqrtInformation;
+  for (unsigned int i = 0; i < dataset.edges.size(); i++) {
+    const G2oSe3Dataset::Edge& edge = dataset.edges[i];
+    std::unordered_map<unsigned int, unsigned int>::const_iterator itA = index.find(edge.idA);
+    std::unordered_map<unsigned int, unsigned int>::const_iterator itB = index.find(edge.idB);
+    if (itA == index.end() || itB == index.end()) {
+      std::stringstream ss; ss << "edge " << i << " refers to an unknown vertex.";
+      throw std::invalid_argument(ss.str());
+    }
+
+    // Consecutive edges usually have the same information, share their noise model
+    if (!sharedNoiseModel || edge.sqrtInformation != sharedSqrtInformation) {
+      sharedSqrtInformation = edge.sqrtInformation;
+      sharedNoiseModel.reset(new StaticNoiseModel<6>(edge.sqrtInformation, SQRT_INFORMATION));
+    }
+
+    TransformErrorEval::Ptr errorfunc(new TransformErrorEval(edge.T_BA,
+        result.poses[itB->second], result.poses[itA->second]));
+    result.costTerms->add(WeightedLeastSqCostTerm<6,6>::Ptr(
+        new WeightedLeastSqCostTerm<6,6>(errorfunc, sharedNoiseModel, lossFunc)));
+  }
+  return result;
+}
+
+} // data
+} // steam
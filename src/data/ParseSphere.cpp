@@ -6,6 +6,7 @@
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <steam/data/ParseSphere.hpp>
+#include <steam/common/MappedFile.hpp>
 #include <steam/common/ParseUtils.hpp>
 
 namespace steam {
@@ -30,45 +31,47 @@ Eigen::Matrix3d CfromRPY(double roll, double pitch, double yaw)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Function that parses an iSAM1 sphere dataset
+/// \brief Parse a chunk of lines of an iSAM1 sphere dataset
 //////////////////////////////////////////////////////////////////////////////////////////////
-std::vector<SphereEdge> parseSphereDataset(const std::string& file) {
-
-  // Parse space delimited file into a matrix of strings
-  std::vector<std::vector<std::string> > temp = steam::parse::loadData(file, ' ');
-  if (temp.size() < 1u) {
-    std::stringstream ss; ss << "The file: " << file << ", was empty.";
-    throw std::invalid_argument(ss.str());
-  }
+static void parseSphereChunk(const char* begin, const char* end, std::vector<SphereEdge>* result) {
 
   // Loop over each line and parse edge
-  std::vector<SphereEdge> result;
-  for (std::vector<std::vector<std::string> >::iterator it = temp.begin(); it != temp.end(); ++it) {
+  const char* pos = begin;
+  const char* lineBegin; const char* lineEnd;
+  while (steam::parse::nextLine(&pos, end, &lineBegin, &lineEnd)) {
+
+    // Skip blank lines
+    if (lineBegin == lineEnd) {
+      continue;
+    }
 
     // Check it is an edge
-    if (it->at(0) != "EDGE3") {
+    steam::parse::FieldCursor fields(lineBegin, lineEnd, ' ');
+    const char* prefix; const char* prefixEnd;
+    fields.next(&prefix, &prefixEnd);
+    if (!steam::parse::fieldEquals(prefix, prefixEnd, "EDGE3")) {
       throw std::logic_error("File format is incorrect, expected prefix EDGE3.");
     }
 
     // Check for one of the two valid sizes
-    if (it->size() != 30 && it->size() != 9) {
+    const unsigned int numFields = steam::parse::countFields(lineBegin, lineEnd, ' ');
+    if (numFields != 30 && numFields != 9) {
       throw std::logic_error("File format (number of entries per line) is incorrect.");
     }
 
     // Parse IDs
     SphereEdge edge;
-    unsigned int i = 0;
-    edge.idA = atoi(it->at(++i).c_str());
-    edge.idB = atoi(it->at(++i).c_str());
+    edge.idA = fields.nextInt();
+    edge.idB = fields.nextInt();
 
     // Parse angles
     double x, y, z, yaw, pitch, roll;
-    x = atof(it->at(++i).c_str());
-    y = atof(it->at(++i).c_str());
-    z = atof(it->at(++i).c_str());
-    roll = atof(it->at(++i).c_str());
-    pitch = atof(it->at(++i).c_str());
-    yaw = atof(it->at(++i).c_str());
+    x = fields.nextDouble();
+    y = fields.nextDouble();
+    z = fields.nextDouble();
+    roll = fields.nextDouble();
+    pitch = fields.nextDouble();
+    yaw = fields.nextDouble();
 
     // Construct transformation
     Eigen::Matrix3d C_ba = CfromRPY(-roll, -pitch, -yaw);
@@ -78,45 +81,47 @@ std::vector<SphereEdge> parseSphereDataset(const std::string& file) {
       edge.T_BA = edge.T_BA.inverse();
     }
 
-    // Get covariance data (Information is inverse of covariance)
+    // Get covariance data (Information is inverse of covariance), the upper-triangular
+    // entries are stored row by row
     edge.sqrtInformation = Eigen::MatrixXd::Identity(6,6);
-    if (it->size() == 30) {
-      double i11, i12, i13, i14, i15, i16, i22, i23, i24, i25, i26,
-             i33, i34, i35, i36, i44, i45, i46, i55, i56, i66;
-      i11 = atof(it->at(++i).c_str());
-      i12 = atof(it->at(++i).c_str());
-      i13 = atof(it->at(++i).c_str());
-      i14 = atof(it->at(++i).c_str());
-      i15 = atof(it->at(++i).c_str());
-      i16 = atof(it->at(++i).c_str());
-      i22 = atof(it->at(++i).c_str());
-      i23 = atof(it->at(++i).c_str());
-      i24 = atof(it->at(++i).c_str());
-      i25 = atof(it->at(++i).c_str());
-      i26 = atof(it->at(++i).c_str());
-      i33 = atof(it->at(++i).c_str());
-      i34 = atof(it->at(++i).c_str());
-      i35 = atof(it->at(++i).c_str());
-      i36 = atof(it->at(++i).c_str());
-      i44 = atof(it->at(++i).c_str());
-      i45 = atof(it->at(++i).c_str());
-      i46 = atof(it->at(++i).c_str());
-      i55 = atof(it->at(++i).c_str());
-      i56 = atof(it->at(++i).c_str());
-      i66 = atof(it->at(++i).c_str());
-      edge.sqrtInformation <<
-        i11, i12, i13, i14, i15, i16,
-         0., i22, i23, i24, i25, i26,
-         0.,  0., i33, i34, i35, i36,
-         0.,  0.,  0., i44, i45, i46,
-         0.,  0.,  0.,  0., i55, i56,
-         0.,  0.,  0.,  0.,  0., i66;
+    if (numFields == 30) {
+      for (unsigned int r = 0; r < 6; r++) {
+        for (unsigned int c = r; c < 6; c++) {
+          edge.sqrtInformation(r,c) = fields.nextDouble();
+        }
+      }
     }
 
     // Store edge
-    result.push_back(edge);
+    result->push_back(edge);
   }
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Function that parses an iSAM1 sphere dataset
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<SphereEdge> parseSphereDataset(const std::string& file, unsigned int numThreads) {
+
+  // Map the space delimited file
+  steam::parse::MappedFile mapped(file);
+  if (mapped.size() < 1u) {
+    std::stringstream ss; ss << "The file: " << file << ", was empty.";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Parse chunks of lines (in parallel for large files)
+  std::vector<std::vector<SphereEdge> > chunks;
+  steam::parse::parseLineChunks(mapped.data(), mapped.data() + mapped.size(), numThreads,
+                                &parseSphereChunk, &chunks);
+  if (chunks.size() == 1u) {
+    return chunks[0];
+  }
+
+  // Concatenate chunks in file order
+  std::vector<SphereEdge> result;
+  for (unsigned int c = 0; c < chunks.size(); c++) {
+    result.insert(result.end(), chunks[c].begin(), chunks[c].end());
+  }
   return result;
 }
 
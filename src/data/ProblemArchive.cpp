@@ -0,0 +1,668 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file ProblemArchive.cpp
+/// \brief Versioned binary format for saving and restoring optimization problems
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/data/ProblemArchive.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <steam/common/MappedFile.hpp>
+#include <steam/state/LieGroupStateVar.hpp>
+#include <steam/state/LandmarkStateVar.hpp>
+#include <steam/state/VectorSpaceStateVar.hpp>
+#include <steam/evaluator/blockauto/transform/TransformStateEvaluator.hpp>
+#include <steam/problem/LossFunctions.hpp>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Archive layout. All records are 8-byte aligned, and each section is preceded by a
+///        SectionHeader (with the size of its payload in bytes, a multiple of 8).
+//////////////////////////////////////////////////////////////////////////////////////////////
+static const char ARCHIVE_MAGIC[8] = {'S', 'T', 'E', 'A', 'M', 'P', 'R', 'B'};
+static const boost::uint32_t ARCHIVE_BYTE_ORDER = 0x01020304;
+
+enum ArchiveSection { STATE_SECTION = 1, KNOT_SECTION = 2, NOISE_SECTION = 3, LOSS_SECTION = 4,
+                      STEREO_SECTION = 5 };
+enum ArchiveStateType { TRANSFORM_STATE = 1, LANDMARK_STATE = 2, VECTOR_SPACE_STATE = 3 };
+enum ArchiveNoiseType { STATIC_NOISE = 1, DIAGONAL_NOISE = 2, ISOTROPIC_NOISE = 3,
+                        BLOCK_DIAGONAL_NOISE = 4 };
+enum ArchiveLossType { L2_LOSS = 1, HUBER_LOSS = 2, CAUCHY_LOSS = 3, GEMAN_MCCLURE_LOSS = 4,
+                       DCS_LOSS = 5 };
+
+struct FileHeader {
+  char magic[8];
+  boost::uint32_t version;
+  boost::uint32_t byteOrder;
+};
+
+struct SectionHeader {
+  boost::uint32_t type;
+  boost::uint32_t count;      // number of records
+  boost::uint64_t bytes;      // size of the payload
+};
+
+// STATE_SECTION: count StateRecords, followed by the raw values of all states (doubles)
+struct StateRecord {
+  boost::uint32_t type;
+  boost::uint32_t locked;
+  boost::uint32_t rawSize;
+  boost::uint32_t reserved;
+};
+
+// KNOT_SECTION: count KnotRecords
+struct KnotRecord {
+  boost::int64_t nanosecs;
+  boost::uint32_t pose;       // state index
+  boost::uint32_t velocity;   // state index
+};
+
+// NOISE_SECTION: count NoiseRecords, each followed by a NoiseBlockRecord (block-diagonal models
+// only) and by the dim*dim sqrt information matrix
+struct NoiseRecord {
+  boost::uint32_t type;
+  boost::uint32_t dim;
+};
+
+struct NoiseBlockRecord {
+  boost::uint32_t blockDim;
+  boost::uint32_t reserved;
+};
+
+// LOSS_SECTION: count LossRecords
+struct LossRecord {
+  boost::uint32_t type;
+  boost::uint32_t reserved;
+  double k;
+};
+
+// STEREO_SECTION: one StereoRecord (count is the number of measurements), followed by the pose
+// and landmark state indices, the four measurement coordinate arrays and the per-measurement
+// pose and landmark indices
+struct StereoRecord {
+  boost::uint32_t noise;
+  boost::uint32_t loss;
+  boost::uint32_t numThreads;
+  boost::uint32_t numPoses;
+  boost::uint32_t numLandmarks;
+  boost::uint32_t reserved;
+  double intrinsics[5];       // b fu fv cu cv
+  double T_cam_vehicle[16];   // column-major
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Round a byte count up to the 8-byte alignment of the archive
+//////////////////////////////////////////////////////////////////////////////////////////////
+static size_t aligned(size_t bytes) {
+  return (bytes + 7) & ~size_t(7);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Sequential writer of aligned records and sections
+//////////////////////////////////////////////////////////////////////////////////////////////
+class ArchiveWriter
+{
+ public:
+  explicit ArchiveWriter(const std::string& file)
+    : out_(file.c_str(), std::ios::binary | std::ios::trunc), sectionStart_(0) {
+    if (!out_.good()) {
+      std::stringstream ss; ss << "error opening output file " << file;
+      throw std::invalid_argument(ss.str());
+    }
+  }
+
+  // Write bytes, padded to the archive alignment
+  void write(const void* data, size_t bytes) {
+    static const char zeros[8] = {0};
+    if (bytes > 0) {
+      out_.write(static_cast<const char*>(data), bytes);
+      out_.write(zeros, aligned(bytes) - bytes);
+    }
+  }
+
+  // Write a vector as a flat array
+  template <typename T>
+  void writeArray(const std::vector<T>& values) {
+    this->write(values.empty() ? NULL : &values[0], values.size()*sizeof(T));
+  }
+
+  // Start a section (the payload size is filled in by endSection)
+  void beginSection(ArchiveSection type, size_t count) {
+    SectionHeader header = {boost::uint32_t(type), boost::uint32_t(count), 0};
+    this->write(&header, sizeof(header));
+    sectionStart_ = out_.tellp();
+  }
+
+  // Finish a section
+  void endSection() {
+    std::streampos end = out_.tellp();
+    boost::uint64_t bytes = end - sectionStart_;
+    out_.seekp(sectionStart_ - std::streamoff(sizeof(bytes)));
+    out_.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+    out_.seekp(end);
+  }
+
+  // Flush and check for errors
+  void close() {
+    out_.close();
+    if (out_.fail()) {
+      throw std::runtime_error("error writing problem archive");
+    }
+  }
+
+ private:
+  std::ofstream out_;
+  std::streampos sectionStart_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Sequential reader of aligned records, directly from a (mapped) buffer
+//////////////////////////////////////////////////////////////////////////////////////////////
+class ArchiveReader
+{
+ public:
+  ArchiveReader(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+  // Get a pointer to the next 'bytes' bytes (in place), and skip the alignment padding (the
+  // size is checked before it is aligned, so that a corrupt size cannot wrap around)
+  const char* take(size_t bytes) {
+    if (bytes > this->remaining() || aligned(bytes) > this->remaining()) {
+      throw std::runtime_error("problem archive is truncated");
+    }
+    const char* data = pos_;
+    pos_ += aligned(bytes);
+    return data;
+  }
+
+  // Copy the next record
+  template <typename T>
+  T read() {
+    T record;
+    memcpy(&record, this->take(sizeof(T)), sizeof(T));
+    return record;
+  }
+
+  // Get a pointer to the next n values (in place, the archive keeps arrays aligned)
+  template <typename T>
+  const T* takeArray(size_t n) {
+    if (n > this->remaining()/sizeof(T)) {
+      throw std::runtime_error("problem archive is truncated");
+    }
+    return reinterpret_cast<const T*>(this->take(n*sizeof(T)));
+  }
+
+  size_t remaining() const { return end_ - pos_; }
+
+  bool atEnd() const { return pos_ == end_; }
+
+ private:
+  const char* pos_;
+  const char* end_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Unique states, noise models and loss functions referenced by an archive
+//////////////////////////////////////////////////////////////////////////////////////////////
+class ArchiveIndex
+{
+ public:
+
+  // Get the index of a state, adding it if needed
+  boost::uint32_t stateIndex(const StateVariableBase::Ptr& state) {
+    if (!state) {
+      throw std::invalid_argument("[writeProblemArchive] null state variable.");
+    }
+    std::pair<boost::unordered_map<StateID, boost::uint32_t>::iterator, bool> it =
+        stateIndices_.insert(std::make_pair(state->getKey().getID(), states_.size()));
+    if (it.second) {
+      states_.push_back(state);
+    }
+    return it.first->second;
+  }
+
+  // Get the index of a noise model, adding it if needed
+  boost::uint32_t noiseIndex(const BaseNoiseModel<4>::ConstPtr& noiseModel) {
+    std::pair<std::map<const void*, boost::uint32_t>::iterator, bool> it =
+        noiseIndices_.insert(std::make_pair(noiseModel.get(), noiseModels_.size()));
+    if (it.second) {
+      noiseModels_.push_back(noiseModel);
+    }
+    return it.first->second;
+  }
+
+  // Get the index of a loss function, adding it if needed
+  boost::uint32_t lossIndex(const LossFunctionBase::ConstPtr& lossFunc) {
+    std::pair<std::map<const void*, boost::uint32_t>::iterator, bool> it =
+        lossIndices_.insert(std::make_pair(lossFunc.get(), lossFuncs_.size()));
+    if (it.second) {
+      lossFuncs_.push_back(lossFunc);
+    }
+    return it.first->second;
+  }
+
+  const std::vector<StateVariableBase::Ptr>& states() const { return states_; }
+  const std::vector<BaseNoiseModel<4>::ConstPtr>& noiseModels() const { return noiseModels_; }
+  const std::vector<LossFunctionBase::ConstPtr>& lossFuncs() const { return lossFuncs_; }
+
+ private:
+  std::vector<StateVariableBase::Ptr> states_;
+  boost::unordered_map<StateID, boost::uint32_t> stateIndices_;
+  std::vector<BaseNoiseModel<4>::ConstPtr> noiseModels_;
+  std::map<const void*, boost::uint32_t> noiseIndices_;
+  std::vector<LossFunctionBase::ConstPtr> lossFuncs_;
+  std::map<const void*, boost::uint32_t> lossIndices_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the archive type of a state
+//////////////////////////////////////////////////////////////////////////////////////////////
+static ArchiveStateType getStateType(const StateVariableBase::Ptr& state) {
+  if (dynamic_cast<const se3::TransformStateVar*>(state.get())) {
+    return TRANSFORM_STATE;
+  } else if (dynamic_cast<const se3::LandmarkStateVar*>(state.get())) {
+    return LANDMARK_STATE;
+  } else if (dynamic_cast<const VectorSpaceStateVar*>(state.get())) {
+    return VECTOR_SPACE_STATE;
+  }
+  throw std::invalid_argument("[writeProblemArchive] unsupported state variable type.");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the archive record of a noise model (and the block size of block-diagonal models)
+//////////////////////////////////////////////////////////////////////////////////////////////
+static NoiseRecord getNoiseRecord(const BaseNoiseModel<4>::ConstPtr& noiseModel,
+                                  NoiseBlockRecord* blockRecord) {
+  NoiseRecord record = {0, 4};
+  blockRecord->blockDim = 0;
+  blockRecord->reserved = 0;
+  const BaseNoiseModel<4>* model = noiseModel.get();
+  if (dynamic_cast<const StaticNoiseModel<4>*>(model)) {
+    record.type = STATIC_NOISE;
+  } else if (dynamic_cast<const DiagonalNoiseModel<4>*>(model)) {
+    record.type = DIAGONAL_NOISE;
+  } else if (dynamic_cast<const IsotropicNoiseModel<4>*>(model)) {
+    record.type = ISOTROPIC_NOISE;
+  } else if (dynamic_cast<const BlockDiagonalNoiseModel<4,1>*>(model)) {
+    record.type = BLOCK_DIAGONAL_NOISE; blockRecord->blockDim = 1;
+  } else if (dynamic_cast<const BlockDiagonalNoiseModel<4,2>*>(model)) {
+    record.type = BLOCK_DIAGONAL_NOISE; blockRecord->blockDim = 2;
+  } else if (dynamic_cast<const BlockDiagonalNoiseModel<4,4>*>(model)) {
+    record.type = BLOCK_DIAGONAL_NOISE; blockRecord->blockDim = 4;
+  } else if (dynamic_cast<const DynamicNoiseModel<4>*>(model)) {
+    throw std::invalid_argument("[writeProblemArchive] dynamic noise models cannot be archived.");
+  } else {
+    throw std::invalid_argument("[writeProblemArchive] unsupported noise model type.");
+  }
+  return record;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build a block-diagonal noise model from its (upper-triangular) sqrt information
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <int BLOCK_DIM>
+static BaseNoiseModel<4>::ConstPtr makeBlockDiagonalNoise(const Eigen::Matrix4d& sqrtInformation) {
+  typename BlockDiagonalNoiseModel<4,BLOCK_DIM>::BlockVectorType blocks;
+  for (unsigned int i = 0; i < 4/BLOCK_DIM; i++) {
+    blocks.push_back(sqrtInformation.block<BLOCK_DIM,BLOCK_DIM>(i*BLOCK_DIM, i*BLOCK_DIM));
+  }
+  return BaseNoiseModel<4>::ConstPtr(
+      new BlockDiagonalNoiseModel<4,BLOCK_DIM>(blocks, SQRT_INFORMATION));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the archive record of a loss function
+//////////////////////////////////////////////////////////////////////////////////////////////
+static LossRecord getLossRecord(const LossFunctionBase::ConstPtr& lossFunc) {
+  LossRecord record = {0, 0, 0.0};
+  if (dynamic_cast<const L2LossFunc*>(lossFunc.get())) {
+    record.type = L2_LOSS;
+  } else if (const HuberLossFunc* huber = dynamic_cast<const HuberLossFunc*>(lossFunc.get())) {
+    record.type = HUBER_LOSS; record.k = huber->getK();
+  } else if (const CauchyLossFunc* cauchy = dynamic_cast<const CauchyLossFunc*>(lossFunc.get())) {
+    record.type = CAUCHY_LOSS; record.k = cauchy->getK();
+  } else if (const GemanMcClureLossFunc* gm =
+             dynamic_cast<const GemanMcClureLossFunc*>(lossFunc.get())) {
+    record.type = GEMAN_MCCLURE_LOSS; record.k = gm->getK();
+  } else if (const DcsLossFunc* dcs = dynamic_cast<const DcsLossFunc*>(lossFunc.get())) {
+    record.type = DCS_LOSS; record.k = dcs->getK();
+  } else {
+    throw std::invalid_argument("[writeProblemArchive] unsupported loss function type.");
+  }
+  return record;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a problem archive
+//////////////////////////////////////////////////////////////////////////////////////////////
+void writeProblemArchive(const std::string& file, const ProblemArchive& archive) {
+
+  // Index the states, noise models and loss functions (listed states keep their order)
+  ArchiveIndex index;
+  for (unsigned int i = 0; i < archive.states.size(); i++) {
+    index.stateIndex(archive.states[i]);
+  }
+  std::vector<KnotRecord> knots(archive.knots.size());
+  for (unsigned int i = 0; i < archive.knots.size(); i++) {
+    se3::TransformStateEvaluator::ConstPtr pose =
+        boost::dynamic_pointer_cast<const se3::TransformStateEvaluator>(archive.knots[i]->getPose());
+    if (!pose) {
+      throw std::invalid_argument("[writeProblemArchive] knot poses must be state evaluators.");
+    }
+    knots[i].nanosecs = archive.knots[i]->getTime().nanosecs();
+    knots[i].pose = index.stateIndex(pose->getStateVariable());
+    knots[i].velocity = index.stateIndex(archive.knots[i]->getVelocity());
+  }
+  std::vector<StereoRecord> stereo(archive.stereoCostTerms.size());
+  std::vector<std::vector<boost::uint32_t> > stereoPoses(stereo.size());
+  std::vector<std::vector<boost::uint32_t> > stereoLandmarks(stereo.size());
+  for (unsigned int i = 0; i < archive.stereoCostTerms.size(); i++) {
+    const StereoCostTermCollection& collection = *archive.stereoCostTerms[i];
+    StereoRecord& record = stereo[i];
+    memset(&record, 0, sizeof(record));
+    record.noise = index.noiseIndex(collection.getNoiseModel());
+    record.loss = index.lossIndex(collection.getLossFunc());
+    record.numThreads = collection.getNumThreads();
+    record.numPoses = collection.getPoses().size();
+    record.numLandmarks = collection.getLandmarks().size();
+    const stereo::CameraIntrinsics& intrinsics = collection.getIntrinsics();
+    record.intrinsics[0] = intrinsics.b;  record.intrinsics[1] = intrinsics.fu;
+    record.intrinsics[2] = intrinsics.fv; record.intrinsics[3] = intrinsics.cu;
+    record.intrinsics[4] = intrinsics.cv;
+    Eigen::Map<Eigen::Matrix4d> T_cam_vehicle(record.T_cam_vehicle);
+    T_cam_vehicle = collection.getCamVehicleTransform().matrix();
+    for (unsigned int j = 0; j < collection.getPoses().size(); j++) {
+      stereoPoses[i].push_back(index.stateIndex(collection.getPoses()[j]));
+    }
+    for (unsigned int j = 0; j < collection.getLandmarks().size(); j++) {
+      stereoLandmarks[i].push_back(index.stateIndex(collection.getLandmarks()[j]));
+    }
+  }
+
+  // Records of the states, noise models and loss functions (unsupported types throw before
+  // the file is created)
+  const std::vector<StateVariableBase::Ptr>& states = index.states();
+  std::vector<StateRecord> stateRecords(states.size());
+  std::vector<double> rawValues;
+  for (unsigned int i = 0; i < states.size(); i++) {
+    StateRecord& record = stateRecords[i];
+    record.type = getStateType(states[i]);
+    record.locked = states[i]->isLocked();
+    record.rawSize = states[i]->getRawValueSize();
+    record.reserved = 0;
+    rawValues.resize(rawValues.size() + record.rawSize);
+    states[i]->writeRawValue(&rawValues[rawValues.size() - record.rawSize]);
+  }
+  const std::vector<BaseNoiseModel<4>::ConstPtr>& noiseModels = index.noiseModels();
+  std::vector<NoiseRecord> noiseRecords(noiseModels.size());
+  std::vector<NoiseBlockRecord> noiseBlockRecords(noiseModels.size());
+  for (unsigned int i = 0; i < noiseModels.size(); i++) {
+    noiseRecords[i] = getNoiseRecord(noiseModels[i], &noiseBlockRecords[i]);
+  }
+  const std::vector<LossFunctionBase::ConstPtr>& lossFuncs = index.lossFuncs();
+  std::vector<LossRecord> lossRecords(lossFuncs.size());
+  for (unsigned int i = 0; i < lossFuncs.size(); i++) {
+    lossRecords[i] = getLossRecord(lossFuncs[i]);
+  }
+
+  // Header
+  ArchiveWriter writer(file);
+  FileHeader header;
+  memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+  header.version = PROBLEM_ARCHIVE_VERSION;
+  header.byteOrder = ARCHIVE_BYTE_ORDER;
+  writer.write(&header, sizeof(header));
+
+  // States
+  writer.beginSection(STATE_SECTION, states.size());
+  writer.writeArray(stateRecords);
+  writer.writeArray(rawValues);
+  writer.endSection();
+
+  // Trajectory knots
+  writer.beginSection(KNOT_SECTION, knots.size());
+  writer.writeArray(knots);
+  writer.endSection();
+
+  // Noise models (full sqrt information)
+  writer.beginSection(NOISE_SECTION, noiseModels.size());
+  for (unsigned int i = 0; i < noiseModels.size(); i++) {
+    Eigen::Matrix4d sqrtInformation = noiseModels[i]->getSqrtInformation();
+    writer.write(&noiseRecords[i], sizeof(NoiseRecord));
+    if (noiseRecords[i].type == BLOCK_DIAGONAL_NOISE) {
+      writer.write(&noiseBlockRecords[i], sizeof(NoiseBlockRecord));
+    }
+    writer.write(sqrtInformation.data(), sizeof(double)*16);
+  }
+  writer.endSection();
+
+  // Loss functions
+  writer.beginSection(LOSS_SECTION, lossFuncs.size());
+  writer.writeArray(lossRecords);
+  writer.endSection();
+
+  // Stereo cost terms
+  for (unsigned int i = 0; i < archive.stereoCostTerms.size(); i++) {
+    const StereoCostTermCollection& collection = *archive.stereoCostTerms[i];
+    writer.beginSection(STEREO_SECTION, collection.numCostTerms());
+    writer.write(&stereo[i], sizeof(StereoRecord));
+    writer.writeArray(stereoPoses[i]);
+    writer.writeArray(stereoLandmarks[i]);
+    for (unsigned int k = 0; k < 4; k++) {
+      writer.writeArray(collection.getMeasurements(k));
+    }
+    writer.writeArray(collection.getPoseIndices());
+    writer.writeArray(collection.getLandmarkIndices());
+    writer.endSection();
+  }
+
+  writer.close();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get a state of a specific type, by archive index
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename StateType>
+static typename StateType::Ptr getState(const std::vector<StateVariableBase::Ptr>& states,
+                                        boost::uint32_t index) {
+  typename StateType::Ptr state;
+  if (index < states.size()) {
+    state = boost::dynamic_pointer_cast<StateType>(states[index]);
+  }
+  if (!state) {
+    throw std::runtime_error("problem archive references an invalid state");
+  }
+  return state;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Read a problem archive
+//////////////////////////////////////////////////////////////////////////////////////////////
+ProblemArchive readProblemArchive(const std::string& file) {
+
+  // Map the archive and check the header
+  steam::parse::MappedFile mapped(file);
+  ArchiveReader reader(mapped.data(), mapped.data() + mapped.size());
+  FileHeader header = reader.read<FileHeader>();
+  if (memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) {
+    throw std::runtime_error("file is not a problem archive");
+  } else if (header.byteOrder != ARCHIVE_BYTE_ORDER) {
+    throw std::runtime_error("problem archive was written with a different byte order");
+  } else if (header.version > PROBLEM_ARCHIVE_VERSION) {
+    std::stringstream ss; ss << "problem archive version " << header.version
+                             << " is newer than the supported version " << PROBLEM_ARCHIVE_VERSION;
+    throw std::runtime_error(ss.str());
+  }
+
+  ProblemArchive result;
+  std::vector<BaseNoiseModel<4>::ConstPtr> noiseModels;
+  std::vector<LossFunctionBase::ConstPtr> lossFuncs;
+  while (!reader.atEnd()) {
+
+    // Read section header, the payload is parsed with its own reader
+    SectionHeader section = reader.read<SectionHeader>();
+    if (section.bytes > reader.remaining()) {
+      throw std::runtime_error("problem archive is truncated");
+    }
+    const char* body = reader.take(section.bytes);
+    ArchiveReader payload(body, body + section.bytes);
+
+    if (section.type == STATE_SECTION) {
+      const StateRecord* records = payload.takeArray<StateRecord>(section.count);
+      size_t numRaw = 0;
+      for (unsigned int i = 0; i < section.count; i++) {
+        numRaw += records[i].rawSize;
+      }
+      const double* raw = payload.takeArray<double>(numRaw);
+      for (unsigned int i = 0; i < section.count; i++) {
+        const StateRecord& record = records[i];
+        StateVariableBase::Ptr state;
+        if (record.type == TRANSFORM_STATE && record.rawSize == 16) {
+          state.reset(new se3::TransformStateVar());
+        } else if (record.type == LANDMARK_STATE && record.rawSize == 4) {
+          state.reset(new se3::LandmarkStateVar(Eigen::Vector3d::Zero()));
+        } else if (record.type == VECTOR_SPACE_STATE) {
+          state.reset(new VectorSpaceStateVar(Eigen::VectorXd::Zero(record.rawSize)));
+        } else {
+          throw std::runtime_error("problem archive contains an unsupported state");
+        }
+        state->readRawValue(raw);
+        state->setLock(record.locked != 0);
+        raw += record.rawSize;
+        result.states.push_back(state);
+      }
+    } else if (section.type == KNOT_SECTION) {
+      const KnotRecord* records = payload.takeArray<KnotRecord>(section.count);
+      for (unsigned int i = 0; i < section.count; i++) {
+        se3::TransformStateVar::Ptr pose =
+            getState<se3::TransformStateVar>(result.states, records[i].pose);
+        VectorSpaceStateVar::Ptr velocity =
+            getState<VectorSpaceStateVar>(result.states, records[i].velocity);
+        result.knots.push_back(se3::SteamTrajVar::Ptr(new se3::SteamTrajVar(
+            steam::Time(records[i].nanosecs), se3::TransformStateEvaluator::MakeShared(pose),
+            velocity)));
+      }
+    } else if (section.type == NOISE_SECTION) {
+      for (unsigned int i = 0; i < section.count; i++) {
+        NoiseRecord record = payload.read<NoiseRecord>();
+        if (record.dim != 4) {
+          throw std::runtime_error("problem archive contains an unsupported noise model");
+        }
+        unsigned int blockDim = 0;
+        if (record.type == BLOCK_DIAGONAL_NOISE) {
+          blockDim = payload.read<NoiseBlockRecord>().blockDim;
+        }
+        Eigen::Map<const Eigen::Matrix4d> sqrtInformation(payload.takeArray<double>(16));
+        if (record.type == BLOCK_DIAGONAL_NOISE) {
+          if (blockDim == 1) {
+            noiseModels.push_back(makeBlockDiagonalNoise<1>(sqrtInformation));
+          } else if (blockDim == 2) {
+            noiseModels.push_back(makeBlockDiagonalNoise<2>(sqrtInformation));
+          } else if (blockDim == 4) {
+            noiseModels.push_back(makeBlockDiagonalNoise<4>(sqrtInformation));
+          } else {
+            throw std::runtime_error("problem archive contains an unsupported noise model");
+          }
+        } else if (record.type == DIAGONAL_NOISE) {
+          noiseModels.push_back(BaseNoiseModel<4>::ConstPtr(new DiagonalNoiseModel<4>(
+              sqrtInformation.diagonal(), SQRT_INFORMATION)));
+        } else if (record.type == ISOTROPIC_NOISE) {
+          noiseModels.push_back(BaseNoiseModel<4>::ConstPtr(new IsotropicNoiseModel<4>(
+              sqrtInformation(0,0), SQRT_INFORMATION)));
+        } else if (record.type == STATIC_NOISE) {
+          noiseModels.push_back(BaseNoiseModel<4>::ConstPtr(new StaticNoiseModel<4>(
+              Eigen::Matrix4d(sqrtInformation), SQRT_INFORMATION)));
+        } else {
+          throw std::runtime_error("problem archive contains an unsupported noise model");
+        }
+      }
+    } else if (section.type == LOSS_SECTION) {
+      const LossRecord* records = payload.takeArray<LossRecord>(section.count);
+      for (unsigned int i = 0; i < section.count; i++) {
+        const double k = records[i].k;
+        LossFunctionBase::ConstPtr lossFunc;
+        if (records[i].type == L2_LOSS) {
+          lossFunc.reset(new L2LossFunc());
+        } else if (records[i].type == HUBER_LOSS) {
+          lossFunc.reset(new HuberLossFunc(k));
+        } else if (records[i].type == CAUCHY_LOSS) {
+          lossFunc.reset(new CauchyLossFunc(k));
+        } else if (records[i].type == GEMAN_MCCLURE_LOSS) {
+          lossFunc.reset(new GemanMcClureLossFunc(k));
+        } else if (records[i].type == DCS_LOSS) {
+          lossFunc.reset(new DcsLossFunc(k));
+        } else {
+          throw std::runtime_error("problem archive contains an unsupported loss function");
+        }
+        lossFuncs.push_back(lossFunc);
+      }
+    } else if (section.type == STEREO_SECTION) {
+      StereoRecord record = payload.read<StereoRecord>();
+      if (record.noise >= noiseModels.size() || record.loss >= lossFuncs.size()) {
+        throw std::runtime_error("problem archive references an invalid noise model or loss");
+      }
+      stereo::CameraIntrinsics intrinsics;
+      intrinsics.b  = record.intrinsics[0]; intrinsics.fu = record.intrinsics[1];
+      intrinsics.fv = record.intrinsics[2]; intrinsics.cu = record.intrinsics[3];
+      intrinsics.cv = record.intrinsics[4];
+      Eigen::Map<const Eigen::Matrix4d> T_cam_vehicle(record.T_cam_vehicle);
+      StereoCostTermCollection::Ptr collection(new StereoCostTermCollection(
+          intrinsics, lgmath::se3::Transformation(Eigen::Matrix4d(T_cam_vehicle)),
+          noiseModels[record.noise], lossFuncs[record.loss], record.numThreads));
+
+      const boost::uint32_t* poses = payload.takeArray<boost::uint32_t>(record.numPoses);
+      for (unsigned int i = 0; i < record.numPoses; i++) {
+        collection->addPose(getState<se3::TransformStateVar>(result.states, poses[i]));
+      }
+      const boost::uint32_t* landmarks = payload.takeArray<boost::uint32_t>(record.numLandmarks);
+      for (unsigned int i = 0; i < record.numLandmarks; i++) {
+        collection->addLandmark(getState<se3::LandmarkStateVar>(result.states, landmarks[i]));
+      }
+
+      // Bulk copy of the measurements (straight from the mapped archive)
+      const double* measurements[4];
+      for (unsigned int k = 0; k < 4; k++) {
+        measurements[k] = payload.takeArray<double>(section.count);
+      }
+      const boost::uint32_t* poseIndices = payload.takeArray<boost::uint32_t>(section.count);
+      const boost::uint32_t* landmarkIndices = payload.takeArray<boost::uint32_t>(section.count);
+      try {
+        collection->reserve(section.count);
+        collection->add(section.count, measurements, poseIndices, landmarkIndices);
+      } catch (const std::invalid_argument&) {
+        throw std::runtime_error("problem archive references an invalid pose or landmark");
+      }
+      result.stereoCostTerms.push_back(collection);
+    }
+    // else: unknown section (from a newer writer), skipped
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add the unlocked states and the cost terms to an optimization problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+void ProblemArchive::addToProblem(OptimizationProblem* problem) const {
+  for (unsigned int i = 0; i < states.size(); i++) {
+    if (!states[i]->isLocked()) {
+      problem->addStateVariable(states[i]);
+    }
+  }
+  for (unsigned int i = 0; i < stereoCostTerms.size(); i++) {
+    problem->addCostTerm(stereoCostTerms[i]);
+  }
+}
+
+} // data
+} // steam
@@ -0,0 +1,303 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file SyntheticProblems.cpp
+/// \brief Deterministic generators of synthetic problems of arbitrary size (pose graphs,
+///        stereo bundle adjustment and continuous-time trajectories), for scaling studies
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/data/SyntheticProblems.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace steam {
+namespace data {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Seeded random numbers. The engine (std::mt19937) is fully specified by the
+///        standard, and the distributions are implemented here (the std:: distributions are
+///        implementation defined), so a seed gives the same problem on every platform.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class SyntheticRandom
+{
+ public:
+  explicit SyntheticRandom(unsigned int seed) : engine_(seed), hasSpare_(false), spare_(0.0) {}
+
+  /// \brief Uniform in [0,1), with 53 random bits
+  double uniform() {
+    const double a = double(engine_() >> 5);
+    const double b = double(engine_() >> 6);
+    return (a*67108864.0 + b)*(1.0/9007199254740992.0);
+  }
+
+  /// \brief Uniform integer in [0,n)
+  unsigned int uniformInt(unsigned int n) {
+    return std::min(n - 1, (unsigned int)(this->uniform()*n));
+  }
+
+  /// \brief Standard normal (Box-Muller)
+  double normal() {
+    if (hasSpare_) {
+      hasSpare_ = false;
+      return spare_;
+    }
+    const double radius = std::sqrt(-2.0*std::log(1.0 - this->uniform()));
+    const double angle = 2.0*M_PI*this->uniform();
+    spare_ = radius*std::sin(angle);
+    hasSpare_ = true;
+    return radius*std::cos(angle);
+  }
+
+ private:
+  std::mt19937 engine_;
+  bool hasSpare_;
+  double spare_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Transformation T_k0 of a frame at position r (in frame 0) with heading yaw
+//////////////////////////////////////////////////////////////////////////////////////////////
+static lgmath::se3::Transformation planarPose(const Eigen::Vector3d& r, double yaw) {
+  Eigen::Matrix3d C_0k;
+  C_0k << std::cos(yaw), -std::sin(yaw), 0.0,
+          std::sin(yaw),  std::cos(yaw), 0.0,
+          0.0, 0.0, 1.0;
+  Eigen::Matrix4d T_k0 = Eigen::Matrix4d::Identity();
+  T_k0.topLeftCorner<3,3>() = C_0k.transpose();
+  T_k0.topRightCorner<3,1>() = -C_0k.transpose()*r;
+  return lgmath::se3::Transformation(T_k0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Perturb a transformation (on the left) by a random se(3) vector
+//////////////////////////////////////////////////////////////////////////////////////////////
+static lgmath::se3::Transformation perturb(const lgmath::se3::Transformation& T,
+                                           double sigmaTranslation, double sigmaRotation,
+                                           SyntheticRandom* random) {
+  Eigen::Matrix<double,6,1> xi;
+  for (unsigned int i = 0; i < 3; i++) {
+    xi[i] = sigmaTranslation*random->normal();
+  }
+  for (unsigned int i = 3; i < 6; i++) {
+    xi[i] = sigmaRotation*random->normal();
+  }
+  return lgmath::se3::Transformation(xi)*T;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Generate a synthetic 3D pose graph
+//////////////////////////////////////////////////////////////////////////////////////////////
+G2oSe3Dataset generatePoseGraph(const PoseGraphParams& params) {
+
+  if (params.posesPerLap < 3) {
+    throw std::invalid_argument("a pose graph needs at least 3 poses per lap.");
+  }
+  SyntheticRandom random(params.seed);
+
+  // Ground-truth poses, on a helix
+  const unsigned int numPoses = params.numPoses;
+  const double radius = params.posesPerLap*params.stepLength/(2.0*M_PI);
+  std::vector<lgmath::se3::Transformation> poses_gt(numPoses);
+  for (unsigned int k = 0; k < numPoses; k++) {
+    const double theta = 2.0*M_PI*k/params.posesPerLap;
+    const Eigen::Vector3d r(radius*std::cos(theta), radius*std::sin(theta),
+                            params.lapRise*k/params.posesPerLap);
+    poses_gt[k] = planarPose(r, theta + 0.5*M_PI);
+  }
+
+  // Noise model (unit information if noise-free)
+  G2oSe3Dataset result;
+  Eigen::Matrix<double,6,1> sqrtInformation;
+  sqrtInformation.head<3>().setConstant(
+      params.sigmaTranslation > 0.0 ? 1.0/params.sigmaTranslation : 1.0);
+  sqrtInformation.tail<3>().setConstant(
+      params.sigmaRotation > 0.0 ? 1.0/params.sigmaRotation : 1.0);
+  G2oSe3Dataset::Edge edge;
+  edge.sqrtInformation = sqrtInformation.asDiagonal();
+
+  // Odometry edges and loop closures (to a pose near the same place, on a previous lap)
+  for (unsigned int k = 1; k < numPoses; k++) {
+    edge.idA = k - 1;
+    edge.idB = k;
+    edge.T_BA = perturb(poses_gt[k]/poses_gt[k-1], params.sigmaTranslation,
+                        params.sigmaRotation, &random);
+    result.edges.push_back(edge);
+
+    if (k < params.posesPerLap) {
+      continue;
+    }
+    const unsigned int wholeClosures = (unsigned int)params.loopClosureDensity;
+    const unsigned int numClosures = wholeClosures +
+        (random.uniform() < params.loopClosureDensity - wholeClosures ? 1 : 0);
+    for (unsigned int c = 0; c < numClosures; c++) {
+      const unsigned int lapsBack = 1 + random.uniformInt(k/params.posesPerLap);
+      const int offset = int(random.uniformInt(5)) - 2;
+      const int j = std::max(0, int(k) - int(lapsBack*params.posesPerLap) + offset);
+      if (j + 1 >= int(k)) {
+        continue;
+      }
+      edge.idA = j;
+      edge.idB = k;
+      edge.T_BA = perturb(poses_gt[k]/poses_gt[j], params.sigmaTranslation,
+                          params.sigmaRotation, &random);
+      result.edges.push_back(edge);
+    }
+  }
+
+  // Initial condition, from dead reckoning of the odometry (edges k-1 -> k are in order)
+  G2oSe3Dataset::Vertex vertex;
+  for (unsigned int k = 0, e = 0; k < numPoses; k++) {
+    vertex.id = k;
+    if (k == 0) {
+      vertex.T_k0 = poses_gt[0];
+    } else {
+      while (result.edges[e].idB != k || result.edges[e].idA != k - 1) {
+        e++;
+      }
+      vertex.T_k0 = result.edges[e].T_BA*vertex.T_k0;
+    }
+    result.vertices.push_back(vertex);
+  }
+  result.fixed.push_back(0);
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Ground-truth vehicle pose T_k0 of the stereo problems, at time t
+//////////////////////////////////////////////////////////////////////////////////////////////
+static lgmath::se3::Transformation vehiclePose(double t, double speed) {
+  const Eigen::Vector3d r(speed*t, 2.0*std::sin(0.2*t), 0.0);
+  return planarPose(r, std::atan2(0.4*std::cos(0.2*t), speed));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Make a frame whose pose round-trips exactly through the dataset text format
+//////////////////////////////////////////////////////////////////////////////////////////////
+static SimpleBaDataset::Frame makeFrame(unsigned int frameID, double time,
+                                        const lgmath::se3::Transformation& T_k0) {
+  SimpleBaDataset::Frame frame;
+  frame.frameID = frameID;
+  frame.time = time;
+  frame.pose_vec_k0 = T_k0.vec();
+  frame.T_k0 = lgmath::se3::Transformation(frame.pose_vec_k0);
+  return frame;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Order measurements by time
+//////////////////////////////////////////////////////////////////////////////////////////////
+static bool earlierMeas(const SimpleBaDataset::StereoMeas& a,
+                        const SimpleBaDataset::StereoMeas& b) {
+  return a.time < b.time;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Generate a synthetic stereo bundle adjustment (or continuous-time trajectory)
+///        problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimpleBaDataset generateStereoBa(const StereoBaParams& params) {
+
+  if (params.numFrames < 1 || params.framePeriod <= 0.0) {
+    throw std::invalid_argument("a stereo problem needs frames with a positive period.");
+  }
+  SyntheticRandom random(params.seed);
+  SimpleBaDataset result;
+
+  // Calibration: forward-looking camera (z forward, x right, y down) on the vehicle
+  // (x forward, y left, z up)
+  result.camParams.b = 0.24;
+  result.camParams.fu = 480.0;
+  result.camParams.fv = 480.0;
+  result.camParams.cu = 320.0;
+  result.camParams.cv = 240.0;
+  Eigen::Matrix4d T_cv = Eigen::Matrix4d::Identity();
+  T_cv.topLeftCorner<3,3>() << 0.0, -1.0, 0.0,
+                               0.0, 0.0, -1.0,
+                               1.0, 0.0, 0.0;
+  result.T_cv = lgmath::se3::Transformation(T_cv);
+  const double variance = params.pixelNoise > 0.0 ? params.pixelNoise*params.pixelNoise : 1.0;
+  result.noise = variance*Eigen::Matrix4d::Identity();
+
+  // Ground-truth and initial-condition frames (the first is exact)
+  for (unsigned int k = 0; k < params.numFrames; k++) {
+    const double time = k*params.framePeriod;
+    const lgmath::se3::Transformation T_k0 = vehiclePose(time, params.speed);
+    result.frames_gt.push_back(makeFrame(k, time, T_k0));
+    result.frames_ic.push_back(makeFrame(k, time, k == 0 ? T_k0 :
+        perturb(T_k0, params.sigmaTranslation, params.sigmaRotation, &random)));
+  }
+
+  // Landmarks and their tracks
+  const unsigned int trackLength = std::max(1u, std::min(params.trackLength, params.numFrames));
+  for (unsigned int l = 0; l < params.numLandmarks; l++) {
+
+    // Tracks are spread evenly over the frames
+    const unsigned int firstFrame = params.numLandmarks > 1 ?
+        (unsigned int)((unsigned long long)l*(params.numFrames - trackLength)/
+                       (params.numLandmarks - 1)) : 0;
+    const unsigned int lastFrame = firstFrame + trackLength - 1;
+
+    // Place the landmark in view of the last frame of its track (so it is ahead of the
+    // camera for the whole track)
+    const double depth = 3.0 + 17.0*random.uniform();
+    Eigen::Vector4d p_c(depth*(random.uniform() - 0.5), depth*0.7*(random.uniform() - 0.5),
+                        depth, 1.0);
+    const lgmath::se3::Transformation T_c0 = result.T_cv*vehiclePose(
+        lastFrame*params.framePeriod, params.speed);
+    const Eigen::Vector4d p_0 = T_c0.inverse()*p_c;
+    SimpleBaDataset::Landmark landmark;
+    landmark.landID = l;
+    landmark.point = p_0.head<3>();
+    result.land_gt.push_back(landmark);
+    for (unsigned int j = 0; j < 3; j++) {
+      landmark.point[j] += params.sigmaLandmark*random.normal();
+    }
+    result.land_ic.push_back(landmark);
+
+    // Measurements, at the frame times or at random times between frames
+    for (unsigned int k = firstFrame; k <= lastFrame; k++) {
+      const unsigned int numTimes = (params.measTimesPerFrame == 0 || k + 1 == params.numFrames) ?
+          1 : params.measTimesPerFrame;
+      for (unsigned int i = 0; i < numTimes; i++) {
+        SimpleBaDataset::StereoMeas meas;
+        meas.frameID = k;
+        meas.landID = l;
+        meas.time = k*params.framePeriod;
+        if (params.measTimesPerFrame > 0 && k + 1 < params.numFrames) {
+          meas.time += params.framePeriod*random.uniform();
+        }
+
+        // Project the landmark into the stereo camera
+        p_c = result.T_cv*vehiclePose(meas.time, params.speed)*p_0;
+        if (p_c[2] < 0.1) {
+          continue;
+        }
+        meas.data << result.camParams.fu*p_c[0]/p_c[2] + result.camParams.cu,
+                     result.camParams.fv*p_c[1]/p_c[2] + result.camParams.cv,
+                     result.camParams.fu*(p_c[0] - result.camParams.b)/p_c[2] + result.camParams.cu,
+                     result.camParams.fv*p_c[1]/p_c[2] + result.camParams.cv;
+        for (unsigned int j = 0; j < 4; j++) {
+          meas.data[j] += params.pixelNoise*random.normal();
+        }
+
+        // Outliers are random pixels (with a positive disparity)
+        if (params.outlierRatio > 0.0 && random.uniform() < params.outlierRatio) {
+          meas.data[0] = 2.0*result.camParams.cu*random.uniform();
+          meas.data[1] = 2.0*result.camParams.cv*random.uniform();
+          meas.data[2] = meas.data[0] - 1.0 - 63.0*random.uniform();
+          meas.data[3] = meas.data[1];
+        }
+        result.meas.push_back(meas);
+      }
+    }
+  }
+
+  // Time-ordered measurements (in landmark order for equal times)
+  std::stable_sort(result.meas.begin(), result.meas.end(), &earlierMeas);
+  return result;
+}
+
+} // data
+} // steam
@@ -78,13 +78,12 @@ EvalTreeNode<lgmath::se3::Transformation>* ComposeInverseTransformEvaluator::eva
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void ComposeInverseTransformEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void ComposeInverseTransformEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Cast back to transformation
   EvalTreeNode<lgmath::se3::Transformation>* tf_bx_tree =
@@ -94,7 +93,7 @@ void ComposeInverseTransformEvaluator::appendJacobiansImpl(
   if (transform_bx_->isActive()) {
 
     // LHS Jacobian passes through -- identity multiplication
-    transform_bx_->appendBlockAutomaticJacobians(lhs, tf_bx_tree, outJacobians);
+    transform_bx_->appendJacobianRows(lhs, tf_bx_tree, outJacobians);
   }
 
   // Get index of split between left and right-hand-side of Jacobians
@@ -107,57 +106,14 @@ void ComposeInverseTransformEvaluator::appendJacobiansImpl(
         static_cast<EvalTreeNode<lgmath::se3::Transformation>*>(evaluationTree->childAt(1));
 
     lgmath::se3::Transformation tf_ba = tf_bx_tree->getValue()/tf_ax_tree->getValue();
-    Eigen::Matrix<double,LHS_DIM,INNER_DIM> newLhs = (-1)*lhs*tf_ba.adjoint();
-    transform_ax_->appendBlockAutomaticJacobians(newLhs, tf_ax_tree, outJacobians);
+    LhsBlock newLhs = (-1)*lhs*tf_ba.adjoint();
+    transform_ax_->appendJacobianRows(newLhs, tf_ax_tree, outJacobians);
   }
 
   // Merge jacobians
-  Jacobian<LHS_DIM,MAX_STATE_SIZE>::merge(outJacobians, hintIndex);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void ComposeInverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeInverseTransformEvaluator::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,1,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeInverseTransformEvaluator::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,2,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeInverseTransformEvaluator::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,3,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeInverseTransformEvaluator::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,4,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeInverseTransformEvaluator::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,6,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
+  outJacobians->merge(hintIndex);
 }
 
 } // se3
+
 } // steam
@@ -82,13 +82,12 @@ EvalTreeNode<Eigen::Vector4d>* ComposeLandmarkEvaluator::evaluateTree() const {
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void ComposeLandmarkEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void ComposeLandmarkEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Cast back to transform
   EvalTreeNode<lgmath::se3::Transformation>* t1 =
@@ -97,8 +96,8 @@ void ComposeLandmarkEvaluator::appendJacobiansImpl(
   // Check if transform1 is active
   if (transform_->isActive()) {
     const Eigen::Vector4d& homogeneous = evaluationTree->getValue();
-    Eigen::Matrix<double,LHS_DIM,6> newLhs = lhs * lgmath::se3::point2fs(homogeneous.head<3>(), homogeneous[3]);
-    transform_->appendBlockAutomaticJacobians(newLhs, t1, outJacobians);
+    TransformEvaluator::LhsBlock newLhs = lhs * lgmath::se3::point2fs(homogeneous.head<3>(), homogeneous[3]);
+    transform_->appendJacobianRows(newLhs, t1, outJacobians);
   }
 
   // Check if state is locked
@@ -107,49 +106,10 @@ void ComposeLandmarkEvaluator::appendJacobiansImpl(
     // Construct Jacobian
     Eigen::Matrix<double,4,6> landJac;
     landJac.block<4,3>(0,0) = t1->getValue().matrix().block<4,3>(0,0);
-    Eigen::Matrix<double,LHS_DIM,MAX_STATE_SIZE> lhsLandJac = lhs * landJac;
-    outJacobians->push_back(Jacobian<LHS_DIM,MAX_STATE_SIZE>(landmark_->getKey(), lhsLandJac));
+    outJacobians->add(landmark_->getKey(), lhs * landJac);
   }
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void ComposeLandmarkEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                                  EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                                  std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeLandmarkEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,4>& lhs,
-                              EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                              std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeLandmarkEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,4>& lhs,
-                              EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                              std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeLandmarkEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,4>& lhs,
-                              EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                              std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeLandmarkEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,4>& lhs,
-                              EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                              std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeLandmarkEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,4>& lhs,
-                              EvalTreeNode<Eigen::Vector4d>* evaluationTree,
-                              std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
 } // se3
+
 } // steam
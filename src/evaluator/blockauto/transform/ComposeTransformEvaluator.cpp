@@ -74,13 +74,12 @@ EvalTreeNode<lgmath::se3::Transformation>* ComposeTransformEvaluator::evaluateTr
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void ComposeTransformEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void ComposeTransformEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Cast back to transformation
   EvalTreeNode<lgmath::se3::Transformation>* t1 =
@@ -90,7 +89,7 @@ void ComposeTransformEvaluator::appendJacobiansImpl(
   if (transform1_->isActive()) {
 
     // LHS Jacobian passes through -- identity multiplication
-    transform1_->appendBlockAutomaticJacobians(lhs, t1, outJacobians);
+    transform1_->appendJacobianRows(lhs, t1, outJacobians);
   }
 
   // Get index of split between left and right-hand-side of Jacobians
@@ -102,52 +101,14 @@ void ComposeTransformEvaluator::appendJacobiansImpl(
     EvalTreeNode<lgmath::se3::Transformation>* t2 =
         static_cast<EvalTreeNode<lgmath::se3::Transformation>*>(evaluationTree->childAt(1));
 
-    Eigen::Matrix<double,LHS_DIM,INNER_DIM> newLhs = lhs*t1->getValue().adjoint();
-    transform2_->appendBlockAutomaticJacobians(newLhs, t2, outJacobians);
+    LhsBlock newLhs = lhs*t1->getValue().adjoint();
+    transform2_->appendJacobianRows(newLhs, t2, outJacobians);
   }
 
   // Merge jacobians
-  Jacobian<LHS_DIM,MAX_STATE_SIZE>::merge(outJacobians, hintIndex);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void ComposeTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                                  EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                                  std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void ComposeTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
+  outJacobians->merge(hintIndex);
 }
 
 } // se3
+
 } // steam
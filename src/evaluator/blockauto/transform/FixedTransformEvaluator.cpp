@@ -56,56 +56,17 @@ EvalTreeNode<lgmath::se3::Transformation>* FixedTransformEvaluator::evaluateTree
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void FixedTransformEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void FixedTransformEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Do nothing
   return;
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void FixedTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                                              std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void FixedTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void FixedTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void FixedTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void FixedTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void FixedTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
 } // se3
+
 } // steam
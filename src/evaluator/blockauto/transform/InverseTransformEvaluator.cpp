@@ -66,61 +66,22 @@ EvalTreeNode<lgmath::se3::Transformation>* InverseTransformEvaluator::evaluateTr
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void InverseTransformEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void InverseTransformEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Check if transform is active
   if (transform_->isActive()) {
-    Eigen::Matrix<double,LHS_DIM,INNER_DIM> newLhs = (-1)*lhs*evaluationTree->getValue().adjoint();
-    transform_->appendBlockAutomaticJacobians(newLhs,
+    LhsBlock newLhs = (-1)*lhs*evaluationTree->getValue().adjoint();
+    transform_->appendJacobianRows(newLhs,
       static_cast<EvalTreeNode<lgmath::se3::Transformation>*>(evaluationTree->childAt(0)),
       outJacobians);
   }
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void InverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                                  EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                                  std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void InverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void InverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void InverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void InverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void InverseTransformEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
 } // se3
+
 } // steam
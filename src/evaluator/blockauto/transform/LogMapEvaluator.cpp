@@ -67,61 +67,22 @@ EvalTreeNode<Eigen::Matrix<double,6,1> >* LogMapEvaluator::evaluateTree() const
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void LogMapEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void LogMapEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Check if transform is active
   if (transform_->isActive()) {
-    Eigen::Matrix<double,LHS_DIM,INNER_DIM> newLhs = lhs * lgmath::se3::vec2jacinv(evaluationTree->getValue());
-    transform_->appendBlockAutomaticJacobians(newLhs,
+    LhsBlock newLhs = lhs * lgmath::se3::vec2jacinv(evaluationTree->getValue());
+    transform_->appendJacobianRows(newLhs,
       static_cast<EvalTreeNode<lgmath::se3::Transformation>*>(evaluationTree->childAt(0)),
       outJacobians);
   }
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void LogMapEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                                  EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-                                  std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void LogMapEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,6>& lhs,
-                              EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-                              std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void LogMapEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,6>& lhs,
-                              EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-                              std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void LogMapEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,6>& lhs,
-                              EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-                              std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void LogMapEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,6>& lhs,
-                              EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-                              std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void LogMapEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,6>& lhs,
-                              EvalTreeNode<Eigen::Matrix<double,6,1> >* evaluationTree,
-                              std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
 } // se3
+
 } // steam
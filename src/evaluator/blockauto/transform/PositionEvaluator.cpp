@@ -65,13 +65,12 @@ EvalTreeNode<Eigen::Matrix<double, 3, 1> > *PositionEvaluator::evaluateTree() co
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void PositionEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double, LHS_DIM, INNER_DIM> &lhs,
+void PositionEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-    std::vector<Jacobian<LHS_DIM, MAX_STATE_SIZE> > *outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   EvalTreeNode<lgmath::se3::Transformation> *t1 =
       static_cast<EvalTreeNode<lgmath::se3::Transformation> *>(evaluationTree->childAt(0));
@@ -81,48 +80,10 @@ void PositionEvaluator::appendJacobiansImpl(
     auto tf = t1->getValue();
     Eigen::Matrix<double, 3, 6> newLhs;
     newLhs << -tf.C_ba().transpose(), Eigen::Matrix3d::Zero();  //lgmath::so3::hat(tf.r_ab_inb());
-    transform_->appendBlockAutomaticJacobians(lhs * newLhs, t1, outJacobians);
+    transform_->appendJacobianRows(lhs * newLhs, t1, outJacobians);
   }
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void PositionEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd &lhs,
-                                                      EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-                                                      std::vector<Jacobian<> > *outJacobians) const {
-  this->appendJacobiansImpl(lhs, evaluationTree, outJacobians);
-}
-
-void PositionEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double, 1, 3> &lhs,
-                                                      EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-                                                      std::vector<Jacobian<1, 6> > *outJacobians) const {
-  this->appendJacobiansImpl(lhs, evaluationTree, outJacobians);
-}
-
-void PositionEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double, 2, 3> &lhs,
-                                                      EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-                                                      std::vector<Jacobian<2, 6> > *outJacobians) const {
-  this->appendJacobiansImpl(lhs, evaluationTree, outJacobians);
-}
-
-void PositionEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double, 3, 3> &lhs,
-                                                      EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-                                                      std::vector<Jacobian<3, 6> > *outJacobians) const {
-  this->appendJacobiansImpl(lhs, evaluationTree, outJacobians);
-}
-
-void PositionEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double, 4, 3> &lhs,
-                                                      EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-                                                      std::vector<Jacobian<4, 6> > *outJacobians) const {
-  this->appendJacobiansImpl(lhs, evaluationTree, outJacobians);
-}
-
-void PositionEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double, 6, 3> &lhs,
-                                                      EvalTreeNode<Eigen::Matrix<double, 3, 1> > *evaluationTree,
-                                                      std::vector<Jacobian<6, 6> > *outJacobians) const {
-  this->appendJacobiansImpl(lhs, evaluationTree, outJacobians);
-}
-
 } // se3
+
 } // steam
@@ -58,56 +58,24 @@ EvalTreeNode<lgmath::se3::Transformation>* TransformStateEvaluator::evaluateTree
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Get the underlying transformation state variable
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void TransformStateEvaluator::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
-  if (!transform_->isLocked()) {
-    outJacobians->push_back(Jacobian<LHS_DIM,MAX_STATE_SIZE>(transform_->getKey(), lhs));
-  }
+const se3::TransformStateVar::Ptr& TransformStateEvaluator::getStateVariable() const {
+  return transform_;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-void TransformStateEvaluator::appendBlockAutomaticJacobians(const Eigen::MatrixXd& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void TransformStateEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,1,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void TransformStateEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,2,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void TransformStateEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,3,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void TransformStateEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,4,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-void TransformStateEvaluator::appendBlockAutomaticJacobians(const Eigen::Matrix<double,6,6>& lhs,
-                              EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-                              std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
+void TransformStateEvaluator::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
+    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
+    JacobianSink<6>* outJacobians) const {
+  if (!transform_->isLocked()) {
+    outJacobians->add(transform_->getKey(), lhs);
+  }
 }
 
 } // se3
+
 } // steam
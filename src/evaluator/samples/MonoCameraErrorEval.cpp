@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file MonoCameraErrorEval.cpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/evaluator/samples/MonoCameraErrorEval.hpp>
+
+namespace steam {
+
+namespace mono {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Camera model
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Vector2d cameraModel(const CameraIntrinsics& intrinsics, const Eigen::Vector4d& point) {
+
+  // Normalized image coordinates and radial distortion
+  const double one_over_z = 1.0/point[2];
+  const double a = point[0] * one_over_z;
+  const double b = point[1] * one_over_z;
+  const double r2 = a*a + b*b;
+  const double d = 1.0 + r2 * (intrinsics.k1 + intrinsics.k2 * r2);
+
+  // Project point into image coordinates
+  Eigen::Vector2d projectedMeas;
+  projectedMeas << intrinsics.fu * d * a + intrinsics.cu,
+                   intrinsics.fv * d * b + intrinsics.cv;
+  return projectedMeas;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Camera model Jacobian
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Matrix<double,2,4> cameraModelJacobian(const CameraIntrinsics& intrinsics,
+                                              const Eigen::Vector4d& point) {
+  // Precompute values
+  const double one_over_z = 1.0/point[2];
+  const double a = point[0] * one_over_z;
+  const double b = point[1] * one_over_z;
+  const double r2 = a*a + b*b;
+  const double d = 1.0 + r2 * (intrinsics.k1 + intrinsics.k2 * r2);
+  const double two_dd_dr2 = 2.0 * (intrinsics.k1 + 2.0 * intrinsics.k2 * r2);
+
+  // Jacobian of (u v) with respect to the normalized coordinates (a b)
+  const double du_da = intrinsics.fu * (d + a * a * two_dd_dr2);
+  const double du_db = intrinsics.fu * a * b * two_dd_dr2;
+  const double dv_da = intrinsics.fv * a * b * two_dd_dr2;
+  const double dv_db = intrinsics.fv * (d + b * b * two_dd_dr2);
+
+  // Chain with the Jacobian of (a b) with respect to x, y, z, and scalar w
+  Eigen::Matrix<double,2,4> jac;
+  jac << du_da * one_over_z, du_db * one_over_z, -(du_da * a + du_db * b) * one_over_z, 0.0,
+         dv_da * one_over_z, dv_db * one_over_z, -(dv_da * a + dv_db * b) * one_over_z, 0.0;
+  return jac;
+}
+
+} // end namespace mono
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor
+//////////////////////////////////////////////////////////////////////////////////////////////
+MonoCameraErrorEval::MonoCameraErrorEval(const Eigen::Vector2d& meas,
+                                         const mono::CameraIntrinsics::ConstPtr& intrinsics,
+                                         const se3::TransformEvaluator::ConstPtr& T_cam_landmark,
+                                         const se3::LandmarkStateVar::Ptr& landmark)
+  : meas_(meas), intrinsics_(intrinsics), eval_(se3::compose(T_cam_landmark, landmark)) {
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns whether or not an evaluator contains unlocked state variables
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool MonoCameraErrorEval::isActive() const {
+  return eval_->isActive();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate the 2-d measurement error (u v)
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Vector2d MonoCameraErrorEval::evaluate() const {
+
+  // Return error (between measurement and point estimate projected in camera frame)
+  return meas_ - mono::cameraModel(*intrinsics_, eval_->evaluate());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Evaluate the 2-d measurement error (u v) and Jacobians
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Vector2d MonoCameraErrorEval::evaluate(const Eigen::Matrix2d& lhs,
+                                              std::vector<Jacobian<2,6> >* jacs) const {
+
+  // Check and initialize jacobian array
+  if (jacs == NULL) {
+    throw std::invalid_argument("Null pointer provided to return-input 'jacs' in evaluate");
+  }
+  jacs->clear();
+
+  // Get evaluation tree
+  EvalTreeHandle<Eigen::Vector4d> blkAutoEvalPointInCameraFrame =
+      eval_->getBlockAutomaticEvaluation();
+
+  // Get evaluation from tree
+  const Eigen::Vector4d& pointInCamFrame = blkAutoEvalPointInCameraFrame.getValue();
+
+  // Get Jacobians
+  Eigen::Matrix<double,2,4> newLhs =
+      (-1)*lhs*mono::cameraModelJacobian(*intrinsics_, pointInCamFrame);
+  eval_->appendBlockAutomaticJacobians(newLhs, blkAutoEvalPointInCameraFrame.getRoot(), jacs);
+
+  // Return evaluation
+  return meas_ - mono::cameraModel(*intrinsics_, pointInCamFrame);
+}
+
+} // steam
@@ -14,25 +14,122 @@ namespace stereo {
 /// @brief Camera model Jacobian
 //////////////////////////////////////////////////////////////////////////////////////////////
 Eigen::Matrix4d cameraModelJacobian(const CameraIntrinsics::ConstPtr &intrinsics, const Eigen::Vector4d& point) {
+  return cameraModelJacobian(*intrinsics, point);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Camera model Jacobian (intrinsics by reference)
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Matrix4d cameraModelJacobian(const CameraIntrinsics &intrinsics, const Eigen::Vector4d& point) {
   // Precompute values
   const double x = point[0];
   const double y = point[1];
   const double z = point[2];
   const double w = point[3];
-  const double xr = x - w * intrinsics->b;
+  const double xr = x - w * intrinsics.b;
   const double one_over_z = 1.0/z;
   const double one_over_z2 = one_over_z*one_over_z;
 
   // Construct Jacobian with respect to x, y, z, and scalar w
-  const double dw = -intrinsics->fu * intrinsics->b * one_over_z;
+  const double dw = -intrinsics.fu * intrinsics.b * one_over_z;
   Eigen::Matrix4d jac;
-  jac << intrinsics->fu * one_over_z, 0.0, -intrinsics->fu * x  * one_over_z2, 0.0,
-         0.0, intrinsics->fv * one_over_z, -intrinsics->fv * y  * one_over_z2, 0.0,
-         intrinsics->fu * one_over_z, 0.0, -intrinsics->fu * xr * one_over_z2,  dw,
-         0.0, intrinsics->fv * one_over_z, -intrinsics->fv * y  * one_over_z2, 0.0;
+  jac << intrinsics.fu * one_over_z, 0.0, -intrinsics.fu * x  * one_over_z2, 0.0,
+         0.0, intrinsics.fv * one_over_z, -intrinsics.fv * y  * one_over_z2, 0.0,
+         intrinsics.fu * one_over_z, 0.0, -intrinsics.fu * xr * one_over_z2,  dw,
+         0.0, intrinsics.fv * one_over_z, -intrinsics.fv * y  * one_over_z2, 0.0;
   return jac;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Batched camera model
+//////////////////////////////////////////////////////////////////////////////////////////////
+void cameraModelBatch(const CameraIntrinsics& intrinsics,
+                      const Eigen::Ref<const PointBatch>& points,
+                      Eigen::Ref<PointBatch> projections) {
+
+  if (projections.cols() != points.cols()) {
+    throw std::invalid_argument("[cameraModelBatch] the number of projections does not match "
+                                "the number of points.");
+  }
+
+  // Load the intrinsics once
+  const double fu = intrinsics.fu;
+  const double fv = intrinsics.fv;
+  const double cu = intrinsics.cu;
+  const double cv = intrinsics.cv;
+  const double b = intrinsics.b;
+
+  // Structure-of-arrays pointers
+  const double* x = points.row(0).data();
+  const double* y = points.row(1).data();
+  const double* z = points.row(2).data();
+  const double* w = points.row(3).data();
+  double* ul = projections.row(0).data();
+  double* vl = projections.row(1).data();
+  double* ur = projections.row(2).data();
+  double* vr = projections.row(3).data();
+
+  const int n = points.cols();
+  #pragma omp simd
+  for (int i = 0; i < n; i++) {
+    const double one_over_z = 1.0/z[i];
+    const double u = fu * x[i] * one_over_z + cu;
+    const double v = fv * y[i] * one_over_z + cv;
+    ul[i] = u;
+    vl[i] = v;
+    ur[i] = u - fu * w[i] * b * one_over_z;
+    vr[i] = v;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Batched camera model and Jacobians
+//////////////////////////////////////////////////////////////////////////////////////////////
+void cameraModelBatch(const CameraIntrinsics& intrinsics,
+                      const Eigen::Ref<const PointBatch>& points,
+                      Eigen::Ref<PointBatch> projections,
+                      Eigen::Ref<JacobianBatch> jacobians) {
+
+  if (jacobians.cols() != points.cols()) {
+    throw std::invalid_argument("[cameraModelBatch] the number of Jacobians does not match "
+                                "the number of points.");
+  }
+  cameraModelBatch(intrinsics, points, projections);
+
+  // Load the intrinsics once
+  const double fu = intrinsics.fu;
+  const double fv = intrinsics.fv;
+  const double b = intrinsics.b;
+
+  // Structure-of-arrays pointers
+  const double* x = points.row(0).data();
+  const double* y = points.row(1).data();
+  const double* z = points.row(2).data();
+  const double* w = points.row(3).data();
+  double* jac[16];
+  for (unsigned int r = 0; r < 16; r++) {
+    jac[r] = jacobians.row(r).data();
+  }
+
+  // Entries of the column-major Jacobian (see cameraModelJacobian), zero entries included
+  const int n = points.cols();
+  #pragma omp simd
+  for (int i = 0; i < n; i++) {
+    const double one_over_z = 1.0/z[i];
+    const double one_over_z2 = one_over_z*one_over_z;
+    const double fu_z = fu * one_over_z;
+    const double fv_z = fv * one_over_z;
+    const double dz_v = -fv * y[i] * one_over_z2;
+    jac[0][i] = fu_z;  jac[1][i] = 0.0;   jac[2][i] = fu_z;  jac[3][i] = 0.0;
+    jac[4][i] = 0.0;   jac[5][i] = fv_z;  jac[6][i] = 0.0;   jac[7][i] = fv_z;
+    jac[8][i] = -fu * x[i] * one_over_z2;
+    jac[9][i] = dz_v;
+    jac[10][i] = -fu * (x[i] - w[i] * b) * one_over_z2;
+    jac[11][i] = dz_v;
+    jac[12][i] = 0.0;  jac[13][i] = 0.0;  jac[14][i] = -fu * b * one_over_z;  jac[15][i] = 0.0;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief Constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -44,30 +141,81 @@ LandmarkNoiseEvaluator::LandmarkNoiseEvaluator(const Eigen::Vector4d& landmark_m
 intrinsics_(intrinsics),
 meas_noise_(meas_noise),
 mean_(landmark_mean),
-T_query_map_(T_query_map) {
+T_query_map_(T_query_map),
+computed_(false),
+diagnostic_checks_(getDefaultDiagnosticChecks()),
+construction_failures_(0),
+evaluation_failures_(0),
+input_stamp_(0),
+checked_stamp_(0) {
   // compute the dialated phi;
   dialated_phi_.setZero();
   dialated_phi_.block(0,0,3,3) = landmark_cov;
   if(!positiveDefinite<3>(landmark_cov)) {
-    std::cout <<  "\nmigrated cov is bad!!!\n";
+    construction_failures_ |= LANDMARK_COV_NOT_PD;
   }
+
+  // The measurement noise is constant, check it once
+  if(!positiveDefinite<4>(meas_noise_)) {
+    construction_failures_ |= MEAS_NOISE_NOT_PD;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Whether new evaluators run the diagnostic checks
+//////////////////////////////////////////////////////////////////////////////////////////////
+static std::atomic<bool>& defaultDiagnosticChecks() {
+  static std::atomic<bool> enabled(true);
+  return enabled;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Set whether new evaluators run the diagnostic checks
+//////////////////////////////////////////////////////////////////////////////////////////////
+void LandmarkNoiseEvaluator::setDefaultDiagnosticChecks(bool enabled) {
+  defaultDiagnosticChecks().store(enabled, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Get whether new evaluators run the diagnostic checks
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool LandmarkNoiseEvaluator::getDefaultDiagnosticChecks() {
+  return defaultDiagnosticChecks().load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Enable or disable the diagnostic positive-definiteness checks
+//////////////////////////////////////////////////////////////////////////////////////////////
+void LandmarkNoiseEvaluator::setDiagnosticChecks(bool enabled) {
+  diagnostic_checks_ = enabled;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Get the failed diagnostic checks
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int LandmarkNoiseEvaluator::getDiagnosticFailures() const {
+  return construction_failures_ | evaluation_failures_;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief evaluatecovariance
 //////////////////////////////////////////////////////////////////////////////////////////////
 Eigen::Matrix<double,4,4> LandmarkNoiseEvaluator::evaluate() {
-  // TODO: Check to see if we need to recaulculate (add a change flag to steam variables.)
-
-  // Add the measurement noise.
-  last_computed_cov_ = meas_noise_;
 
-  if(!positiveDefinite<4>(meas_noise_)) {
-    std::cout << "measurement noise is bad!!";
-  }
   // evaluate the steam transform evaluator
   const lgmath::se3::Transformation T_l_p = T_query_map_->evaluate();
 
+  // The landmark mean and covariance are constant, so nothing changed if the pose did not
+  if (computed_ && T_l_p.matrix() == last_computed_T_) {
+    return last_computed_cov_;
+  }
+  last_computed_T_ = T_l_p.matrix();
+  computed_ = true;
+  evaluation_failures_ = 0;
+
+  // Add the measurement noise.
+  last_computed_cov_ = meas_noise_;
+
   // Compute the new landmark noise
   Eigen::Matrix<double,4,4> lm_noise_l = T_l_p.matrix() * dialated_phi_ * T_l_p.matrix().transpose();
 
@@ -86,19 +234,46 @@ Eigen::Matrix<double,4,4> LandmarkNoiseEvaluator::evaluate() {
     if(positiveDefinite<3>(lm_noise_3)) {
       last_computed_cov_ += lm_noise;
     } else {
-      std::cout << "\nmigrated noise is not positive definite!!\n";
+      evaluation_failures_ |= PROJECTED_LANDMARK_NOISE_NOT_PD;
     }
     // return the new noise.
   } else {
-    std::cout << "\nlm_noise_l is bad!!\n";
+    evaluation_failures_ |= QUERY_LANDMARK_COV_NOT_PD;
   }
 
   if (!positiveDefinite<4>(last_computed_cov_)) {
-    std::cout << "sum of noise is bad...";
+    evaluation_failures_ |= TOTAL_COV_NOT_PD;
   }
   return last_computed_cov_;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief The covariance only depends on the states of T_query_map (and on constants)
+//////////////////////////////////////////////////////////////////////////////////////////////
+StateStamp LandmarkNoiseEvaluator::getInputStamp() const {
+
+  // Fast path, no state has changed since the last check
+  const StateStamp latest = StampGenerator::getLatestStamp();
+  if (checked_stamp_.load(std::memory_order_acquire) == latest) {
+    return input_stamp_.load(std::memory_order_relaxed);
+  }
+
+  // Some state changed, issue a new stamp only if the transform did. Input stamps are only
+  // compared against earlier stamps of this evaluator, so a local counter suffices (drawing
+  // from the global generator would invalidate the fast path of every other evaluator).
+  std::lock_guard<std::mutex> lock(stamp_mutex_);
+  if (checked_stamp_.load(std::memory_order_relaxed) != latest) {
+    const Eigen::Matrix4d T = T_query_map_->evaluate().matrix();
+    const StateStamp stamp = input_stamp_.load(std::memory_order_relaxed);
+    if (stamp == 0 || T != stamped_T_) {
+      stamped_T_ = T;
+      input_stamp_.store(stamp + 1, std::memory_order_relaxed);
+    }
+    checked_stamp_.store(latest, std::memory_order_release);
+  }
+  return input_stamp_.load(std::memory_order_relaxed);
+}
+
 } // end namespace stereo
 
 //////////////////////////////////////////////////////////////////////////////////////////////
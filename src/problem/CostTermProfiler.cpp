@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file CostTermProfiler.cpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/problem/CostTermProfiler.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <stdexcept>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include <omp.h>
+
+namespace steam {
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Sample of the cost term being linearized on this thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+thread_local CostTermProfiler::Sample* currentSample = NULL;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Readable name of a type
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::string typeName(const std::type_info& type) {
+#ifdef __GNUG__
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+  if (status == 0 && demangled) {
+    std::string name(demangled);
+    free(demangled);
+    return name;
+  }
+#endif
+  return type.name();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Total time of a type, for sorting
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool byTotalTime(const CostTermProfiler::TypeStats& a, const CostTermProfiler::TypeStats& b) {
+  return a.evaluateTime + a.linearizeTime > b.evaluateTime + b.linearizeTime;
+}
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor, times one in every 'sampleInterval' cost terms
+//////////////////////////////////////////////////////////////////////////////////////////////
+CostTermProfiler::CostTermProfiler(unsigned int sampleInterval)
+  : sampleInterval_(sampleInterval), nextOffset_(0) {
+  if (sampleInterval == 0) {
+    throw std::invalid_argument("The sample interval must be positive.");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the sample interval
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int CostTermProfiler::getSampleInterval() const {
+  return sampleInterval_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the statistics of each cost-term type, by decreasing total time
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<CostTermProfiler::TypeStats> CostTermProfiler::getStats() const {
+
+  // Merge the counters of the threads
+  std::vector<Counters> merged;
+  for (unsigned int t = 0; t < threads_.size(); t++) {
+    const std::vector<Counters>& types = threads_[t]->types;
+    for (unsigned int i = 0; i < types.size(); i++) {
+      unsigned int j = 0;
+      while (j < merged.size() && *merged[j].type != *types[i].type) {
+        j++;
+      }
+      if (j == merged.size()) {
+        Counters counters;
+        counters.type = types[i].type;
+        merged.push_back(counters);
+      }
+      merged[j].evaluations += types[i].evaluations;
+      merged[j].linearizations += types[i].linearizations;
+      merged[j].evaluateTime += types[i].evaluateTime;
+      merged[j].linearizeTime += types[i].linearizeTime;
+      merged[j].jacobians += types[i].jacobians;
+      merged[j].hessianBlocks += types[i].hessianBlocks;
+    }
+  }
+
+  // Scale the sampled counters to estimates of the totals
+  std::vector<TypeStats> stats(merged.size());
+  for (unsigned int i = 0; i < merged.size(); i++) {
+    stats[i].name = typeName(*merged[i].type);
+    stats[i].evaluations = sampleInterval_*merged[i].evaluations;
+    stats[i].linearizations = sampleInterval_*merged[i].linearizations;
+    stats[i].evaluateTime = 1000.0*sampleInterval_*merged[i].evaluateTime;
+    stats[i].linearizeTime = 1000.0*sampleInterval_*merged[i].linearizeTime;
+    stats[i].jacobians = sampleInterval_*merged[i].jacobians;
+    stats[i].hessianBlocks = sampleInterval_*merged[i].hessianBlocks;
+  }
+  std::stable_sort(stats.begin(), stats.end(), byTotalTime);
+  return stats;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Print a summary table of the statistics, with the share of the total time
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CostTermProfiler::printSummary(std::ostream& out) const {
+
+  std::vector<TypeStats> stats = this->getStats();
+  double totalTime = 0.0;
+  for (unsigned int i = 0; i < stats.size(); i++) {
+    totalTime += stats[i].evaluateTime + stats[i].linearizeTime;
+  }
+
+  const std::ios_base::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << "Cost-term profile (1 in " << sampleInterval_ << " cost terms sampled)" << std::endl;
+  out << std::right << std::setw(12) << std::setfill(' ') << "evals"
+      << std::right << std::setw(12) << std::setfill(' ') << "eval (ms)"
+      << std::right << std::setw(12) << std::setfill(' ') << "lins"
+      << std::right << std::setw(12) << std::setfill(' ') << "lin (ms)"
+      << std::right << std::setw(12) << std::setfill(' ') << "jacobians"
+      << std::right << std::setw(12) << std::setfill(' ') << "H blocks"
+      << std::right << std::setw(8) << std::setfill(' ') << "share"
+      << "  type" << std::endl;
+  for (unsigned int i = 0; i < stats.size(); i++) {
+    const double share = totalTime > 0.0 ?
+        100.0*(stats[i].evaluateTime + stats[i].linearizeTime)/totalTime : 0.0;
+    out << std::right << std::setw(12) << std::setfill(' ') << stats[i].evaluations
+        << std::right << std::setw(12) << std::setfill(' ') << std::fixed << std::setprecision(3)
+        << stats[i].evaluateTime
+        << std::right << std::setw(12) << std::setfill(' ') << stats[i].linearizations
+        << std::right << std::setw(12) << std::setfill(' ') << stats[i].linearizeTime
+        << std::right << std::setw(12) << std::setfill(' ') << stats[i].jacobians
+        << std::right << std::setw(12) << std::setfill(' ') << stats[i].hessianBlocks
+        << std::right << std::setw(7) << std::setfill(' ') << std::setprecision(1) << share << "%"
+        << "  " << stats[i].name << std::endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Clear the statistics
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CostTermProfiler::reset() {
+  threads_.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Prepare the counters of 'numThreads' threads for a pass over a collection, and
+///        return the index of the first sampled cost term
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int CostTermProfiler::beginPass(unsigned int numThreads) {
+  while (threads_.size() < numThreads) {
+    threads_.push_back(boost::shared_ptr<ThreadCounters>(new ThreadCounters()));
+  }
+
+  // Rotate the sampled subset, so that periodic orderings of the cost terms are not aliased
+  const unsigned int offset = nextOffset_;
+  nextOffset_ = (nextOffset_ + 1) % sampleInterval_;
+  return offset;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Record a sampled cost evaluation on the calling thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CostTermProfiler::recordEvaluate(const std::type_info& type, double seconds) {
+  Counters& counters = this->getCounters(type);
+  counters.evaluations++;
+  counters.evaluateTime += seconds;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Record a sampled linearization on the calling thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CostTermProfiler::recordLinearize(const std::type_info& type, double seconds,
+                                       const Sample& sample) {
+  Counters& counters = this->getCounters(type);
+  counters.linearizations++;
+  counters.linearizeTime += seconds;
+  counters.jacobians += sample.jacobians;
+  counters.hessianBlocks += sample.hessianBlocks;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the sample of the cost term being linearized on the calling thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+CostTermProfiler::Sample* CostTermProfiler::activeSample() {
+  return currentSample;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Set the sample of the cost term being linearized on the calling thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CostTermProfiler::setActiveSample(Sample* sample) {
+  currentSample = sample;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the counters of a type on the calling thread
+//////////////////////////////////////////////////////////////////////////////////////////////
+CostTermProfiler::Counters& CostTermProfiler::getCounters(const std::type_info& type) {
+
+  ThreadCounters& thread = *threads_.at(omp_get_thread_num());
+  std::vector<Counters>& types = thread.types;
+  if (thread.last < types.size() &&
+      (types[thread.last].type == &type || *types[thread.last].type == type)) {
+    return types[thread.last];
+  }
+  for (unsigned int i = 0; i < types.size(); i++) {
+    if (types[i].type == &type || *types[i].type == type) {
+      thread.last = i;
+      return types[i];
+    }
+  }
+  types.push_back(Counters());
+  types.back().type = &type;
+  thread.last = types.size() - 1;
+  return types.back();
+}
+
+} // steam
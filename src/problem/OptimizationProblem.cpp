@@ -6,6 +6,7 @@
 
 #include <steam/problem/OptimizationProblem.hpp>
 
+#include <algorithm>
 #include <iomanip>
 #include <steam/common/Timer.hpp>
 
@@ -14,14 +15,50 @@ namespace steam {
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Default Constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
-OptimizationProblem::OptimizationProblem() {
+OptimizationProblem::OptimizationProblem()
+  : numTrimmedStateChanges_(0), structureRevision_(0) {
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Add an 'active' state variable
 //////////////////////////////////////////////////////////////////////////////////////////////
 void OptimizationProblem::addStateVariable(const StateVariableBase::Ptr& state) {
+
+  if (!stateIndices_.insert(std::make_pair(state->getKey().getID(),
+                                           (unsigned int)stateVariables_.size())).second) {
+    throw std::runtime_error("The state variable has already been added to the problem.");
+  }
   stateVariables_.push_back(state);
+  this->logStateChange(state, true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove a state variable
+//////////////////////////////////////////////////////////////////////////////////////////////
+void OptimizationProblem::removeStateVariable(const StateKey& key) {
+
+  boost::unordered_map<StateID, unsigned int>::iterator it = stateIndices_.find(key.getID());
+  if (it == stateIndices_.end()) {
+    throw std::runtime_error("State variable was not found in call to removeStateVariable()");
+  }
+
+  // Move the last state into the freed position
+  const unsigned int idx = it->second;
+  StateVariableBase::Ptr state = stateVariables_[idx];
+  stateIndices_.erase(it);
+  if (idx != stateVariables_.size() - 1) {
+    stateVariables_[idx] = stateVariables_.back();
+    stateIndices_[stateVariables_[idx]->getKey().getID()] = idx;
+  }
+  stateVariables_.pop_back();
+  this->logStateChange(state, false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Check if a state variable has been added to the problem
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool OptimizationProblem::hasStateVariable(const StateKey& key) const {
+  return stateIndices_.find(key.getID()) != stateIndices_.end();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -36,6 +73,38 @@ void OptimizationProblem::addCostTerm(const CostTermBase::ConstPtr& costTerm) {
     // Add parallelized cost terms to diff collection
     parallelizedCostTerms_.push_back(costTerm);
   }
+  structureRevision_++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove a cost term
+//////////////////////////////////////////////////////////////////////////////////////////////
+void OptimizationProblem::removeCostTerm(const CostTermBase::ConstPtr& costTerm) {
+
+  bool found = false;
+  if (!costTerm->isImplParallelized()) {
+    found = singleCostTerms_.remove(costTerm);
+  } else {
+    // There are typically few parallelized collections, a linear search is fine
+    std::vector<CostTermBase::ConstPtr>::iterator it =
+        std::find(parallelizedCostTerms_.begin(), parallelizedCostTerms_.end(), costTerm);
+    if (it != parallelizedCostTerms_.end()) {
+      parallelizedCostTerms_.erase(it);
+      found = true;
+    }
+  }
+
+  if (!found) {
+    throw std::runtime_error("Cost term was not found in call to removeCostTerm()");
+  }
+  structureRevision_++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Attach a profiler to the single-threaded cost terms (NULL to detach)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void OptimizationProblem::setCostTermProfiler(const CostTermProfiler::Ptr& profiler) {
+  singleCostTerms_.setProfiler(profiler);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -81,15 +150,68 @@ unsigned int OptimizationProblem::getNumberOfCostTerms() const {
   return size;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the structure revision
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int OptimizationProblem::getStructureRevision() const {
+  return structureRevision_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the total number of state changes (additions and removals) made so far
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int OptimizationProblem::getNumberOfStateChanges() const {
+  return numTrimmedStateChanges_ + stateChanges_.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the state changes made after the first 'numChanges' changes, in order
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool OptimizationProblem::getStateChangesSince(unsigned int numChanges,
+                                               std::vector<StateChange>* changes) const {
+
+  if (changes == NULL) {
+    throw std::invalid_argument("Null pointer provided to getStateChangesSince()");
+  }
+
+  // Check that the log still covers the requested changes
+  if (numChanges < numTrimmedStateChanges_ || numChanges > this->getNumberOfStateChanges()) {
+    return false;
+  }
+  changes->assign(stateChanges_.begin() + (numChanges - numTrimmedStateChanges_),
+                  stateChanges_.end());
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Append to the state change log
+//////////////////////////////////////////////////////////////////////////////////////////////
+void OptimizationProblem::logStateChange(const StateVariableBase::Ptr& state, bool added) {
+
+  // Trim the log once it is large relative to the problem, a consumer that falls this far
+  // behind rebuilds from scratch (which costs about as much as replaying the log)
+  if (stateChanges_.size() >= std::max<size_t>(1024, 2*stateVariables_.size())) {
+    numTrimmedStateChanges_ += stateChanges_.size();
+    stateChanges_.clear();
+  }
+
+  StateChange change;
+  change.state = state;
+  change.added = added;
+  stateChanges_.push_back(change);
+  structureRevision_++;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Fill in the supplied block matrices
 //////////////////////////////////////////////////////////////////////////////////////////////
 void OptimizationProblem::buildGaussNewtonTerms(const StateVector& stateVector,
                                                 Eigen::SparseMatrix<double>* approximateHessian,
-                                                Eigen::VectorXd* gradientVector) const {
+                                                Eigen::VectorXd* gradientVector,
+                                                MemoryUsage* memoryUsage) const {
 
   // Setup Matrices
-  std::vector<unsigned int> sqSizes = stateVector.getStateBlockSizes();
+  const std::vector<unsigned int>& sqSizes = stateVector.getStateBlockSizes();
   BlockSparseMatrix A_(sqSizes, true);
   BlockVector b_(sqSizes);
 
@@ -105,6 +227,12 @@ void OptimizationProblem::buildGaussNewtonTerms(const StateVector& stateVector,
   // ** Note we do not exploit sub-block-sparsity in case it changes at a later iteration
   *approximateHessian = A_.toEigen(false);
   *gradientVector = b_.toEigen();
+
+  // Both copies of the approximate Hessian are alive at this point
+  if (memoryUsage) {
+    memoryUsage->blockHessian = A_.getMemoryUsage();
+    memoryUsage->sparseHessian = getMemoryUsage(*approximateHessian);
+  }
 }
 
 } // steam
@@ -6,7 +6,11 @@
 
 #include <steam/problem/ParallelizedCostTermCollection.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <steam/common/Timer.hpp>
 
 #include <omp.h>
@@ -17,7 +21,7 @@ namespace steam {
 /// \brief Constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
 ParallelizedCostTermCollection::ParallelizedCostTermCollection(unsigned int numThreads)
-  : numThreads_(numThreads) {
+  : numThreads_(numThreads), indexed_(false) {
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -29,7 +33,65 @@ void ParallelizedCostTermCollection::add(const CostTermBase::ConstPtr& costTerm)
     throw std::runtime_error("Do not add pre-parallelized cost "
                              "terms to a cost term parallelizer.");
   }
+  if (indexed_) {
+    indices_.insert(std::make_pair(costTerm.get(), (unsigned int)costTerms_.size()));
+  }
   costTerms_.push_back(costTerm);
+  boost::atomic_store(&norms_, boost::shared_ptr<const NormCache>());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove a cost term
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool ParallelizedCostTermCollection::remove(const CostTermBase::ConstPtr& costTerm) {
+
+  // Index the cost terms on the first removal, so that collections that are only ever
+  // added to do not pay for the map
+  if (!indexed_) {
+    indices_.clear();
+    for (unsigned int i = 0; i < costTerms_.size(); i++) {
+      indices_.insert(std::make_pair(costTerms_[i].get(), i));
+    }
+    indexed_ = true;
+  }
+
+  IndexMap::iterator it = indices_.find(costTerm.get());
+  if (it == indices_.end()) {
+    return false;
+  }
+
+  // Move the last cost term into the freed position
+  const unsigned int idx = it->second;
+  const unsigned int last = costTerms_.size() - 1;
+  indices_.erase(it);
+  if (idx != last) {
+    costTerms_[idx] = costTerms_[last];
+    std::pair<IndexMap::iterator, IndexMap::iterator> range =
+        indices_.equal_range(costTerms_[idx].get());
+    for (IndexMap::iterator moved = range.first; moved != range.second; ++moved) {
+      if (moved->second == last) {
+        moved->second = idx;
+        break;
+      }
+    }
+  }
+  costTerms_.pop_back();
+  boost::atomic_store(&norms_, boost::shared_ptr<const NormCache>());
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Attach a profiler (NULL to detach)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void ParallelizedCostTermCollection::setProfiler(const CostTermProfiler::Ptr& profiler) {
+  profiler_ = profiler;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the attached profiler (NULL if none)
+//////////////////////////////////////////////////////////////////////////////////////////////
+const CostTermProfiler::Ptr& ParallelizedCostTermCollection::getProfiler() const {
+  return profiler_;
 }
 
 std::vector<double> ParallelizedCostTermCollection::costs() const {
@@ -46,29 +108,102 @@ double ParallelizedCostTermCollection::cost() const {
 
   // Init
   double cost = 0;
+  const unsigned int numTerms = costTerms_.size();
+  const unsigned int numBlocks = (numTerms + BATCH_SIZE - 1)/BATCH_SIZE;
+  boost::shared_ptr<NormCache> cache(new NormCache());
+  cache->stamp = StampGenerator::getLatestStamp();
+  cache->norms.resize(numTerms);
+  std::vector<double>& norms = cache->norms;
 
   // Set number of OpenMP threads
   omp_set_num_threads(numThreads_);
 
-  // Parallelize for the cost terms
+  // Cost terms i with i % sampleInterval == sampleOffset are timed by the profiler
+  CostTermProfiler* profiler = profiler_.get();
+  const unsigned int sampleInterval = profiler ? profiler->getSampleInterval() : 0;
+  const unsigned int sampleOffset = profiler ? profiler->beginPass(numThreads_) : 0;
+
+  // Parallelize for the blocks of cost terms
   #pragma omp parallel
   {
+    const LossFunctionBase* losses[BATCH_SIZE];
+    double costs[BATCH_SIZE];
+    bool failed[BATCH_SIZE];
+    bool reusable[BATCH_SIZE];
+
     #pragma omp for reduction(+:cost)
-    for(unsigned int i = 0; i < costTerms_.size(); i++) {
-      try {
-        double cost_i = costTerms_.at(i)->cost();
-        if(std::isnan(cost_i)) {
+    for (unsigned int b = 0; b < numBlocks; b++) {
+      const unsigned int begin = b*BATCH_SIZE;
+      const unsigned int end = std::min(begin + BATCH_SIZE, numTerms);
+      this->getLossFunctions(begin, end, losses);
+
+      // Whitened error norms of the robust cost terms, other cost terms are evaluated directly
+      for (unsigned int i = begin; i < end; i++) {
+        failed[i-begin] = false;
+        reusable[i-begin] = false;
+        const bool sampled = profiler && i % sampleInterval == sampleOffset;
+        std::chrono::steady_clock::time_point start;
+        if (sampled) {
+          start = std::chrono::steady_clock::now();
+        }
+        try {
+          if (losses[i-begin]) {
+            norms[i] = costTerms_[i]->whitenedErrorNorm();
+            reusable[i-begin] = costTerms_[i]->hasStampedInputs();
+          } else {
+            norms[i] = std::numeric_limits<double>::quiet_NaN();
+            costs[i-begin] = costTerms_[i]->cost();
+          }
+          if (sampled) {
+            profiler->recordEvaluate(costTerms_[i]->getProfileType(),
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+          }
+        } catch (const std::exception & e) {
+          std::cout << "STEAM exception in parallel cost term:\n" << e.what() << std::endl;
+          norms[i] = std::numeric_limits<double>::quiet_NaN();
+          failed[i-begin] = true;
+        } catch (...) {
+          std::cout << "STEAM exception in parallel cost term: (unknown)" << std::endl;
+          norms[i] = std::numeric_limits<double>::quiet_NaN();
+          failed[i-begin] = true;
+        }
+      }
+
+      // Batched loss evaluation for each run of cost terms that share a loss function
+      for (unsigned int i = begin; i < end; ) {
+        const LossFunctionBase* loss = losses[i-begin];
+        unsigned int j = i + 1;
+        while (j < end && losses[j-begin] == loss) {
+          j++;
+        }
+        if (loss) {
+          loss->costBatch(&norms[i], j - i, &costs[i-begin]);
+        }
+        i = j;
+      }
+
+      // Norms that may change without a new state stamp are not kept for the weights
+      for (unsigned int i = begin; i < end; i++) {
+        if (!reusable[i-begin]) {
+          norms[i] = std::numeric_limits<double>::quiet_NaN();
+        }
+      }
+
+      // Accumulate
+      for (unsigned int i = begin; i < end; i++) {
+        if (failed[i-begin]) {
+          continue;
+        } else if (std::isnan(costs[i-begin])) {
           std::cout << "nan cost term!";
         } else {
-          cost += cost_i;
+          cost += costs[i-begin];
         }
-      } catch (const std::exception & e) {
-        std::cout << "STEAM exception in parallel cost term:\n" << e.what() << std::endl;
-      } catch (...) {
-        std::cout << "STEAM exception in parallel cost term: (unknown)" << std::endl;
       }
     }
   }
+
+  // Keep the norms for the weights of a following linearization at the same state
+  boost::atomic_store(&norms_, boost::shared_ptr<const NormCache>(cache));
   return cost;
 }
 
@@ -98,23 +233,101 @@ void ParallelizedCostTermCollection::buildGaussNewtonTerms(
   // Locally disable any internal eigen multithreading -- we do our own OpenMP
   Eigen::setNbThreads(1);
 
+  // The norms from the last cost evaluation are valid if no state variable has changed since
+  const unsigned int numTerms = costTerms_.size();
+  const unsigned int numBlocks = (numTerms + BATCH_SIZE - 1)/BATCH_SIZE;
+  const boost::shared_ptr<const NormCache> cache = boost::atomic_load(&norms_);
+  const bool reuseNorms = cache && cache->norms.size() == numTerms &&
+                          cache->stamp == StampGenerator::getLatestStamp();
+
   // Set number of OpenMP threads
   omp_set_num_threads(numThreads_);
 
-  // Parallelize for the cost terms
+  // Cost terms c with c % sampleInterval == sampleOffset are timed by the profiler
+  CostTermProfiler* profiler = profiler_.get();
+  const unsigned int sampleInterval = profiler ? profiler->getSampleInterval() : 0;
+  const unsigned int sampleOffset = profiler ? profiler->beginPass(numThreads_) : 0;
+
+  // Parallelize for the blocks of cost terms
   #pragma omp parallel
   {
+    const LossFunctionBase* losses[BATCH_SIZE];
+    double weights[BATCH_SIZE];
+
     #pragma omp for
-    for (unsigned int c = 0 ; c < costTerms_.size(); c++) {
-      try {
-        costTerms_.at(c)->buildGaussNewtonTerms(stateVector, approximateHessian, gradientVector);
-      } catch (const std::exception & e) {
-        std::cout << "STEAM exception in parallel cost term:\n" << e.what() << std::endl;
-      } catch (...) {
-        std::cout << "STEAM exception in parallel cost term: (unknown)" << std::endl;
+    for (unsigned int b = 0; b < numBlocks; b++) {
+      const unsigned int begin = b*BATCH_SIZE;
+      const unsigned int end = std::min(begin + BATCH_SIZE, numTerms);
+
+      // Batched weight evaluation for each run of cost terms that share a loss function (terms
+      // without a stored norm compute their own weight)
+      bool batched = false;
+      if (reuseNorms && this->getLossFunctions(begin, end, losses)) {
+        for (unsigned int i = begin; i < end; i++) {
+          if (std::isnan(cache->norms[i])) {
+            losses[i-begin] = NULL;
+          }
+          batched = batched || losses[i-begin] != NULL;
+        }
+      }
+      for (unsigned int i = begin; batched && i < end; ) {
+        const LossFunctionBase* loss = losses[i-begin];
+        unsigned int j = i + 1;
+        while (j < end && losses[j-begin] == loss) {
+          j++;
+        }
+        if (loss) {
+          loss->weightBatch(&cache->norms[i], j - i, &weights[i-begin]);
+        }
+        i = j;
       }
-    } // end cost term loop
+
+      for (unsigned int c = begin; c < end; c++) {
+
+        // The cost term adds its Jacobian and Hessian-block counts to the active sample
+        const bool sampled = profiler && c % sampleInterval == sampleOffset;
+        CostTermProfiler::Sample sample;
+        std::chrono::steady_clock::time_point start;
+        if (sampled) {
+          CostTermProfiler::setActiveSample(&sample);
+          start = std::chrono::steady_clock::now();
+        }
+        try {
+          if (batched && losses[c-begin]) {
+            costTerms_[c]->buildReweightedGaussNewtonTerms(stateVector, approximateHessian,
+                                                           gradientVector, weights[c-begin]);
+          } else {
+            costTerms_[c]->buildGaussNewtonTerms(stateVector, approximateHessian, gradientVector);
+          }
+          if (sampled) {
+            profiler->recordLinearize(costTerms_[c]->getProfileType(),
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                sample);
+          }
+        } catch (const std::exception & e) {
+          std::cout << "STEAM exception in parallel cost term:\n" << e.what() << std::endl;
+        } catch (...) {
+          std::cout << "STEAM exception in parallel cost term: (unknown)" << std::endl;
+        }
+        if (sampled) {
+          CostTermProfiler::setActiveSample(NULL);
+        }
+      } // end cost term loop
+    } // end block loop
   } // end parallel
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the loss functions of a block of cost terms, returns whether any are robust
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool ParallelizedCostTermCollection::getLossFunctions(unsigned int begin, unsigned int end,
+                                                      const LossFunctionBase** losses) const {
+  bool any = false;
+  for (unsigned int i = begin; i < end; i++) {
+    losses[i-begin] = costTerms_[i]->getLossFunction();
+    any = any || losses[i-begin] != NULL;
+  }
+  return any;
+}
+
 } // steam
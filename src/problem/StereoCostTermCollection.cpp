@@ -0,0 +1,417 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file StereoCostTermCollection.cpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/problem/StereoCostTermCollection.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <omp.h>
+
+namespace steam {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor
+//////////////////////////////////////////////////////////////////////////////////////////////
+StereoCostTermCollection::StereoCostTermCollection(const stereo::CameraIntrinsics& intrinsics,
+                                                   const lgmath::se3::Transformation& T_cam_vehicle,
+                                                   const BaseNoiseModel<4>::ConstPtr& noiseModel,
+                                                   const LossFunctionBase::ConstPtr& lossFunc,
+                                                   unsigned int numThreads)
+  : intrinsics_(intrinsics), T_cam_vehicle_(T_cam_vehicle), noiseModel_(noiseModel),
+    lossFunc_(lossFunc), numThreads_(numThreads) {
+  if (!noiseModel_ || !lossFunc_) {
+    throw std::invalid_argument("[StereoCostTermCollection] null noise model or loss function.");
+  }
+
+  // Diagonal and isotropic models whiten by scaling the rows, rather than a dense product
+  diagonalNoise_ = true;
+  if (const DiagonalNoiseModel<4>* diagonal =
+      dynamic_cast<const DiagonalNoiseModel<4>*>(noiseModel_.get())) {
+    sqrtInfoDiagonal_ = diagonal->getSqrtInformationDiagonal();
+  } else if (const IsotropicNoiseModel<4>* isotropic =
+             dynamic_cast<const IsotropicNoiseModel<4>*>(noiseModel_.get())) {
+    sqrtInfoDiagonal_.setConstant(isotropic->getSqrtInformationScalar());
+  } else {
+    diagonalNoise_ = false;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Register a vehicle pose, T_vehicle_map, returns its index for add()
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int StereoCostTermCollection::addPose(const se3::TransformStateVar::Ptr& T_vehicle_map) {
+  poses_.push_back(T_vehicle_map);
+  return poses_.size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Register a landmark (in the map frame), returns its index for add()
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int StereoCostTermCollection::addLandmark(const se3::LandmarkStateVar::Ptr& landmark) {
+  landmarks_.push_back(landmark);
+  return landmarks_.size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Reserve storage for a number of measurements
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StereoCostTermCollection::reserve(unsigned int numMeasurements) {
+  for (unsigned int k = 0; k < 4; k++) {
+    measurements_[k].reserve(numMeasurements);
+  }
+  poseIndices_.reserve(numMeasurements);
+  landmarkIndices_.reserve(numMeasurements);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add a stereo measurement of a registered landmark from a registered pose
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StereoCostTermCollection::add(const Eigen::Vector4d& meas, unsigned int poseIndex,
+                                   unsigned int landmarkIndex) {
+  if (poseIndex >= poses_.size() || landmarkIndex >= landmarks_.size()) {
+    throw std::invalid_argument("[StereoCostTermCollection] pose or landmark index is not "
+                                "registered.");
+  }
+  for (unsigned int k = 0; k < 4; k++) {
+    measurements_[k].push_back(meas[k]);
+  }
+  poseIndices_.push_back(poseIndex);
+  landmarkIndices_.push_back(landmarkIndex);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add a batch of n stereo measurements, given as structure-of-arrays
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StereoCostTermCollection::add(unsigned int n, const double* const measurements[4],
+                                   const unsigned int* poseIndices,
+                                   const unsigned int* landmarkIndices) {
+  for (unsigned int i = 0; i < n; i++) {
+    if (poseIndices[i] >= poses_.size() || landmarkIndices[i] >= landmarks_.size()) {
+      throw std::invalid_argument("[StereoCostTermCollection] pose or landmark index is not "
+                                  "registered.");
+    }
+  }
+  for (unsigned int k = 0; k < 4; k++) {
+    measurements_[k].insert(measurements_[k].end(), measurements[k], measurements[k] + n);
+  }
+  poseIndices_.insert(poseIndices_.end(), poseIndices, poseIndices + n);
+  landmarkIndices_.insert(landmarkIndices_.end(), landmarkIndices, landmarkIndices + n);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the shared camera intrinsics
+//////////////////////////////////////////////////////////////////////////////////////////////
+const stereo::CameraIntrinsics& StereoCostTermCollection::getIntrinsics() const {
+  return intrinsics_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the shared extrinsic calibration (T_cam_vehicle)
+//////////////////////////////////////////////////////////////////////////////////////////////
+const lgmath::se3::Transformation& StereoCostTermCollection::getCamVehicleTransform() const {
+  return T_cam_vehicle_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the shared noise model
+//////////////////////////////////////////////////////////////////////////////////////////////
+const BaseNoiseModel<4>::ConstPtr& StereoCostTermCollection::getNoiseModel() const {
+  return noiseModel_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the shared loss function
+//////////////////////////////////////////////////////////////////////////////////////////////
+const LossFunctionBase::ConstPtr& StereoCostTermCollection::getLossFunc() const {
+  return lossFunc_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of threads
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int StereoCostTermCollection::getNumThreads() const {
+  return numThreads_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the registered poses
+//////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<se3::TransformStateVar::Ptr>& StereoCostTermCollection::getPoses() const {
+  return poses_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the registered landmarks
+//////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<se3::LandmarkStateVar::Ptr>& StereoCostTermCollection::getLandmarks() const {
+  return landmarks_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get coordinate k (ul vl ur vr) of every measurement
+//////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<double>& StereoCostTermCollection::getMeasurements(unsigned int k) const {
+  if (k >= 4) {
+    throw std::out_of_range("[StereoCostTermCollection] measurement coordinate out of range.");
+  }
+  return measurements_[k];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the pose index of every measurement
+//////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<unsigned int>& StereoCostTermCollection::getPoseIndices() const {
+  return poseIndices_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the landmark index of every measurement
+//////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<unsigned int>& StereoCostTermCollection::getLandmarkIndices() const {
+  return landmarkIndices_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute the cost from the collection of cost terms
+//////////////////////////////////////////////////////////////////////////////////////////////
+double StereoCostTermCollection::cost() const {
+
+  // Shared quantities are evaluated once per pass
+  const unsigned int numTerms = poseIndices_.size();
+  const unsigned int numBlocks = (numTerms + BATCH_SIZE - 1)/BATCH_SIZE;
+  const Eigen::Matrix4d sqrtInformation = noiseModel_->getSqrtInformation();
+  Matrix4dVector T_cam_map;
+  this->computeCameraPoses(&T_cam_map);
+
+  // Init
+  double cost = 0;
+
+  // Set number of OpenMP threads
+  omp_set_num_threads(numThreads_);
+
+  // Parallelize for the blocks of cost terms
+  #pragma omp parallel
+  {
+    PointBlock points;
+    PointBlock whitenedErrors;
+    double norms[BATCH_SIZE];
+    double costs[BATCH_SIZE];
+
+    #pragma omp for reduction(+:cost)
+    for (unsigned int b = 0; b < numBlocks; b++) {
+      const unsigned int begin = b*BATCH_SIZE;
+      const unsigned int end = std::min(begin + BATCH_SIZE, numTerms);
+      this->evaluateBlock(begin, end, T_cam_map, sqrtInformation, &points, &whitenedErrors, norms);
+      lossFunc_->costBatch(norms, end - begin, costs);
+      for (unsigned int i = 0; i < end - begin; i++) {
+        if (std::isnan(costs[i])) {
+          std::cout << "nan cost term!";
+        } else {
+          cost += costs[i];
+        }
+      }
+    }
+  }
+  return cost;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns the number of cost terms contained by this object
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int StereoCostTermCollection::numCostTerms() const {
+  return poseIndices_.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns whether or not the implementation already uses multi-threading
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool StereoCostTermCollection::isImplParallelized() const {
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the left-hand and right-hand sides of the Gauss-Newton system of equations
+///        using the cost terms in this collection.
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StereoCostTermCollection::buildGaussNewtonTerms(const StateVector& stateVector,
+                                                     BlockSparseMatrix* approximateHessian,
+                                                     BlockVector* gradientVector) const {
+
+  // Locally disable any internal eigen multithreading -- we do our own OpenMP
+  Eigen::setNbThreads(1);
+
+  // Shared quantities are evaluated once per pass
+  const unsigned int numTerms = poseIndices_.size();
+  const unsigned int numBlocks = (numTerms + BATCH_SIZE - 1)/BATCH_SIZE;
+  const Eigen::Matrix4d sqrtInformation = noiseModel_->getSqrtInformation();
+  const Eigen::Matrix<double,6,6> adT_cam_vehicle = T_cam_vehicle_.adjoint();
+  Matrix4dVector T_cam_map;
+  this->computeCameraPoses(&T_cam_map);
+
+  // Block indices of the poses and landmarks (-1 if locked)
+  std::vector<int> poseBlocks(poses_.size(), -1);
+  for (unsigned int k = 0; k < poses_.size(); k++) {
+    if (!poses_[k]->isLocked()) {
+      poseBlocks[k] = stateVector.getStateBlockIndex(poses_[k]->getKey());
+    }
+  }
+  std::vector<int> landmarkBlocks(landmarks_.size(), -1);
+  for (unsigned int l = 0; l < landmarks_.size(); l++) {
+    if (!landmarks_[l]->isLocked()) {
+      landmarkBlocks[l] = stateVector.getStateBlockIndex(landmarks_[l]->getKey());
+    }
+  }
+
+  // Set number of OpenMP threads
+  omp_set_num_threads(numThreads_);
+
+  // Parallelize for the blocks of cost terms
+  #pragma omp parallel
+  {
+    PointBlock points;
+    PointBlock whitenedErrors;
+    double norms[BATCH_SIZE];
+    double weights[BATCH_SIZE];
+    JacobianBlock cameraJacobians;
+
+    #pragma omp for
+    for (unsigned int b = 0; b < numBlocks; b++) {
+      const unsigned int begin = b*BATCH_SIZE;
+      const unsigned int end = std::min(begin + BATCH_SIZE, numTerms);
+      this->evaluateBlock(begin, end, T_cam_map, sqrtInformation, &points, &whitenedErrors, norms,
+                          &cameraJacobians);
+      lossFunc_->weightBatch(norms, end - begin, weights);
+
+      for (unsigned int i = begin; i < end; i++) {
+        const unsigned int j = i - begin;
+        const int poseBlk = poseBlocks[poseIndices_[i]];
+        const int landBlk = landmarkBlocks[landmarkIndices_[i]];
+        if (poseBlk < 0 && landBlk < 0) {
+          continue;
+        }
+
+        // Whitened Jacobian of the error with respect to the point in the camera frame
+        const Eigen::Vector4d point = points.col(j);
+        const Eigen::Map<const Eigen::Matrix4d, 0, Eigen::Stride<4*BATCH_SIZE,BATCH_SIZE> >
+            cameraJac(&cameraJacobians(0,j));
+        Eigen::Matrix4d dedp;
+        if (diagonalNoise_) {
+          dedp.noalias() = (-sqrtInfoDiagonal_).asDiagonal()*cameraJac;
+        } else {
+          dedp.noalias() = (-1)*sqrtInformation*cameraJac;
+        }
+
+        // Pose (left perturbation of T_vehicle_map) and landmark Jacobians
+        const Eigen::Matrix<double,4,6> poseJac =
+            dedp*lgmath::se3::point2fs(point.head<3>(), point[3])*adT_cam_vehicle;
+        const Eigen::Matrix<double,4,3> landJac =
+            dedp*T_cam_map[poseIndices_[i]].block<4,3>(0,0);
+        const Eigen::Vector4d error = whitenedErrors.col(j);
+        const double weight = weights[j];
+
+        // Update the right-hand side (thread critical)
+        #pragma omp critical(b_update)
+        {
+          if (poseBlk >= 0) {
+            gradientVector->mapAt(poseBlk) -= weight*poseJac.transpose()*error;
+          }
+          if (landBlk >= 0) {
+            gradientVector->mapAt(landBlk) -= weight*landJac.transpose()*error;
+          }
+        }
+
+        // Update the left-hand side (thread critical)
+        if (poseBlk >= 0) {
+          BlockSparseMatrix::BlockRowEntry& entry =
+              approximateHessian->rowEntryAt(poseBlk, poseBlk, true);
+          omp_set_lock(&entry.lock);
+          entry.data += weight*poseJac.transpose()*poseJac;
+          omp_unset_lock(&entry.lock);
+        }
+        if (landBlk >= 0) {
+          BlockSparseMatrix::BlockRowEntry& entry =
+              approximateHessian->rowEntryAt(landBlk, landBlk, true);
+          omp_set_lock(&entry.lock);
+          entry.data += weight*landJac.transpose()*landJac;
+          omp_unset_lock(&entry.lock);
+        }
+        if (poseBlk >= 0 && landBlk >= 0) {
+          if (poseBlk < landBlk) {
+            BlockSparseMatrix::BlockRowEntry& entry =
+                approximateHessian->rowEntryAt(poseBlk, landBlk, true);
+            omp_set_lock(&entry.lock);
+            entry.data += weight*poseJac.transpose()*landJac;
+            omp_unset_lock(&entry.lock);
+          } else {
+            BlockSparseMatrix::BlockRowEntry& entry =
+                approximateHessian->rowEntryAt(landBlk, poseBlk, true);
+            omp_set_lock(&entry.lock);
+            entry.data += weight*landJac.transpose()*poseJac;
+            omp_unset_lock(&entry.lock);
+          }
+        }
+      } // end cost term loop
+    } // end block loop
+  } // end parallel
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute T_cam_map = T_cam_vehicle * T_vehicle_map for every pose
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StereoCostTermCollection::computeCameraPoses(Matrix4dVector* T_cam_map) const {
+  const Eigen::Matrix4d T_cv = T_cam_vehicle_.matrix();
+  T_cam_map->resize(poses_.size());
+  for (unsigned int k = 0; k < poses_.size(); k++) {
+    (*T_cam_map)[k] = T_cv*poses_[k]->getValue().matrix();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute the landmarks in the camera frame, the whitened errors and their norms,
+///        for the terms [begin, end)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StereoCostTermCollection::evaluateBlock(unsigned int begin, unsigned int end,
+                                             const Matrix4dVector& T_cam_map,
+                                             const Eigen::Matrix4d& sqrtInformation,
+                                             PointBlock* points,
+                                             PointBlock* whitenedErrors,
+                                             double* norms,
+                                             JacobianBlock* cameraJacobians) const {
+
+  const unsigned int n = end - begin;
+
+  // Gather the landmarks, transformed into the camera frame
+  for (unsigned int i = begin; i < end; i++) {
+    points->col(i - begin) = T_cam_map[poseIndices_[i]]*landmarks_[landmarkIndices_[i]]->getValue();
+  }
+
+  // Batched projection (and camera model Jacobians)
+  PointBlock errors;
+  if (cameraJacobians) {
+    stereo::cameraModelBatch(intrinsics_, points->leftCols(n), errors.leftCols(n),
+                             cameraJacobians->leftCols(n));
+  } else {
+    stereo::cameraModelBatch(intrinsics_, points->leftCols(n), errors.leftCols(n));
+  }
+
+  // Raw errors (measurement minus projection), whitened errors and norms
+  for (unsigned int k = 0; k < 4; k++) {
+    errors.row(k).head(n) = Eigen::Map<const Eigen::RowVectorXd>(&measurements_[k][begin], n) -
+                            errors.row(k).head(n);
+  }
+  if (diagonalNoise_) {
+    whitenedErrors->leftCols(n).noalias() = sqrtInfoDiagonal_.asDiagonal()*errors.leftCols(n);
+  } else {
+    whitenedErrors->leftCols(n).noalias() = sqrtInformation*errors.leftCols(n);
+  }
+  for (unsigned int j = 0; j < n; j++) {
+    norms[j] = whitenedErrors->col(j).norm();
+  }
+}
+
+} // steam
@@ -6,6 +6,8 @@
 
 #include <steam/problem/lossfunc/CauchyLossFunc.hpp>
 
+#include <cmath>
+
 namespace steam {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -24,4 +26,30 @@ double CauchyLossFunc::weight(double whitened_error_norm) const {
   return 1.0 / (1.0 + e_div_k*e_div_k);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CauchyLossFunc::costBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double inv_k = 1.0/k_;
+  const double k2 = k_*k_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double e_div_k = whitened_error_norms[i]*inv_k;
+    out[i] = 0.5 * k2 * std::log(1.0 + e_div_k*e_div_k);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void CauchyLossFunc::weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double inv_k = 1.0/k_;
+  const double k2 = k_*k_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double e_div_k = whitened_error_norms[i]*inv_k;
+    out[i] = 1.0 / (1.0 + e_div_k*e_div_k);
+  }
+}
+
 } // steam
@@ -6,6 +6,8 @@
 
 #include <steam/problem/lossfunc/DcsLossFunc.hpp>
 
+#include <cmath>
+
 namespace steam {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,4 +35,36 @@ double DcsLossFunc::weight(double whitened_error_norm) const {
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void DcsLossFunc::costBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double k2 = k2_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double e2 = whitened_error_norms[i]*whitened_error_norms[i];
+    out[i] = e2 <= k2 ? 0.5*e2 : 2.0*k2*e2/(k2 + e2) - 0.5*k2;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void DcsLossFunc::weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double k2 = k2_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double e2 = whitened_error_norms[i]*whitened_error_norms[i];
+    const double k2e2 = k2 + e2;
+    out[i] = e2 <= k2 ? 1.0 : 4.0*k2*k2/(k2e2*k2e2);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the constructor threshold, k
+//////////////////////////////////////////////////////////////////////////////////////////////
+double DcsLossFunc::getK() const {
+  return std::sqrt(k2_);
+}
+
 } // steam
@@ -6,6 +6,8 @@
 
 #include <steam/problem/lossfunc/GemanMcClureLossFunc.hpp>
 
+#include <cmath>
+
 namespace steam {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -25,4 +27,36 @@ double GemanMcClureLossFunc::weight(double whitened_error_norm) const {
   return k2_*k2_/(k2e2*k2e2);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void GemanMcClureLossFunc::costBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double k2 = k2_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double e2 = whitened_error_norms[i]*whitened_error_norms[i];
+    out[i] = 0.5 * e2 / (k2 + e2);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void GemanMcClureLossFunc::weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double k2 = k2_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double e2 = whitened_error_norms[i]*whitened_error_norms[i];
+    const double k2e2 = k2 + e2;
+    out[i] = k2*k2/(k2e2*k2e2);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the constructor threshold, k
+//////////////////////////////////////////////////////////////////////////////////////////////
+double GemanMcClureLossFunc::getK() const {
+  return std::sqrt(k2_);
+}
+
 } // steam
@@ -6,6 +6,8 @@
 
 #include <steam/problem/lossfunc/HuberLossFunc.hpp>
 
+#include <cmath>
+
 namespace steam {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -33,4 +35,28 @@ double HuberLossFunc::weight(double whitened_error_norm) const {
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void HuberLossFunc::costBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double k = k_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double abse = std::fabs(whitened_error_norms[i]);
+    out[i] = abse <= k ? 0.5*abse*abse : k*(abse - 0.5*k);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void HuberLossFunc::weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  const double k = k_;
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    const double abse = std::fabs(whitened_error_norms[i]);
+    out[i] = abse <= k ? 1.0 : k/abse;
+  }
+}
+
 } // steam
@@ -26,4 +26,24 @@ double L2LossFunc::weight(double whitened_error_norm) const {
   return 1.0;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched cost function, out[i] = cost(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void L2LossFunc::costBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = 0.5*whitened_error_norms[i]*whitened_error_norms[i];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Batched weight function, out[i] = weight(whitened_error_norms[i])
+//////////////////////////////////////////////////////////////////////////////////////////////
+void L2LossFunc::weightBatch(const double* whitened_error_norms, unsigned int n, double* out) const {
+  #pragma omp simd
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = 1.0;
+  }
+}
+
 } // steam
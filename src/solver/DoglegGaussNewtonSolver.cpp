@@ -151,6 +151,14 @@ bool DoglegGaussNewtonSolver::linearizeSolveAndUpdate(double* newCost, double* g
 
   updateTime = timer.milliseconds();
 
+  // Fill in the iteration report (update and cost-evaluation times are recorded by the base)
+  IterationReport& report = this->getCurrIterationReport();
+  report.buildTime = buildTime;
+  report.solveTime = solveTime - report.factorizeTime;
+  report.trustRegionSize = trustRegionSize;
+  report.actualToPredictedRatio = actualToPredictedRatio;
+  report.numBacktracks = numTrDecreases;
+
   // Print report line if verbose option enabled
   if (params_.verbose) {
     if (this->getCurrIteration() == 1) {
@@ -6,6 +6,7 @@
 
 #include <steam/solver/GaussNewtonSolverBase.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <Eigen/Cholesky>
 
@@ -17,7 +18,9 @@ namespace steam {
 /// \brief Constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
 GaussNewtonSolverBase::GaussNewtonSolverBase(OptimizationProblem* problem) :
-  SolverBase(problem), patternInitialized_(false), factorizedInformationSuccesfully_(false) {
+  SolverBase(problem), patternInitialized_(false), analyzedRevision_(0),
+  analyzedStateOrder_(0), analyzedSize_(0), analyzedNonZeros_(0), orderedSize_(0),
+  orderedFactorNonZeros_(0), factorizedRevision_(0), factorizedInformationSuccesfully_(false) {
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -61,6 +64,12 @@ BlockMatrix GaussNewtonSolverBase::queryCovarianceBlock(const std::vector<steam:
                              "have to call solveCovariances().");
   }
 
+  // Check that the factorization matches the current problem structure
+  if (factorizedRevision_ != this->getProblem().getStructureRevision()) {
+    throw std::runtime_error("Cannot query covariance, as the problem structure changed "
+                             "since the approximate Hessian was factorized.");
+  }
+
   // Creating indexing
   BlockMatrixIndexing indexing(this->getStateVector().getStateBlockSizes());
   const BlockDimIndexing& blkRowIndexing = indexing.rowIndexing();
@@ -128,24 +137,41 @@ BlockMatrix GaussNewtonSolverBase::queryCovarianceBlock(const std::vector<steam:
 //////////////////////////////////////////////////////////////////////////////////////////////
 void GaussNewtonSolverBase::buildGaussNewtonTerms(Eigen::SparseMatrix<double>* approximateHessian,
                                                   Eigen::VectorXd* gradientVector) {
-  this->getProblem().buildGaussNewtonTerms(this->getStateVector(), approximateHessian, gradientVector);
+  MemoryUsage usage;
+  this->getProblem().buildGaussNewtonTerms(this->getStateVector(), approximateHessian,
+                                           gradientVector, &usage);
+  this->getCurrIterationReport().memory.updateMax(usage);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Predict the memory of an iteration before running it
+//////////////////////////////////////////////////////////////////////////////////////////////
+MemoryUsage GaussNewtonSolverBase::predictMemoryUsage() {
+
+  // Assemble the system at the current state
+  this->syncWithProblem();
+  MemoryUsage usage;
+  Eigen::SparseMatrix<double> approximateHessian;
+  Eigen::VectorXd gradientVector;
+  this->getProblem().buildGaussNewtonTerms(this->getStateVector(), &approximateHessian,
+                                           &gradientVector, &usage);
+
+  // The symbolic analysis allocates the factor
+  this->analyzePattern(approximateHessian);
+  usage.choleskyFactor = hessianSolver_.getMemoryUsage();
+  this->getStateMemoryUsage(&usage);
+  return usage;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Perform the LLT decomposition on the approx. Hessian matrix
 //////////////////////////////////////////////////////////////////////////////////////////////
-void GaussNewtonSolverBase::factorizeHessian(const Eigen::SparseMatrix<double>& approximateHessian,
+bool GaussNewtonSolverBase::factorizeHessian(const Eigen::SparseMatrix<double>& approximateHessian,
                                              bool augmentedHessian) {
 
-  // Check if the pattern has been initialized
-  if (!patternInitialized_) {
-
-    // The first time we are solving the problem we need to analyze the sparsity pattern
-    // ** Note we use approximate-minimal-degree (AMD) reordering.
-    //    Also, this step does not actually use the numerical values in gaussNewtonLHS
-    hessianSolver_.analyzePattern(approximateHessian);
-    patternInitialized_ = true;
-  }
+  // Analyze the pattern the first time, or if it changed
+  bool patternAnalyzed = this->analyzePattern(approximateHessian);
+  factorizedRevision_ = this->getProblem().getStructureRevision();
 
   // Perform a Cholesky factorization of the approximate Hessian matrix
   factorizedInformationSuccesfully_ = false;
@@ -165,6 +191,7 @@ void GaussNewtonSolverBase::factorizeHessian(const Eigen::SparseMatrix<double>&
 
   // todo - it would be nice to check the condition number (not just the determinant) of the
   // solved system... need to find a fast way to do this
+  return patternAnalyzed;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -175,12 +202,101 @@ Eigen::VectorXd GaussNewtonSolverBase::solveGaussNewton(const Eigen::SparseMatri
                                                         bool augmentedHessian) {
 
   // Perform a Cholesky factorization of the approximate Hessian matrix
-  this->factorizeHessian(approximateHessian, augmentedHessian);
+  IterationReport& report = this->getCurrIterationReport();
+  steam::Timer timer;
+  report.hessianNonZeros = approximateHessian.nonZeros();
+  report.numFactorizations++;
+  if (this->factorizeHessian(approximateHessian, augmentedHessian)) {
+    report.patternAnalyzed = true;
+  }
+  report.factorNonZeros = hessianSolver_.matrixL().nestedExpression().nonZeros();
+  report.memory.choleskyFactor = std::max(report.memory.choleskyFactor,
+                                          hessianSolver_.getMemoryUsage());
+  report.factorizeTime += timer.milliseconds();
 
   // Do the backward pass, using the Cholesky factorization (fast)
   return hessianSolver_.solve(gradientVector);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Analyze the sparsity pattern of the approx. Hessian, if the structure changed
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool GaussNewtonSolverBase::analyzePattern(const Eigen::SparseMatrix<double>& approximateHessian) {
+
+  // The pattern only depends on the structure of the problem (blocks are stored even if zero)
+  const unsigned int revision = this->getProblem().getStructureRevision();
+  const unsigned int stateOrder = this->getStateOrderRevision();
+  const int size = approximateHessian.rows();
+  const int nnz = approximateHessian.nonZeros();
+  if (patternInitialized_ && analyzedRevision_ == revision && analyzedSize_ == size &&
+      analyzedNonZeros_ == nnz) {
+    return false;
+  }
+
+  // If states and cost terms were only appended, the analyzed rows keep their indices and
+  // their fill-reducing ordering stays a reasonable one, so it is reused. The ordering is
+  // recomputed once the system doubled in size (or its factor in non-zeros), or if states
+  // were removed (which reorders the state vector).
+  bool extended = false;
+  if (patternInitialized_ && analyzedStateOrder_ == stateOrder && size >= analyzedSize_ &&
+      size < 2*orderedSize_) {
+    hessianSolver_.analyzeExtendedPattern(approximateHessian);
+    extended = hessianSolver_.getFactorNonZeros() <= 2*orderedFactorNonZeros_;
+  }
+
+  // The first time we are solving the problem (or when the structure changes) we need to
+  // analyze the sparsity pattern
+  // ** Note we use approximate-minimal-degree (AMD) reordering.
+  //    Also, this step does not actually use the numerical values in gaussNewtonLHS
+  if (!extended) {
+    hessianSolver_.analyzePattern(approximateHessian);
+    orderedSize_ = size;
+    orderedFactorNonZeros_ = hessianSolver_.getFactorNonZeros();
+  }
+  analyzedRevision_ = revision;
+  analyzedStateOrder_ = stateOrder;
+  analyzedSize_ = size;
+  analyzedNonZeros_ = nnz;
+  patternInitialized_ = true;
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the bytes of the factor, permutations and elimination tree
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t GaussNewtonSolverBase::HessianSolver::getMemoryUsage() const {
+  return steam::getMemoryUsage(m_matrix) + m_diag.size()*sizeof(double) +
+         (m_P.size() + m_Pinv.size() + m_parent.size() + m_nonZerosPerCol.size())*sizeof(int);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of non-zeros of the factor allocated by the pattern analysis
+//////////////////////////////////////////////////////////////////////////////////////////////
+int GaussNewtonSolverBase::HessianSolver::getFactorNonZeros() const {
+  return m_matrix.nonZeros();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Analyze the pattern of a matrix that extends the last analyzed matrix
+//////////////////////////////////////////////////////////////////////////////////////////////
+void GaussNewtonSolverBase::HessianSolver::analyzeExtendedPattern(
+    const Eigen::SparseMatrix<double>& a) {
+
+  // Keep the permutation of the analyzed rows, the appended rows are eliminated last
+  const int size = a.rows();
+  const int analyzedSize = m_P.size();
+  m_P.indices().conservativeResize(size);
+  for (int i = analyzedSize; i < size; i++) {
+    m_P.indices()[i] = i;
+  }
+  m_Pinv = m_P.inverse();
+
+  // Symbolic factorization of the permuted matrix (as in Eigen's analyzePattern, without AMD)
+  Eigen::SparseMatrix<double> ap(size, size);
+  ap.selfadjointView<Eigen::Upper>() = a.selfadjointView<Eigen::Upper>().twistedBy(m_P);
+  analyzePattern_preordered(ap, false);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Find the Cauchy point (used for the Dogleg method).
 ///        The cauchy point is the optimal step length in the gradient descent direction.
@@ -160,6 +160,14 @@ bool LevMarqGaussNewtonSolver::linearizeSolveAndUpdate(double* newCost, double*
     }
   }
 
+  // Fill in the iteration report (update and cost-evaluation times are recorded by the base)
+  IterationReport& report = this->getCurrIterationReport();
+  report.buildTime = buildTime;
+  report.solveTime = solveTime - report.factorizeTime;
+  report.dampingCoeff = diagCoeff;
+  report.actualToPredictedRatio = actualToPredictedRatio;
+  report.numBacktracks = numTrDecreases;
+
   // Print report line if verbose option enabled
   if (params_.verbose) {
     if (this->getCurrIteration() == 1) {
@@ -80,6 +80,13 @@ bool LineSearchGaussNewtonSolver::linearizeSolveAndUpdate(double* newCost, doubl
 
   updateTime = timer.milliseconds();
 
+  // Fill in the iteration report (update and cost-evaluation times are recorded by the base)
+  IterationReport& report = this->getCurrIterationReport();
+  report.buildTime = buildTime;
+  report.solveTime = solveTime - report.factorizeTime;
+  report.stepScale = backtrackCoeff;
+  report.numBacktracks = nBacktrack;
+
   // Print report line if verbose option enabled
   if (params_.verbose) {
     if (this->getCurrIteration() == 1) {
@@ -6,6 +6,7 @@
 
 #include <steam/solver/SolverBase.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 #include <steam/common/Timer.hpp>
@@ -16,21 +17,17 @@ namespace steam {
 /// \brief Constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
 SolverBase::SolverBase(OptimizationProblem* problem) : problem_(problem),
-    firstBackup_(true), pendingProposedState_(false),
+    stateOrderRevision_(0), pendingProposedState_(false),
     currIteration_(0), solverConverged_(false),
     term_(TERMINATE_NOT_YET_TERMINATED) {
 
   // Set current cost from initial problem
   currCost_ = prevCost_ = problem_->cost();
 
-  // Set up state vector -- add all states that are not locked to vector
-  const std::vector<StateVariableBase::Ptr>& stateRef = problem_->getStateVariables();
-  for (unsigned int i = 0; i < stateRef.size(); i++) {
-    const StateVariableBase::Ptr& stateVarRef = stateRef.at(i);
-    if (!stateVarRef->isLocked()) {
-      stateVec_.addStateVariable(stateVarRef);
-    }
-  }
+  // Set up state vector
+  structureRevision_ = problem_->getStructureRevision();
+  numStateChanges_ = problem_->getNumberOfStateChanges();
+  this->buildStateVector();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +42,9 @@ bool SolverBase::converged() const {
 //////////////////////////////////////////////////////////////////////////////////////////////
 void SolverBase::iterate() {
 
+  // Patch the state vector if the problem has changed
+  this->syncWithProblem();
+
   // Check is solver has already converged
   if (solverConverged_) {
     std::cout << "[STEAM WARN] Requested an iteration when solver has already converged, iteration ignored.";
@@ -66,6 +66,11 @@ void SolverBase::iterate() {
   // Record previous iteration cost
   prevCost_ = currCost_;
 
+  // Start a new report (the solver fills in its own values)
+  steam::Timer iterTimer;
+  report_ = IterationReport();
+  const unsigned long long allocationsBefore = getAllocationCount();
+
   // Perform an iteration of the implemented solver-type
   double gradientNorm = 0.0;
   bool stepSuccess = linearizeSolveAndUpdate(&currCost_, &gradientNorm);
@@ -77,10 +82,6 @@ void SolverBase::iterate() {
   } else if (!stepSuccess) {
     term_ = TERMINATE_STEP_UNSUCCESSFUL;
     solverConverged_ = true;
-    throw unsuccessful_step("The steam solver terminated due to being unable to produce a "
-                            "'successful' step. If this occurs, it is likely that your problem "
-                            "is very nonlinear and poorly initialized, or is using incorrect "
-                            "analytical Jacobians.");
   } else if (currIteration_ >= this->getSolverBaseParams().maxIterations) {
     term_ = TERMINATE_MAX_ITERATIONS;
     solverConverged_ = true;
@@ -95,6 +96,30 @@ void SolverBase::iterate() {
     solverConverged_ = true;
   }
 
+  // Complete the report and notify the observers
+  report_.iteration = currIteration_;
+  report_.cost = currCost_;
+  report_.prevCost = prevCost_;
+  report_.gradientNorm = gradientNorm;
+  report_.stepSuccess = stepSuccess;
+  report_.iterationTime = iterTimer.milliseconds();
+  this->getStateMemoryUsage(&report_.memory);
+  report_.numAllocations = getAllocationCount() - allocationsBefore;
+  report_.peakResidentMemory = getPeakResidentMemory();
+  peakMemory_.updateMax(report_.memory);
+  report_.converged = solverConverged_;
+  report_.termination = term_;
+  for (unsigned int i = 0; i < observers_.size(); i++) {
+    observers_[i]->onIteration(report_);
+  }
+
+  if (term_ == TERMINATE_STEP_UNSUCCESSFUL) {
+    throw unsuccessful_step("The steam solver terminated due to being unable to produce a "
+                            "'successful' step. If this occurs, it is likely that your problem "
+                            "is very nonlinear and poorly initialized, or is using incorrect "
+                            "analytical Jacobians.");
+  }
+
   // Log on final iteration
   if (this->getSolverBaseParams().verbose && solverConverged_) {
     std::cout << "Termination Cause: " << term_ << std::endl;
@@ -111,6 +136,9 @@ void SolverBase::optimize() {
   // Timer
   steam::Timer timer;
 
+  // Patch the state vector if the problem has changed (this restarts a converged solver)
+  this->syncWithProblem();
+
   // Optimization loop
   while(!this->converged()) {
     this->iterate();
@@ -136,6 +164,38 @@ unsigned int SolverBase::getCurrIteration() const {
   return currIteration_;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add an observer of the iterations
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SolverBase::addObserver(const Observer::Ptr& observer) {
+  if (!observer) {
+    throw std::invalid_argument("Null observer passed to addObserver()");
+  }
+  observers_.push_back(observer);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove an observer of the iterations
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SolverBase::removeObserver(const Observer::Ptr& observer) {
+  observers_.erase(std::remove(observers_.begin(), observers_.end(), observer),
+                   observers_.end());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Return the report of the last iteration
+//////////////////////////////////////////////////////////////////////////////////////////////
+const SolverBase::IterationReport& SolverBase::getLastIterationReport() const {
+  return report_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Return the largest bytes held by each subsystem over the iterations so far
+//////////////////////////////////////////////////////////////////////////////////////////////
+const MemoryUsage& SolverBase::getPeakMemoryUsage() const {
+  return peakMemory_;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Return previous iteration cost evaluation
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -175,20 +235,20 @@ double SolverBase::proposeUpdate(const Eigen::VectorXd& stateStep) {
                              "or reject before proposing a new one.");
   }
 
-  // Make copy of state vector
-  if (firstBackup_) {
-    stateVectorBackup_ = stateVec_;
-    firstBackup_ = false;
-  } else {
-    stateVectorBackup_.copyValues(stateVec_);
-  }
+  // Save the current state values
+  steam::Timer timer;
+  stateVec_.saveValues(&stateSnapshot_);
 
   // Update copy with perturbation
   stateVec_.update(stateStep);
   pendingProposedState_ = true;
+  report_.updateTime += timer.milliseconds();
 
   // Test new cost
-  return problem_->cost();
+  timer.reset();
+  const double cost = problem_->cost();
+  report_.costEvalTime += timer.milliseconds();
+  return cost;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -216,12 +276,106 @@ void SolverBase::rejectProposedState() {
   }
 
   // Revert to previous state
-  stateVec_.copyValues(stateVectorBackup_);
+  steam::Timer timer;
+  stateVec_.restoreValues(stateSnapshot_);
+  report_.updateTime += timer.milliseconds();
 
   // Switch flag, ready for new proposal
   pendingProposedState_ = false;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the report of the current iteration, for the derived solvers to fill in
+//////////////////////////////////////////////////////////////////////////////////////////////
+SolverBase::IterationReport& SolverBase::getCurrIterationReport() {
+  return report_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Record the bytes of the state vector, its backup and the evaluator pools
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SolverBase::getStateMemoryUsage(MemoryUsage* usage) const {
+
+  if (usage == NULL) {
+    throw std::invalid_argument("Null pointer provided to getStateMemoryUsage()");
+  }
+  usage->stateVector = stateVec_.getMemoryUsage();
+  if (stateSnapshot_.copies.size() == stateVec_.getNumberOfStates()) {
+    usage->stateBackup = stateSnapshot_.getMemoryUsage();
+  } else {
+    StateVector::Snapshot snapshot;
+    stateVec_.saveValues(&snapshot);
+    usage->stateBackup = snapshot.getMemoryUsage();
+  }
+  usage->evaluatorPools = getPoolMemoryUsage();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Add all unlocked states of the problem to an empty state vector
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SolverBase::buildStateVector() {
+
+  // Set up state vector -- add all states that are not locked to vector
+  const std::vector<StateVariableBase::Ptr>& stateRef = problem_->getStateVariables();
+  for (unsigned int i = 0; i < stateRef.size(); i++) {
+    const StateVariableBase::Ptr& stateVarRef = stateRef.at(i);
+    if (!stateVarRef->isLocked()) {
+      stateVec_.addStateVariable(stateVarRef);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Apply structural changes made to the problem since the last synchronization
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SolverBase::syncWithProblem() {
+
+  // Check if anything changed
+  if (structureRevision_ == problem_->getStructureRevision()) {
+    return;
+  }
+
+  // The backup of a pending update would no longer match the state vector
+  if (pendingProposedState_) {
+    throw std::runtime_error("The problem structure changed while an update was pending, "
+                             "accept or reject the update first.");
+  }
+
+  // Replay the state changes, or rebuild if the problem no longer logs all of them
+  std::vector<OptimizationProblem::StateChange> changes;
+  if (problem_->getStateChangesSince(numStateChanges_, &changes)) {
+    for (unsigned int i = 0; i < changes.size(); i++) {
+      const StateVariableBase::Ptr& state = changes[i].state;
+      const bool inVector = stateVec_.hasStateVariable(state->getKey());
+      if (changes[i].added && !inVector && !state->isLocked()) {
+        stateVec_.addStateVariable(state);
+      } else if (!changes[i].added && inVector) {
+        stateVec_.removeStateVariable(state->getKey());
+        stateOrderRevision_++;
+      }
+    }
+  } else {
+    stateVec_ = StateVector();
+    this->buildStateVector();
+    stateOrderRevision_++;
+  }
+  structureRevision_ = problem_->getStructureRevision();
+  numStateChanges_ = problem_->getNumberOfStateChanges();
+
+  // The objective has changed, restart convergence tracking
+  currCost_ = prevCost_ = problem_->cost();
+  currIteration_ = 0;
+  solverConverged_ = false;
+  term_ = TERMINATE_NOT_YET_TERMINATED;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the revision of the order of the state vector
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int SolverBase::getStateOrderRevision() const {
+  return stateOrderRevision_;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Print termination cause
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -59,6 +59,12 @@ bool VanillaGaussNewtonSolver::linearizeSolveAndUpdate(double* newCost, double*
   this->acceptProposedState();
   updateTime = timer.milliseconds();
 
+  // Fill in the iteration report (update and cost-evaluation times are recorded by the base)
+  IterationReport& report = this->getCurrIterationReport();
+  report.buildTime = buildTime;
+  report.solveTime = solveTime - report.factorizeTime;
+  report.stepScale = 1.0;
+
   // Print report line if verbose option enabled
   if (params_.verbose) {
     if (this->getCurrIteration() == 1) {
@@ -33,6 +33,15 @@ bool LandmarkStateVar::update(const Eigen::VectorXd& perturbation) {
   return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Update the state from a raw perturbation (without allocation)
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool LandmarkStateVar::updateRaw(const double* perturbation) {
+  this->value_.head<3>() += Eigen::Map<const Eigen::Vector3d>(perturbation);
+  this->refreshHomogeneousScaling();
+  return true;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Clone method
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,6 +49,29 @@ StateVariableBase::Ptr LandmarkStateVar::clone() const {
   return LandmarkStateVar::Ptr(new LandmarkStateVar(*this));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of doubles used to store the raw (homogeneous) value
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int LandmarkStateVar::getRawValueSize() const {
+  return 4;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write the raw value of the state into a buffer
+//////////////////////////////////////////////////////////////////////////////////////////////
+void LandmarkStateVar::writeRawValue(double* out) const {
+  Eigen::Map<Eigen::Vector4d> raw(out);
+  raw = this->value_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Set the value of the state from a raw buffer (no rescaling is performed)
+//////////////////////////////////////////////////////////////////////////////////////////////
+void LandmarkStateVar::readRawValue(const double* in) {
+  this->value_ = Eigen::Map<const Eigen::Vector4d>(in);
+  this->markChanged();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Set value -- mostly for landmark initialization
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -63,6 +95,9 @@ void LandmarkStateVar::refreshHomogeneousScaling() {
 
   // Update scaling
   this->value_[3] *= invmag;
+
+  // All modifications of the value end here
+  this->markChanged();
 }
 
 } // se3
@@ -5,7 +5,6 @@
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <steam/state/StateVector.hpp>
-#include <steam/blockmat/BlockVector.hpp>
 
 #include <iostream>
 
@@ -14,19 +13,18 @@ namespace steam {
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Default constructor
 //////////////////////////////////////////////////////////////////////////////////////////////
-StateVector::StateVector() : numBlockEntries_(0) {}
+StateVector::StateVector() : perturbDim_(0) {}
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Copy constructor -- deep copy
 //////////////////////////////////////////////////////////////////////////////////////////////
 StateVector::StateVector(const StateVector& other) : states_(other.states_),
-  numBlockEntries_(other.numBlockEntries_) {
+  indices_(other.indices_), blockSizes_(other.blockSizes_), perturbDim_(other.perturbDim_) {
 
-  // Map is copied in initialization list to avoid re-hashing all the entries,
-  // now we go through the entries and perform a deep copy
-  boost::unordered_map<StateID, StateContainer>::iterator it = states_.begin();
-  for(; it != states_.end(); ++it) {
-    it->second.state = it->second.state->clone();
+  // Containers are copied in initialization list to avoid re-hashing all the entries,
+  // now we go through the entries and perform a deep copy (clones keep the same key)
+  for (unsigned int i = 0; i < states_.size(); i++) {
+    states_[i].state = states_[i].state->clone();
   }
 }
 
@@ -38,7 +36,9 @@ StateVector& StateVector::operator= (const StateVector& other) {
   // Copy-swap idiom
   StateVector tmp(other); // note, copy constructor makes a deep copy
   std::swap(states_, tmp.states_);
-  std::swap(numBlockEntries_, tmp.numBlockEntries_);
+  std::swap(indices_, tmp.indices_);
+  std::swap(blockSizes_, tmp.blockSizes_);
+  std::swap(perturbDim_, tmp.perturbDim_);
   return *this;
 }
 
@@ -50,33 +50,99 @@ void StateVector::copyValues(const StateVector& other) {
 
   // Check state vector are the same size
   if (this->states_.empty() ||
-      this->numBlockEntries_ != other.numBlockEntries_ ||
       this->states_.size() != other.states_.size()) {
     throw std::invalid_argument("StateVector size was not the same in copyValues()");
   }
 
   // Iterate over the state vectors and perform a "deep" copy without allocation new memory.
   // Keeping the original pointers is important as they are shared in other places, and we
-  // want to update the shared memory.
-  // todo: can we avoid a 'find' here?
-  boost::unordered_map<StateID, StateContainer>::iterator it = states_.begin();
-  for(; it != states_.end(); ++it) {
-
-    // Find matching state by ID
-    boost::unordered_map<StateID, StateContainer>::const_iterator itOther = other.states_.find(it->second.state->getKey().getID());
-
-    // Check that matching state was found and has the same structure
-    if (itOther == other.states_.end() ||
-        it->second.state->getKey().getID() != itOther->second.state->getKey().getID() ||
-        it->second.localBlockIndex != itOther->second.localBlockIndex) {
+  // want to update the shared memory. Since states are stored in block order, matching
+  // states are found at the same index.
+  for (unsigned int i = 0; i < states_.size(); i++) {
+
+    // Check that the structure of the state vectors is the same
+    if (states_[i].id != other.states_[i].id) {
       throw std::runtime_error("StateVector was missing an entry in copyValues(), "
                                "or structure of StateVector did not match.");
     }
 
     // Copy
-    it->second.state->setFromCopy(itOther->second.state);
+    states_[i].state->setFromCopy(other.states_[i].state);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Save the values of all states into a snapshot
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StateVector::saveValues(Snapshot* snapshot) const {
+
+  if (snapshot == NULL) {
+    throw std::invalid_argument("Null snapshot passed to saveValues()");
+  }
+
+  // Size the buffers (only allocates on the first save, or if the structure changed)
+  unsigned int rawSize = 0;
+  for (unsigned int i = 0; i < states_.size(); i++) {
+    rawSize += states_[i].state->getRawValueSize();
   }
+  snapshot->values.resize(rawSize);
+  snapshot->copies.resize(states_.size());
+
+  // Pack raw values, and copy the states that do not support them
+  double* out = snapshot->values.empty() ? NULL : &snapshot->values[0];
+  for (unsigned int i = 0; i < states_.size(); i++) {
+    const StateVariableBase::Ptr& state = states_[i].state;
+    unsigned int size = state->getRawValueSize();
+    if (size > 0) {
+      state->writeRawValue(out);
+      out += size;
+    } else if (snapshot->copies[i] && snapshot->copies[i]->getKey().equals(state->getKey())) {
+      snapshot->copies[i]->setFromCopy(state);
+    } else {
+      snapshot->copies[i] = state->clone();
+    }
+  }
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Approximate number of bytes held by the snapshot
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t StateVector::Snapshot::getMemoryUsage() const {
+  return sizeof(*this) + values.capacity()*sizeof(double) +
+         copies.capacity()*sizeof(StateVariableBase::Ptr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Restore the values of all states from a snapshot
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StateVector::restoreValues(const Snapshot& snapshot) {
+
+  // Check that the snapshot matches the structure of the state vector
+  if (snapshot.copies.size() != states_.size()) {
+    throw std::invalid_argument("Snapshot size did not match the StateVector in restoreValues()");
+  }
+
+  // Unpack raw values, and copy the states that do not support them
+  const double* in = snapshot.values.empty() ? NULL : &snapshot.values[0];
+  const double* end = in + snapshot.values.size();
+  for (unsigned int i = 0; i < states_.size(); i++) {
+    const StateVariableBase::Ptr& state = states_[i].state;
+    unsigned int size = state->getRawValueSize();
+    if (size > 0) {
+      if (in + size > end) {
+        throw std::runtime_error("Snapshot structure did not match the StateVector "
+                                 "in restoreValues()");
+      }
+      state->readRawValue(in);
+      in += size;
+    } else {
+      if (!snapshot.copies[i]) {
+        throw std::runtime_error("Snapshot structure did not match the StateVector "
+                                 "in restoreValues()");
+      }
+      state->setFromCopy(snapshot.copies[i]);
+    }
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -96,14 +162,55 @@ void StateVector::addStateVariable(const StateVariableBase::Ptr& state) {
     throw std::runtime_error("StateVector already contains the state being added.");
   }
 
-  // Create new container
+  // Create new container in the next slot
+  unsigned int slot = states_.size();
   StateContainer newEntry;
   newEntry.state = state; // copy the shared_ptr (increases ref count)
-  newEntry.localBlockIndex = numBlockEntries_;
-  states_[key.getID()] = newEntry;
+  newEntry.id = key.getID();
+  newEntry.offset = perturbDim_;
+  states_.push_back(newEntry);
+  indices_[key.getID()] = slot;
+  blockSizes_.push_back(state->getPerturbDim());
+  perturbDim_ += state->getPerturbDim();
+
+  // Let the key of the state carry its slot
+  state->setSlot(slot);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove a state variable
+//////////////////////////////////////////////////////////////////////////////////////////////
+void StateVector::removeStateVariable(const StateKey& key) {
 
-  // Increment number of entries
-  numBlockEntries_++;
+  // Find the slot of the state
+  boost::unordered_map<StateID, unsigned int>::iterator it = indices_.find(key.getID());
+  if (it == indices_.end()) {
+    throw std::runtime_error("State variable was not found in call to removeStateVariable()");
+  }
+  const unsigned int slot = it->second;
+  const unsigned int last = states_.size() - 1;
+  const unsigned int removedDim = blockSizes_[slot];
+  indices_.erase(it);
+
+  // Move the last state into the freed slot
+  if (slot != last) {
+    const unsigned int offset = states_[slot].offset;
+    states_[slot] = states_[last];
+    blockSizes_[slot] = blockSizes_[last];
+    indices_[states_[slot].id] = slot;
+    states_[slot].state->setSlot(slot);
+
+    // Offsets only shift if the moved state has a different size
+    states_[slot].offset = offset;
+    if (blockSizes_[slot] != removedDim) {
+      for (unsigned int i = slot + 1; i < last; i++) {
+        states_[i].offset = states_[i-1].offset + blockSizes_[i-1];
+      }
+    }
+  }
+  states_.pop_back();
+  blockSizes_.pop_back();
+  perturbDim_ -= removedDim;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -112,10 +219,10 @@ void StateVector::addStateVariable(const StateVariableBase::Ptr& state) {
 bool StateVector::hasStateVariable(const StateKey& key) const {
 
   // Find the StateContainer for key
-  boost::unordered_map<StateID, StateContainer>::const_iterator it = states_.find(key.getID());
+  boost::unordered_map<StateID, unsigned int>::const_iterator it = indices_.find(key.getID());
 
   // Return if found
-  return it != states_.end();
+  return it != indices_.end();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -124,15 +231,15 @@ bool StateVector::hasStateVariable(const StateKey& key) const {
 StateVariableBase::ConstPtr StateVector::getStateVariable(const StateKey& key) const {
 
   // Find the StateContainer for key
-  boost::unordered_map<StateID, StateContainer>::const_iterator it = states_.find(key.getID());
+  boost::unordered_map<StateID, unsigned int>::const_iterator it = indices_.find(key.getID());
 
   // Check that it was found
-  if (it == states_.end()) {
+  if (it == indices_.end()) {
     throw std::runtime_error("State variable was not found in call to getStateVariable()");
   }
 
   // Return state variable reference
-  return it->second.state;
+  return states_[it->second].state;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -147,47 +254,34 @@ unsigned int StateVector::getNumberOfStates() const {
 //////////////////////////////////////////////////////////////////////////////////////////////
 int StateVector::getStateBlockIndex(const StateKey& key) const {
 
+  // Fast path, the slot carried by the key refers to this state vector
+  int slot = key.getSlot();
+  if (slot >= 0 && slot < (int)states_.size() && states_[slot].id == key.getID()) {
+    return slot;
+  }
+
   // Find the StateContainer for key
-  boost::unordered_map<StateID, StateContainer>::const_iterator it = states_.find(key.getID());
+  boost::unordered_map<StateID, unsigned int>::const_iterator it = indices_.find(key.getID());
 
   // Check that the state exists in the state vector
   //  **Note the likely causes that this occurs:
   //      1)  A cost term includes a state that is not added to the problem
   //      2)  A cost term is not checking whether states are locked, and adding a Jacobian for a locked state variable
-  if (it == states_.end()) {
+  if (it == indices_.end()) {
     std::stringstream ss; ss << "Tried to find a state that does not exist "
                                 "in the state vector (ID: " << key.getID() << ").";
     throw std::runtime_error(ss.str());
   }
 
   // Return block index
-  return it->second.localBlockIndex;
+  return it->second;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Get an ordered list of the sizes of the 'block' state variables
 //////////////////////////////////////////////////////////////////////////////////////////////
-std::vector<unsigned int> StateVector::getStateBlockSizes() const {
-
-  // Init return
-  std::vector<unsigned int> result;
-  result.resize(states_.size());
-
-  // Iterate over states and populate result
-  for (boost::unordered_map<StateID, StateContainer>::const_iterator it = states_.begin();
-       it != states_.end(); ++it ) {
-
-    // Check that the local block index is in a valid range
-    if (it->second.localBlockIndex < 0 ||
-        it->second.localBlockIndex >= (int)result.size()) {
-      throw std::logic_error("localBlockIndex is not a valid range");
-    }
-
-    // Populate return vector
-    result[it->second.localBlockIndex] = it->second.state->getPerturbDim();
-  }
-
-  return result;
+const std::vector<unsigned int>& StateVector::getStateBlockSizes() const {
+  return blockSizes_;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -195,20 +289,31 @@ std::vector<unsigned int> StateVector::getStateBlockSizes() const {
 //////////////////////////////////////////////////////////////////////////////////////////////
 void StateVector::update(const Eigen::VectorXd& perturbation) {
 
-  // Convert single vector to a block-vector of perturbations (this checks sizes)
-  BlockVector blkPerturb(this->getStateBlockSizes(), perturbation);
+  // Check size
+  if (perturbation.size() != (int)perturbDim_) {
+    throw std::invalid_argument("Perturbation size did not match the StateVector in update()");
+  }
 
-  // Iterate over states and update each
-  for ( boost::unordered_map<StateID, StateContainer>::const_iterator it = states_.begin(); it != states_.end(); ++it ) {
+  // Update each state from its segment of the perturbation. States are independent, so
+  // large state vectors are updated in parallel (small ones are not worth the overhead).
+  const double* data = perturbation.data();
+  const int numStates = states_.size();
+  #pragma omp parallel for schedule(static) if(numStates > 1000)
+  for (int i = 0; i < numStates; i++) {
+    states_[i].state->updateRaw(data + states_[i].offset);
+  }
+}
 
-    // Check for valid index
-    if (it->second.localBlockIndex < 0) {
-      throw std::runtime_error("localBlockIndex is not initialized");
-    }
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the approximate number of bytes held by the state vector's index
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::size_t StateVector::getMemoryUsage() const {
 
-    // Update state
-    it->second.state->update(blkPerturb.at(it->second.localBlockIndex));
-  }
+  // Containers, and the hash map (buckets, and a node with a link per entry)
+  return sizeof(*this) + states_.capacity()*sizeof(StateContainer) +
+         blockSizes_.capacity()*sizeof(unsigned int) +
+         indices_.bucket_count()*sizeof(void*) +
+         indices_.size()*(sizeof(std::pair<const StateID, unsigned int>) + sizeof(void*));
 }
 
 } // steam
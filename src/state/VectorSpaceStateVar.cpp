@@ -25,6 +25,16 @@ bool VectorSpaceStateVar::update(const Eigen::VectorXd& perturbation) {
   }
 
   this->value_ = this->value_ + perturbation;
+  this->markChanged();
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Update the state from a raw perturbation (without allocation)
+/////////////////////////////////////////////////////////////////////////////////////////////
+bool VectorSpaceStateVar::updateRaw(const double* perturbation) {
+  this->value_ += Eigen::Map<const Eigen::VectorXd>(perturbation, this->value_.size());
+  this->markChanged();
   return true;
 }
 
@@ -36,4 +46,27 @@ StateVariableBase::Ptr VectorSpaceStateVar::clone() const {
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of doubles used to store the raw value
+/////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int VectorSpaceStateVar::getRawValueSize() const {
+  return this->value_.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Write the raw value of the state into a buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+void VectorSpaceStateVar::writeRawValue(double* out) const {
+  Eigen::Map<Eigen::VectorXd> raw(out, this->value_.size());
+  raw = this->value_;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Set the value of the state from a raw buffer
+/////////////////////////////////////////////////////////////////////////////////////////////
+void VectorSpaceStateVar::readRawValue(const double* in) {
+  this->value_ = Eigen::Map<const Eigen::VectorXd>(in, this->value_.size());
+  this->markChanged();
+}
+
 } // steam
@@ -6,6 +6,8 @@
 
 #include <steam/trajectory/SteamTrajInterface.hpp>
 
+#include <algorithm>
+
 #include <lgmath.hpp>
 
 #include <steam/trajectory/SteamTrajPoseInterpEval.hpp>
@@ -55,11 +57,8 @@ SteamTrajInterface::SteamTrajInterface(const Eigen::Matrix<double,6,6>& Qc_inv,
 //////////////////////////////////////////////////////////////////////////////////////////////
 void SteamTrajInterface::add(const SteamTrajVar::Ptr& knot) {
 
-  // Todo, check that time does not already exist in map?
-
-  // Insert in map
-  knotMap_.insert(knotMap_.end(),
-                  std::pair<boost::int64_t, SteamTrajVar::Ptr>(knot->getTime().nanosecs(), knot));
+  // Insert in knot array (throws if a knot already exists at the time)
+  knots_.insert(knot);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -74,14 +73,25 @@ void SteamTrajInterface::add(const steam::Time& time,
     throw std::invalid_argument("invalid velocity size");
   }
 
-  // Todo, check that time does not already exist in map?
-
   // Make knot
   SteamTrajVar::Ptr newEntry(new SteamTrajVar(time, T_k0, velocity));
 
-  // Insert in map
-  knotMap_.insert(knotMap_.end(),
-                  std::pair<boost::int64_t, SteamTrajVar::Ptr>(time.nanosecs(), newEntry));
+  // Insert in knot array (throws if a knot already exists at the time)
+  knots_.insert(newEntry);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove all knots strictly before a time
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajInterface::removeKnotsBefore(const steam::Time& time) {
+  knots_.dropBefore(time);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the number of knots
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int SteamTrajInterface::getNumKnots() const {
+  return knots_.size();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -90,21 +100,19 @@ void SteamTrajInterface::add(const steam::Time& time,
 TransformEvaluator::ConstPtr SteamTrajInterface::getInterpPoseEval(const steam::Time& time) const {
 
   // Check that map is not empty
-  if (knotMap_.empty()) {
+  if (knots_.empty()) {
     throw std::runtime_error("[GpTrajectory][getEvaluator] map was empty");
   }
 
-  // Get iterator to first element with time equal to or greater than 'time'
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it1
-      = knotMap_.lower_bound(time.nanosecs());
+  // Get index of first knot with time equal to or greater than 'time'
+  unsigned int idx = knots_.lowerBound(time);
 
   // Check if time is passed the last entry
-  if (it1 == knotMap_.end()) {
+  if (idx == knots_.size()) {
 
     // If we allow extrapolation, return constant-velocity interpolated entry
     if (allowExtrapolation_) {
-      --it1; // should be safe, as we checked that the map was not empty..
-      const SteamTrajVar::Ptr& endKnot = it1->second;
+      const SteamTrajVar::Ptr& endKnot = knots_.back();
       TransformEvaluator::Ptr T_t_k =
           ConstVelTransformEvaluator::MakeShared(endKnot->getVelocity(), time - endKnot->getTime());
       return compose(T_t_k, endKnot->getPose());
@@ -114,18 +122,18 @@ TransformEvaluator::ConstPtr SteamTrajInterface::getInterpPoseEval(const steam::
   }
 
   // Check if we requested time exactly
-  if (it1->second->getTime() == time) {
+  if (knots_.at(idx)->getTime() == time) {
 
     // return state variable exactly (no interp)
-    return it1->second->getPose();
+    return knots_.at(idx)->getPose();
   }
 
   // Check if we requested before first time
-  if (it1 == knotMap_.begin()) {
+  if (idx == 0) {
 
     // If we allow extrapolation, return constant-velocity interpolated entry
     if (allowExtrapolation_) {
-      const SteamTrajVar::Ptr& startKnot = it1->second;
+      const SteamTrajVar::Ptr& startKnot = knots_.front();
       TransformEvaluator::Ptr T_t_k =
           ConstVelTransformEvaluator::MakeShared(startKnot->getVelocity(),
                                                  time - startKnot->getTime());
@@ -135,34 +143,33 @@ TransformEvaluator::ConstPtr SteamTrajInterface::getInterpPoseEval(const steam::
     }
   }
 
-  // Get iterators bounding the time interval
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it2 = it1; --it1;
-  if (time <= it1->second->getTime() || time >= it2->second->getTime()) {
+  // Get knots bounding the time interval
+  const SteamTrajVar::Ptr& knot1 = knots_.at(idx-1);
+  const SteamTrajVar::Ptr& knot2 = knots_.at(idx);
+  if (time <= knot1->getTime() || time >= knot2->getTime()) {
     throw std::runtime_error("Requested trajectory evaluator at an invalid time. This exception "
                              "should not trigger... report to a STEAM contributor.");
   }
 
   // Create interpolated evaluator
-  return SteamTrajPoseInterpEval::MakeShared(time, it1->second, it2->second);
+  return SteamTrajPoseInterpEval::MakeShared(time, knot1, knot2);
 }
 
 Eigen::VectorXd SteamTrajInterface::getVelocity(const steam::Time& time) {
   // Check that map is not empty
-  if (knotMap_.empty()) {
+  if (knots_.empty()) {
     throw std::runtime_error("[GpTrajectory][getEvaluator] map was empty");
   }
 
-  // Get iterator to first element with time equal to or greater than 'time'
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it1
-     = knotMap_.lower_bound(time.nanosecs());
+  // Get index of first knot with time equal to or greater than 'time'
+  unsigned int idx = knots_.lowerBound(time);
 
   // Check if time is passed the last entry
-  if (it1 == knotMap_.end()) {
+  if (idx == knots_.size()) {
 
    // If we allow extrapolation, return constant-velocity interpolated entry
    if (allowExtrapolation_) {
-     --it1; // should be safe, as we checked that the map was not empty..
-     const SteamTrajVar::Ptr& endKnot = it1->second;
+     const SteamTrajVar::Ptr& endKnot = knots_.back();
      return endKnot->getVelocity()->getValue();
    } else {
      throw std::runtime_error("Requested trajectory evaluator at an invalid time.");
@@ -170,26 +177,27 @@ Eigen::VectorXd SteamTrajInterface::getVelocity(const steam::Time& time) {
   }
 
   // Check if we requested time exactly
-  if (it1->second->getTime() == time) {
-     const SteamTrajVar::Ptr& knot = it1->second;
+  if (knots_.at(idx)->getTime() == time) {
+     const SteamTrajVar::Ptr& knot = knots_.at(idx);
      // return state variable exactly (no interp)
      return knot->getVelocity()->getValue();
   }
 
   // Check if we requested before first time
-  if (it1 == knotMap_.begin()) {
+  if (idx == 0) {
     // If we allow extrapolation, return constant-velocity interpolated entry
     if (allowExtrapolation_) {
-     const SteamTrajVar::Ptr& startKnot = it1->second;
+     const SteamTrajVar::Ptr& startKnot = knots_.front();
      return startKnot->getVelocity()->getValue();
     } else {
      throw std::runtime_error("Requested trajectory evaluator at an invalid time.");
     }
   }
 
-  // Get iterators bounding the time interval
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it2 = it1; --it1;
-  if (time <= it1->second->getTime() || time >= it2->second->getTime()) {
+  // Get knots bounding the time interval
+  const SteamTrajVar::Ptr& knot1 = knots_.at(idx-1);
+  const SteamTrajVar::Ptr& knot2 = knots_.at(idx);
+  if (time <= knot1->getTime() || time >= knot2->getTime()) {
     throw std::runtime_error("Requested trajectory evaluator at an invalid time. This exception "
                             "should not trigger... report to a STEAM contributor.");
   }
@@ -197,10 +205,6 @@ Eigen::VectorXd SteamTrajInterface::getVelocity(const steam::Time& time) {
   // OK, we actually need to interpolate.
   // Follow a similar setup to SteamTrajPoseInterpEval
 
-  // Convenience defs
-  auto &knot1 = it1->second;
-  auto &knot2 = it2->second;
-
   // Calculate time constants
   double tau = (time - knot1->getTime()).seconds();
   double T = (knot2->getTime() - knot1->getTime()).seconds();
@@ -244,6 +248,367 @@ Eigen::VectorXd SteamTrajInterface::getVelocity(const steam::Time& time) {
    return xi_it;
  }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Sweep a sorted vector of times against the knots
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajInterface::sweepKnots(const std::vector<steam::Time>& times,
+                                    std::vector<int>* knotIndices,
+                                    std::vector<int>* intervals) const {
+
+  // Check that map is not empty
+  if (knots_.empty()) {
+    throw std::runtime_error("[GpTrajectory][sweepKnots] map was empty");
+  }
+
+  // Check that the query times are sorted
+  for (unsigned int i = 1; i < times.size(); i++) {
+    if (times[i] < times[i-1]) {
+      throw std::invalid_argument("[GpTrajectory][sweepKnots] query times must be sorted.");
+    }
+  }
+
+  // Check extrapolation (only the first and last times need to be checked, as they are sorted)
+  if (!times.empty() && !allowExtrapolation_ &&
+      (times.front() < knots_.front()->getTime() || times.back() > knots_.back()->getTime())) {
+    throw std::runtime_error("Requested trajectory evaluator at an invalid time.");
+  }
+
+  // Single sweep over knots and times
+  knotIndices->resize(times.size());
+  if (intervals) {
+    intervals->clear();
+  }
+  int k = -1;
+  for (unsigned int i = 0; i < times.size(); i++) {
+    while (k+1 < int(knots_.size()) && knots_.timeAt(k+1) <= times[i].nanosecs()) {
+      ++k;
+    }
+    (*knotIndices)[i] = k;
+
+    // Record intervals that require interpolation
+    if (intervals && k >= 0 && k+1 < int(knots_.size()) && knots_.timeAt(k) != times[i].nanosecs() &&
+        (intervals->empty() || intervals->back() != k)) {
+      intervals->push_back(k);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compute the interval caches for the provided interval indices
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajInterface::buildIntervalCaches(
+    const std::vector<int>& intervals,
+    std::vector<IntervalCache, Eigen::aligned_allocator<IntervalCache> >* caches) const {
+
+  // Compute the interval quantities (in parallel, as the knot poses may be costly to evaluate)
+  caches->resize(knots_.size() > 0 ? knots_.size() - 1 : 0);
+  #pragma omp parallel for
+  for (int j = 0; j < int(intervals.size()); j++) {
+    const int k = intervals[j];
+    const SteamTrajVar::Ptr& knot1 = knots_.at(k);
+    const SteamTrajVar::Ptr& knot2 = knots_.at(k+1);
+    IntervalCache& cache = (*caches)[k];
+
+    // Get relative matrix info
+    cache.T_10 = knot1->getPose()->evaluate();
+    lgmath::se3::Transformation T_21 = knot2->getPose()->evaluate()/cache.T_10;
+
+    // Get se3 algebra of relative matrix and the velocity terms
+    cache.xi_21 = T_21.vec();
+    cache.w1 = knot1->getVelocity()->getValue();
+    cache.J21inv_w2 = lgmath::se3::vec2jacinv(cache.xi_21)*knot2->getVelocity()->getValue();
+    cache.T = (knot2->getTime() - knot1->getTime()).seconds();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get transform evaluators for a batch of sorted times
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<TransformEvaluator::ConstPtr> SteamTrajInterface::getInterpPoseEvals(
+    const std::vector<steam::Time>& times) const {
+
+  // Find the knots associated with each time
+  std::vector<int> knotIndices;
+  this->sweepKnots(times, &knotIndices);
+
+  // Create evaluators
+  std::vector<TransformEvaluator::ConstPtr> result(times.size());
+  #pragma omp parallel for
+  for (int i = 0; i < int(times.size()); i++) {
+    const int k = knotIndices[i];
+    if (k < 0 || (k+1 == int(knots_.size()) && knots_.at(k)->getTime() != times[i])) {
+
+      // Extrapolate (constant velocity) from the first or last knot
+      const SteamTrajVar::Ptr& knot = knots_.at(k < 0 ? 0 : k);
+      TransformEvaluator::Ptr T_t_k =
+          ConstVelTransformEvaluator::MakeShared(knot->getVelocity(), times[i] - knot->getTime());
+      result[i] = compose(T_t_k, knot->getPose());
+    } else if (knots_.at(k)->getTime() == times[i]) {
+
+      // Return state variable exactly (no interp)
+      result[i] = knots_.at(k)->getPose();
+    } else {
+
+      // Create interpolated evaluator
+      result[i] = SteamTrajPoseInterpEval::MakeShared(times[i], knots_.at(k), knots_.at(k+1));
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get interpolated pose values for a batch of sorted times
+//////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<lgmath::se3::Transformation> SteamTrajInterface::getInterpPoses(
+    const std::vector<steam::Time>& times) const {
+
+  // Find the knots associated with each time, and cache the interval quantities
+  std::vector<int> knotIndices;
+  std::vector<int> intervals;
+  this->sweepKnots(times, &knotIndices, &intervals);
+  std::vector<IntervalCache, Eigen::aligned_allocator<IntervalCache> > caches;
+  this->buildIntervalCaches(intervals, &caches);
+
+  // Interpolate
+  std::vector<lgmath::se3::Transformation> result(times.size());
+  #pragma omp parallel for
+  for (int i = 0; i < int(times.size()); i++) {
+    const int k = knotIndices[i];
+    if (k < 0 || (k+1 == int(knots_.size()) && knots_.at(k)->getTime() != times[i])) {
+
+      // Extrapolate (constant velocity) from the first or last knot
+      const SteamTrajVar::Ptr& knot = knots_.at(k < 0 ? 0 : k);
+      Eigen::Matrix<double,6,1> xi = (times[i] - knot->getTime()).seconds() *
+                                     knot->getVelocity()->getValue();
+      result[i] = lgmath::se3::Transformation(xi)*knot->getPose()->evaluate();
+    } else if (knots_.at(k)->getTime() == times[i]) {
+
+      // Return state variable exactly (no interp)
+      result[i] = knots_.at(k)->getPose()->evaluate();
+    } else {
+
+      // Calculate time constants
+      const IntervalCache& cache = caches[k];
+      double tau = (times[i] - knots_.at(k)->getTime()).seconds();
+      double ratio = tau/cache.T;
+      double ratio2 = ratio*ratio;
+      double ratio3 = ratio2*ratio;
+
+      // Calculate 'psi' and 'lambda' interpolation values
+      double psi11 = 3.0*ratio2 - 2.0*ratio3;
+      double psi12 = tau*(ratio2 - ratio);
+      double lambda12 = tau - cache.T*psi11 - psi12;
+
+      // Calculate interpolated relative se3 algebra
+      Eigen::Matrix<double,6,1> xi_i1 = lambda12*cache.w1 +
+                                        psi11*cache.xi_21 +
+                                        psi12*cache.J21inv_w2;
+
+      // Return `global' interpolated transform
+      result[i] = lgmath::se3::Transformation(xi_i1)*cache.T_10;
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get interpolated velocities for a batch of sorted times (one column per time)
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Matrix<double,6,Eigen::Dynamic> SteamTrajInterface::getVelocities(
+    const std::vector<steam::Time>& times) const {
+
+  // Find the knots associated with each time, and cache the interval quantities
+  std::vector<int> knotIndices;
+  std::vector<int> intervals;
+  this->sweepKnots(times, &knotIndices, &intervals);
+  std::vector<IntervalCache, Eigen::aligned_allocator<IntervalCache> > caches;
+  this->buildIntervalCaches(intervals, &caches);
+
+  // Interpolate
+  Eigen::Matrix<double,6,Eigen::Dynamic> result(6, times.size());
+  #pragma omp parallel for
+  for (int i = 0; i < int(times.size()); i++) {
+    const int k = knotIndices[i];
+    if (k < 0 || knots_.at(k)->getTime() == times[i] || k+1 == int(knots_.size())) {
+
+      // Extrapolated (constant velocity) or exact knot velocity
+      result.col(i) = knots_.at(k < 0 ? 0 : k)->getVelocity()->getValue();
+    } else {
+
+      // Calculate time constants
+      const IntervalCache& cache = caches[k];
+      double tau = (times[i] - knots_.at(k)->getTime()).seconds();
+      double ratio = tau/cache.T;
+      double ratio2 = ratio*ratio;
+      double ratio3 = ratio2*ratio;
+
+      // Calculate 'psi' and 'lambda' interpolation values
+      double psi11 = 3.0*ratio2 - 2.0*ratio3;
+      double psi12 = tau*(ratio2 - ratio);
+      double psi21 = 6.0*(ratio - ratio2)/cache.T;
+      double psi22 = 3.0*ratio2 - 2.0*ratio;
+      double lambda12 = tau - cache.T*psi11 - psi12;
+      double lambda22 = 1.0 - cache.T*psi21 - psi22;
+
+      // Calculate interpolated relative se3 algebra
+      Eigen::Matrix<double,6,1> xi_i1 = lambda12*cache.w1 +
+                                        psi11*cache.xi_21 +
+                                        psi12*cache.J21inv_w2;
+
+      // Calculate interpolated velocity
+      result.col(i) = lgmath::se3::vec2jac(xi_i1)*(lambda22*cache.w1 +
+                                                   psi21*cache.xi_21 +
+                                                   psi22*cache.J21inv_w2);
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief De-skew a point cloud into the vehicle frame at a reference time
+//////////////////////////////////////////////////////////////////////////////////////////////
+Eigen::Matrix<double,Eigen::Dynamic,3> SteamTrajInterface::deskewPointCloud(
+    const std::vector<steam::Time>& times,
+    const Eigen::Matrix<double,Eigen::Dynamic,3>& points,
+    const steam::Time& refTime) const {
+
+  // Check inputs
+  if (int(times.size()) != points.rows()) {
+    throw std::invalid_argument("[GpTrajectory][deskewPointCloud] number of times and points "
+                                "must match.");
+  }
+
+  // Get reference pose (also checks that the map is not empty, and the reference time is valid)
+  std::vector<steam::Time> refTimes(1, refTime);
+  lgmath::se3::Transformation T_ref_0 = this->getInterpPoses(refTimes)[0];
+
+  const int numKnots = knots_.size();
+  const int numPoints = times.size();
+
+  // Bin points by knot interval. Bin 0 holds points before the first knot, bin k+1 holds
+  // points in [t_k, t_k+1), and the last bin holds points at or after the final knot. Note the
+  // lookup is a direct index computation when the knots are uniformly spaced.
+  std::vector<int> bin(numPoints);
+  #pragma omp parallel for
+  for (int i = 0; i < numPoints; i++) {
+    bin[i] = knots_.upperBound(times[i]);
+  }
+
+  // Check extrapolation
+  if (!allowExtrapolation_ && numPoints > 0) {
+    std::pair<std::vector<steam::Time>::const_iterator,
+              std::vector<steam::Time>::const_iterator> range =
+        std::minmax_element(times.begin(), times.end());
+    if (*range.first < knots_.front()->getTime() || *range.second > knots_.back()->getTime()) {
+      throw std::runtime_error("Requested trajectory evaluator at an invalid time.");
+    }
+  }
+
+  // Count the points in each bin
+  std::vector<int> binOffsets(numKnots + 2, 0);
+  for (int i = 0; i < numPoints; i++) {
+    binOffsets[bin[i]+1]++;
+  }
+
+  // Counting sort of the points by bin (stable, so that points stay in order within a bin)
+  for (int b = 0; b <= numKnots; b++) {
+    binOffsets[b+1] += binOffsets[b];
+  }
+  std::vector<int> perm(numPoints);
+  std::vector<int> binFill(binOffsets.begin(), binOffsets.end() - 1);
+  for (int i = 0; i < numPoints; i++) {
+    perm[binFill[bin[i]]++] = i;
+  }
+
+  // Compute the interval quantities of the occupied interior bins
+  std::vector<int> intervals;
+  for (int k = 0; k + 1 < numKnots; k++) {
+    if (binOffsets[k+2] > binOffsets[k+1]) {
+      intervals.push_back(k);
+    }
+  }
+  std::vector<IntervalCache, Eigen::aligned_allocator<IntervalCache> > caches;
+  this->buildIntervalCaches(intervals, &caches);
+
+  // Extrapolation is constant velocity from the end knots, which is the same as interpolation
+  // with lambda12 = tau, and all other terms zero
+  IntervalCache frontCache;
+  frontCache.T_10 = knots_.front()->getPose()->evaluate();
+  frontCache.w1 = knots_.front()->getVelocity()->getValue();
+  frontCache.xi_21 = frontCache.J21inv_w2 = Eigen::Matrix<double,6,1>::Zero();
+  frontCache.T = 0.0;
+  IntervalCache backCache = frontCache;
+  backCache.T_10 = knots_.back()->getPose()->evaluate();
+  backCache.w1 = knots_.back()->getVelocity()->getValue();
+
+  // Evaluate the interpolation coefficients, vectorized over the (contiguous) points of each bin
+  Eigen::ArrayXd lambda12(numPoints);
+  Eigen::ArrayXd psi11(numPoints);
+  Eigen::ArrayXd psi12(numPoints);
+  #pragma omp parallel for schedule(dynamic)
+  for (int b = 0; b <= numKnots; b++) {
+    const int start = binOffsets[b];
+    const int size = binOffsets[b+1] - start;
+    if (size == 0) {
+      continue;
+    }
+
+    // Get time since the knot at the start of the bin
+    const boost::int64_t t1 = knots_.timeAt(b > 0 ? b - 1 : 0);
+    Eigen::ArrayXd tau(size);
+    for (int j = 0; j < size; j++) {
+      tau[j] = 1e-9*static_cast<double>(times[perm[start + j]].nanosecs() - t1);
+    }
+
+    if (b == 0 || b == numKnots) {
+      lambda12.segment(start, size) = tau;
+      psi11.segment(start, size).setZero();
+      psi12.segment(start, size).setZero();
+    } else {
+      const double T = caches[b-1].T;
+      Eigen::ArrayXd ratio = tau/T;
+      Eigen::ArrayXd ratio2 = ratio*ratio;
+      psi11.segment(start, size) = 3.0*ratio2 - 2.0*ratio2*ratio;
+      psi12.segment(start, size) = tau*(ratio2 - ratio);
+      lambda12.segment(start, size) = tau - T*psi11.segment(start, size) -
+                                      psi12.segment(start, size);
+    }
+  }
+
+  // Compute the relative transform (T_ref_t) for each point, stored as structure-of-arrays
+  Eigen::Matrix<double,Eigen::Dynamic,12> T_ref_t(numPoints, 12);
+  #pragma omp parallel for schedule(dynamic)
+  for (int b = 0; b <= numKnots; b++) {
+    const IntervalCache& cache = (b == 0) ? frontCache : (b == numKnots ? backCache : caches[b-1]);
+    for (int j = binOffsets[b]; j < binOffsets[b+1]; j++) {
+
+      // Calculate interpolated relative se3 algebra
+      Eigen::Matrix<double,6,1> xi_i1 = lambda12[j]*cache.w1 +
+                                        psi11[j]*cache.xi_21 +
+                                        psi12[j]*cache.J21inv_w2;
+
+      // Calculate the transform from the point's vehicle frame to the reference frame
+      lgmath::se3::Transformation T_t_0 = lgmath::se3::Transformation(xi_i1)*cache.T_10;
+      Eigen::Matrix4d T = (T_ref_0/T_t_0).matrix();
+      const int i = perm[j];
+      for (int c = 0; c < 3; c++) {
+        T_ref_t.block<1,3>(i, 3*c) = T.block<1,3>(c, 0);
+        T_ref_t(i, 9 + c) = T(c, 3);
+      }
+    }
+  }
+
+  // Apply transforms (vectorized over the structure-of-arrays)
+  Eigen::Matrix<double,Eigen::Dynamic,3> result(numPoints, 3);
+  for (int c = 0; c < 3; c++) {
+    result.col(c) = T_ref_t.col(3*c).cwiseProduct(points.col(0)) +
+                    T_ref_t.col(3*c + 1).cwiseProduct(points.col(1)) +
+                    T_ref_t.col(3*c + 2).cwiseProduct(points.col(2)) +
+                    T_ref_t.col(9 + c);
+  }
+  return result;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Add a unary pose prior factor at a knot time. Note that only a single pose prior
 ///        should exist on a trajectory, adding a second will overwrite the first.
@@ -253,18 +618,18 @@ void SteamTrajInterface::addPosePrior(const steam::Time& time,
                                       const Eigen::Matrix<double,6,6>& cov) {
 
   // Check that map is not empty
-  if (knotMap_.empty()) {
+  if (knots_.empty()) {
     throw std::runtime_error("[GpTrajectory][addPosePrior] map was empty.");
   }
 
   // Try to find knot at same time
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it = knotMap_.find(time.nanosecs());
-  if (it == knotMap_.end()) {
+  unsigned int idx = knots_.find(time);
+  if (idx == knots_.size()) {
     throw std::runtime_error("[GpTrajectory][addPosePrior] no knot at provided time.");
   }
 
   // Get reference
-  const SteamTrajVar::Ptr& knotRef = it->second;
+  const SteamTrajVar::Ptr& knotRef = knots_.at(idx);
 
   // Check that the pose is not locked
   if(!knotRef->getPose()->isActive()) {
@@ -290,18 +655,18 @@ void SteamTrajInterface::addVelocityPrior(const steam::Time& time,
                                           const Eigen::Matrix<double,6,6>& cov) {
 
   // Check that map is not empty
-  if (knotMap_.empty()) {
+  if (knots_.empty()) {
     throw std::runtime_error("[GpTrajectory][addVelocityPrior] map was empty.");
   }
 
   // Try to find knot at same time
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it = knotMap_.find(time.nanosecs());
-  if (it == knotMap_.end()) {
+  unsigned int idx = knots_.find(time);
+  if (idx == knots_.size()) {
     throw std::runtime_error("[GpTrajectory][addVelocityPrior] no knot at provided time.");
   }
 
   // Get reference
-  const SteamTrajVar::Ptr& knotRef = it->second;
+  const SteamTrajVar::Ptr& knotRef = knots_.at(idx);
 
   // Check that the pose is not locked
   if(knotRef->getVelocity()->isLocked()) {
@@ -325,7 +690,7 @@ void SteamTrajInterface::appendPriorCostTerms(
     const ParallelizedCostTermCollection::Ptr& costTerms) const {
 
   // If empty, return none
-  if (knotMap_.empty()) {
+  if (knots_.empty()) {
     return;
   }
 
@@ -340,19 +705,12 @@ void SteamTrajInterface::appendPriorCostTerms(
   // All prior factors will use an L2 loss function
   steam::L2LossFunc::Ptr sharedLossFunc(new steam::L2LossFunc());
 
-  // Initialize first iterator
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it1 = knotMap_.begin();
-  if (it1 == knotMap_.end()) {
-    throw std::runtime_error("No knots...");
-  }
-
   // Iterate through all states.. if any are unlocked, supply a prior term
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it2 = it1; ++it2;
-  for (; it2 != knotMap_.end(); ++it1, ++it2) {
+  for (unsigned int i = 1; i < knots_.size(); i++) {
 
     // Get knots
-    const SteamTrajVar::ConstPtr& knot1 = it1->second;
-    const SteamTrajVar::ConstPtr& knot2 = it2->second;
+    const SteamTrajVar::ConstPtr& knot1 = knots_.at(i-1);
+    const SteamTrajVar::ConstPtr& knot2 = knots_.at(i);
 
     // Check if any of the variables are unlocked
     if(knot1->getPose()->isActive()  || !knot1->getVelocity()->isLocked() ||
@@ -366,14 +724,14 @@ void SteamTrajInterface::appendPriorCostTerms(
       Qi_inv.block<6,6>(0,0) = 12.0 * one_over_dt3 * Qc_inv_;
       Qi_inv.block<6,6>(6,0) = Qi_inv.block<6,6>(0,6) = -6.0 * one_over_dt2 * Qc_inv_;
       Qi_inv.block<6,6>(6,6) = 4.0 * one_over_dt  * Qc_inv_;
-      steam::BaseNoiseModelX::Ptr sharedGPNoiseModel(
-            new steam::StaticNoiseModelX(Qi_inv, steam::INFORMATION));
+      steam::BaseNoiseModel<12>::Ptr sharedGPNoiseModel(
+            new steam::StaticNoiseModel<12>(Qi_inv, steam::INFORMATION));
 
       // Create cost term
       steam::se3::SteamTrajPriorFactor::Ptr errorfunc(
             new steam::se3::SteamTrajPriorFactor(knot1, knot2));
-      steam::WeightedLeastSqCostTermX::Ptr cost(
-            new steam::WeightedLeastSqCostTermX(errorfunc, sharedGPNoiseModel, sharedLossFunc));
+      steam::WeightedLeastSqCostTerm<12,6>::Ptr cost(
+            new steam::WeightedLeastSqCostTerm<12,6>(errorfunc, sharedGPNoiseModel, sharedLossFunc));
       costTerms->add(cost);
     }
   }
@@ -386,15 +744,15 @@ void SteamTrajInterface::getActiveStateVariables(
     std::map<unsigned int, steam::StateVariableBase::Ptr>* outStates) const {
 
   // Iterate over trajectory
-  std::map<boost::int64_t, SteamTrajVar::Ptr>::const_iterator it;
-  for (it = knotMap_.begin(); it != knotMap_.end(); ++it) {
+  for (unsigned int i = 0; i < knots_.size(); i++) {
+    const SteamTrajVar::Ptr& knot = knots_.at(i);
 
     // Append active states in transform evaluator
-    it->second->getPose()->getActiveStateVariables(outStates);
+    knot->getPose()->getActiveStateVariables(outStates);
 
     // Check if velocity is locked
-    if (!it->second->getVelocity()->isLocked()) {
-      (*outStates)[it->second->getVelocity()->getKey().getID()] = it->second->getVelocity();
+    if (!knot->getVelocity()->isLocked()) {
+      (*outStates)[knot->getVelocity()->getKey().getID()] = knot->getVelocity();
     }
   }
 }
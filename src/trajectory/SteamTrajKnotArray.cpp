@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \file SteamTrajKnotArray.cpp
+///
+/// \author Sean Anderson, ASRL
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <steam/trajectory/SteamTrajKnotArray.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace steam {
+namespace se3 {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Constructor
+//////////////////////////////////////////////////////////////////////////////////////////////
+SteamTrajKnotArray::SteamTrajKnotArray() : begin_(0), uniform_(true), spacing_(0) {
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Insert a knot
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajKnotArray::insert(const SteamTrajVar::Ptr& knot) {
+
+  const boost::int64_t time = knot->getTime().nanosecs();
+
+  // Fast path, append after the latest knot
+  if (this->empty() || time > times_.back()) {
+
+    // Update uniformity
+    if (this->size() == 1) {
+      spacing_ = time - times_.back();
+    } else if (this->size() > 1) {
+      uniform_ = uniform_ && (time - times_.back() == spacing_);
+    }
+
+    knots_.push_back(knot);
+    times_.push_back(time);
+    return;
+  }
+
+  // Insert in order
+  std::vector<boost::int64_t>::iterator it =
+      std::lower_bound(times_.begin() + begin_, times_.end(), time);
+  if (*it == time) {
+    throw std::invalid_argument("[SteamTrajKnotArray][insert] a knot already exists at this time.");
+  }
+  const unsigned int idx = it - times_.begin();
+  knots_.insert(knots_.begin() + idx, knot);
+  times_.insert(it, time);
+  this->updateUniformity();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Drop the earliest 'num' knots
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajKnotArray::dropFront(unsigned int num) {
+
+  // Drop knots (release references immediately)
+  num = std::min(num, this->size());
+  for (unsigned int i = begin_; i < begin_ + num; i++) {
+    knots_[i].reset();
+  }
+  begin_ += num;
+
+  // Compact storage once the dropped knots make up half of it
+  if (2*begin_ >= knots_.size()) {
+    knots_.erase(knots_.begin(), knots_.begin() + begin_);
+    times_.erase(times_.begin(), times_.begin() + begin_);
+    begin_ = 0;
+  }
+
+  // Uniform knots remain uniform, otherwise the remaining knots may have become uniform
+  if (!uniform_ || this->size() < 2) {
+    this->updateUniformity();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Drop all knots strictly before a time
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajKnotArray::dropBefore(const steam::Time& time) {
+  this->dropFront(this->lowerBound(time));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Remove all knots
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajKnotArray::clear() {
+  knots_.clear();
+  times_.clear();
+  begin_ = 0;
+  uniform_ = true;
+  spacing_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the index of the first knot with time equal to or greater than 'time'
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int SteamTrajKnotArray::lowerBound(const steam::Time& time) const {
+
+  const boost::int64_t t = time.nanosecs();
+  if (this->empty() || t <= times_[begin_]) {
+    return 0;
+  } else if (t > times_.back()) {
+    return this->size();
+  }
+
+  // Direct index for uniformly spaced knots (round up to the next knot)
+  if (uniform_) {
+    return (t - times_[begin_] + spacing_ - 1)/spacing_;
+  }
+
+  return std::lower_bound(times_.begin() + begin_, times_.end(), t) - (times_.begin() + begin_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the index of the first knot with time greater than 'time'
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int SteamTrajKnotArray::upperBound(const steam::Time& time) const {
+
+  const boost::int64_t t = time.nanosecs();
+  if (this->empty() || t < times_[begin_]) {
+    return 0;
+  } else if (t >= times_.back()) {
+    return this->size();
+  }
+
+  // Direct index for uniformly spaced knots (round down, plus one)
+  if (uniform_) {
+    return (t - times_[begin_])/spacing_ + 1;
+  }
+
+  return std::upper_bound(times_.begin() + begin_, times_.end(), t) - (times_.begin() + begin_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the index of the knot at exactly 'time' (returns size() if there is none)
+//////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int SteamTrajKnotArray::find(const steam::Time& time) const {
+  unsigned int idx = this->lowerBound(time);
+  if (idx < this->size() && this->timeAt(idx) == time.nanosecs()) {
+    return idx;
+  }
+  return this->size();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Recompute the uniform spacing flag from scratch
+//////////////////////////////////////////////////////////////////////////////////////////////
+void SteamTrajKnotArray::updateUniformity() {
+  uniform_ = true;
+  spacing_ = this->size() > 1 ? times_[begin_ + 1] - times_[begin_] : 0;
+  for (unsigned int i = begin_ + 2; i < times_.size() && uniform_; i++) {
+    uniform_ = (times_[i] - times_[i-1] == spacing_);
+  }
+}
+
+} // se3
+} // steam
@@ -139,13 +139,12 @@ EvalTreeNode<lgmath::se3::Transformation>* SteamTrajPoseInterpEval::evaluateTree
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Implementation for Block Automatic Differentiation
+/// \brief Evaluate the Jacobian tree
 //////////////////////////////////////////////////////////////////////////////////////////////
-template<int LHS_DIM, int INNER_DIM, int MAX_STATE_SIZE>
-void SteamTrajPoseInterpEval::appendJacobiansImpl(
-    const Eigen::Matrix<double,LHS_DIM,INNER_DIM>& lhs,
+void SteamTrajPoseInterpEval::appendJacobianRows(
+    const Eigen::Ref<const LhsBlock>& lhs,
     EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<LHS_DIM,MAX_STATE_SIZE> >* outJacobians) const {
+    JacobianSink<6>* outJacobians) const {
 
   // Cast back to transformations
   EvalTreeNode<lgmath::se3::Transformation>* transform1 =
@@ -186,7 +185,7 @@ void SteamTrajPoseInterpEval::appendJacobiansImpl(
       // Check if transform1 is active
       if (knot1_->getPose()->isActive()) {
         Eigen::Matrix<double,6,6> jacobian = (-1) * w * T_21.adjoint() + T_i1.adjoint();
-        knot1_->getPose()->appendBlockAutomaticJacobians(lhs*jacobian, transform1, outJacobians);
+        knot1_->getPose()->appendJacobianRows(lhs*jacobian, transform1, outJacobians);
       }
 
       // Get index of split between left and right-hand-side of Jacobians
@@ -194,18 +193,18 @@ void SteamTrajPoseInterpEval::appendJacobiansImpl(
 
       // Check if transform2 is active
       if (knot2_->getPose()->isActive()) {
-        knot2_->getPose()->appendBlockAutomaticJacobians(lhs*w, transform2, outJacobians);
+        knot2_->getPose()->appendJacobianRows(lhs*w, transform2, outJacobians);
       }
 
       // Merge jacobians
-      Jacobian<LHS_DIM,MAX_STATE_SIZE>::merge(outJacobians, hintIndex);
+      outJacobians->merge(hintIndex);
     }
 
     // 6 x 6 Velocity Jacobian 1
     if(!knot1_->getVelocity()->isLocked()) {
 
       // Add Jacobian
-      outJacobians->push_back(Jacobian<LHS_DIM,MAX_STATE_SIZE>(knot1_->getVelocity()->getKey(), lhs*lambda12_*J_i1));
+      outJacobians->add(knot1_->getVelocity()->getKey(), lhs*lambda12_*J_i1);
     }
 
     // 6 x 6 Velocity Jacobian 2
@@ -213,70 +212,11 @@ void SteamTrajPoseInterpEval::appendJacobiansImpl(
 
       // Add Jacobian
       Eigen::Matrix<double,6,6> jacobian = psi12_*J_i1*J_21_inv;
-      outJacobians->push_back(Jacobian<LHS_DIM,MAX_STATE_SIZE>(knot2_->getVelocity()->getKey(), lhs*jacobian));
+      outJacobians->add(knot2_->getVelocity()->getKey(), lhs*jacobian);
     }
   }
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Evaluate the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void SteamTrajPoseInterpEval::appendBlockAutomaticJacobians(
-    const Eigen::MatrixXd& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Fixed-size evaluations of the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void SteamTrajPoseInterpEval::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,1,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<1,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Fixed-size evaluations of the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void SteamTrajPoseInterpEval::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,2,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<2,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Fixed-size evaluations of the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void SteamTrajPoseInterpEval::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,3,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<3,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Fixed-size evaluations of the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void SteamTrajPoseInterpEval::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,4,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<4,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief Fixed-size evaluations of the Jacobian tree
-//////////////////////////////////////////////////////////////////////////////////////////////
-void SteamTrajPoseInterpEval::appendBlockAutomaticJacobians(
-    const Eigen::Matrix<double,6,6>& lhs,
-    EvalTreeNode<lgmath::se3::Transformation>* evaluationTree,
-    std::vector<Jacobian<6,6> >* outJacobians) const {
-  this->appendJacobiansImpl(lhs,evaluationTree, outJacobians);
-}
-
 } // se3
+
 } // steam
@@ -30,7 +30,7 @@ bool SteamTrajPriorFactor::isActive() const {
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Evaluate the GP prior factor
 //////////////////////////////////////////////////////////////////////////////////////////////
-Eigen::VectorXd SteamTrajPriorFactor::evaluate() const {
+Eigen::Matrix<double,12,1> SteamTrajPriorFactor::evaluate() const {
 
   // Precompute values
   lgmath::se3::Transformation T_21 = knot2_->getPose()->evaluate()/knot1_->getPose()->evaluate();
@@ -47,8 +47,9 @@ Eigen::VectorXd SteamTrajPriorFactor::evaluate() const {
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief Evaluate the GP prior factor and Jacobians
 //////////////////////////////////////////////////////////////////////////////////////////////
-Eigen::VectorXd SteamTrajPriorFactor::evaluate(const Eigen::MatrixXd& lhs,
-                                            std::vector<Jacobian<> >* jacs) const {
+Eigen::Matrix<double,12,1> SteamTrajPriorFactor::evaluate(
+    const Eigen::Matrix<double,12,12>& lhs,
+    std::vector<Jacobian<12,6> >* jacs) const {
 
   // Check and initialize jacobian array
   if (jacs == NULL) {
@@ -96,14 +97,14 @@ Eigen::VectorXd SteamTrajPriorFactor::evaluate(const Eigen::MatrixXd& lhs,
 
   // Merge jacobians (transform evaluators from knots 1 and 2 could contain the same
   // state variables, in which case we need to merge)
-  Jacobian<>::merge(jacs, hintIndex);
+  Jacobian<12,6>::merge(jacs, hintIndex);
 
   // Knot 1 velocity
   if(!knot1_->getVelocity()->isLocked()) {
 
     // Construct Jacobian Object
-    jacs->push_back(Jacobian<>());
-    Jacobian<>& jacref = jacs->back();
+    jacs->push_back(Jacobian<12,6>());
+    Jacobian<12,6>& jacref = jacs->back();
     jacref.key = knot1_->getVelocity()->getKey();
 
     // Fill in matrix
@@ -117,8 +118,8 @@ Eigen::VectorXd SteamTrajPriorFactor::evaluate(const Eigen::MatrixXd& lhs,
   if(!knot2_->getVelocity()->isLocked()) {
 
     // Construct Jacobian Object
-    jacs->push_back(Jacobian<>());
-    Jacobian<>& jacref = jacs->back();
+    jacs->push_back(Jacobian<12,6>());
+    Jacobian<12,6>& jacref = jacs->back();
     jacref.key = knot2_->getVelocity()->getKey();
 
     // Fill in matrix
@@ -0,0 +1,166 @@
+#include "catch.hpp"
+
+#include <steam.hpp>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Compare the fixed-size Jacobians of a transform evaluator against the dynamic path
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<int LHS_DIM>
+void checkFixedSizeJacobians(const steam::se3::TransformEvaluator::ConstPtr& eval) {
+
+  Eigen::Matrix<double,LHS_DIM,6> lhs;
+  for (int i = 0; i < LHS_DIM; i++) {
+    for (int j = 0; j < 6; j++) {
+      lhs(i,j) = 0.1*(i+1) - 0.3*j + 0.01*i*j;
+    }
+  }
+
+  steam::EvalTreeHandle<lgmath::se3::Transformation> tree = eval->getBlockAutomaticEvaluation();
+  std::vector<steam::Jacobian<LHS_DIM,6> > fixedJacs;
+  std::vector<steam::Jacobian<> > dynamicJacs;
+  eval->appendBlockAutomaticJacobians(lhs, tree.getRoot(), &fixedJacs);
+  eval->appendBlockAutomaticJacobians(Eigen::MatrixXd(lhs), tree.getRoot(), &dynamicJacs);
+
+  REQUIRE( fixedJacs.size() == dynamicJacs.size() );
+  for (unsigned int i = 0; i < fixedJacs.size(); i++) {
+    INFO("lhs dim: " << LHS_DIM << ", jacobian: " << i);
+    CHECK( fixedJacs[i].key.equals(dynamicJacs[i].key) );
+    CHECK( (Eigen::MatrixXd(fixedJacs[i].jac) - dynamicJacs[i].jac).norm() < 1e-12 );
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Block-automatic Jacobians
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("fixed-size block-automatic Jacobians match the dynamic path", "[evaluator]" ) {
+
+  Eigen::Matrix<double,6,1> xi1; xi1 << 0.1, -0.2, 0.3, 0.05, -0.1, 0.2;
+  Eigen::Matrix<double,6,1> xi2; xi2 << 0.6, 0.1, -0.2, -0.1, 0.2, 0.4;
+  steam::se3::TransformStateVar::Ptr state1(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi1)));
+  steam::se3::TransformStateVar::Ptr state2(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi2)));
+
+  // Composite evaluator with two active states
+  steam::se3::TransformEvaluator::Ptr eval = steam::se3::compose(
+        steam::se3::inverse(steam::se3::TransformStateEvaluator::MakeShared(state1)),
+        steam::se3::TransformStateEvaluator::MakeShared(state2));
+
+  checkFixedSizeJacobians<5>(eval);  // single block of rows
+  checkFixedSizeJacobians<12>(eval); // single block of rows
+  checkFixedSizeJacobians<15>(eval); // blocks of 12 + 3 rows
+  checkFixedSizeJacobians<30>(eval); // blocks of 12 + 12 + 6 rows
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Landmark noise evaluator
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("landmark noise is only recomputed when the pose changes", "[evaluator]" ) {
+
+  steam::stereo::CameraIntrinsics::Ptr intrinsics(new steam::stereo::CameraIntrinsics());
+  intrinsics->b = 0.24; intrinsics->fu = 400.0; intrinsics->fv = 400.0;
+  intrinsics->cu = 320.0; intrinsics->cv = 240.0;
+  Eigen::Vector4d mean(0.5, -0.2, 8.0, 1.0);
+  Eigen::Matrix3d landmarkCov = 0.01*Eigen::Matrix3d::Identity();
+  landmarkCov(0,1) = landmarkCov(1,0) = 0.002;
+  Eigen::Matrix4d measNoise = Eigen::Matrix4d::Identity();
+
+  steam::se3::TransformStateVar::Ptr pose(new steam::se3::TransformStateVar());
+  steam::VectorSpaceStateVar::Ptr other(new steam::VectorSpaceStateVar(Eigen::Vector2d::Zero()));
+  boost::shared_ptr<steam::stereo::LandmarkNoiseEvaluator> noiseEval(
+      new steam::stereo::LandmarkNoiseEvaluator(mean, landmarkCov, measNoise, intrinsics,
+          steam::se3::TransformStateEvaluator::MakeShared(pose)));
+  steam::DynamicNoiseModel<4> noiseModel(noiseEval);
+  const steam::StateStamp stamp = noiseEval->getInputStamp();
+  REQUIRE( stamp != 0 );
+
+  // An unrelated state change does not invalidate the covariance
+  other->update(Eigen::Vector2d(1.0, 1.0));
+  CHECK( noiseEval->getInputStamp() == stamp );
+
+  // A pose change does, and matches a freshly constructed evaluator (without diagnostics)
+  Eigen::Matrix<double,6,1> xi; xi << 0.1, 0.2, -0.1, 0.05, -0.02, 0.1;
+  pose->update(xi);
+  CHECK( noiseEval->getInputStamp() != stamp );
+  boost::shared_ptr<steam::stereo::LandmarkNoiseEvaluator> fresh(
+      new steam::stereo::LandmarkNoiseEvaluator(mean, landmarkCov, measNoise, intrinsics,
+          steam::se3::TransformStateEvaluator::MakeShared(pose)));
+  fresh->setDiagnosticChecks(false);
+  steam::DynamicNoiseModel<4> freshModel(fresh);
+  CHECK( (noiseModel.getSqrtInformation() - freshModel.getSqrtInformation()).norm() < 1e-12 );
+  CHECK( (noiseEval->evaluateCovariance() - fresh->evaluateCovariance()).norm() < 1e-12 );
+  CHECK( noiseEval->getDiagnosticFailures() == 0u );
+
+  // Failed diagnostic checks are reported, unless disabled by default
+  Eigen::Matrix3d badCov = -landmarkCov;
+  steam::stereo::LandmarkNoiseEvaluator bad(mean, badCov, measNoise, intrinsics,
+      steam::se3::TransformStateEvaluator::MakeShared(pose));
+  bad.evaluateCovariance();
+  CHECK( (bad.getDiagnosticFailures() & steam::stereo::LandmarkNoiseEvaluator::LANDMARK_COV_NOT_PD) );
+  CHECK( (bad.getDiagnosticFailures() & steam::stereo::LandmarkNoiseEvaluator::QUERY_LANDMARK_COV_NOT_PD) );
+  steam::stereo::LandmarkNoiseEvaluator::setDefaultDiagnosticChecks(false);
+  steam::stereo::LandmarkNoiseEvaluator unchecked(mean, badCov, measNoise, intrinsics,
+      steam::se3::TransformStateEvaluator::MakeShared(pose));
+  steam::stereo::LandmarkNoiseEvaluator::setDefaultDiagnosticChecks(true);
+  unchecked.evaluateCovariance();
+  CHECK( unchecked.getDiagnosticFailures() == 0u );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Batched stereo camera model
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("batched stereo camera model matches single-point evaluation", "[evaluator]" ) {
+
+  steam::stereo::CameraIntrinsics intrinsics;
+  intrinsics.b = 0.24; intrinsics.fu = 480.0; intrinsics.fv = 470.0;
+  intrinsics.cu = 320.0; intrinsics.cv = 240.0;
+
+  const int numPoints = 37;
+  steam::stereo::PointBatch points(4, numPoints);
+  for (int i = 0; i < numPoints; i++) {
+    points.col(i) << -1.0 + 0.05*i, 0.5 - 0.03*i, 2.0 + 0.2*i, 1.0/(1.0 + 0.01*i);
+  }
+  steam::stereo::PointBatch projections(4, numPoints);
+  steam::stereo::JacobianBatch jacobians(16, numPoints);
+  steam::stereo::cameraModelBatch(intrinsics, points, projections, jacobians);
+
+  for (int i = 0; i < numPoints; i++) {
+    const Eigen::Vector4d p = points.col(i);
+    Eigen::Vector4d expected;
+    expected << intrinsics.fu*p[0]/p[2] + intrinsics.cu, intrinsics.fv*p[1]/p[2] + intrinsics.cv,
+                intrinsics.fu*(p[0] - p[3]*intrinsics.b)/p[2] + intrinsics.cu,
+                intrinsics.fv*p[1]/p[2] + intrinsics.cv;
+    Eigen::Matrix4d jac;
+    for (int r = 0; r < 16; r++) {
+      jac.data()[r] = jacobians(r, i);
+    }
+    INFO("point: " << i);
+    CHECK( (projections.col(i) - expected).norm() < 1e-9 );
+    CHECK( (jac - steam::stereo::cameraModelJacobian(intrinsics, p)).norm() < 1e-9 );
+  }
+  steam::stereo::PointBatch tooFew(4, numPoints - 1);
+  REQUIRE_THROWS( steam::stereo::cameraModelBatch(intrinsics, points, tooFew) );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Monocular camera model
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("monocular camera model Jacobian matches finite differences", "[evaluator]" ) {
+
+  steam::mono::CameraIntrinsics intrinsics;
+  intrinsics.fu = 500.0; intrinsics.fv = 490.0; intrinsics.cu = 320.0; intrinsics.cv = 240.0;
+  intrinsics.k1 = -0.2; intrinsics.k2 = 0.05;
+
+  const double h = 1e-6;
+  for (int i = 0; i < 5; i++) {
+    Eigen::Vector4d p; p << -0.8 + 0.4*i, 0.6 - 0.25*i, 1.5 + 0.5*i, 1.0 + 0.1*i;
+    Eigen::Matrix<double,2,4> numerical;
+    for (int j = 0; j < 4; j++) {
+      Eigen::Vector4d dp = Eigen::Vector4d::Zero(); dp[j] = h;
+      numerical.col(j) = (steam::mono::cameraModel(intrinsics, p + dp) -
+                          steam::mono::cameraModel(intrinsics, p - dp))/(2.0*h);
+    }
+    INFO("point: " << i);
+    CHECK( (steam::mono::cameraModelJacobian(intrinsics, p) - numerical).norm() < 1e-4 );
+  }
+} // TEST_CASE
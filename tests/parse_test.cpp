@@ -0,0 +1,359 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#include <Eigen/Geometry>
+
+#include <steam/common/ParseUtils.hpp>
+#include <steam/data/ParseBA.hpp>
+#include <steam/data/ParseBAL.hpp>
+#include <steam/data/ParseG2o.hpp>
+#include <steam/data/ParseSphere.hpp>
+#include <steam/data/SyntheticProblems.hpp>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Fast float parsing
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("in-place number parsing matches strtod", "[parse]" ) {
+
+  const char* fields[] = {"0", "-0.0", "10000.000000", "321.680500", "-95.111694", "1e-3",
+                          "+2.5E+10", "0.000000000000000000001234", "123456789012345678901",
+                          "9007199254740993", "1.7976931348623157e308", "4.9e-324", "1.",
+                          ".5", "-inf"};
+  for (unsigned int i = 0; i < sizeof(fields)/sizeof(fields[0]); i++) {
+    std::string field(fields[i]);
+    INFO("field: " << field);
+    CHECK( steam::parse::parseDouble(field.data(), field.data() + field.size()) ==
+           strtod(field.c_str(), NULL) );
+  }
+
+  // Pseudo-random fixed-point numbers (as written by the dataset generators)
+  unsigned int seed = 1;
+  for (int i = 0; i < 10000; i++) {
+    seed = 1103515245u*seed + 12345u;
+    char buffer[64];
+    int length = snprintf(buffer, sizeof(buffer), "%.*f", int(seed % 10),
+                          (double(seed) - 2147483648.0)/double(1 + (seed >> 20)));
+    INFO("field: " << buffer);
+    REQUIRE( steam::parse::parseDouble(buffer, buffer + length) == strtod(buffer, NULL) );
+  }
+
+  std::string bad[] = {"", "-", "1.2.3", "12a", "e5", "1e"};
+  for (unsigned int i = 0; i < sizeof(bad)/sizeof(bad[0]); i++) {
+    INFO("field: " << bad[i]);
+    CHECK_THROWS( steam::parse::parseDouble(bad[i].data(), bad[i].data() + bad[i].size()) );
+  }
+  std::string id("12,");
+  CHECK( steam::parse::parseInt(id.data(), id.data() + 2) == 12 );
+  CHECK_THROWS( steam::parse::parseInt(id.data(), id.data() + 3) );
+
+  // Delimited fields may be padded with spaces and tabs
+  std::string line("LAND_IC, 7 , 1.500000 ,-2.250000\t,10.125000 ");
+  steam::parse::FieldCursor cursor(line.data(), line.data() + line.size(), ',');
+  const char* begin; const char* end;
+  cursor.next(&begin, &end);
+  CHECK( steam::parse::fieldEquals(begin, end, "LAND_IC") );
+  CHECK( cursor.nextInt() == 7 );
+  CHECK( cursor.nextDouble() == 1.5 );
+  CHECK( cursor.nextDouble() == -2.25 );
+  CHECK( cursor.nextDouble() == 10.125 );
+  CHECK( !cursor.hasNext() );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Dataset parsing
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("memory-mapped dataset parsing, serial and in parallel chunks", "[parse]" ) {
+
+  // Write a BA dataset large enough to be split into several chunks
+  const std::string baFile = "parse_test_ba.txt";
+  const unsigned int numMeas = 40000;
+  {
+    std::ofstream out(baFile.c_str());
+    out << "CAMPARAMS,0.24,484.5,484.5,0.0,0.0\r\n";
+    out << "FRAME_GT,0,10000.000000,0.100000,-0.200000,0.300000,0.010000,0.020000,-0.030000\n";
+    out << "LAND_IC,7,1.500000,-2.250000,10.125000\n";
+    for (unsigned int i = 0; i < numMeas; i++) {
+      out << "STEREO," << i % 61 << "," << i << "," << 10000 + i % 61 << ".000000,"
+          << 0.5*i << ",-95.111694," << 239.458157 + i << ",1e-3\n";
+    }
+    out << "DIAGNOISE,0.1,0.2,0.3,0.4\n";
+    out << "EXTRINSIC,0,0,0,0,0,0"; // no trailing newline
+  }
+
+  SECTION("simple BA dataset" ) {
+    for (unsigned int numThreads = 1; numThreads <= 4; numThreads += 3) {
+      INFO("threads: " << numThreads);
+      steam::data::SimpleBaDataset dataset = steam::data::parseSimpleBaDataset(baFile, numThreads);
+      REQUIRE( dataset.meas.size() == numMeas );
+      REQUIRE( dataset.frames_gt.size() == 1 );
+      REQUIRE( dataset.land_ic.size() == 1 );
+      CHECK( dataset.camParams.fu == 484.5 );
+      CHECK( dataset.camParams.cv == 0.0 );
+      CHECK( dataset.frames_gt[0].pose_vec_k0[2] == 0.3 );
+      CHECK( dataset.land_ic[0].landID == 7 );
+      CHECK( dataset.land_ic[0].point[2] == 10.125 );
+      CHECK( dataset.noise(3,3) == 0.4 );
+      CHECK( dataset.noise(0,1) == 0.0 );
+      CHECK( dataset.T_cv.matrix().isIdentity() );
+      bool allMatch = true;
+      for (unsigned int i = 0; i < numMeas; i++) {
+        const steam::data::SimpleBaDataset::StereoMeas& meas = dataset.meas[i];
+        allMatch = allMatch && meas.frameID == i % 61 && meas.landID == i &&
+                   meas.time == 10000 + i % 61 && meas.data[0] == 0.5*i &&
+                   meas.data[1] == -95.111694 && meas.data[3] == 1e-3;
+      }
+      CHECK( allMatch );
+    }
+  }
+
+  SECTION("sphere dataset" ) {
+    const std::string sphereFile = "parse_test_sphere.txt";
+    {
+      std::ofstream out(sphereFile.c_str());
+      out << "EDGE3 0 1 1 2 3 0 0 0 10 1 2 3 4 5 10 0 0 0 0 10 0 0 0 100 0 0 100 0 25\n";
+      out << "EDGE3 2 1 1 0 0 0 0 0.5\n";
+    }
+    std::vector<steam::data::SphereEdge> edges = steam::data::parseSphereDataset(sphereFile);
+    REQUIRE( edges.size() == 2 );
+    CHECK( edges[0].idB == 1 );
+    CHECK( edges[0].sqrtInformation(0,5) == 5.0 );
+    CHECK( edges[0].sqrtInformation(5,5) == 25.0 );
+    CHECK( edges[0].sqrtInformation(1,0) == 0.0 );
+    CHECK( edges[0].T_BA.matrix().block<3,1>(0,3).isApprox(Eigen::Vector3d(-1,-2,-3)) );
+    CHECK( edges[1].sqrtInformation.isIdentity() );
+    remove(sphereFile.c_str());
+  }
+
+  SECTION("malformed files" ) {
+    const std::string badFile = "parse_test_bad.txt";
+    {
+      std::ofstream out(badFile.c_str());
+      out << "STEREO,0,0,1.0,1,2,3,4\nUNKNOWN,1\n";
+    }
+    CHECK_THROWS_AS( steam::data::parseSimpleBaDataset(badFile), std::logic_error );
+    { std::ofstream out(badFile.c_str()); }
+    CHECK_THROWS_AS( steam::data::parseSimpleBaDataset(badFile), std::invalid_argument );
+    remove(badFile.c_str());
+    CHECK_THROWS_AS( steam::data::parseSphereDataset(badFile), std::invalid_argument );
+  }
+
+  remove(baFile.c_str());
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Public dataset formats
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("g2o and BAL datasets map onto consistent problems", "[parse]" ) {
+
+  steam::LossFunctionBase::Ptr loss(new steam::L2LossFunc());
+
+  SECTION("g2o 3D pose graph" ) {
+
+    // Three poses, and two noise-free relative measurements (T_ij = T_i0 * inv(T_j0))
+    std::vector<lgmath::se3::Transformation> T_k0;
+    for (unsigned int k = 0; k < 3; k++) {
+      Eigen::Matrix<double,6,1> xi; xi << 1.0*k, -0.5*k, 0.2, 0.1*k, -0.3, 0.2*k;
+      T_k0.push_back(lgmath::se3::Transformation(xi));
+    }
+    const std::string file = "parse_test_g2o.txt";
+    {
+      std::ofstream out(file.c_str());
+      out << std::setprecision(17);
+      for (unsigned int k = 0; k < 3; k++) {
+        const Eigen::Matrix4d T_0k = T_k0[k].inverse().matrix();
+        const Eigen::Quaterniond q(Eigen::Matrix3d(T_0k.topLeftCorner<3,3>()));
+        out << "VERTEX_SE3:QUAT " << 10 + k << " " << T_0k(0,3) << " " << T_0k(1,3) << " "
+            << T_0k(2,3) << " " << q.x() << " " << q.y() << " " << q.z() << " " << q.w() << "\n";
+      }
+      for (unsigned int k = 0; k < 2; k++) {
+        const Eigen::Matrix4d T_ij = (T_k0[k] * T_k0[k+1].inverse()).matrix();
+        const Eigen::Quaterniond q(Eigen::Matrix3d(T_ij.topLeftCorner<3,3>()));
+        out << "EDGE_SE3:QUAT  " << 10 + k << " " << 11 + k << " " << T_ij(0,3) << " "
+            << T_ij(1,3) << " " << T_ij(2,3) << " " << q.x() << " " << q.y() << " " << q.z()
+            << " " << q.w();
+        for (unsigned int r = 0; r < 6; r++) {
+          for (unsigned int c = r; c < 6; c++) {
+            out << " " << (r == c ? 4.0 : 0.0);
+          }
+        }
+        out << "\t\n";
+      }
+      out << "FIX 11\n";
+    }
+
+    steam::data::G2oSe3Dataset dataset = steam::data::parseG2oSe3Dataset(file);
+    REQUIRE( dataset.vertices.size() == 3 );
+    REQUIRE( dataset.edges.size() == 2 );
+    REQUIRE( dataset.fixed.size() == 1 );
+    CHECK( dataset.vertices[2].id == 12 );
+    CHECK( dataset.vertices[2].T_k0.matrix().isApprox(T_k0[2].matrix(), 1e-12) );
+    CHECK( dataset.edges[1].idA == 11 );
+    Eigen::Matrix<double,6,1> sqrtInfo; sqrtInfo << 2.0, 2.0, 2.0, 1.0, 1.0, 1.0;
+    CHECK( dataset.edges[0].sqrtInformation.isApprox(
+             Eigen::Matrix<double,6,6>(sqrtInfo.asDiagonal()), 1e-12) );
+
+    steam::data::G2oSe3Problem problem = steam::data::buildG2oSe3Problem(dataset, loss, 1);
+    REQUIRE( problem.costTerms->numCostTerms() == 2 );
+    CHECK( problem.poses[1]->isLocked() );
+    CHECK( !problem.poses[0]->isLocked() );
+    CHECK( problem.costTerms->cost() < 1e-16 );
+
+    dataset.edges[1].idB = 99;
+    CHECK_THROWS_AS( steam::data::buildG2oSe3Problem(dataset, loss, 1), std::invalid_argument );
+    remove(file.c_str());
+  }
+
+  SECTION("bundle adjustment in the large" ) {
+
+    // Two cameras and three points, observations from the BAL camera model
+    double cameras[2][9] = {{0.01, -0.02, 0.03, 0.1, -0.2, 0.3, 500.0, -0.1, 0.02},
+                            {-0.05, 0.1, 0.0, -0.4, 0.1, 0.2, 520.0, 0.05, -0.01}};
+    double points[3][3] = {{0.5, -0.3, -5.0}, {-1.0, 0.2, -6.0}, {0.1, 0.8, -4.5}};
+    const std::string file = "parse_test_bal.txt";
+    {
+      std::ofstream out(file.c_str());
+      out << std::setprecision(17) << "2 3 5\n";
+      for (unsigned int o = 0; o < 5; o++) {
+        const double* c = cameras[o % 2];
+        const Eigen::Vector3d aaxis(c[0], c[1], c[2]);
+        const Eigen::Vector3d P = Eigen::AngleAxisd(aaxis.norm(), aaxis.normalized()) *
+                                  Eigen::Vector3d(points[o % 3]) + Eigen::Vector3d(c[3], c[4], c[5]);
+        const Eigen::Vector2d p = -P.head<2>()/P[2];
+        const double r2 = p.squaredNorm();
+        const Eigen::Vector2d uv = c[6]*(1.0 + c[7]*r2 + c[8]*r2*r2)*p;
+        out << o % 2 << " " << o % 3 << "     " << uv[0] << " " << uv[1] << "\n";
+      }
+      for (unsigned int i = 0; i < 2; i++) {
+        for (unsigned int j = 0; j < 9; j++) {
+          out << cameras[i][j] << "\n";
+        }
+      }
+      for (unsigned int i = 0; i < 3; i++) {
+        out << points[i][0] << "\n" << points[i][1] << "\n" << points[i][2] << "\n";
+      }
+    }
+
+    steam::data::BalDataset dataset = steam::data::parseBalDataset(file);
+    REQUIRE( dataset.cameras.size() == 2 );
+    REQUIRE( dataset.points.size() == 3 );
+    REQUIRE( dataset.observations.size() == 5 );
+    CHECK( dataset.cameras[1].f == 520.0 );
+    CHECK( dataset.points[2][1] == 0.8 );
+    CHECK( dataset.observations[4].cameraID == 0 );
+    CHECK( dataset.observations[4].pointID == 1 );
+
+    steam::data::BalProblem problem = steam::data::buildBalProblem(dataset, loss, 1);
+    REQUIRE( problem.costTerms->numCostTerms() == 5 );
+    CHECK( problem.poses[0]->isLocked() );
+    CHECK( problem.costTerms->cost() < 1e-16 );
+
+    { std::ofstream out(file.c_str()); out << "2 3 5\n0 0 1.0 2.0\n"; }
+    CHECK_THROWS_AS( steam::data::parseBalDataset(file), std::logic_error );
+    remove(file.c_str());
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Synthetic problems
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("synthetic problems are seeded and consistent with their ground truth", "[parse]" ) {
+
+  steam::LossFunctionBase::Ptr loss(new steam::L2LossFunc());
+
+  SECTION("pose graph" ) {
+    steam::data::PoseGraphParams params;
+    params.numPoses = 250;
+    params.posesPerLap = 50;
+    params.loopClosureDensity = 1.5;
+    params.seed = 7;
+    steam::data::G2oSe3Dataset first = steam::data::generatePoseGraph(params);
+    steam::data::G2oSe3Dataset second = steam::data::generatePoseGraph(params);
+    REQUIRE( first.vertices.size() == 250 );
+    REQUIRE( first.edges.size() > 249 + 150 );
+    REQUIRE( first.edges.size() == second.edges.size() );
+    bool identical = true;
+    for (unsigned int i = 0; i < first.edges.size(); i++) {
+      identical = identical && first.edges[i].idA == second.edges[i].idA &&
+                  first.edges[i].T_BA.matrix() == second.edges[i].T_BA.matrix();
+    }
+    CHECK( identical );
+    params.seed = 8;
+    CHECK( steam::data::generatePoseGraph(params).edges[0].T_BA.matrix() !=
+           first.edges[0].T_BA.matrix() );
+
+    // Round trip through the g2o format
+    const std::string file = "parse_test_synthetic.g2o";
+    steam::data::writeG2oSe3Dataset(file, first);
+    steam::data::G2oSe3Dataset parsed = steam::data::parseG2oSe3Dataset(file);
+    REQUIRE( parsed.edges.size() == first.edges.size() );
+    CHECK( parsed.fixed == first.fixed );
+    CHECK( parsed.vertices.back().T_k0.matrix().isApprox(first.vertices.back().T_k0.matrix(), 1e-9) );
+    CHECK( parsed.edges.back().T_BA.matrix().isApprox(first.edges.back().T_BA.matrix(), 1e-9) );
+    CHECK( parsed.edges.back().sqrtInformation.isApprox(first.edges.back().sqrtInformation, 1e-9) );
+    remove(file.c_str());
+
+    // Noise-free graphs are consistent
+    params.sigmaTranslation = 0.0;
+    params.sigmaRotation = 0.0;
+    steam::data::G2oSe3Problem problem =
+        steam::data::buildG2oSe3Problem(steam::data::generatePoseGraph(params), loss, 1);
+    CHECK( problem.costTerms->cost() < 1e-12 );
+  }
+
+  SECTION("stereo bundle adjustment and continuous-time trajectory" ) {
+    steam::data::StereoBaParams params;
+    params.numFrames = 20;
+    params.numLandmarks = 50;
+    params.trackLength = 5;
+    params.pixelNoise = 0.0;
+    params.sigmaTranslation = 0.0;
+    params.sigmaRotation = 0.0;
+    params.sigmaLandmark = 0.0;
+    steam::data::SimpleBaDataset dataset = steam::data::generateStereoBa(params);
+    REQUIRE( dataset.frames_ic.size() == 20 );
+    REQUIRE( dataset.land_ic.size() == 50 );
+    REQUIRE( dataset.meas.size() == 50*5 );
+    CHECK( dataset.meas.front().landID == 0 );
+    CHECK( dataset.meas.back().frameID == 19 );
+    steam::data::SimpleBaProblem problem = steam::data::buildSimpleBaProblem(dataset, loss, 1);
+    CHECK( problem.costTerms->cost() < 1e-12 );
+
+    // Round trip through the simple BA format, with noise and outliers
+    params.pixelNoise = 0.5;
+    params.outlierRatio = 0.2;
+    params.sigmaLandmark = 0.2;
+    dataset = steam::data::generateStereoBa(params);
+    const std::string file = "parse_test_synthetic_ba.txt";
+    steam::data::writeSimpleBaDataset(file, dataset);
+    steam::data::SimpleBaDataset parsed = steam::data::parseSimpleBaDataset(file);
+    REQUIRE( parsed.meas.size() == dataset.meas.size() );
+    CHECK( parsed.meas[17].data == dataset.meas[17].data );
+    CHECK( parsed.land_ic[3].point == dataset.land_ic[3].point );
+    CHECK( parsed.frames_ic[5].T_k0.matrix() == dataset.frames_ic[5].T_k0.matrix() );
+    CHECK( steam::data::buildSimpleBaProblem(parsed, loss, 1).costTerms->cost() > 1.0 );
+    remove(file.c_str());
+
+    // Continuous-time measurements, between the knots
+    params.measTimesPerFrame = 3;
+    dataset = steam::data::generateStereoBa(params);
+    bool ordered = true;
+    for (unsigned int i = 0; i < dataset.meas.size(); i++) {
+      ordered = ordered && (i == 0 || dataset.meas[i-1].time <= dataset.meas[i].time) &&
+                dataset.meas[i].time >= dataset.frames_ic[dataset.meas[i].frameID].time &&
+                dataset.meas[i].time <= dataset.frames_ic.back().time;
+    }
+    CHECK( ordered );
+    CHECK( dataset.meas.size() > 50*5*2 );
+    Eigen::Matrix<double,6,6> Qc_inv = Eigen::Matrix<double,6,6>::Identity();
+    steam::data::SimpleBaTrajectoryProblem trajProblem =
+        steam::data::buildSimpleBaTrajectoryProblem(dataset, Qc_inv, loss, 1);
+    REQUIRE( trajProblem.costTerms->numCostTerms() == dataset.meas.size() );
+    CHECK( trajProblem.priorCostTerms->numCostTerms() == 19 );
+    steam::OptimizationProblem optProblem;
+    trajProblem.addToProblem(&optProblem);
+    CHECK( optProblem.getStateVariables().size() == 19 + 20 + 50 );
+  }
+} // TEST_CASE
@@ -0,0 +1,931 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+#include <steam.hpp>
+#include <steam/problem/StereoCostTermCollection.hpp>
+#include <steam/data/ProblemArchive.hpp>
+#include <steam/data/ParseBA.hpp>
+#include <steam/data/SyntheticProblems.hpp>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Make a unary cost term that pulls a 2D vector-space state towards a measurement
+/////////////////////////////////////////////////////////////////////////////////////////////
+steam::WeightedLeastSqCostTerm<2,2>::Ptr makeUnaryCostTerm(
+    const steam::VectorSpaceStateVar::Ptr& state, const Eigen::Vector2d& meas) {
+
+  steam::VectorSpaceErrorEval<2,2>::Ptr error(new steam::VectorSpaceErrorEval<2,2>(meas, state));
+  steam::BaseNoiseModel<2>::Ptr noise(new steam::StaticNoiseModel<2>(Eigen::Matrix2d::Identity()));
+  steam::L2LossFunc::Ptr loss(new steam::L2LossFunc());
+  return steam::WeightedLeastSqCostTerm<2,2>::Ptr(
+      new steam::WeightedLeastSqCostTerm<2,2>(error, noise, loss));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Incremental problem edits
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("incremental problem edits are applied to an existing solver", "[problem]" ) {
+
+  steam::OptimizationProblem problem;
+  std::vector<steam::VectorSpaceStateVar::Ptr> states;
+  std::vector<steam::WeightedLeastSqCostTerm<2,2>::Ptr> costTerms;
+  for (unsigned int i = 0; i < 5; i++) {
+    states.push_back(steam::VectorSpaceStateVar::Ptr(
+        new steam::VectorSpaceStateVar(Eigen::Vector2d::Zero())));
+    costTerms.push_back(makeUnaryCostTerm(states.back(), Eigen::Vector2d(i, -1.0*i)));
+    problem.addStateVariable(states.back());
+    problem.addCostTerm(costTerms.back());
+  }
+  REQUIRE_THROWS( problem.addStateVariable(states[0]) );
+
+  steam::VanillaGaussNewtonSolver::Params params;
+  params.maxIterations = 5;
+  steam::VanillaGaussNewtonSolver solver(&problem, params);
+  solver.optimize();
+  CHECK( problem.cost() < 1e-12 );
+
+  // Slide the window: remove the first state and its cost term, add a new state
+  problem.removeCostTerm(costTerms[0]);
+  problem.removeStateVariable(states[0]->getKey());
+  REQUIRE_THROWS( problem.removeStateVariable(states[0]->getKey()) );
+  REQUIRE_THROWS( problem.removeCostTerm(costTerms[0]) );
+  states.push_back(steam::VectorSpaceStateVar::Ptr(
+      new steam::VectorSpaceStateVar(Eigen::Vector2d::Zero())));
+  costTerms.push_back(makeUnaryCostTerm(states.back(), Eigen::Vector2d(5.0, 2.0)));
+  problem.addStateVariable(states.back());
+  problem.addCostTerm(costTerms.back());
+  REQUIRE( problem.getStateVariables().size() == 5 );
+  REQUIRE( problem.getNumberOfCostTerms() == 5 );
+  REQUIRE( problem.hasStateVariable(states.back()->getKey()) );
+  REQUIRE( !problem.hasStateVariable(states[0]->getKey()) );
+
+  // A cost term added twice is removed one addition at a time
+  problem.addCostTerm(costTerms[1]);
+  REQUIRE( problem.getNumberOfCostTerms() == 6 );
+  problem.removeCostTerm(costTerms[1]);
+  REQUIRE( problem.getNumberOfCostTerms() == 5 );
+
+  // The same solver picks up the changes and converges again
+  REQUIRE( solver.converged() );
+  solver.optimize();
+  CHECK( problem.cost() < 1e-12 );
+  CHECK( (states.back()->getValue() - Eigen::Vector2d(5.0, 2.0)).norm() < 1e-9 );
+
+  SECTION("a solver that falls behind the change log rebuilds its state vector" ) {
+    for (unsigned int i = 0; i < 1200; i++) {
+      steam::VectorSpaceStateVar::Ptr state(new steam::VectorSpaceStateVar(Eigen::Vector2d::Zero()));
+      steam::WeightedLeastSqCostTerm<2,2>::Ptr costTerm =
+          makeUnaryCostTerm(state, Eigen::Vector2d(1.0, 1.0));
+      problem.addStateVariable(state);
+      problem.addCostTerm(costTerm);
+      if (i % 2 == 0) {
+        problem.removeCostTerm(costTerm);
+        problem.removeStateVariable(state->getKey());
+      } else {
+        states.push_back(state);
+      }
+    }
+    std::vector<steam::OptimizationProblem::StateChange> changes;
+    REQUIRE( !problem.getStateChangesSince(0, &changes) );
+    solver.optimize();
+    CHECK( problem.cost() < 1e-12 );
+    CHECK( (states.back()->getValue() - Eigen::Vector2d(1.0, 1.0)).norm() < 1e-9 );
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Appended states and cost terms
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("appending states and cost terms keeps the solution and covariances exact", "[problem]" ) {
+
+  // A chain of poses with a prior on the first pose and consistent odometry
+  Eigen::Matrix<double,6,1> xi; xi << 1.0, 0.1, 0.0, 0.0, 0.0, 0.05;
+  lgmath::se3::Transformation meas_T_21(xi);
+  steam::BaseNoiseModel<6>::Ptr noise(new steam::StaticNoiseModel<6>(
+      Eigen::Matrix<double,6,6>::Identity()));
+  steam::L2LossFunc::Ptr loss(new steam::L2LossFunc());
+  steam::OptimizationProblem problem;
+  std::vector<steam::se3::TransformStateVar::Ptr> poses;
+  poses.push_back(steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar()));
+  problem.addStateVariable(poses.back());
+  steam::TransformErrorEval::Ptr priorError(new steam::TransformErrorEval(
+      lgmath::se3::Transformation(), steam::se3::TransformStateEvaluator::MakeShared(poses.back())));
+  problem.addCostTerm(steam::WeightedLeastSqCostTerm<6,6>::Ptr(
+      new steam::WeightedLeastSqCostTerm<6,6>(priorError, noise, loss)));
+
+  steam::VanillaGaussNewtonSolver::Params params;
+  params.maxIterations = 10;
+  steam::VanillaGaussNewtonSolver solver(&problem, params);
+  for (unsigned int batch = 0; batch < 4; batch++) {
+
+    // Append a few poses, with loop closures to the first pose
+    for (unsigned int i = 0; i < 5; i++) {
+      poses.push_back(steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar()));
+      problem.addStateVariable(poses.back());
+      steam::TransformErrorEval::Ptr error(new steam::TransformErrorEval(
+          meas_T_21, poses[poses.size()-1], poses[poses.size()-2]));
+      problem.addCostTerm(steam::WeightedLeastSqCostTerm<6,6>::Ptr(
+          new steam::WeightedLeastSqCostTerm<6,6>(error, noise, loss)));
+    }
+    lgmath::se3::Transformation meas_T_n0;
+    for (unsigned int i = 1; i < poses.size(); i++) {
+      meas_T_n0 = meas_T_21*meas_T_n0;
+    }
+    steam::TransformErrorEval::Ptr closure(new steam::TransformErrorEval(
+        meas_T_n0, poses.back(), poses.front()));
+    problem.addCostTerm(steam::WeightedLeastSqCostTerm<6,6>::Ptr(
+        new steam::WeightedLeastSqCostTerm<6,6>(closure, noise, loss)));
+
+    // The same solver analyzes the extended pattern and converges
+    solver.optimize();
+    CHECK( problem.cost() < 1e-12 );
+
+    // Covariances match those of a solver that analyzed the problem from scratch
+    steam::VanillaGaussNewtonSolver fresh(&problem, params);
+    fresh.optimize();
+    Eigen::MatrixXd cov = solver.queryCovariance(poses.back()->getKey(), poses[1]->getKey());
+    Eigen::MatrixXd freshCov = fresh.queryCovariance(poses.back()->getKey(), poses[1]->getKey());
+    CHECK( (cov - freshCov).norm() < 1e-6*freshCov.norm() );
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Noise evaluator with a state-dependent covariance that counts its evaluations
+/////////////////////////////////////////////////////////////////////////////////////////////
+class CountingNoiseEvaluator : public steam::NoiseEvaluator<2> {
+ public:
+  CountingNoiseEvaluator(const steam::VectorSpaceStateVar::ConstPtr& state, bool stamped)
+    : state_(state), stamped_(stamped), count(0) {}
+
+  virtual steam::StateStamp getInputStamp() const {
+    return stamped_ ? state_->getStamp() : 0;
+  }
+
+  steam::VectorSpaceStateVar::ConstPtr state_;
+  bool stamped_;
+  unsigned int count;
+
+ protected:
+  virtual Eigen::Matrix2d evaluate() {
+    count++;
+    Eigen::Vector2d x = state_->getValue();
+    return (Eigen::Vector2d::Ones() + x.cwiseProduct(x)).asDiagonal();
+  }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Dynamic noise model cache
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("dynamic noise model re-evaluates only when its inputs change", "[problem]" ) {
+
+  steam::VectorSpaceStateVar::Ptr state(new steam::VectorSpaceStateVar(Eigen::Vector2d(1.0, 0.0)));
+  boost::shared_ptr<CountingNoiseEvaluator> stamped(new CountingNoiseEvaluator(state, true));
+  boost::shared_ptr<CountingNoiseEvaluator> unstamped(new CountingNoiseEvaluator(state, false));
+  steam::DynamicNoiseModel<2> cached(stamped);
+  steam::DynamicNoiseModel<2> uncached(unstamped);
+  REQUIRE( stamped->count == 1 );
+  REQUIRE( unstamped->count == 1 );
+
+  Eigen::Vector2d error(1.0, 1.0);
+  for (int i = 0; i < 5; i++) {
+    CHECK( (cached.whitenError(error) - Eigen::Vector2d(1.0/sqrt(2.0), 1.0)).norm() < 1e-12 );
+    CHECK( fabs(cached.getWhitenedErrorNorm(error) - sqrt(1.5)) < 1e-12 );
+    uncached.whitenError(error);
+  }
+  CHECK( stamped->count == 1 );
+  CHECK( unstamped->count == 6 );
+
+  // Changing the state renews its stamp
+  steam::StateStamp before = state->getStamp();
+  state->update(Eigen::Vector2d(0.0, 1.0));
+  CHECK( state->getStamp() > before );
+  CHECK( (cached.getSqrtInformation().diagonal() - Eigen::Vector2d(1.0/sqrt(2.0), 1.0/sqrt(2.0))).norm() < 1e-12 );
+  cached.whitenError(error);
+  CHECK( stamped->count == 2 );
+  CHECK( (uncached.whitenError(error) - Eigen::Vector2d(1.0/sqrt(2.0), 1.0/sqrt(2.0))).norm() < 1e-12 );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Structured noise models
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("structured noise models match the equivalent full noise model", "[problem]" ) {
+
+  Eigen::Matrix<double,6,1> error; error << 0.3, -1.2, 0.7, 2.0, -0.4, 0.05;
+  Eigen::Matrix<double,6,Eigen::Dynamic> jac = Eigen::Matrix<double,6,Eigen::Dynamic>::Random(6, 9);
+
+  // Block-diagonal covariance made of two correlated 3x3 blocks
+  steam::BlockDiagonalNoiseModel<6,3>::BlockVectorType blocks(2);
+  blocks[0] << 2.0, 0.3, 0.1,  0.3, 1.0, -0.2,  0.1, -0.2, 0.5;
+  blocks[1] << 0.4, 0.0, 0.05,  0.0, 0.9, 0.1,  0.05, 0.1, 3.0;
+  Eigen::Matrix<double,6,6> blockCov = Eigen::Matrix<double,6,6>::Zero();
+  blockCov.topLeftCorner<3,3>() = blocks[0];
+  blockCov.bottomRightCorner<3,3>() = blocks[1];
+
+  Eigen::Matrix<double,6,1> diag; diag << 0.5, 2.0, 1.5, 0.1, 4.0, 1.0;
+
+  std::vector<steam::BaseNoiseModel<6>::ConstPtr> structured, full;
+  structured.push_back(steam::BaseNoiseModel<6>::ConstPtr(new steam::DiagonalNoiseModel<6>(diag)));
+  full.push_back(steam::BaseNoiseModel<6>::ConstPtr(
+      new steam::StaticNoiseModel<6>(Eigen::Matrix<double,6,6>(diag.asDiagonal()))));
+  structured.push_back(steam::BaseNoiseModel<6>::ConstPtr(
+      new steam::DiagonalNoiseModel<6>(diag, steam::INFORMATION)));
+  full.push_back(steam::BaseNoiseModel<6>::ConstPtr(new steam::StaticNoiseModel<6>(
+      Eigen::Matrix<double,6,6>(diag.asDiagonal()), steam::INFORMATION)));
+  structured.push_back(steam::BaseNoiseModel<6>::ConstPtr(new steam::IsotropicNoiseModel<6>(0.25)));
+  full.push_back(steam::BaseNoiseModel<6>::ConstPtr(
+      new steam::StaticNoiseModel<6>(0.25*Eigen::Matrix<double,6,6>::Identity())));
+  structured.push_back(steam::BaseNoiseModel<6>::ConstPtr(
+      new steam::BlockDiagonalNoiseModel<6,3>(blocks)));
+  full.push_back(steam::BaseNoiseModel<6>::ConstPtr(new steam::StaticNoiseModel<6>(blockCov)));
+
+  for (unsigned int i = 0; i < structured.size(); i++) {
+    INFO("model: " << i);
+    CHECK( (structured[i]->getSqrtInformation() - full[i]->getSqrtInformation()).norm() < 1e-10 );
+    CHECK( (structured[i]->whitenError(error) - full[i]->whitenError(error)).norm() < 1e-10 );
+    CHECK( std::fabs(structured[i]->getWhitenedErrorNorm(error) -
+                     full[i]->getWhitenedErrorNorm(error)) < 1e-10 );
+    Eigen::Matrix<double,6,Eigen::Dynamic> whitened = jac;
+    structured[i]->whitenJacobian(whitened);
+    CHECK( (whitened - full[i]->getSqrtInformation()*jac).norm() < 1e-10 );
+  }
+
+  SECTION("invalid parameters are rejected" ) {
+    diag[2] = 0.0;
+    REQUIRE_THROWS( steam::DiagonalNoiseModel<6>(diag) );
+    REQUIRE_THROWS( steam::IsotropicNoiseModel<6>(-1.0) );
+    REQUIRE_THROWS( steam::IsotropicNoiseModel<6>(1.0, steam::COVARIANCE, 4) );
+    blocks.pop_back();
+    REQUIRE_THROWS( steam::BlockDiagonalNoiseModel<6,3>(blocks) );
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Huber loss function that counts its batched evaluations
+/////////////////////////////////////////////////////////////////////////////////////////////
+class CountingHuberLossFunc : public steam::HuberLossFunc {
+ public:
+  CountingHuberLossFunc() : steam::HuberLossFunc(1.0), costBatches(0), weightBatches(0) {}
+
+  virtual void costBatch(const double* norms, unsigned int n, double* out) const {
+    costBatches++;
+    steam::HuberLossFunc::costBatch(norms, n, out);
+  }
+  virtual void weightBatch(const double* norms, unsigned int n, double* out) const {
+    weightBatches++;
+    steam::HuberLossFunc::weightBatch(norms, n, out);
+  }
+
+  mutable std::atomic<unsigned int> costBatches;
+  mutable std::atomic<unsigned int> weightBatches;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Batched robust loss evaluation
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("batched loss evaluation matches per-term evaluation", "[problem]" ) {
+
+  // Runs of cost terms that share loss functions (across several blocks)
+  boost::shared_ptr<CountingHuberLossFunc> huber(new CountingHuberLossFunc());
+  std::vector<steam::LossFunctionBase::ConstPtr> losses;
+  losses.push_back(huber);
+  losses.push_back(steam::LossFunctionBase::ConstPtr(new steam::CauchyLossFunc(0.8)));
+  losses.push_back(steam::LossFunctionBase::ConstPtr(new steam::DcsLossFunc(1.5)));
+  losses.push_back(steam::LossFunctionBase::ConstPtr(new steam::GemanMcClureLossFunc(1.2)));
+  losses.push_back(steam::LossFunctionBase::ConstPtr(new steam::L2LossFunc()));
+
+  steam::OptimizationProblem problem;
+  steam::StateVector stateVector;
+  std::vector<steam::VectorSpaceStateVar::Ptr> states;
+  std::vector<steam::CostTermBase::ConstPtr> costTerms;
+  for (unsigned int i = 0; i < 700; i++) {
+    states.push_back(steam::VectorSpaceStateVar::Ptr(new steam::VectorSpaceStateVar(
+        Eigen::Vector2d(0.01*(i % 37), -0.02*(i % 11)))));
+    steam::VectorSpaceErrorEval<2,2>::Ptr error(new steam::VectorSpaceErrorEval<2,2>(
+        Eigen::Vector2d(0.5, 0.1*(i % 23)), states.back()));
+    steam::BaseNoiseModel<2>::Ptr noise(new steam::DiagonalNoiseModel<2>(Eigen::Vector2d(0.5, 2.0)));
+    costTerms.push_back(steam::CostTermBase::ConstPtr(new steam::WeightedLeastSqCostTerm<2,2>(
+        error, noise, losses[(i/50) % losses.size()])));
+    problem.addStateVariable(states.back());
+    problem.addCostTerm(costTerms.back());
+    stateVector.addStateVariable(states.back());
+  }
+
+  double expected = 0.0;
+  for (unsigned int i = 0; i < costTerms.size(); i++) {
+    expected += costTerms[i]->cost();
+  }
+  CHECK( std::fabs(problem.cost() - expected) < 1e-9 );
+  CHECK( huber->costBatches > 0 );
+
+  // Linearize with the weights from the last cost evaluation
+  Eigen::SparseMatrix<double> batchedHessian, hessian;
+  Eigen::VectorXd batchedGradient, gradient;
+  problem.buildGaussNewtonTerms(stateVector, &batchedHessian, &batchedGradient);
+  CHECK( huber->weightBatches > 0 );
+
+  // Any state change invalidates the stored norms, and each cost term computes its own weight
+  huber->weightBatches = 0;
+  states[0]->setValue(states[0]->getValue());
+  problem.buildGaussNewtonTerms(stateVector, &hessian, &gradient);
+  CHECK( huber->weightBatches == 0 );
+  CHECK( (Eigen::MatrixXd(batchedHessian) - Eigen::MatrixXd(hessian)).norm() < 1e-9 );
+  CHECK( (batchedGradient - gradient).norm() < 1e-9 );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Noise evaluator with an isotropic covariance that is set outside of the states
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ScaledNoiseEvaluator : public steam::NoiseEvaluator<2> {
+ public:
+  ScaledNoiseEvaluator() : scale(1.0) {}
+
+  double scale;
+
+ protected:
+  virtual Eigen::Matrix2d evaluate() {
+    return scale*Eigen::Matrix2d::Identity();
+  }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Norm reuse with unstamped inputs
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("norms of cost terms with unstamped inputs are not reused for the weights", "[problem]" ) {
+
+  boost::shared_ptr<CountingHuberLossFunc> huber(new CountingHuberLossFunc());
+  boost::shared_ptr<ScaledNoiseEvaluator> scaled(new ScaledNoiseEvaluator());
+  steam::BaseNoiseModel<2>::Ptr noise(new steam::DynamicNoiseModel<2>(scaled));
+
+  steam::OptimizationProblem problem;
+  steam::StateVector stateVector;
+  std::vector<steam::VectorSpaceStateVar::Ptr> states;
+  for (unsigned int i = 0; i < 20; i++) {
+    states.push_back(steam::VectorSpaceStateVar::Ptr(
+        new steam::VectorSpaceStateVar(Eigen::Vector2d::Zero())));
+    steam::VectorSpaceErrorEval<2,2>::Ptr error(new steam::VectorSpaceErrorEval<2,2>(
+        Eigen::Vector2d(3.0, 0.5*i), states.back()));
+    problem.addStateVariable(states.back());
+    problem.addCostTerm(steam::CostTermBase::ConstPtr(
+        new steam::WeightedLeastSqCostTerm<2,2>(error, noise, huber)));
+    stateVector.addStateVariable(states.back());
+  }
+
+  // The covariance changes after the cost evaluation without a new state stamp
+  problem.cost();
+  scaled->scale = 16.0;
+  Eigen::SparseMatrix<double> hessian, expectedHessian;
+  Eigen::VectorXd gradient, expectedGradient;
+  problem.buildGaussNewtonTerms(stateVector, &hessian, &gradient);
+  CHECK( huber->weightBatches == 0 );
+
+  // Reference: a state change makes each cost term compute its own weight
+  states[0]->setValue(states[0]->getValue());
+  problem.buildGaussNewtonTerms(stateVector, &expectedHessian, &expectedGradient);
+  CHECK( (Eigen::MatrixXd(hessian) - Eigen::MatrixXd(expectedHessian)).norm() < 1e-12 );
+  CHECK( (gradient - expectedGradient).norm() < 1e-12 );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Stereo cost-term collection
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("stereo cost-term collection matches individual stereo cost terms", "[problem]" ) {
+
+  steam::stereo::CameraIntrinsics::Ptr intrinsics(new steam::stereo::CameraIntrinsics());
+  intrinsics->b = 0.24; intrinsics->fu = 480.0; intrinsics->fv = 470.0;
+  intrinsics->cu = 320.0; intrinsics->cv = 240.0;
+  Eigen::Matrix<double,6,1> xi_cv; xi_cv << 0.1, 0.0, -0.2, -1.2, 0.05, -1.5;
+  lgmath::se3::Transformation T_cv(xi_cv);
+  steam::BaseNoiseModel<4>::Ptr noise(
+      new steam::DiagonalNoiseModel<4>(Eigen::Vector4d(0.25, 0.3, 0.25, 0.3)));
+  steam::LossFunctionBase::Ptr loss(new steam::HuberLossFunc(2.0));
+
+  steam::StereoCostTermCollection::Ptr stereoTerms(
+      new steam::StereoCostTermCollection(*intrinsics, T_cv, noise, loss));
+  steam::ParallelizedCostTermCollection::Ptr referenceTerms(
+      new steam::ParallelizedCostTermCollection());
+  steam::StateVector stateVector;
+
+  // Poses (the first is locked) and landmarks in front of the camera
+  std::vector<steam::se3::TransformStateVar::Ptr> poses;
+  for (unsigned int k = 0; k < 3; k++) {
+    Eigen::Matrix<double,6,1> xi; xi << -0.5*k, 0.1*k, 0.0, 0.0, 0.02*k, -0.05*k;
+    poses.push_back(steam::se3::TransformStateVar::Ptr(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi))));
+    poses.back()->setLock(k == 0);
+    REQUIRE( stereoTerms->addPose(poses.back()) == k );
+    if (k > 0) {
+      stateVector.addStateVariable(poses.back());
+    }
+  }
+  std::vector<steam::se3::LandmarkStateVar::Ptr> landmarks;
+  for (unsigned int l = 0; l < 40; l++) {
+    landmarks.push_back(steam::se3::LandmarkStateVar::Ptr(new steam::se3::LandmarkStateVar(
+        Eigen::Vector3d(5.0 + 0.3*(l % 7), -2.0 + 0.1*l, 0.5 - 0.05*(l % 5)))));
+    REQUIRE( stereoTerms->addLandmark(landmarks.back()) == l );
+    stateVector.addStateVariable(landmarks.back());
+  }
+
+  // Every pose observes every landmark (offset from the projection, some outliers)
+  for (unsigned int k = 0; k < poses.size(); k++) {
+    for (unsigned int l = 0; l < landmarks.size(); l++) {
+      Eigen::Vector4d p = T_cv.matrix()*poses[k]->getValue().matrix()*landmarks[l]->getValue();
+      Eigen::Vector4d meas;
+      meas << intrinsics->fu*p[0]/p[2] + intrinsics->cu, intrinsics->fv*p[1]/p[2] + intrinsics->cv,
+              intrinsics->fu*(p[0] - p[3]*intrinsics->b)/p[2] + intrinsics->cu,
+              intrinsics->fv*p[1]/p[2] + intrinsics->cv;
+      meas += Eigen::Vector4d(0.3*(l % 3), -0.2*(l % 4), 0.1*k, (l % 11 == 0) ? 5.0 : 0.0);
+      stereoTerms->add(meas, k, l);
+
+      steam::se3::TransformEvaluator::Ptr T_c0 = steam::se3::compose(
+          steam::se3::FixedTransformEvaluator::MakeShared(T_cv),
+          steam::se3::TransformStateEvaluator::MakeShared(poses[k]));
+      steam::StereoCameraErrorEval::Ptr error(
+          new steam::StereoCameraErrorEval(meas, intrinsics, T_c0, landmarks[l]));
+      referenceTerms->add(steam::CostTermBase::ConstPtr(
+          new steam::WeightedLeastSqCostTerm<4,6>(error, noise, loss)));
+    }
+  }
+  REQUIRE( stereoTerms->numCostTerms() == referenceTerms->numCostTerms() );
+  REQUIRE_THROWS( stereoTerms->add(Eigen::Vector4d::Zero(), 3, 0) );
+
+  steam::OptimizationProblem stereoProblem, referenceProblem;
+  stereoProblem.addCostTerm(stereoTerms);
+  referenceProblem.addCostTerm(referenceTerms);
+  CHECK( std::fabs(stereoProblem.cost() - referenceProblem.cost()) <
+         1e-9*referenceProblem.cost() );
+
+  Eigen::SparseMatrix<double> stereoHessian, referenceHessian;
+  Eigen::VectorXd stereoGradient, referenceGradient;
+  stereoProblem.buildGaussNewtonTerms(stateVector, &stereoHessian, &stereoGradient);
+  referenceProblem.buildGaussNewtonTerms(stateVector, &referenceHessian, &referenceGradient);
+  Eigen::MatrixXd hessianDiff = Eigen::MatrixXd(stereoHessian) - Eigen::MatrixXd(referenceHessian);
+  CHECK( hessianDiff.norm() < 1e-9*Eigen::MatrixXd(referenceHessian).norm() );
+  CHECK( (stereoGradient - referenceGradient).norm() < 1e-9*referenceGradient.norm() );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Noise evaluator with a constant stereo covariance
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ConstantStereoNoiseEvaluator : public steam::NoiseEvaluator<4> {
+ protected:
+  virtual Eigen::Matrix4d evaluate() {
+    return 0.25*Eigen::Matrix4d::Identity();
+  }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Binary problem archive
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("problem archive round trip restores states and cost terms", "[problem]" ) {
+
+  steam::stereo::CameraIntrinsics intrinsics;
+  intrinsics.b = 0.24; intrinsics.fu = 480.0; intrinsics.fv = 470.0;
+  intrinsics.cu = 320.0; intrinsics.cv = 240.0;
+  Eigen::Matrix<double,6,1> xi_cv; xi_cv << 0.1, 0.0, -0.2, -1.2, 0.05, -1.5;
+  steam::BaseNoiseModel<4>::Ptr noise(
+      new steam::DiagonalNoiseModel<4>(Eigen::Vector4d(0.25, 0.3, 0.25, 0.3)));
+  steam::StereoCostTermCollection::Ptr stereoTerms(new steam::StereoCostTermCollection(
+      intrinsics, lgmath::se3::Transformation(xi_cv), noise,
+      steam::LossFunctionBase::Ptr(new steam::CauchyLossFunc(1.5)), 2));
+
+  // Poses (the first is locked), landmarks, measurements and a trajectory knot
+  steam::data::ProblemArchive archive;
+  for (unsigned int k = 0; k < 3; k++) {
+    Eigen::Matrix<double,6,1> xi; xi << -0.5*k, 0.1*k, 0.0, 0.0, 0.02*k, -0.05*k;
+    steam::se3::TransformStateVar::Ptr pose(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi)));
+    pose->setLock(k == 0);
+    stereoTerms->addPose(pose);
+  }
+  for (unsigned int l = 0; l < 50; l++) {
+    steam::se3::LandmarkStateVar::Ptr landmark(new steam::se3::LandmarkStateVar(
+        Eigen::Vector3d(5.0 + 0.3*(l % 7), -2.0 + 0.1*l, 0.5 - 0.05*(l % 5))));
+    stereoTerms->addLandmark(landmark);
+    archive.states.push_back(landmark);
+    for (unsigned int k = 0; k < 3; k++) {
+      stereoTerms->add(Eigen::Vector4d(300.0 + l, 240.0 - k, 290.0 + l, 240.5 - k), k, l);
+    }
+  }
+  steam::VectorSpaceStateVar::Ptr velocity(
+      new steam::VectorSpaceStateVar(Eigen::Matrix<double,6,1>::Constant(0.3)));
+  archive.knots.push_back(steam::se3::SteamTrajVar::Ptr(new steam::se3::SteamTrajVar(
+      steam::Time(boost::int64_t(1234567)),
+      steam::se3::TransformStateEvaluator::MakeShared(stereoTerms->getPoses()[1]), velocity)));
+  archive.stereoCostTerms.push_back(stereoTerms);
+
+  const std::string file = "problem_test_archive.bin";
+  steam::data::writeProblemArchive(file, archive);
+  steam::data::ProblemArchive restored = steam::data::readProblemArchive(file);
+
+  // Listed states keep their order, referenced states are appended
+  REQUIRE( restored.states.size() == 50 + 3 + 1 );
+  for (unsigned int i = 0; i < 50; i++) {
+    steam::se3::LandmarkStateVar::Ptr landmark =
+        boost::dynamic_pointer_cast<steam::se3::LandmarkStateVar>(restored.states[i]);
+    REQUIRE( landmark );
+    CHECK( landmark->getValue() == stereoTerms->getLandmarks()[i]->getValue() );
+  }
+  REQUIRE( restored.stereoCostTerms.size() == 1 );
+  const steam::StereoCostTermCollection& restoredTerms = *restored.stereoCostTerms[0];
+  REQUIRE( restoredTerms.numCostTerms() == stereoTerms->numCostTerms() );
+  REQUIRE( restoredTerms.getPoses().size() == 3 );
+  CHECK( restoredTerms.getPoses()[0]->isLocked() );
+  CHECK( !restoredTerms.getPoses()[1]->isLocked() );
+  CHECK( restoredTerms.getPoses()[2]->getValue().matrix() ==
+         stereoTerms->getPoses()[2]->getValue().matrix() );
+  CHECK( restoredTerms.getLandmarks()[7] == restored.states[7] );
+  CHECK( restoredTerms.getMeasurements(2) == stereoTerms->getMeasurements(2) );
+  CHECK( restoredTerms.getLandmarkIndices() == stereoTerms->getLandmarkIndices() );
+  CHECK( restoredTerms.getNumThreads() == 2 );
+  CHECK( restoredTerms.getNoiseModel()->getSqrtInformation() == noise->getSqrtInformation() );
+  CHECK( std::fabs(restoredTerms.cost() - stereoTerms->cost()) < 1e-12*stereoTerms->cost() );
+
+  // The knot shares the restored pose state
+  REQUIRE( restored.knots.size() == 1 );
+  CHECK( restored.knots[0]->getTime().nanosecs() == 1234567 );
+  CHECK( restored.knots[0]->getVelocity()->getValue() == velocity->getValue() );
+  steam::se3::TransformStateEvaluator::ConstPtr knotPose =
+      boost::dynamic_pointer_cast<steam::se3::TransformStateEvaluator>(restored.knots[0]->getPose());
+  REQUIRE( knotPose );
+  CHECK( knotPose->getStateVariable() == restoredTerms.getPoses()[1] );
+
+  steam::OptimizationProblem problem;
+  restored.addToProblem(&problem);
+  CHECK( problem.getStateVariables().size() == restored.states.size() - 1 );
+  CHECK( problem.getNumberOfCostTerms() == stereoTerms->numCostTerms() );
+
+  SECTION("block-diagonal noise models round trip and dynamic ones are rejected" ) {
+    Eigen::Matrix2d block; block << 0.3, 0.1, 0.1, 0.2;
+    steam::BlockDiagonalNoiseModel<4,2>::BlockVectorType blocks(2, block);
+    blocks[1] *= 2.0;
+    steam::BaseNoiseModel<4>::Ptr blockNoise(new steam::BlockDiagonalNoiseModel<4,2>(blocks));
+    steam::StereoCostTermCollection::Ptr blockTerms(new steam::StereoCostTermCollection(
+        intrinsics, lgmath::se3::Transformation(xi_cv), blockNoise,
+        steam::LossFunctionBase::Ptr(new steam::L2LossFunc()), 1));
+    blockTerms->addPose(stereoTerms->getPoses()[1]);
+    blockTerms->addLandmark(stereoTerms->getLandmarks()[0]);
+    blockTerms->add(Eigen::Vector4d(300.0, 240.0, 290.0, 240.5), 0, 0);
+    steam::data::ProblemArchive blockArchive;
+    blockArchive.stereoCostTerms.push_back(blockTerms);
+    steam::data::writeProblemArchive(file, blockArchive);
+    steam::data::ProblemArchive restoredBlock = steam::data::readProblemArchive(file);
+    REQUIRE( restoredBlock.stereoCostTerms.size() == 1 );
+    const steam::BaseNoiseModel<4>::ConstPtr& restoredNoise =
+        restoredBlock.stereoCostTerms[0]->getNoiseModel();
+    CHECK( boost::dynamic_pointer_cast<const steam::BlockDiagonalNoiseModel<4,2> >(restoredNoise) );
+    CHECK( restoredNoise->getSqrtInformation() == blockNoise->getSqrtInformation() );
+
+    // Dynamic noise models throw before the archive is created
+    const std::string dynamicFile = "problem_test_dynamic.bin";
+    steam::data::ProblemArchive dynamicArchive;
+    dynamicArchive.stereoCostTerms.push_back(steam::StereoCostTermCollection::Ptr(
+        new steam::StereoCostTermCollection(intrinsics, lgmath::se3::Transformation(xi_cv),
+            steam::BaseNoiseModel<4>::Ptr(new steam::DynamicNoiseModel<4>(
+                steam::NoiseEvaluator<4>::Ptr(new ConstantStereoNoiseEvaluator()))),
+            steam::LossFunctionBase::Ptr(new steam::L2LossFunc()), 1)));
+    CHECK_THROWS_AS( steam::data::writeProblemArchive(dynamicFile, dynamicArchive),
+                     std::invalid_argument );
+    CHECK( !std::ifstream(dynamicFile.c_str()).good() );
+  }
+
+  SECTION("malformed archives are rejected" ) {
+    std::ifstream in(file.c_str(), std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream(file.c_str(), std::ios::binary).write(contents.data(), contents.size()/2);
+    CHECK_THROWS_AS( steam::data::readProblemArchive(file), std::runtime_error );
+
+    // A section size that wraps around when it is aligned (the first section header follows
+    // the 16-byte file header, its size is at offset 24)
+    std::string corrupt(contents);
+    const boost::uint64_t wrapping = ~boost::uint64_t(6);
+    memcpy(&corrupt[24], &wrapping, sizeof(wrapping));
+    std::ofstream(file.c_str(), std::ios::binary).write(corrupt.data(), corrupt.size());
+    CHECK_THROWS_AS( steam::data::readProblemArchive(file), std::runtime_error );
+    contents[0] = 'X';
+    std::ofstream(file.c_str(), std::ios::binary).write(contents.data(), contents.size());
+    CHECK_THROWS_AS( steam::data::readProblemArchive(file), std::runtime_error );
+  }
+  remove(file.c_str());
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Streaming ingestion
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("streamed cost terms match a fully parsed dataset", "[problem]" ) {
+
+  // Small BA dataset, measurements follow the frames, landmarks and calibration
+  const std::string file = "problem_test_stream.txt";
+  {
+    std::ofstream out(file.c_str());
+    out << "FRAME_IC,0,0.0,0,0,0,0,0,0\nFRAME_IC,1,0.1,-0.5,0.1,0,0,0.02,-0.05\n";
+    for (unsigned int l = 0; l < 30; l++) {
+      out << "LAND_IC," << l << "," << 5.0 + 0.3*(l % 7) << "," << -2.0 + 0.1*l << ",0.5\n";
+    }
+    out << "EXTRINSIC,0.1,0,-0.2,-1.2,0.05,-1.5\nCAMPARAMS,0.24,480,470,320,240\n";
+    out << "DIAGNOISE,0.25,0.3,0.25,0.3\n";
+    for (unsigned int i = 0; i < 60; i++) {
+      out << "STEREO," << i % 2 << "," << i % 30 << ",0.0," << 300 + i << "," << 240 - i % 5
+          << "," << 290 + i << "," << 240 - i % 5 << "\n";
+    }
+  }
+
+  // States and cost-term factory from the lines before the measurements
+  steam::data::SimpleBaStream stream(file);
+  const steam::data::SimpleBaDataset& dataset = stream.getDataset();
+  REQUIRE( dataset.meas.empty() );
+  REQUIRE( dataset.frames_ic.size() == 2 );
+  REQUIRE( dataset.land_ic.size() == 30 );
+  std::vector<steam::se3::TransformStateVar::Ptr> poses;
+  for (unsigned int i = 0; i < dataset.frames_ic.size(); i++) {
+    poses.push_back(steam::se3::TransformStateVar::Ptr(
+        new steam::se3::TransformStateVar(dataset.frames_ic[i].T_k0)));
+  }
+  std::vector<steam::se3::LandmarkStateVar::Ptr> landmarks;
+  for (unsigned int i = 0; i < dataset.land_ic.size(); i++) {
+    landmarks.push_back(steam::se3::LandmarkStateVar::Ptr(
+        new steam::se3::LandmarkStateVar(dataset.land_ic[i].point)));
+  }
+  steam::stereo::CameraIntrinsics::Ptr intrinsics(new steam::stereo::CameraIntrinsics());
+  intrinsics->b = dataset.camParams.b; intrinsics->fu = dataset.camParams.fu;
+  intrinsics->fv = dataset.camParams.fv; intrinsics->cu = dataset.camParams.cu;
+  intrinsics->cv = dataset.camParams.cv;
+  steam::BaseNoiseModel<4>::Ptr noise(new steam::DiagonalNoiseModel<4>(dataset.noise.diagonal()));
+  steam::LossFunctionBase::Ptr loss(new steam::L2LossFunc());
+  const lgmath::se3::Transformation T_cv = dataset.T_cv;
+  steam::CostTermIngestor<steam::data::SimpleBaDataset::StereoMeas>::CostTermFactory factory =
+      [&](const steam::data::SimpleBaDataset::StereoMeas& meas) {
+    if (meas.frameID >= poses.size() || meas.landID >= landmarks.size()) {
+      throw std::out_of_range("unknown frame or landmark");
+    }
+    steam::se3::TransformEvaluator::Ptr T_c0 = steam::se3::compose(
+        steam::se3::FixedTransformEvaluator::MakeShared(T_cv),
+        steam::se3::TransformStateEvaluator::MakeShared(poses[meas.frameID]));
+    steam::StereoCameraErrorEval::Ptr error(
+        new steam::StereoCameraErrorEval(meas.data, intrinsics, T_c0, landmarks[meas.landID]));
+    return steam::CostTermBase::ConstPtr(new steam::WeightedLeastSqCostTerm<4,6>(error, noise, loss));
+  };
+
+  // Reference problem, from the fully parsed dataset
+  steam::data::SimpleBaDataset full = steam::data::parseSimpleBaDataset(file);
+  steam::OptimizationProblem reference;
+  for (unsigned int i = 0; i < full.meas.size(); i++) {
+    reference.addCostTerm(factory(full.meas[i]));
+  }
+
+  SECTION("measurements are ingested in batches while the problem is in use" ) {
+    steam::OptimizationProblem problem;
+    steam::CostTermIngestor<steam::data::SimpleBaDataset::StereoMeas> ingestor(factory, 7, 2);
+    ingestor.startProducer([&stream](
+        steam::CostTermIngestor<steam::data::SimpleBaDataset::StereoMeas>* in) {
+      steam::data::SimpleBaDataset::StereoMeas meas;
+      while (stream.next(&meas) && in->push(meas)) {}
+    });
+    unsigned int numAppends = 0;
+    while (!ingestor.isFinished()) {
+      if (ingestor.waitForBatch()) {
+        numAppends += (ingestor.appendReady(&problem) > 0);
+        problem.cost();
+      }
+    }
+    CHECK( numAppends > 0 );
+    CHECK( ingestor.getNumAppended() == full.meas.size() );
+    CHECK( problem.getNumberOfCostTerms() == reference.getNumberOfCostTerms() );
+    CHECK( std::fabs(problem.cost() - reference.cost()) < 1e-9*reference.cost() );
+  }
+
+  SECTION("producer errors are reported to the consumer" ) {
+    steam::OptimizationProblem problem;
+    steam::CostTermIngestor<steam::data::SimpleBaDataset::StereoMeas> ingestor(factory, 4);
+    ingestor.startProducer([](
+        steam::CostTermIngestor<steam::data::SimpleBaDataset::StereoMeas>* in) {
+      steam::data::SimpleBaDataset::StereoMeas meas;
+      meas.frameID = 5; meas.landID = 0; meas.time = 0.0; meas.data.setZero();
+      in->push(meas);
+    });
+    CHECK( !ingestor.waitForBatch() );
+    CHECK( !ingestor.isFinished() );
+    CHECK_THROWS_AS( ingestor.appendReady(&problem), std::out_of_range );
+  }
+  remove(file.c_str());
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Solver observer that keeps the iteration reports
+/////////////////////////////////////////////////////////////////////////////////////////////
+class RecordingObserver : public steam::SolverBase::Observer {
+ public:
+  virtual void onIteration(const steam::SolverBase::IterationReport& report) {
+    reports.push_back(report);
+  }
+  std::vector<steam::SolverBase::IterationReport> reports;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Solver telemetry
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("solver observers receive a report per iteration", "[problem]" ) {
+
+  steam::data::PoseGraphParams graphParams;
+  graphParams.numPoses = 60;
+  graphParams.posesPerLap = 20;
+  graphParams.loopClosureDensity = 0.5;
+  steam::data::G2oSe3Problem graph = steam::data::buildG2oSe3Problem(
+      steam::data::generatePoseGraph(graphParams),
+      steam::L2LossFunc::Ptr(new steam::L2LossFunc()), 1);
+  steam::OptimizationProblem problem;
+  graph.addToProblem(&problem);
+
+  boost::shared_ptr<RecordingObserver> observer(new RecordingObserver());
+  boost::shared_ptr<RecordingObserver> removed(new RecordingObserver());
+  std::vector<steam::SolverBase::IterationReport>& reports = observer->reports;
+
+  SECTION("dogleg" ) {
+    steam::DoglegGaussNewtonSolver::Params params;
+    params.maxIterations = 20;
+    steam::DoglegGaussNewtonSolver solver(&problem, params);
+    REQUIRE_THROWS( solver.addObserver(steam::SolverBase::Observer::Ptr()) );
+    solver.addObserver(observer);
+    solver.addObserver(removed);
+    solver.removeObserver(removed);
+    const double initialCost = problem.cost();
+    solver.optimize();
+
+    REQUIRE( reports.size() == solver.getCurrIteration() );
+    CHECK( removed->reports.empty() );
+    CHECK( reports.front().prevCost == initialCost );
+    CHECK( reports.back().cost == problem.cost() );
+    CHECK( reports.back().converged );
+    CHECK( reports.back().termination == solver.getTerminationCause() );
+    CHECK( reports.front().patternAnalyzed );
+    for (unsigned int i = 0; i < reports.size(); i++) {
+      INFO("iteration: " << i);
+      CHECK( reports[i].iteration == i + 1 );
+      CHECK( reports[i].stepSuccess );
+      CHECK( reports[i].gradientNorm > 0.0 );
+      CHECK( reports[i].trustRegionSize > 0.0 );
+      CHECK( reports[i].numFactorizations == 1u );
+      CHECK( reports[i].hessianNonZeros > 0u );
+      CHECK( reports[i].factorNonZeros >= reports[i].hessianNonZeros );
+      CHECK( reports[i].iterationTime + 1e-3 >= reports[i].buildTime + reports[i].factorizeTime +
+             reports[i].solveTime + reports[i].updateTime + reports[i].costEvalTime );
+      CHECK( (i == 0 || !reports[i].patternAnalyzed) );
+      CHECK( (i + 1 == reports.size() || !reports[i].converged) );
+      CHECK( (i == 0 || reports[i].prevCost == reports[i-1].cost) );
+    }
+    CHECK( solver.getLastIterationReport().iteration == reports.back().iteration );
+  }
+
+  SECTION("Levenberg-Marquardt" ) {
+    steam::LevMarqGaussNewtonSolver::Params params;
+    params.maxIterations = 3;
+    steam::LevMarqGaussNewtonSolver solver(&problem, params);
+    solver.addObserver(observer);
+    solver.optimize();
+
+    REQUIRE( reports.size() == solver.getCurrIteration() );
+    for (unsigned int i = 0; i < reports.size(); i++) {
+      CHECK( reports[i].dampingCoeff > 0.0 );
+      CHECK( reports[i].numFactorizations == reports[i].numBacktracks + 1 );
+      CHECK( reports[i].cost <= reports[i].prevCost );
+    }
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Cost-term profiling
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("cost-term profiler attributes evaluations to the error evaluator types", "[problem]" ) {
+
+  steam::data::PoseGraphParams graphParams;
+  graphParams.numPoses = 40;
+  graphParams.posesPerLap = 20;
+  steam::data::G2oSe3Problem graph = steam::data::buildG2oSe3Problem(
+      steam::data::generatePoseGraph(graphParams),
+      steam::L2LossFunc::Ptr(new steam::L2LossFunc()), 2);
+  steam::OptimizationProblem problem;
+  graph.addToProblem(&problem);
+  const unsigned int numEdges = graph.costTerms->numCostTerms();
+  const unsigned int numUnary = 7;
+  for (unsigned int i = 0; i < numUnary; i++) {
+    steam::VectorSpaceStateVar::Ptr state(new steam::VectorSpaceStateVar(Eigen::Vector2d::Zero()));
+    problem.addStateVariable(state);
+    problem.addCostTerm(makeUnaryCostTerm(state, Eigen::Vector2d(1.0, i)));
+  }
+  steam::StateVector stateVector;
+  for (unsigned int i = 0; i < problem.getStateVariables().size(); i++) {
+    stateVector.addStateVariable(problem.getStateVariables()[i]);
+  }
+
+  // Sampling one in three terms, three passes visit every term once
+  steam::CostTermProfiler::Ptr profiler;
+  for (unsigned int interval = 1; interval <= 3; interval += 2) {
+    INFO("sample interval: " << interval);
+    profiler.reset(new steam::CostTermProfiler(interval));
+    problem.setCostTermProfiler(profiler);
+    graph.costTerms->setProfiler(profiler);
+    for (unsigned int pass = 0; pass < interval; pass++) {
+      problem.cost();
+      Eigen::SparseMatrix<double> approximateHessian;
+      Eigen::VectorXd gradientVector;
+      problem.buildGaussNewtonTerms(stateVector, &approximateHessian, &gradientVector);
+    }
+
+    std::vector<steam::CostTermProfiler::TypeStats> stats = profiler->getStats();
+    REQUIRE( stats.size() == 2u );
+    for (unsigned int i = 0; i < stats.size(); i++) {
+      INFO("type: " << stats[i].name);
+      CHECK( stats[i].evaluateTime > 0.0 );
+      CHECK( stats[i].linearizeTime > 0.0 );
+      CHECK( (i == 0 || stats[i].evaluateTime + stats[i].linearizeTime <=
+                        stats[i-1].evaluateTime + stats[i-1].linearizeTime) );
+      if (stats[i].name.find("VectorSpaceErrorEval") != std::string::npos) {
+        CHECK( stats[i].evaluations == interval*numUnary );
+        CHECK( stats[i].linearizations == interval*numUnary );
+        CHECK( stats[i].jacobians == interval*numUnary );
+        CHECK( stats[i].hessianBlocks == interval*numUnary );
+      } else {
+        // Edges to the locked first pose have one Jacobian (one block), the others two (three)
+        CHECK( stats[i].name.find("TransformErrorEval") != std::string::npos );
+        CHECK( stats[i].evaluations == interval*numEdges );
+        CHECK( stats[i].linearizations == interval*numEdges );
+        CHECK( stats[i].jacobians < 2*interval*numEdges );
+        CHECK( stats[i].jacobians > interval*numEdges );
+        CHECK( stats[i].hessianBlocks == 2*stats[i].jacobians - interval*numEdges );
+      }
+    }
+  }
+
+  // Detached and reset, nothing more is recorded
+  std::ostringstream summary;
+  profiler->printSummary(summary);
+  CHECK( summary.str().find("TransformErrorEval") != std::string::npos );
+  problem.setCostTermProfiler(steam::CostTermProfiler::Ptr());
+  graph.costTerms->setProfiler(steam::CostTermProfiler::Ptr());
+  profiler->reset();
+  problem.cost();
+  CHECK( profiler->getStats().empty() );
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Allocation counter that reports three allocations per call
+/////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long long fakeAllocationCount() {
+  static unsigned long long count = 0;
+  return count += 3;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Memory accounting
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("memory accounting predicts and reports the solver subsystems", "[problem]" ) {
+
+  steam::data::PoseGraphParams graphParams;
+  graphParams.numPoses = 60;
+  graphParams.posesPerLap = 20;
+  graphParams.loopClosureDensity = 0.5;
+  steam::data::G2oSe3Problem graph = steam::data::buildG2oSe3Problem(
+      steam::data::generatePoseGraph(graphParams),
+      steam::L2LossFunc::Ptr(new steam::L2LossFunc()), 1);
+  steam::OptimizationProblem problem;
+  graph.addToProblem(&problem);
+
+  steam::DoglegGaussNewtonSolver::Params params;
+  params.maxIterations = 3;
+  steam::DoglegGaussNewtonSolver solver(&problem, params);
+  boost::shared_ptr<RecordingObserver> observer(new RecordingObserver());
+  solver.addObserver(observer);
+
+  // The symbolic analysis sizes the factor, which holds at least the Hessian's non-zeros
+  const steam::MemoryUsage predicted = solver.predictMemoryUsage();
+  INFO("predicted: " << predicted);
+  CHECK( predicted.blockHessian > 0u );
+  CHECK( predicted.sparseHessian > 0u );
+  CHECK( predicted.choleskyFactor >= predicted.sparseHessian - sizeof(Eigen::SparseMatrix<double>) );
+  CHECK( predicted.stateVector > 0u );
+  CHECK( predicted.stateBackup >= 59*sizeof(double) );
+  CHECK( predicted.total() > predicted.choleskyFactor );
+
+  steam::setAllocationCounter(&fakeAllocationCount);
+  solver.iterate();
+  steam::setAllocationCounter(NULL);
+  solver.iterate();
+
+  const std::vector<steam::SolverBase::IterationReport>& reports = observer->reports;
+  REQUIRE( reports.size() == 2u );
+  CHECK( reports[0].numAllocations == 3u );
+  CHECK( reports[1].numAllocations == 0u );
+  for (unsigned int i = 0; i < reports.size(); i++) {
+    INFO("iteration: " << i << ", " << reports[i].memory);
+    CHECK( !reports[i].patternAnalyzed );
+    CHECK( reports[i].memory.blockHessian == predicted.blockHessian );
+    CHECK( reports[i].memory.sparseHessian == predicted.sparseHessian );
+    CHECK( reports[i].memory.choleskyFactor == predicted.choleskyFactor );
+    CHECK( reports[i].memory.stateVector == predicted.stateVector );
+    CHECK( reports[i].memory.stateBackup >= predicted.stateBackup );
+    CHECK( reports[i].memory.evaluatorPools == steam::getPoolMemoryUsage() );
+    CHECK( reports[i].peakResidentMemory > 0u );
+    CHECK( solver.getPeakMemoryUsage().total() >= reports[i].memory.total() );
+  }
+} // TEST_CASE
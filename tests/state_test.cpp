@@ -0,0 +1,149 @@
+#include "catch.hpp"
+
+#include <steam.hpp>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// State vector
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("state vector block indices and slots", "[state]" ) {
+
+  // States of different sizes
+  std::vector<steam::StateVariableBase::Ptr> states;
+  for (unsigned int i = 0; i < 6; i++) {
+    if (i % 2 == 0) {
+      states.push_back(steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar()));
+    } else {
+      states.push_back(steam::VectorSpaceStateVar::Ptr(
+          new steam::VectorSpaceStateVar(Eigen::VectorXd::Constant(i, 1.0))));
+    }
+  }
+
+  steam::StateVector stateVector;
+  for (unsigned int i = 0; i < states.size(); i++) {
+    stateVector.addStateVariable(states[i]);
+  }
+  REQUIRE_THROWS( stateVector.addStateVariable(states[0]) );
+
+  // Block order follows insertion order, and keys carry their slot
+  const std::vector<unsigned int>& sizes = stateVector.getStateBlockSizes();
+  REQUIRE( sizes.size() == states.size() );
+  for (unsigned int i = 0; i < states.size(); i++) {
+    CHECK( sizes[i] == states[i]->getPerturbDim() );
+    CHECK( states[i]->getKey().getSlot() == int(i) );
+    CHECK( stateVector.getStateBlockIndex(states[i]->getKey()) == int(i) );
+  }
+
+  SECTION("a state shared by another state vector falls back to the map" ) {
+    steam::StateVector other;
+    other.addStateVariable(states[3]);
+    CHECK( states[3]->getKey().getSlot() == 0 );
+    CHECK( other.getStateBlockIndex(states[3]->getKey()) == 0 );
+    CHECK( stateVector.getStateBlockIndex(states[3]->getKey()) == 3 );
+    steam::se3::TransformStateVar::Ptr missing(new steam::se3::TransformStateVar());
+    CHECK_THROWS( stateVector.getStateBlockIndex(missing->getKey()) );
+  }
+
+  SECTION("removing a state moves the last state into its slot" ) {
+    stateVector.removeStateVariable(states[1]->getKey());
+    REQUIRE_THROWS( stateVector.removeStateVariable(states[1]->getKey()) );
+    REQUIRE( stateVector.getNumberOfStates() == 5 );
+    CHECK( stateVector.getStateBlockIndex(states[5]->getKey()) == 1 );
+    CHECK( stateVector.getStateBlockSizes()[1] == 5 );
+    CHECK( !stateVector.hasStateVariable(states[1]->getKey()) );
+
+    // Offsets after the moved state are shifted
+    stateVector.update(Eigen::VectorXd::LinSpaced(6*3 + 3 + 5, 0.0, 1.0));
+    CHECK( (boost::dynamic_pointer_cast<steam::VectorSpaceStateVar>(states[3])->getValue()
+            - Eigen::VectorXd::LinSpaced(6*3 + 3 + 5, 0.0, 1.0).segment(17, 3)
+            - Eigen::VectorXd::Constant(3, 1.0)).norm() < 1e-12 );
+    REQUIRE_THROWS( stateVector.update(Eigen::VectorXd::Zero(6*3 + 1 + 3 + 5)) );
+  }
+
+  SECTION("deep copies keep the structure and copy values back" ) {
+    steam::StateVector backup(stateVector);
+    Eigen::VectorXd perturb = Eigen::VectorXd::Constant(
+        6*3 + 1 + 3 + 5, 0.1);
+    stateVector.update(perturb);
+    CHECK( (boost::dynamic_pointer_cast<steam::VectorSpaceStateVar>(states[1])->getValue()
+            - Eigen::VectorXd::Constant(1, 1.1)).norm() < 1e-12 );
+    stateVector.copyValues(backup);
+    CHECK( (boost::dynamic_pointer_cast<steam::VectorSpaceStateVar>(states[1])->getValue()
+            - Eigen::VectorXd::Constant(1, 1.0)).norm() < 1e-12 );
+    CHECK( backup.getStateBlockIndex(states[5]->getKey()) == 5 );
+  }
+
+  SECTION("snapshots restore values after an update" ) {
+    steam::se3::LandmarkStateVar::Ptr landmark(
+        new steam::se3::LandmarkStateVar(Eigen::Vector3d(1.0, 2.0, 3.0)));
+    stateVector.addStateVariable(landmark);
+    std::vector<Eigen::Matrix4d> poses;
+    for (unsigned int i = 0; i < states.size(); i += 2) {
+      poses.push_back(boost::dynamic_pointer_cast<steam::se3::TransformStateVar>(
+                        states[i])->getValue().matrix());
+    }
+    Eigen::Vector4d point = landmark->getValue();
+
+    steam::StateVector::Snapshot snapshot;
+    for (int pass = 0; pass < 2; pass++) {
+      stateVector.saveValues(&snapshot);
+      CHECK( snapshot.values.size() == 3*16 + 1 + 3 + 5 + 4 );
+      stateVector.update(Eigen::VectorXd::Constant(6*3 + 1 + 3 + 5 + 3, 0.1*(pass + 1)));
+      CHECK( (landmark->getValue() - point).norm() > 1e-3 );
+      stateVector.restoreValues(snapshot);
+      for (unsigned int i = 0; i < states.size(); i += 2) {
+        CHECK( (boost::dynamic_pointer_cast<steam::se3::TransformStateVar>(
+                  states[i])->getValue().matrix() - poses[i/2]).norm() < 1e-12 );
+      }
+      CHECK( (boost::dynamic_pointer_cast<steam::VectorSpaceStateVar>(states[5])->getValue()
+              - Eigen::VectorXd::Constant(5, 1.0)).norm() < 1e-12 );
+      CHECK( (landmark->getValue() - point).norm() < 1e-12 );
+    }
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// State vector update
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("state vector update matches per-state updates", "[state]" ) {
+
+  // Enough states to take the parallel path
+  std::vector<steam::StateVariableBase::Ptr> states;
+  std::vector<steam::StateVariableBase::Ptr> expected;
+  steam::StateVector stateVector;
+  unsigned int dim = 0;
+  for (unsigned int i = 0; i < 1500; i++) {
+    if (i % 3 == 0) {
+      states.push_back(steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar()));
+    } else if (i % 3 == 1) {
+      states.push_back(steam::se3::LandmarkStateVar::Ptr(
+          new steam::se3::LandmarkStateVar(Eigen::Vector3d(1.0, 0.5*i, 2.0))));
+    } else {
+      states.push_back(steam::VectorSpaceStateVar::Ptr(
+          new steam::VectorSpaceStateVar(Eigen::VectorXd::Constant(1 + i % 4, 1.0))));
+    }
+    expected.push_back(states.back()->clone());
+    stateVector.addStateVariable(states.back());
+    dim += states.back()->getPerturbDim();
+  }
+
+  Eigen::VectorXd perturb(dim);
+  for (unsigned int i = 0; i < dim; i++) {
+    perturb[i] = 0.01*((i*7) % 13) - 0.05;
+  }
+  stateVector.update(perturb);
+  REQUIRE_THROWS( stateVector.update(Eigen::VectorXd::Zero(dim - 1)) );
+
+  // Compare against the dynamic-size update of each state
+  unsigned int offset = 0;
+  for (unsigned int i = 0; i < states.size(); i++) {
+    const unsigned int size = states[i]->getPerturbDim();
+    expected[i]->update(perturb.segment(offset, size));
+    offset += size;
+    Eigen::VectorXd actualRaw(states[i]->getRawValueSize());
+    Eigen::VectorXd expectedRaw(expected[i]->getRawValueSize());
+    states[i]->writeRawValue(actualRaw.data());
+    expected[i]->writeRawValue(expectedRaw.data());
+    INFO("state: " << i);
+    CHECK( (actualRaw - expectedRaw).norm() < 1e-12 );
+  }
+} // TEST_CASE
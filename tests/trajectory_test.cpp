@@ -0,0 +1,212 @@
+#include "catch.hpp"
+
+#include <steam.hpp>
+#include <steam/trajectory/SteamTrajPriorFactor.hpp>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Make a small trajectory with non-trivial knot poses and velocities
+/////////////////////////////////////////////////////////////////////////////////////////////
+steam::se3::SteamTrajInterface makeTestTrajectory(unsigned int numKnots, double delT) {
+
+  steam::se3::SteamTrajInterface traj(true);
+  for (unsigned int i = 0; i < numKnots; i++) {
+    Eigen::Matrix<double,6,1> xi; xi << 0.5*i, 0.1*i, 0.0, 0.01*i, 0.0, 0.2*i;
+    Eigen::Matrix<double,6,1> w; w << 1.0, 0.1*i, 0.05, 0.0, 0.02*i, 0.3;
+    steam::se3::TransformStateVar::Ptr pose(
+          new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi)));
+    steam::VectorSpaceStateVar::Ptr velocity(new steam::VectorSpaceStateVar(w));
+    traj.add(steam::Time(i*delT), steam::se3::TransformStateEvaluator::MakeShared(pose), velocity);
+  }
+  return traj;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Batched trajectory queries
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("batched trajectory queries match single queries", "[trajectory]" ) {
+
+  steam::se3::SteamTrajInterface traj = makeTestTrajectory(5, 0.5);
+
+  // Sorted query times, including extrapolation before/after and exact knot times
+  std::vector<steam::Time> times;
+  for (int i = -3; i < 30; i++) {
+    times.push_back(steam::Time(0.1*i));
+  }
+
+  std::vector<lgmath::se3::Transformation> poses = traj.getInterpPoses(times);
+  std::vector<steam::se3::TransformEvaluator::ConstPtr> evals = traj.getInterpPoseEvals(times);
+  Eigen::Matrix<double,6,Eigen::Dynamic> velocities = traj.getVelocities(times);
+  REQUIRE( poses.size() == times.size() );
+  REQUIRE( evals.size() == times.size() );
+  REQUIRE( velocities.cols() == int(times.size()) );
+
+  for (unsigned int i = 0; i < times.size(); i++) {
+    Eigen::Matrix4d expected = traj.getInterpPoseEval(times[i])->evaluate().matrix();
+    INFO("time: " << times[i].seconds());
+    CHECK( (poses[i].matrix() - expected).norm() < 1e-6 );
+    CHECK( (evals[i]->evaluate().matrix() - expected).norm() < 1e-6 );
+    CHECK( (velocities.col(i) - traj.getVelocity(times[i])).norm() < 1e-6 );
+  }
+
+  SECTION("unsorted times are rejected" ) {
+    std::vector<steam::Time> unsorted;
+    unsorted.push_back(steam::Time(1.0));
+    unsorted.push_back(steam::Time(0.5));
+    REQUIRE_THROWS( traj.getInterpPoses(unsorted) );
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Point-cloud de-skew
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("point-cloud de-skew matches per-point interpolation", "[trajectory]" ) {
+
+  steam::se3::SteamTrajInterface traj = makeTestTrajectory(5, 0.5);
+
+  // Unsorted point times (including extrapolation and knot times)
+  const int numPoints = 200;
+  std::vector<steam::Time> times;
+  Eigen::Matrix<double,Eigen::Dynamic,3> points(numPoints, 3);
+  for (int i = 0; i < numPoints; i++) {
+    times.push_back(steam::Time(-0.2 + 0.0137*((i*37) % numPoints)));
+    points.row(i) << 1.0 + 0.1*i, -2.0 + 0.03*i, 0.5 - 0.01*i;
+  }
+  times[0] = steam::Time(0.5);
+  steam::Time refTime(1.2);
+
+  Eigen::Matrix<double,Eigen::Dynamic,3> deskewed = traj.deskewPointCloud(times, points, refTime);
+  REQUIRE( deskewed.rows() == numPoints );
+
+  lgmath::se3::Transformation T_ref_0 = traj.getInterpPoseEval(refTime)->evaluate();
+  for (int i = 0; i < numPoints; i++) {
+    lgmath::se3::Transformation T_ref_t = T_ref_0/traj.getInterpPoseEval(times[i])->evaluate();
+    Eigen::Vector4d p; p << points.row(i).transpose(), 1.0;
+    Eigen::Vector4d expected = T_ref_t.matrix()*p;
+    INFO("point: " << i);
+    CHECK( (deskewed.row(i).transpose() - expected.head<3>()).norm() < 1e-6 );
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Knot array
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("knot array lookups and sliding window", "[trajectory]" ) {
+
+  steam::se3::SteamTrajKnotArray knots;
+  steam::se3::TransformEvaluator::Ptr pose = steam::se3::TransformStateEvaluator::MakeShared(
+        steam::se3::TransformStateVar::Ptr(new steam::se3::TransformStateVar()));
+  steam::VectorSpaceStateVar::Ptr velocity(
+        new steam::VectorSpaceStateVar(Eigen::Matrix<double,6,1>::Zero()));
+
+  // Uniformly spaced knots, appended in order
+  std::vector<boost::int64_t> times;
+  for (int i = 0; i < 10; i++) {
+    times.push_back(1000 + 100*i);
+    knots.insert(steam::se3::SteamTrajVar::Ptr(
+          new steam::se3::SteamTrajVar(steam::Time(times.back()), pose, velocity)));
+  }
+  REQUIRE( knots.size() == 10 );
+  REQUIRE( knots.isUniform() );
+  REQUIRE_THROWS( knots.insert(steam::se3::SteamTrajVar::Ptr(
+      new steam::se3::SteamTrajVar(steam::Time(boost::int64_t(1300)), pose, velocity))) );
+
+  SECTION("uniform and non-uniform lookups match a binary search" ) {
+    for (int pass = 0; pass < 2; pass++) {
+      if (pass == 1) {
+        times.insert(times.begin() + 3, 1250);
+        knots.insert(steam::se3::SteamTrajVar::Ptr(
+            new steam::se3::SteamTrajVar(steam::Time(boost::int64_t(1250)), pose, velocity)));
+        REQUIRE( !knots.isUniform() );
+      }
+      for (boost::int64_t t = 900; t < 2100; t += 7) {
+        steam::Time time(t);
+        INFO("time: " << t);
+        CHECK( int(knots.lowerBound(time)) ==
+               std::lower_bound(times.begin(), times.end(), t) - times.begin() );
+        CHECK( int(knots.upperBound(time)) ==
+               std::upper_bound(times.begin(), times.end(), t) - times.begin() );
+      }
+    }
+  }
+
+  SECTION("dropping old knots" ) {
+    knots.dropBefore(steam::Time(boost::int64_t(1550)));
+    REQUIRE( knots.size() == 4 );
+    REQUIRE( knots.timeAt(0) == 1600 );
+    REQUIRE( knots.isUniform() );
+    REQUIRE( knots.find(steam::Time(boost::int64_t(1800))) == 2 );
+    REQUIRE( knots.find(steam::Time(boost::int64_t(1850))) == knots.size() );
+    knots.insert(steam::se3::SteamTrajVar::Ptr(
+        new steam::se3::SteamTrajVar(steam::Time(boost::int64_t(2000)), pose, velocity)));
+    REQUIRE( knots.size() == 5 );
+    REQUIRE( knots.lowerBound(steam::Time(boost::int64_t(1950))) == 4 );
+  }
+} // TEST_CASE
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Prior factor
+/////////////////////////////////////////////////////////////////////////////////////////////
+TEST_CASE("fixed-size prior factor Jacobians match finite differences", "[trajectory]" ) {
+
+  // Knot states (the second pose is a composition, to exercise the 12-row block-automatic path)
+  Eigen::Matrix<double,6,1> xi1; xi1 << 0.1, -0.2, 0.3, 0.05, -0.1, 0.2;
+  Eigen::Matrix<double,6,1> xi2; xi2 << 0.2, -0.2, 0.3, 0.06, -0.1, 0.22;
+  Eigen::Matrix<double,6,1> xiFixed; xiFixed << 0.02, 0.0, 0.01, 0.0, 0.0, -0.01;
+  Eigen::Matrix<double,6,1> w1; w1 << 1.0, 0.1, 0.0, 0.0, 0.05, 0.2;
+  Eigen::Matrix<double,6,1> w2; w2 << 0.9, 0.2, 0.1, 0.02, 0.0, 0.3;
+  std::vector<steam::StateVariableBase::Ptr> states;
+  steam::se3::TransformStateVar::Ptr pose1(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi1)));
+  steam::se3::TransformStateVar::Ptr pose2(
+        new steam::se3::TransformStateVar(lgmath::se3::Transformation(xi2)));
+  steam::VectorSpaceStateVar::Ptr vel1(new steam::VectorSpaceStateVar(w1));
+  steam::VectorSpaceStateVar::Ptr vel2(new steam::VectorSpaceStateVar(w2));
+  states.push_back(pose1); states.push_back(pose2);
+  states.push_back(vel1); states.push_back(vel2);
+
+  steam::se3::TransformEvaluator::Ptr T_20 = steam::se3::compose(
+        steam::se3::inverse(steam::se3::FixedTransformEvaluator::MakeShared(
+                              lgmath::se3::Transformation(xiFixed))),
+        steam::se3::TransformStateEvaluator::MakeShared(pose2));
+  steam::se3::SteamTrajVar::Ptr knot1(new steam::se3::SteamTrajVar(steam::Time(0.0),
+        steam::se3::TransformStateEvaluator::MakeShared(pose1), vel1));
+  steam::se3::SteamTrajVar::Ptr knot2(new steam::se3::SteamTrajVar(steam::Time(0.7), T_20, vel2));
+  steam::se3::SteamTrajPriorFactor factor(knot1, knot2);
+
+  // Analytical Jacobians
+  std::vector<steam::Jacobian<12,6> > jacs;
+  Eigen::Matrix<double,12,1> error =
+      factor.evaluate(Eigen::Matrix<double,12,12>::Identity(), &jacs);
+  REQUIRE( jacs.size() == 4 );
+  REQUIRE( (error - factor.evaluate()).norm() < 1e-12 );
+
+  // Central differences
+  const double eps = 1e-6;
+  for (unsigned int i = 0; i < jacs.size(); i++) {
+    steam::StateVariableBase::Ptr state;
+    for (unsigned int j = 0; j < states.size(); j++) {
+      if (jacs[i].key.equals(states[j]->getKey())) {
+        state = states[j];
+      }
+    }
+    REQUIRE( state );
+    steam::StateVariableBase::ConstPtr original = state->clone();
+    Eigen::Matrix<double,12,6> numerical;
+    for (int k = 0; k < 6; k++) {
+      Eigen::VectorXd perturb = Eigen::VectorXd::Zero(6);
+      perturb[k] = eps;
+      state->update(perturb);
+      Eigen::Matrix<double,12,1> plus = factor.evaluate();
+      state->setFromCopy(original);
+      state->update(-perturb);
+      Eigen::Matrix<double,12,1> minus = factor.evaluate();
+      state->setFromCopy(original);
+      numerical.col(k) = (plus - minus)/(2.0*eps);
+    }
+    INFO("jacobian: " << i);
+    CHECK( (jacs[i].jac.topRows<6>() - numerical.topRows<6>()).norm() < 1e-5 );
+
+    // The pose Jacobians of the velocity error use a small-interval approximation of J^{-1}
+    CHECK( (jacs[i].jac.bottomRows<6>() - numerical.bottomRows<6>()).norm() < 1e-2 );
+  }
+} // TEST_CASE